@@ -0,0 +1,30 @@
+# ############################################################################
+# Copyright (c) 2026 Axoflow
+#
+# This program is free software: you can redistribute it and/or modify it
+# under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+# As an additional exemption you are allowed to compile & link against the
+# OpenSSL libraries as published by the OpenSSL project. See the file
+# COPYING for details.
+#
+# ############################################################################
+
+include (LibFindMacros)
+
+
+# both Hyperscan and its portable fork, Vectorscan install libhs
+libfind_pkg_detect(HYPERSCAN libhs FIND_PATH hs.h PATH_SUFFIXES hs FIND_LIBRARY hs)
+set(HYPERSCAN_PROCESS_INCLUDES HYPERSCAN_INCLUDE_DIR)
+set(HYPERSCAN_PROCESS_LIBS HYPERSCAN_LIBRARY)
+libfind_process(HYPERSCAN)
@@ -49,6 +49,7 @@
 #include "multi-line/multi-line-factory.h"
 #include "filterx/filterx-globals.h"
 #include "transport/transport-globals.h"
+#include "utf8utils.h"
 
 #include <iv.h>
 #include <iv_work.h>
@@ -219,6 +220,7 @@ app_startup(void)
   iv_set_fatal_msg_handler(app_fatal);
   iv_init();
   crypto_init();
+  utf8utils_global_init();
   hostname_global_init();
   dns_caching_global_init();
   dns_caching_thread_init();
@@ -264,6 +264,10 @@ main_location_print (FILE *yyo, YYLTYPE const * const yylocp)
 %token KW_BATCH_SIZE                  10601
 %token KW_FILTERX_JIT                 10602
 %token KW_FILTERX_JIT_DEBUG_INFO      10603
+%token KW_ZERO_COPY_INPUT             10604
+%token KW_WORK_STEALING               10605
+%token KW_FILTERX_JIT_CACHE_DIR        10606
+%token KW_FILTERX_JIT_HOT_THRESHOLD    10607
 
 %token KW_STATS                       10400
 %token KW_FREQ                        10401
@@ -842,6 +846,10 @@ log_scheduler_option
           {
             last_scheduler_options->log_fetch_limit = $3;
           }
+        | KW_WORK_STEALING '(' yesno ')'
+          {
+            last_scheduler_options->work_stealing = $3;
+          }
         ;
 
 
@@ -1156,6 +1164,17 @@ options_item
 	    filterx_config_set_jit_debug_info(fx_cfg, mode);
 	    free($3);
 	  }
+	| KW_FILTERX_JIT_CACHE_DIR '(' string ')'
+	  {
+	    FilterXConfig *fx_cfg = filterx_config_get(configuration);
+	    filterx_config_set_jit_cache_dir(fx_cfg, $3);
+	    free($3);
+	  }
+	| KW_FILTERX_JIT_HOT_THRESHOLD '(' nonnegative_integer ')'
+	  {
+	    FilterXConfig *fx_cfg = filterx_config_get(configuration);
+	    filterx_config_set_jit_hot_threshold(fx_cfg, $3);
+	  }
 	| { last_template_options = &configuration->template_options; } template_option
 	| { last_host_resolve_options = &configuration->host_resolve_options; } host_resolve_option
 	| { last_stats_options = &configuration->stats_options; last_healthcheck_options = &configuration->healthcheck_options; } stat_option
@@ -1549,6 +1568,7 @@ source_proto_option
         | KW_LOG_MSG_SIZE '(' positive_integer ')'      { last_proto_server_options->max_msg_size = $3; }
         | KW_IDLE_TIMEOUT '(' positive_integer ')'      { last_proto_server_options->idle_timeout = $3; }
         | KW_TRIM_LARGE_MESSAGES '(' yesno ')'          { last_proto_server_options->trim_large_messages = $3; }
+        | KW_ZERO_COPY_INPUT '(' yesno ')'              { last_proto_server_options->zero_copy_input = $3; }
         ;
 
 host_resolve_option
@@ -146,6 +146,8 @@ static CfgLexerKeyword main_keywords[] =
   { "log_level",          KW_LOG_LEVEL },
   { "filterx_jit",        KW_FILTERX_JIT },
   { "filterx_jit_debug_info", KW_FILTERX_JIT_DEBUG_INFO },
+  { "filterx_jit_cache_dir", KW_FILTERX_JIT_CACHE_DIR },
+  { "filterx_jit_hot_threshold", KW_FILTERX_JIT_HOT_THRESHOLD },
 
   { "log_fifo_size",      KW_LOG_FIFO_SIZE },
   { "log_fetch_limit",    KW_LOG_FETCH_LIMIT },
@@ -153,6 +155,7 @@ static CfgLexerKeyword main_keywords[] =
   { "log_msg_size",       KW_LOG_MSG_SIZE },
   { "log_flow_control",   KW_LOG_FLOW_CONTROL },
   { "trim_large_messages", KW_TRIM_LARGE_MESSAGES },
+  { "zero_copy_input",    KW_ZERO_COPY_INPUT },
   { "idle_timeout",       KW_IDLE_TIMEOUT },
   { "log_prefix",         KW_LOG_PREFIX, KWS_OBSOLETE, "program_override" },
   { "program_override",   KW_PROGRAM_OVERRIDE },
@@ -200,6 +203,7 @@ static CfgLexerKeyword main_keywords[] =
   { "batch_timeout",      KW_BATCH_TIMEOUT },
   { "batch_idle_timeout", KW_BATCH_IDLE_TIMEOUT },
   { "batch_size",         KW_BATCH_SIZE },
+  { "work_stealing",      KW_WORK_STEALING },
 
   { "read_old_records",   KW_READ_OLD_RECORDS},
   { "use_syslogng_pid",   KW_USE_SYSLOGNG_PID },
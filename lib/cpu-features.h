@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef CPU_FEATURES_H_INCLUDED
+#define CPU_FEATURES_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/*
+ * Runtime detection of the SIMD instruction sets we have hand written
+ * kernels for.  The kernels themselves are compiled with the matching
+ * target attribute, so the binary runs on CPUs without them, the caller is
+ * expected to select the implementation once (e.g. at init time) based on
+ * these functions.
+ *
+ * NEON is mandatory on aarch64, so it is selected at compile time.
+ */
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CPU_FEATURES_HAVE_X86_SIMD 1
+
+static inline gboolean
+cpu_supports_sse2(void)
+{
+  return __builtin_cpu_supports("sse2");
+}
+
+static inline gboolean
+cpu_supports_sse42(void)
+{
+  return __builtin_cpu_supports("sse4.2");
+}
+
+static inline gboolean
+cpu_supports_avx2(void)
+{
+  return __builtin_cpu_supports("avx2");
+}
+
+static inline gboolean
+cpu_supports_avx512bw(void)
+{
+  return __builtin_cpu_supports("avx512bw");
+}
+
+#else
+#define CPU_FEATURES_HAVE_X86_SIMD 0
+
+static inline gboolean
+cpu_supports_sse2(void)
+{
+  return FALSE;
+}
+
+static inline gboolean
+cpu_supports_sse42(void)
+{
+  return FALSE;
+}
+
+static inline gboolean
+cpu_supports_avx2(void)
+{
+  return FALSE;
+}
+
+static inline gboolean
+cpu_supports_avx512bw(void)
+{
+  return FALSE;
+}
+
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define CPU_FEATURES_HAVE_NEON 1
+#else
+#define CPU_FEATURES_HAVE_NEON 0
+#endif
+
+#endif
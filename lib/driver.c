@@ -182,7 +182,7 @@ _log_src_driver_register_counters(LogSrcDriver *self)
   stats_register_counter(level, &sc_key, SC_TYPE_PROCESSED,
                          &self->super.processed_group_messages);
   stats_cluster_logpipe_key_legacy_set(&sc_key,  SCS_CENTER, NULL, "received" );
-  stats_register_counter(level, &sc_key, SC_TYPE_PROCESSED, &self->received_global_messages);
+  stats_register_sharded_counter(level, &sc_key, SC_TYPE_PROCESSED, &self->received_global_messages);
   stats_unlock();
 }
 
@@ -350,7 +350,7 @@ _log_dest_driver_register_counters(LogDestDriver *self)
   stats_register_counter(level, &sc_key, SC_TYPE_PROCESSED,
                          &self->super.processed_group_messages);
   stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_CENTER, NULL, "queued" );
-  stats_register_counter(level, &sc_key, SC_TYPE_PROCESSED, &self->queued_global_messages);
+  stats_register_sharded_counter(level, &sc_key, SC_TYPE_PROCESSED, &self->queued_global_messages);
   stats_unlock();
 }
 
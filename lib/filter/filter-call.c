@@ -68,9 +68,10 @@ filter_call_init(FilterExprNode *s, GlobalConfig *cfg)
       return FALSE;
     }
 
-  /* skip initialize if filter_call_init already called. */
+  /* skip looking up the rule if filter_call_init already called, the
+   * expression may have been deinitialized since then though */
   if (self->filter_expr)
-    return TRUE;
+    return filter_expr_init(self->filter_expr, cfg);
 
   self->visited = TRUE;
 
@@ -110,6 +111,15 @@ filter_call_init(FilterExprNode *s, GlobalConfig *cfg)
   return TRUE;
 }
 
+static void
+filter_call_deinit(FilterExprNode *s, GlobalConfig *cfg)
+{
+  FilterCall *self = (FilterCall *) s;
+
+  if (self->filter_expr)
+    filter_expr_deinit(self->filter_expr, cfg);
+}
+
 static void
 filter_call_free(FilterExprNode *s)
 {
@@ -137,6 +147,7 @@ filter_call_new(gchar *rule, GlobalConfig *cfg)
 
   filter_expr_node_init_instance(&self->super);
   self->super.init = filter_call_init;
+  self->super.deinit = filter_call_deinit;
   self->super.eval = filter_call_eval;
   self->super.free_fn = filter_call_free;
   self->super.type = g_strdup_printf("filter(%s)", rule);
@@ -318,6 +318,48 @@ fop_cmp_free(FilterExprNode *s)
   g_free((gchar *) self->super.type);
 }
 
+/*
+ * Returns the literal side of a string based equality comparison ("eq")
+ * between a single name-value pair and a literal string, e.g.  "$HOST" eq
+ * "foo".  Such filters can be replaced by a hash lookup on the value.
+ * Returns NULL otherwise.
+ */
+const gchar *
+fop_cmp_get_exact_match(FilterExprNode *s, NVHandle *value_handle)
+{
+  FilterCmp *self = (FilterCmp *) s;
+  LogTemplate *value_side, *literal_side;
+
+  if (s->eval != fop_cmp_eval || s->comp || s->modify)
+    return NULL;
+
+  if ((self->compare_mode & FCMP_MODE_MASK) != FCMP_STRING_BASED || (self->compare_mode & FCMP_OP_MASK) != FCMP_EQ)
+    return NULL;
+
+  if (log_template_is_literal_string(self->right))
+    {
+      value_side = self->left;
+      literal_side = self->right;
+    }
+  else if (log_template_is_literal_string(self->left))
+    {
+      value_side = self->right;
+      literal_side = self->left;
+    }
+  else
+    return NULL;
+
+  if (!log_template_is_trivial(value_side))
+    return NULL;
+
+  NVHandle handle = log_template_get_trivial_value_handle(value_side);
+  if (handle == LM_V_NONE)
+    return NULL;
+
+  *value_handle = handle;
+  return log_template_get_literal_value(literal_side, NULL);
+}
+
 FilterExprNode *
 fop_cmp_clone(FilterExprNode *s)
 {
@@ -41,5 +41,6 @@
 FilterExprNode *fop_cmp_new(LogTemplate *left, LogTemplate *right,
                             const gchar *type, gint compare_mode,
                             const gchar *location);
+const gchar *fop_cmp_get_exact_match(FilterExprNode *s, NVHandle *value_handle);
 
 #endif
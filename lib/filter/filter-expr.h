@@ -39,6 +39,7 @@ struct _FilterExprNode
           modify:1; /* this filter changes the log message */
   const gchar *type;
   gboolean (*init)(FilterExprNode *self, GlobalConfig *cfg);
+  void (*deinit)(FilterExprNode *self, GlobalConfig *cfg);
   gboolean (*eval)(FilterExprNode *self, LogMessage **msg, gint num_msg, LogTemplateEvalOptions *options);
   FilterExprNode *(*clone)(FilterExprNode *self);
   void (*free_fn)(FilterExprNode *self);
@@ -55,6 +56,13 @@ filter_expr_init(FilterExprNode *self, GlobalConfig *cfg)
   return TRUE;
 }
 
+static inline void
+filter_expr_deinit(FilterExprNode *self, GlobalConfig *cfg)
+{
+  if (self->deinit)
+    self->deinit(self, cfg);
+}
+
 gboolean filter_expr_eval(FilterExprNode *self, LogMessage *msg);
 gboolean filter_expr_eval_with_context(FilterExprNode *self, LogMessage **msgs, gint num_msg,
                                        LogTemplateEvalOptions *options);
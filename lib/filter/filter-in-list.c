@@ -23,18 +23,13 @@
 
 #include "filter-in-list.h"
 #include "logmsg/logmsg.h"
-#include "str-utils.h"
-
-#include <errno.h>
-#include <stdlib.h>
-#include <stdio.h>
-#include <string.h>
+#include "string-set.h"
 
 typedef struct _FilterInList
 {
   FilterExprNode super;
   NVHandle value_handle;
-  GTree *tree;
+  StringSetFile *list;
 } FilterInList;
 
 static gboolean
@@ -46,53 +41,64 @@ filter_in_list_eval(FilterExprNode *s, LogMessage **msgs, gint num_msg, LogTempl
   gssize len = 0;
 
   value = log_msg_get_value(msg, self->value_handle, &len);
-  APPEND_ZERO(value, value, len);
 
-  gboolean result = (g_tree_lookup(self->tree, value) != NULL);
+  gboolean result = string_set_file_match(self->list, value, len);
   msg_trace("in-list() evaluation started",
-            evt_tag_str("value", value),
+            evt_tag_mem("value", value, len),
             evt_tag_msg_reference(msg));
 
   return result ^ s->comp;
 }
 
+static gboolean
+filter_in_list_init(FilterExprNode *s, GlobalConfig *cfg)
+{
+  FilterInList *self = (FilterInList *)s;
+
+  string_set_file_start_monitoring(self->list);
+  return TRUE;
+}
+
+static void
+filter_in_list_deinit(FilterExprNode *s, GlobalConfig *cfg)
+{
+  FilterInList *self = (FilterInList *)s;
+
+  string_set_file_stop_monitoring(self->list);
+}
+
 static void
 filter_in_list_free(FilterExprNode *s)
 {
   FilterInList *self = (FilterInList *)s;
 
-  g_tree_destroy(self->tree);
+  string_set_file_free(self->list);
 }
 
 FilterExprNode *
-filter_in_list_new(const gchar *list_file, const gchar *property)
+filter_in_list_new(const gchar *list_file, const gchar *property, StringSetMode mode)
 {
   FilterInList *self;
-  FILE *stream;
-  gchar line[16384];
+  GError *error = NULL;
+  StringSetFile *list;
 
-  stream = fopen(list_file, "r");
-  if (!stream)
+  list = string_set_file_new(list_file, mode, &error);
+  if (!list)
     {
       msg_error("Error opening in-list filter list file",
                 evt_tag_str("file", list_file),
-                evt_tag_error("errno"));
+                evt_tag_str("error", error->message));
+      g_clear_error(&error);
       return NULL;
     }
 
   self = g_new0(FilterInList, 1);
   filter_expr_node_init_instance(&self->super);
   self->value_handle = log_msg_get_value_handle(property);
-  self->tree = g_tree_new_full((GCompareDataFunc)strcmp, NULL, g_free, NULL);
-
-  while (fgets(line, sizeof(line), stream) != NULL)
-    {
-      line[strlen(line) - 1] = '\0';
-      if (line[0])
-        g_tree_insert(self->tree, g_strdup(line), GINT_TO_POINTER(1));
-    }
-  fclose(stream);
+  self->list = list;
 
+  self->super.init = filter_in_list_init;
+  self->super.deinit = filter_in_list_deinit;
   self->super.eval = filter_in_list_eval;
   self->super.free_fn = filter_in_list_free;
   return &self->super;
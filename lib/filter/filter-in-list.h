@@ -25,8 +25,10 @@
 #define FILTER_IN_LIST_H_INCLUDED
 
 #include "filter-expr.h"
+#include "string-set.h"
 
 FilterExprNode *filter_in_list_new(const gchar *list_file,
-                                   const gchar *property);
+                                   const gchar *property,
+                                   StringSetMode mode);
 
 #endif
@@ -35,6 +35,23 @@ typedef struct _FilterNetmask
   struct in_addr netmask;
 } FilterNetmask;
 
+/* the address netmask() matches against, messages received locally are
+ * treated as if they were coming from the loopback address */
+struct in_addr *
+filter_netmask_get_msg_address(LogMessage *msg, struct in_addr *addr_storage)
+{
+  if (msg->saddr && g_sockaddr_inet_check(msg->saddr))
+    return &((struct sockaddr_in *) &msg->saddr->sa)->sin_addr;
+
+  if (!msg->saddr || msg->saddr->sa.sa_family == AF_UNIX)
+    {
+      addr_storage->s_addr = htonl(INADDR_LOOPBACK);
+      return addr_storage;
+    }
+
+  return NULL;
+}
+
 static gboolean
 filter_netmask_eval(FilterExprNode *s, LogMessage **msgs, gint num_msg, LogTemplateEvalOptions *options)
 {
@@ -43,19 +60,7 @@ filter_netmask_eval(FilterExprNode *s, LogMessage **msgs, gint num_msg, LogTempl
   LogMessage *msg = msgs[num_msg - 1];
   gboolean res;
 
-  if (msg->saddr && g_sockaddr_inet_check(msg->saddr))
-    {
-      addr = &((struct sockaddr_in *) &msg->saddr->sa)->sin_addr;
-    }
-  else if (!msg->saddr || msg->saddr->sa.sa_family == AF_UNIX)
-    {
-      addr_storage.s_addr = htonl(INADDR_LOOPBACK);
-      addr = &addr_storage;
-    }
-  else
-    {
-      addr = NULL;
-    }
+  addr = filter_netmask_get_msg_address(msg, &addr_storage);
 
   if (addr)
     res = ((addr->s_addr & self->netmask.s_addr) == (self->address.s_addr));
@@ -70,6 +75,20 @@ filter_netmask_eval(FilterExprNode *s, LogMessage **msgs, gint num_msg, LogTempl
   return res ^ s->comp;
 }
 
+/* returns the network of a netmask() filter that is not negated */
+gboolean
+filter_netmask_get_network(FilterExprNode *s, struct in_addr *address, struct in_addr *netmask)
+{
+  FilterNetmask *self = (FilterNetmask *) s;
+
+  if (s->eval != filter_netmask_eval || s->comp)
+    return FALSE;
+
+  *address = self->address;
+  *netmask = self->netmask;
+  return TRUE;
+}
+
 FilterExprNode *
 filter_netmask_new(const gchar *cidr)
 {
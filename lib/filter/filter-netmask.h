@@ -26,6 +26,10 @@
 
 #include "filter-expr.h"
 
+#include <netinet/in.h>
+
+struct in_addr *filter_netmask_get_msg_address(LogMessage *msg, struct in_addr *addr_storage);
+gboolean filter_netmask_get_network(FilterExprNode *s, struct in_addr *address, struct in_addr *netmask);
 FilterExprNode *filter_netmask_new(const gchar *cidr);
 
 #endif
@@ -21,11 +21,25 @@
  *
  */
 #include "filter-op.h"
+#include "filter-re.h"
+#include "logmatcher-hyperscan.h"
+#include "messages.h"
+
+typedef struct _FilterOpRegexpSet
+{
+  NVHandle value_handle;
+  LogMatcherHyperscanSet *set;
+} FilterOpRegexpSet;
 
 typedef struct _FilterOp
 {
   FilterExprNode super;
   FilterExprNode *left, *right;
+
+  /* OR chains are evaluated as a flat list of operands, sibling regexps
+   * on the same name-value pair are merged into multi-pattern sets */
+  GPtrArray *operands;
+  GArray *regexp_sets;
 } FilterOp;
 
 static gboolean
@@ -47,11 +61,42 @@ fop_init(FilterExprNode *s, GlobalConfig *cfg)
   return TRUE;
 }
 
+/* used by OR nodes too, operands merged or flattened at init are
+ * reachable through left/right as well */
+static void
+fop_deinit(FilterExprNode *s, GlobalConfig *cfg)
+{
+  FilterOp *self = (FilterOp *) s;
+
+  filter_expr_deinit(self->left, cfg);
+  filter_expr_deinit(self->right, cfg);
+}
+
+static void
+fop_or_free_operands(FilterOp *self)
+{
+#if SYSLOG_NG_ENABLE_HYPERSCAN
+  if (self->regexp_sets)
+    {
+      for (gint i = 0; i < self->regexp_sets->len; i++)
+        log_matcher_hyperscan_set_free(g_array_index(self->regexp_sets, FilterOpRegexpSet, i).set);
+      g_array_free(self->regexp_sets, TRUE);
+      self->regexp_sets = NULL;
+    }
+#endif
+  if (self->operands)
+    {
+      g_ptr_array_free(self->operands, TRUE);
+      self->operands = NULL;
+    }
+}
+
 static void
 fop_free(FilterExprNode *s)
 {
   FilterOp *self = (FilterOp *) s;
 
+  fop_or_free_operands(self);
   filter_expr_unref(self->left);
   filter_expr_unref(self->right);
   g_free((gchar *) self->super.type);
@@ -64,7 +109,8 @@ fop_clone(FilterExprNode *s)
   FilterOp *cloned_self = g_new0(FilterOp, 1);
   filter_expr_node_init_instance(&cloned_self->super);
 
-  cloned_self->super.init = fop_init;
+  cloned_self->super.init = self->super.init;
+  cloned_self->super.deinit = self->super.deinit;
   cloned_self->super.free_fn = fop_free;
   cloned_self->super.clone = fop_clone;
   cloned_self->super.eval = self->super.eval;
@@ -79,6 +125,7 @@ fop_init_instance(FilterOp *self)
 {
   filter_expr_node_init_instance(&self->super);
   self->super.init = fop_init;
+  self->super.deinit = fop_deinit;
   self->super.free_fn = fop_free;
   self->super.clone = fop_clone;
 }
@@ -88,8 +135,184 @@ fop_or_eval(FilterExprNode *s, LogMessage **msgs, gint num_msg, LogTemplateEvalO
 {
   FilterOp *self = (FilterOp *) s;
 
-  return (filter_expr_eval_with_context(self->left, msgs, num_msg, options)
-          || filter_expr_eval_with_context(self->right, msgs, num_msg, options)) ^ s->comp;
+  if (!self->operands)
+    return (filter_expr_eval_with_context(self->left, msgs, num_msg, options)
+            || filter_expr_eval_with_context(self->right, msgs, num_msg, options)) ^ s->comp;
+
+#if SYSLOG_NG_ENABLE_HYPERSCAN
+  if (self->regexp_sets)
+    {
+      LogMessage *msg = msgs[num_msg - 1];
+
+      for (gint i = 0; i < self->regexp_sets->len; i++)
+        {
+          FilterOpRegexpSet *regexp_set = &g_array_index(self->regexp_sets, FilterOpRegexpSet, i);
+
+          if (log_matcher_hyperscan_set_match_value(regexp_set->set, msg, regexp_set->value_handle))
+            return TRUE ^ s->comp;
+        }
+    }
+#endif
+
+  for (gint i = 0; i < self->operands->len; i++)
+    {
+      if (filter_expr_eval_with_context(g_ptr_array_index(self->operands, i), msgs, num_msg, options))
+        return TRUE ^ s->comp;
+    }
+  return FALSE ^ s->comp;
+}
+
+static void
+fop_or_collect_operands(FilterOp *self, GPtrArray *operands)
+{
+  FilterExprNode *children[] = { self->left, self->right };
+
+  for (gint i = 0; i < G_N_ELEMENTS(children); i++)
+    {
+      FilterExprNode *child = children[i];
+
+      if (child->eval == fop_or_eval && !child->comp)
+        fop_or_collect_operands((FilterOp *) child, operands);
+      else
+        g_ptr_array_add(operands, child);
+    }
+}
+
+#if SYSLOG_NG_ENABLE_HYPERSCAN
+
+static FilterOpRegexpSet *
+fop_or_lookup_regexp_set(GArray *regexp_sets, NVHandle value_handle)
+{
+  for (gint i = 0; i < regexp_sets->len; i++)
+    {
+      FilterOpRegexpSet *regexp_set = &g_array_index(regexp_sets, FilterOpRegexpSet, i);
+
+      if (regexp_set->value_handle == value_handle)
+        return regexp_set;
+    }
+
+  FilterOpRegexpSet new_set = { .value_handle = value_handle, .set = log_matcher_hyperscan_set_new() };
+  g_array_append_val(regexp_sets, new_set);
+  return &g_array_index(regexp_sets, FilterOpRegexpSet, regexp_sets->len - 1);
+}
+
+static gboolean
+fop_or_is_regexp_set_used(FilterOpRegexpSet *regexp_set)
+{
+  if (log_matcher_hyperscan_set_get_size(regexp_set->set) < 2)
+    return FALSE;
+
+  GError *error = NULL;
+  if (!log_matcher_hyperscan_set_compile(regexp_set->set, &error))
+    {
+      msg_debug("Error compiling multi-pattern database for regexp filters, evaluating them one-by-one",
+                evt_tag_msg_value_name("name", regexp_set->value_handle),
+                evt_tag_str("error", error->message));
+      g_clear_error(&error);
+      return FALSE;
+    }
+
+  msg_debug("Sibling regexp filters merged into a multi-pattern database",
+            evt_tag_msg_value_name("name", regexp_set->value_handle),
+            evt_tag_int("patterns", log_matcher_hyperscan_set_get_size(regexp_set->set)));
+  return TRUE;
+}
+
+/*
+ * Regexps on the same name-value pair are moved into a single Hyperscan
+ * database each, so that the value is scanned once instead of once per
+ * operand.  As this changes the order of evaluation, we only do this if
+ * none of the operands modify the message.  Operands that cannot be
+ * merged remain in the list and are evaluated after the sets.
+ */
+static void
+fop_or_merge_regexps(FilterOp *self)
+{
+  GArray *regexp_sets = g_array_new(FALSE, FALSE, sizeof(FilterOpRegexpSet));
+  gint operand_set_index[self->operands->len];
+
+  for (gint i = 0; i < self->operands->len; i++)
+    {
+      FilterExprNode *operand = g_ptr_array_index(self->operands, i);
+      NVHandle value_handle;
+      gint flags;
+
+      operand_set_index[i] = -1;
+
+      const gchar *pattern = filter_re_get_mergeable_pattern(operand, &value_handle, &flags);
+      if (!pattern)
+        continue;
+
+      FilterOpRegexpSet *regexp_set = fop_or_lookup_regexp_set(regexp_sets, value_handle);
+      if (log_matcher_hyperscan_set_add_pattern(regexp_set->set, pattern, flags, NULL))
+        operand_set_index[i] = regexp_set - (FilterOpRegexpSet *) regexp_sets->data;
+    }
+
+  GArray *used_sets = g_array_new(FALSE, FALSE, sizeof(FilterOpRegexpSet));
+  for (gint set_ndx = 0; set_ndx < regexp_sets->len; set_ndx++)
+    {
+      FilterOpRegexpSet *regexp_set = &g_array_index(regexp_sets, FilterOpRegexpSet, set_ndx);
+
+      if (!fop_or_is_regexp_set_used(regexp_set))
+        {
+          log_matcher_hyperscan_set_free(regexp_set->set);
+          continue;
+        }
+
+      g_array_append_val(used_sets, *regexp_set);
+      for (gint i = 0; i < self->operands->len; i++)
+        {
+          if (operand_set_index[i] == set_ndx)
+            g_ptr_array_index(self->operands, i) = NULL;
+        }
+    }
+  g_array_free(regexp_sets, TRUE);
+
+  if (used_sets->len == 0)
+    {
+      g_array_free(used_sets, TRUE);
+      return;
+    }
+
+  for (gint i = self->operands->len - 1; i >= 0; i--)
+    {
+      if (!g_ptr_array_index(self->operands, i))
+        g_ptr_array_remove_index(self->operands, i);
+    }
+  self->regexp_sets = used_sets;
+}
+
+#endif
+
+static gboolean
+fop_or_init(FilterExprNode *s, GlobalConfig *cfg)
+{
+  FilterOp *self = (FilterOp *) s;
+
+  g_assert(self->left);
+  g_assert(self->right);
+
+  fop_or_free_operands(self);
+  self->operands = g_ptr_array_new();
+  fop_or_collect_operands(self, self->operands);
+
+  /* nested OR nodes are not initialized, their operands are evaluated from here */
+  self->super.modify = FALSE;
+  for (gint i = 0; i < self->operands->len; i++)
+    {
+      FilterExprNode *operand = g_ptr_array_index(self->operands, i);
+
+      if (!filter_expr_init(operand, cfg))
+        return FALSE;
+      self->super.modify |= operand->modify;
+    }
+
+#if SYSLOG_NG_ENABLE_HYPERSCAN
+  if (!self->super.modify)
+    fop_or_merge_regexps(self);
+#endif
+
+  return TRUE;
 }
 
 FilterExprNode *
@@ -98,6 +321,7 @@ fop_or_new(FilterExprNode *e1, FilterExprNode *e2)
   FilterOp *self = g_new0(FilterOp, 1);
 
   fop_init_instance(self);
+  self->super.init = fop_or_init;
   self->super.eval = fop_or_eval;
   self->left = e1;
   self->right = e2;
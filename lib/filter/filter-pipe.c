@@ -52,6 +52,15 @@ log_filter_pipe_init(LogPipe *s)
   return TRUE;
 }
 
+static gboolean
+log_filter_pipe_deinit(LogPipe *s)
+{
+  LogFilterPipe *self = (LogFilterPipe *) s;
+
+  filter_expr_deinit(self->expr, log_pipe_get_config(s));
+  return TRUE;
+}
+
 static void
 log_filter_pipe_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
 {
@@ -123,6 +132,7 @@ log_filter_pipe_new(FilterExprNode *expr, GlobalConfig *cfg)
   log_pipe_init_instance(&self->super, cfg);
   self->super.flags |= PIF_CONFIG_RELATED + PIF_SYNC_FILTERX_TO_MSG;
   self->super.init = log_filter_pipe_init;
+  self->super.deinit = log_filter_pipe_deinit;
   self->super.queue = log_filter_pipe_queue;
   self->super.free_fn = log_filter_pipe_free;
   self->super.clone = log_filter_pipe_clone;
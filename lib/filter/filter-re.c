@@ -89,6 +89,56 @@ filter_re_compile_pattern(FilterExprNode *s, const gchar *re, GError **error)
   return log_matcher_compile(self->matcher, re, error);
 }
 
+/*
+ * Returns the pattern of an initialized regexp filter if it could be
+ * evaluated as part of a multi-pattern set on the same name-value pair:
+ * it is not negated, it is a regular expression and it does not store
+ * matches.  Returns NULL otherwise.
+ */
+const gchar *
+filter_re_get_mergeable_pattern(FilterExprNode *s, NVHandle *value_handle, gint *flags)
+{
+  FilterRE *self = (FilterRE *) s;
+
+  if (s->eval != filter_re_eval || s->comp || s->modify)
+    return NULL;
+
+  if (strcmp(self->matcher_options.type, "pcre") != 0 && strcmp(self->matcher_options.type, "hyperscan") != 0)
+    return NULL;
+
+  if (self->matcher_options.flags & LMF_STORE_MATCHES)
+    return NULL;
+
+  *value_handle = self->value_handle;
+  *flags = self->matcher_options.flags;
+  return self->matcher->pattern;
+}
+
+/*
+ * Returns the pattern of an initialized filter if it matches a name-value
+ * pair against a literal string as a whole: it is not negated, uses the
+ * string matcher without the prefix or substring flags.  Such filters can
+ * be replaced by a hash lookup on the value.  Returns NULL otherwise.
+ */
+const gchar *
+filter_re_get_exact_match(FilterExprNode *s, NVHandle *value_handle, gboolean *ignore_case)
+{
+  FilterRE *self = (FilterRE *) s;
+
+  if (s->eval != filter_re_eval || s->comp || s->modify)
+    return NULL;
+
+  if (strcmp(self->matcher_options.type, "string") != 0)
+    return NULL;
+
+  if (self->matcher_options.flags & (LMF_PREFIX | LMF_SUBSTRING | LMF_STORE_MATCHES))
+    return NULL;
+
+  *value_handle = self->value_handle;
+  *ignore_case = !!(self->matcher_options.flags & LMF_ICASE);
+  return self->matcher->pattern;
+}
+
 static void
 filter_re_init_instance(FilterRE *self, NVHandle value_handle)
 {
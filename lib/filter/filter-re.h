@@ -29,6 +29,8 @@
 
 LogMatcherOptions *filter_re_get_matcher_options(FilterExprNode *s);
 gboolean filter_re_compile_pattern(FilterExprNode *s, const gchar *re, GError **error);
+const gchar *filter_re_get_mergeable_pattern(FilterExprNode *s, NVHandle *value_handle, gint *flags);
+const gchar *filter_re_get_exact_match(FilterExprNode *s, NVHandle *value_handle, gboolean *ignore_case);
 
 FilterExprNode *filter_re_new(NVHandle value_handle);
 FilterExprNode *filter_source_new(void);
@@ -30,6 +30,8 @@
 #include "apphook.h"
 #include "plugin.h"
 #include "filter/filter-in-list.h"
+#include "filter/filter-expr-parser.h"
+#include "cfg-lexer.h"
 #include "msg-format.h"
 
 #include <stdlib.h>
@@ -66,7 +68,7 @@ Test(template_filters, test_filter_returns_false_when_list_is_empty)
 {
   gchar *list_file_with_zero_lines = g_strdup_printf(LIST_FILE_DIR "empty.list", top_srcdir);
 
-  cr_assert_not(evaluate_testcase(MSG_1, filter_in_list_new(list_file_with_zero_lines, "PROGRAM")),
+  cr_assert_not(evaluate_testcase(MSG_1, filter_in_list_new(list_file_with_zero_lines, "PROGRAM", STRING_SET_EXACT)),
                 "in-list filter matches");
 
   g_free(list_file_with_zero_lines);
@@ -75,7 +77,7 @@ Test(template_filters, test_filter_returns_false_when_list_is_empty)
 Test(template_filters, test_string_searched_for_is_not_in_the_list)
 {
   gchar *list_file_with_one_line = g_strdup_printf(LIST_FILE_DIR "test.list", top_srcdir);
-  cr_assert_not(evaluate_testcase(MSG_2, filter_in_list_new(list_file_with_one_line, "PROGRAM")),
+  cr_assert_not(evaluate_testcase(MSG_2, filter_in_list_new(list_file_with_one_line, "PROGRAM", STRING_SET_EXACT)),
                 "in-list filter matches");
   g_free(list_file_with_one_line);
 }
@@ -83,7 +85,7 @@ Test(template_filters, test_string_searched_for_is_not_in_the_list)
 Test(template_filters, test_given_macro_is_not_available_in_this_message)
 {
   gchar *list_file_with_one_line = g_strdup_printf(LIST_FILE_DIR "test.list", top_srcdir);
-  cr_assert_not(evaluate_testcase(MSG_2, filter_in_list_new(list_file_with_one_line, "FOO_MACRO")),
+  cr_assert_not(evaluate_testcase(MSG_2, filter_in_list_new(list_file_with_one_line, "FOO_MACRO", STRING_SET_EXACT)),
                 "in-list filter matches");
   g_free(list_file_with_one_line);
 }
@@ -91,7 +93,7 @@ Test(template_filters, test_given_macro_is_not_available_in_this_message)
 Test(template_filters, test_list_file_doesnt_exist)
 {
   gchar *list_file_which_doesnt_exist = g_strdup_printf(LIST_FILE_DIR "notexisting.list", top_srcdir);
-  cr_assert_null(filter_in_list_new(list_file_which_doesnt_exist, "PROGRAM"),
+  cr_assert_null(filter_in_list_new(list_file_which_doesnt_exist, "PROGRAM", STRING_SET_EXACT),
                  "in-list filter should fail, when the list file does not exist");
   g_free(list_file_which_doesnt_exist);
 }
@@ -99,7 +101,7 @@ Test(template_filters, test_list_file_doesnt_exist)
 Test(template_filters, test_list_file_contains_only_one_line)
 {
   gchar *list_file_with_one_line = g_strdup_printf(LIST_FILE_DIR "test.list", top_srcdir);
-  cr_assert(evaluate_testcase(MSG_1, filter_in_list_new(list_file_with_one_line, "PROGRAM")),
+  cr_assert(evaluate_testcase(MSG_1, filter_in_list_new(list_file_with_one_line, "PROGRAM", STRING_SET_EXACT)),
             "in-list filter matches");
   g_free(list_file_with_one_line);
 }
@@ -107,7 +109,7 @@ Test(template_filters, test_list_file_contains_only_one_line)
 Test(template_filters, test_list_file_contains_lot_of_lines)
 {
   gchar *list_file_which_has_a_lot_of_lines = g_strdup_printf(LIST_FILE_DIR "lot_of_lines.list", top_srcdir);
-  cr_assert(evaluate_testcase(MSG_1, filter_in_list_new(list_file_which_has_a_lot_of_lines, "PROGRAM")),
+  cr_assert(evaluate_testcase(MSG_1, filter_in_list_new(list_file_which_has_a_lot_of_lines, "PROGRAM", STRING_SET_EXACT)),
             "in-list filter matches");
   g_free(list_file_which_has_a_lot_of_lines);
 }
@@ -115,7 +117,7 @@ Test(template_filters, test_list_file_contains_lot_of_lines)
 Test(template_filters, test_filter_with_ip_address)
 {
   gchar *list_file_with_ip_address = g_strdup_printf(LIST_FILE_DIR "ip.list", top_srcdir);
-  cr_assert(evaluate_testcase(MSG_3, filter_in_list_new(list_file_with_ip_address, "HOST")),
+  cr_assert(evaluate_testcase(MSG_3, filter_in_list_new(list_file_with_ip_address, "HOST", STRING_SET_EXACT)),
             "in-list filter matches");
   g_free(list_file_with_ip_address);
 }
@@ -123,11 +125,73 @@ Test(template_filters, test_filter_with_ip_address)
 Test(template_filters, test_filter_with_long_line)
 {
   gchar *list_file_with_long_line = g_strdup_printf(LIST_FILE_DIR "long_line.list", top_srcdir);
-  cr_assert(evaluate_testcase(MSG_LONG, filter_in_list_new(list_file_with_long_line, "HOST")),
+  cr_assert(evaluate_testcase(MSG_LONG, filter_in_list_new(list_file_with_long_line, "HOST", STRING_SET_EXACT)),
             "in-list filter matches");
   g_free(list_file_with_long_line);
 }
 
+Test(template_filters, test_substring_mode_matches_if_the_value_contains_any_of_the_strings)
+{
+  gchar *list_file_with_substrings = g_strdup_printf(LIST_FILE_DIR "substring.list", top_srcdir);
+  cr_assert(evaluate_testcase(MSG_1, filter_in_list_new(list_file_with_substrings, "MESSAGE", STRING_SET_SUBSTRING)),
+            "in-list filter does not match");
+  cr_assert_not(evaluate_testcase(MSG_1, filter_in_list_new(list_file_with_substrings, "MESSAGE", STRING_SET_EXACT)),
+                "in-list filter matches");
+  cr_assert_not(evaluate_testcase(MSG_1, filter_in_list_new(list_file_with_substrings, "PROGRAM", STRING_SET_SUBSTRING)),
+                "in-list filter matches");
+  g_free(list_file_with_substrings);
+}
+
+static FilterExprNode *
+_compile_filter(const gchar *config_snippet)
+{
+  FilterExprNode *filter = NULL;
+  CfgLexer *lexer = cfg_lexer_new_buffer(configuration, config_snippet, strlen(config_snippet));
+
+  cr_assert(lexer, "Couldn't initialize a buffer for CfgLexer");
+  if (!cfg_run_parser(configuration, lexer, &filter_expr_parser, (gpointer *) &filter, NULL))
+    return NULL;
+  return filter;
+}
+
+Test(template_filters, test_substring_option_is_parsed_in_the_value_form)
+{
+  gchar *config_snippet = g_strdup_printf("in-list(\"" LIST_FILE_DIR "substring.list\" value(\"MESSAGE\") substring(yes))",
+                                          top_srcdir);
+  FilterExprNode *filter = _compile_filter(config_snippet);
+
+  cr_assert(evaluate_testcase(MSG_1, filter), "in-list filter does not match");
+  g_free(config_snippet);
+
+  config_snippet = g_strdup_printf("in-list(\"" LIST_FILE_DIR "substring.list\" value(\"MESSAGE\") nosuchoption(yes))",
+                                   top_srcdir);
+  cr_assert_null(_compile_filter(config_snippet), "unknown in-list() option accepted");
+  g_free(config_snippet);
+}
+
+/* substring is not a keyword in filters, the SCL uses it as a bare word */
+Test(template_filters, test_bare_substring_matcher_flag_still_parses)
+{
+  const gchar *scl_filters[] =
+  {
+    /* scl/cisco/plugin.conf */
+    "message(\": %\" type(string) flags(substring))",
+    /* scl/websense/plugin.conf */
+    "message(\"vendor=Websense\" type(string) flags(substring))",
+    /* scl/iptables/iptables.conf */
+    "facility(kern) and program(\"kernel\" type(string)) and message(\"PROTO=\" type(string) flags(substring))",
+    NULL
+  };
+
+  for (gint i = 0; scl_filters[i]; i++)
+    {
+      FilterExprNode *filter = _compile_filter(scl_filters[i]);
+
+      cr_assert_not_null(filter, "failed to parse filter: %s", scl_filters[i]);
+      filter_expr_unref(filter);
+    }
+}
+
 static void
 setup(void)
 {
@@ -387,3 +387,45 @@ Test(filter, test_match_with_template_non_trivial)
   filter_match_set_template_ref(filter, compile_template("$PID $PROGRAM"));
   testcase("<15>Oct 15 16:17:01 host openvpn[2499]: PTHREAD support initialized", filter, TRUE);
 }
+
+static FilterExprNode *
+_create_or_chain_of_message_regexps(const gchar *patterns[], gint flags[], gint num_patterns)
+{
+  FilterExprNode *chain = create_pcre_regexp_filter(LM_V_MESSAGE, patterns[0], flags[0]);
+
+  for (gint i = 1; i < num_patterns; i++)
+    chain = fop_or_new(chain, create_pcre_regexp_filter(LM_V_MESSAGE, patterns[i], flags[i]));
+  return chain;
+}
+
+Test(filter, test_or_chain_of_regexps_on_the_same_value)
+{
+  const gchar *msg = "<15>Oct 15 16:17:01 host openvpn[2499]: PTHREAD support initialized";
+  const gchar *patterns[] = { "^foo", "bar$", "(P)T\\1", "^pthread", "initialized$" };
+  gint flags[] = { 0, 0, 0, LMF_ICASE, 0 };
+
+  testcase(msg, _create_or_chain_of_message_regexps(patterns, flags, 5), TRUE);
+  testcase(msg, _create_or_chain_of_message_regexps(patterns, flags, 4), TRUE);
+
+  flags[3] = 0;
+  testcase(msg, _create_or_chain_of_message_regexps(patterns, flags, 4), FALSE);
+
+  /* operands that store matches are evaluated in order, one-by-one */
+  flags[0] = LMF_STORE_MATCHES;
+  testcase(msg, _create_or_chain_of_message_regexps(patterns, flags, 5), TRUE);
+}
+
+Test(filter, test_or_chain_of_regexps_mixed_with_other_filters)
+{
+  const gchar *msg = "<15>Oct 15 16:17:01 host openvpn[2499]: PTHREAD support initialized";
+
+  testcase(msg, fop_or_new(fop_or_new(create_pcre_regexp_filter(LM_V_MESSAGE, "^foo", 0),
+                                      create_pcre_regexp_filter(LM_V_PROGRAM, "^openvpn$", 0)),
+                           create_pcre_regexp_filter(LM_V_MESSAGE, "bar$", 0)), TRUE);
+  testcase(msg, fop_or_new(fop_or_new(create_pcre_regexp_filter(LM_V_MESSAGE, "^foo", 0),
+                                      create_pcre_regexp_filter(LM_V_PROGRAM, "^syslog$", 0)),
+                           create_pcre_regexp_filter(LM_V_MESSAGE, "bar$", 0)), FALSE);
+  testcase(msg, fop_and_new(fop_or_new(create_pcre_regexp_filter(LM_V_MESSAGE, "^foo", 0),
+                                       create_pcre_regexp_filter(LM_V_MESSAGE, "support", 0)),
+                            create_pcre_regexp_filter(LM_V_PROGRAM, "^openvpn$", 0)), TRUE);
+}
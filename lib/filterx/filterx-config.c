@@ -33,6 +33,7 @@ filterx_config_free(ModuleConfig *s)
   FilterXConfig *self = (FilterXConfig *) s;
 
   filterx_env_clear(&self->global_env);
+  g_free(self->jit_cache_dir);
   module_config_free_method(s);
 }
 
@@ -58,11 +59,11 @@ filterx_config_post_cfg_init(ModuleConfig *s, GlobalConfig *cfg)
 }
 
 static inline FilterXJIT *
-_create_jit(FilterXJITDebugInfo debug_info)
+_create_jit(FilterXConfig *self)
 {
 #if SYSLOG_NG_ENABLE_JIT
   GError *error = NULL;
-  FilterXJIT *jit = filterx_jit_new(FILTERX_JIT_MODULE_NAME, debug_info, &error);
+  FilterXJIT *jit = filterx_jit_new(FILTERX_JIT_MODULE_NAME, self->jit_debug_info, &error);
 
   if (!jit)
     {
@@ -71,6 +72,10 @@ _create_jit(FilterXJITDebugInfo debug_info)
       return NULL;
     }
 
+  if (self->jit_cache_dir)
+    filterx_jit_set_cache_dir(jit, self->jit_cache_dir);
+  filterx_jit_set_hot_threshold(jit, self->jit_hot_threshold);
+
   return jit;
 #else
   return NULL;
@@ -94,7 +99,7 @@ filterx_config_init(ModuleConfig *s, GlobalConfig *cfg)
     self->enable_jit = FALSE;
 
   if (self->enable_jit)
-    self->jit = _create_jit(self->jit_debug_info);
+    self->jit = _create_jit(self);
 
   return TRUE;
 }
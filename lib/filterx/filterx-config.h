@@ -35,6 +35,8 @@ typedef struct _FilterXConfig
   ModuleConfig super;
   gboolean enable_jit;
   FilterXJITDebugInfo jit_debug_info;
+  gchar *jit_cache_dir;
+  guint jit_hot_threshold;
   FilterXJIT *jit;
   /* config related objects, e.g. frozen string literals, etc */
   FilterXEnvironment global_env;
@@ -77,4 +79,17 @@ filterx_config_set_jit_debug_info(FilterXConfig *self, FilterXJITDebugInfo mode)
   self->jit_debug_info = mode;
 }
 
+static inline void
+filterx_config_set_jit_hot_threshold(FilterXConfig *self, guint hot_threshold)
+{
+  self->jit_hot_threshold = hot_threshold;
+}
+
+static inline void
+filterx_config_set_jit_cache_dir(FilterXConfig *self, const gchar *cache_dir)
+{
+  g_free(self->jit_cache_dir);
+  self->jit_cache_dir = g_strdup(cache_dir);
+}
+
 #endif
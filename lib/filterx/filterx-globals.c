@@ -54,6 +54,7 @@
 #include "filterx/func-digest.h"
 #include "filterx/func-encode.h"
 #include "filterx/func-glob.h"
+#include "filterx/func-in-list.h"
 #include "filterx/expr-regexp-search.h"
 #include "filterx/expr-regexp-subst.h"
 #include "filterx/expr-regexp.h"
@@ -186,6 +187,7 @@ _ctors_init(void)
   g_assert(filterx_builtin_function_ctor_register("set_timestamp", filterx_function_set_timestamp_new));
   g_assert(filterx_builtin_function_ctor_register("set_pri", filterx_function_set_pri_new));
   g_assert(filterx_builtin_function_ctor_register("cache_json_file", filterx_function_cache_json_file_new));
+  g_assert(filterx_builtin_function_ctor_register("in_list", filterx_function_in_list_new));
   g_assert(filterx_builtin_function_ctor_register("regexp_search", filterx_function_regexp_search_new));
   g_assert(filterx_builtin_function_ctor_register("failure_info_enable", filterx_fn_failure_info_enable_new));
   g_assert(filterx_builtin_function_ctor_register("failure_info_clear", filterx_fn_failure_info_clear_new));
@@ -34,6 +34,12 @@ typedef struct _LogFilterXPipe
   FilterXExpr *block;
   FilterXScopeVariableLayout *scope_var_layout;
   FilterXJITExecFunc jit_exec;
+
+  /* tiered JIT: the block is compiled after jit_hot_threshold interpreted executions */
+  gboolean jit_ir_generated;
+  FilterXJIT *jit;
+  guint jit_hot_threshold;
+  gint interpreted_executions;
 } LogFilterXPipe;
 
 static inline const gchar *
@@ -60,6 +66,7 @@ _compile_block(LogFilterXPipe *self, GlobalConfig *cfg)
   filterx_jit_ir_add_new_block(jit, _jit_block_name(self, block_name, G_N_ELEMENTS(block_name)));
   FilterXIRValue result = filterx_expr_compile(self->block, jit);
   filterx_jit_ir_finish_current_block(jit, result);
+  self->jit_ir_generated = TRUE;
 }
 
 static gboolean
@@ -99,6 +106,16 @@ _setup_jit_exec(LogPipe *s)
   if (!jit)
     return TRUE;
 
+  if (filterx_jit_get_hot_threshold(jit) > 0)
+    {
+      if (self->jit_ir_generated)
+        {
+          self->jit = jit;
+          self->jit_hot_threshold = filterx_jit_get_hot_threshold(jit);
+        }
+      return TRUE;
+    }
+
   GError *error = NULL;
   gchar block_name[1024];
   FilterXJITAddress addr = filterx_jit_lookup(jit, _jit_block_name(self, block_name, G_N_ELEMENTS(block_name)), &error);
@@ -129,6 +146,31 @@ log_filterx_pipe_deinit(LogPipe *s)
   return TRUE;
 }
 
+static inline FilterXJITExecFunc
+_get_jit_exec(LogFilterXPipe *self)
+{
+  FilterXJITExecFunc jit_exec = g_atomic_pointer_get(&self->jit_exec);
+
+  if (jit_exec || !self->jit_hot_threshold)
+    return jit_exec;
+
+  /* racy pre-check, so that we stop touching the counter once the compilation was requested */
+  if ((guint) g_atomic_int_get(&self->interpreted_executions) >= self->jit_hot_threshold)
+    return NULL;
+
+  if ((guint) g_atomic_int_add(&self->interpreted_executions, 1) + 1 == self->jit_hot_threshold)
+    {
+      gchar block_name[1024];
+
+      msg_debug("FilterX block got hot, compiling it in the background",
+                evt_tag_str("block", self->name),
+                log_pipe_location_tag(&self->super));
+      filterx_jit_compile_block_async(self->jit, _jit_block_name(self, block_name, G_N_ELEMENTS(block_name)),
+                                      &self->jit_exec);
+    }
+  return NULL;
+}
+
 static void
 log_filterx_pipe_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
 {
@@ -149,7 +191,7 @@ log_filterx_pipe_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_o
               log_pipe_location_tag(s),
               evt_tag_msg_reference(msg));
 
-    eval_res = filterx_eval_exec(&eval_context, self->block, self->jit_exec);
+    eval_res = filterx_eval_exec(&eval_context, self->block, _get_jit_exec(self));
 
     msg_trace("<<<<<< filterx rule evaluation result",
               filterx_format_eval_result(eval_res),
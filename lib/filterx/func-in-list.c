@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "filterx/func-in-list.h"
+#include "filterx/object-primitive.h"
+#include "filterx/object-extractor.h"
+#include "filterx/filterx-eval.h"
+#include "string-set.h"
+
+#define FILTERX_FUNC_IN_LIST_USAGE "Usage: in_list(string, \"/path/to/file\", substring=false)"
+
+typedef struct _FilterXFunctionInList
+{
+  FilterXFunction super;
+  FilterXExpr *value;
+  StringSetFile *list;
+} FilterXFunctionInList;
+
+static FilterXObject *
+_eval(FilterXExpr *s)
+{
+  FilterXFunctionInList *self = (FilterXFunctionInList *) s;
+
+  FilterXObject *obj = filterx_expr_eval(self->value);
+  if (!obj)
+    return NULL;
+
+  const gchar *str;
+  gsize len;
+  if (!filterx_object_extract_string_ref(obj, &str, &len))
+    {
+      filterx_eval_push_error("Failed to evaluate in_list(): value must be a string", self->value, obj);
+      filterx_object_unref(obj);
+      return NULL;
+    }
+
+  gboolean result = string_set_file_match(self->list, str, len);
+  filterx_object_unref(obj);
+  return filterx_boolean_new(result);
+}
+
+static gboolean
+_walk(FilterXExpr *s, FilterXExprWalkFunc f, gpointer user_data)
+{
+  FilterXFunctionInList *self = (FilterXFunctionInList *) s;
+
+  return filterx_expr_visit(s, &self->value, f, user_data);
+}
+
+static gboolean
+_init(FilterXExpr *s, GlobalConfig *cfg)
+{
+  FilterXFunctionInList *self = (FilterXFunctionInList *) s;
+
+  string_set_file_start_monitoring(self->list);
+  return filterx_function_init_method(&self->super, cfg);
+}
+
+static void
+_deinit(FilterXExpr *s, GlobalConfig *cfg)
+{
+  FilterXFunctionInList *self = (FilterXFunctionInList *) s;
+
+  string_set_file_stop_monitoring(self->list);
+  filterx_function_deinit_method(&self->super, cfg);
+}
+
+static void
+_free(FilterXExpr *s)
+{
+  FilterXFunctionInList *self = (FilterXFunctionInList *) s;
+
+  filterx_expr_unref(self->value);
+  string_set_file_free(self->list);
+  filterx_function_free_method(&self->super);
+}
+
+static gboolean
+_extract_args(FilterXFunctionInList *self, FilterXFunctionArgs *args, GError **error)
+{
+  if (filterx_function_args_len(args) != 2)
+    {
+      g_set_error(error, FILTERX_FUNCTION_ERROR, FILTERX_FUNCTION_ERROR_CTOR_FAIL,
+                  "invalid number of arguments. " FILTERX_FUNC_IN_LIST_USAGE);
+      return FALSE;
+    }
+
+  const gchar *filename = filterx_function_args_get_literal_string(args, 1, NULL);
+  if (!filename)
+    {
+      g_set_error(error, FILTERX_FUNCTION_ERROR, FILTERX_FUNCTION_ERROR_CTOR_FAIL,
+                  "file argument must be string literal. " FILTERX_FUNC_IN_LIST_USAGE);
+      return FALSE;
+    }
+
+  gboolean exists, eval_error;
+  gboolean substring = filterx_function_args_get_named_literal_boolean(args, "substring", &exists, &eval_error);
+  if (eval_error)
+    {
+      g_set_error(error, FILTERX_FUNCTION_ERROR, FILTERX_FUNCTION_ERROR_CTOR_FAIL,
+                  "substring argument must be boolean literal. " FILTERX_FUNC_IN_LIST_USAGE);
+      return FALSE;
+    }
+
+  GError *local_error = NULL;
+  self->list = string_set_file_new(filename, exists && substring ? STRING_SET_SUBSTRING : STRING_SET_EXACT,
+                                   &local_error);
+  if (!self->list)
+    {
+      g_set_error(error, FILTERX_FUNCTION_ERROR, FILTERX_FUNCTION_ERROR_CTOR_FAIL,
+                  "failed to load file: %s (%s)", filename, local_error->message);
+      g_clear_error(&local_error);
+      return FALSE;
+    }
+
+  self->value = filterx_function_args_get_expr(args, 0);
+  return filterx_function_args_check(args, error);
+}
+
+/* in_list(value, "/path/to/file", substring=false)
+ *
+ * Returns TRUE if the value is one of the lines of the file, or with
+ * substring=true, if it contains any of them.  The file is reloaded when
+ * it changes while the configuration is running.
+ */
+FilterXExpr *
+filterx_function_in_list_new(FilterXFunctionArgs *args, GError **error)
+{
+  FilterXFunctionInList *self = g_new0(FilterXFunctionInList, 1);
+
+  filterx_function_init_instance(&self->super, "in_list", FXE_READ);
+  self->super.super.eval = _eval;
+  self->super.super.walk_children = _walk;
+  self->super.super.init = _init;
+  self->super.super.deinit = _deinit;
+  self->super.super.free_fn = _free;
+
+  if (!_extract_args(self, args, error))
+    goto error;
+
+  filterx_function_args_free(args);
+  return &self->super.super;
+
+error:
+  filterx_function_args_free(args);
+  filterx_expr_unref(&self->super.super);
+  return NULL;
+}
@@ -93,6 +93,9 @@ _emit_call(FilterXJIT *jit, FilterXJITFFICall c, FilterXIRValue *args, unsigned
 FilterXIRValue
 fx_jit_emit_const_ptr(FilterXJIT *jit, gconstpointer p)
 {
+  if (jit->cache_dir && p)
+    return filterx_jit_ir_get_address_symbol(jit, p);
+
   LLVMTypeRef ptr_sized_int = LLVMIntTypeInContext(jit->ctx, sizeof(gconstpointer) * 8);
   return LLVMConstIntToPtr(LLVMConstInt(ptr_sized_int, (guintptr) p, FALSE), jit->ffi.ptr_ty);
 }
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "filterx/jit/jit-cache.h"
+
+#if SYSLOG_NG_ENABLE_JIT
+
+#include "messages.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-single.h"
+
+#include <llvm-c/Core.h>
+#include <llvm-c/BitWriter.h>
+#include <llvm/Config/llvm-config.h>
+
+#include <string.h>
+#include <errno.h>
+#include <glib/gstdio.h>
+
+#define FILTERX_JIT_CACHE_MAGIC "FXJITOBJ"
+#define FILTERX_JIT_CACHE_VERSION 1
+
+typedef struct _FilterXJITCacheHeader
+{
+  gchar magic[8];
+  guint32 version;
+  guint32 reserved;
+  guint64 compile_time_usec;
+} FilterXJITCacheHeader;
+
+static StatsCounterItem *cache_hits;
+static StatsCounterItem *cache_misses;
+static StatsCounterItem *cache_saved_compile_time;
+
+static void
+_checksum_update_string(GChecksum *checksum, const gchar *str)
+{
+  /* include the terminating NUL, so that "ab" + "c" differs from "a" + "bc" */
+  g_checksum_update(checksum, (const guchar *) (str ? : ""), str ? strlen(str) + 1 : 1);
+}
+
+static void
+_checksum_update_llvm_string(GChecksum *checksum, gchar *str)
+{
+  _checksum_update_string(checksum, str);
+  LLVMDisposeMessage(str);
+}
+
+gchar *
+filterx_jit_cache_compute_key(LLVMModuleRef mod, LLVMTargetMachineRef tm)
+{
+  GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA256);
+
+  _checksum_update_string(checksum, SYSLOG_NG_VERSION);
+  _checksum_update_string(checksum, LLVM_VERSION_STRING);
+  _checksum_update_llvm_string(checksum, LLVMGetTargetMachineTriple(tm));
+  _checksum_update_llvm_string(checksum, LLVMGetTargetMachineCPU(tm));
+  _checksum_update_llvm_string(checksum, LLVMGetTargetMachineFeatureString(tm));
+  _checksum_update_string(checksum, g_getenv("SYSLOG_NG_FILTERX_JIT_PASSES"));
+
+  LLVMMemoryBufferRef bitcode = LLVMWriteBitcodeToMemoryBuffer(mod);
+  g_checksum_update(checksum, (const guchar *) LLVMGetBufferStart(bitcode), LLVMGetBufferSize(bitcode));
+  LLVMDisposeMemoryBuffer(bitcode);
+
+  gchar *key = g_strdup(g_checksum_get_string(checksum));
+  g_checksum_free(checksum);
+  return key;
+}
+
+static gchar *
+_format_object_path(const gchar *cache_dir, const gchar *key)
+{
+  gchar *file_name = g_strdup_printf("%s.o", key);
+  gchar *path = g_build_filename(cache_dir, file_name, NULL);
+
+  g_free(file_name);
+  return path;
+}
+
+static gboolean
+_validate_header(const FilterXJITCacheHeader *header, gsize len)
+{
+  return len > sizeof(*header)
+         && memcmp(header->magic, FILTERX_JIT_CACHE_MAGIC, sizeof(header->magic)) == 0
+         && header->version == FILTERX_JIT_CACHE_VERSION;
+}
+
+/* returns an object buffer to be passed to ORC, or NULL if it is not cached */
+LLVMMemoryBufferRef
+filterx_jit_cache_load(const gchar *cache_dir, const gchar *key)
+{
+  gchar *path = _format_object_path(cache_dir, key);
+  gchar *contents = NULL;
+  gsize len = 0;
+  LLVMMemoryBufferRef object = NULL;
+
+  if (!g_file_get_contents(path, &contents, &len, NULL))
+    goto exit;
+
+  const FilterXJITCacheHeader *header = (const FilterXJITCacheHeader *) contents;
+  if (!_validate_header(header, len))
+    {
+      msg_warning("FilterX JIT cache entry is invalid, ignoring",
+                  evt_tag_str("filename", path));
+      goto exit;
+    }
+
+  object = LLVMCreateMemoryBufferWithMemoryRangeCopy(contents + sizeof(*header), len - sizeof(*header), key);
+  stats_counter_add(cache_saved_compile_time, header->compile_time_usec / 1000);
+
+  msg_debug("FilterX JIT module loaded from cache",
+            evt_tag_str("filename", path),
+            evt_tag_long("saved_compile_time_usec", header->compile_time_usec));
+
+exit:
+  if (object)
+    stats_counter_inc(cache_hits);
+  else
+    stats_counter_inc(cache_misses);
+
+  g_free(contents);
+  g_free(path);
+  return object;
+}
+
+void
+filterx_jit_cache_store(const gchar *cache_dir, const gchar *key, LLVMMemoryBufferRef object,
+                        gint64 compile_time_usec)
+{
+  if (g_mkdir_with_parents(cache_dir, 0700) < 0)
+    {
+      msg_error("Error creating FilterX JIT cache directory",
+                evt_tag_str("dir", cache_dir),
+                evt_tag_error("error"));
+      return;
+    }
+
+  FilterXJITCacheHeader header = { .version = FILTERX_JIT_CACHE_VERSION, .compile_time_usec = compile_time_usec };
+  memcpy(header.magic, FILTERX_JIT_CACHE_MAGIC, sizeof(header.magic));
+
+  gsize object_len = LLVMGetBufferSize(object);
+  GString *contents = g_string_sized_new(sizeof(header) + object_len);
+  g_string_append_len(contents, (const gchar *) &header, sizeof(header));
+  g_string_append_len(contents, LLVMGetBufferStart(object), object_len);
+
+  /* g_file_set_contents() writes a temporary file and renames it, so readers never see partial objects */
+  gchar *path = _format_object_path(cache_dir, key);
+  GError *error = NULL;
+  if (!g_file_set_contents(path, contents->str, contents->len, &error))
+    {
+      msg_error("Error storing FilterX JIT module in cache",
+                evt_tag_str("filename", path),
+                evt_tag_str("error", error->message));
+      g_clear_error(&error);
+    }
+  else
+    {
+      msg_debug("FilterX JIT module stored in cache",
+                evt_tag_str("filename", path),
+                evt_tag_long("compile_time_usec", compile_time_usec));
+    }
+
+  g_free(path);
+  g_string_free(contents, TRUE);
+}
+
+static void
+_format_saved_compile_time_key(StatsClusterKey *sc_key)
+{
+  stats_cluster_single_key_set(sc_key, METRIC(filterx_jit_cache_saved_compile_time_seconds), NULL, 0);
+  stats_cluster_key_add_unit(sc_key, SCU_MILLISECONDS);
+}
+
+void
+filterx_jit_cache_global_init(void)
+{
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, METRIC(filterx_jit_cache_hits_total), NULL, 0);
+  stats_register_counter(STATS_LEVEL0, &sc_key, SC_TYPE_SINGLE_VALUE, &cache_hits);
+
+  stats_cluster_single_key_set(&sc_key, METRIC(filterx_jit_cache_misses_total), NULL, 0);
+  stats_register_counter(STATS_LEVEL0, &sc_key, SC_TYPE_SINGLE_VALUE, &cache_misses);
+
+  _format_saved_compile_time_key(&sc_key);
+  stats_register_counter(STATS_LEVEL0, &sc_key, SC_TYPE_SINGLE_VALUE, &cache_saved_compile_time);
+  stats_unlock();
+}
+
+void
+filterx_jit_cache_global_deinit(void)
+{
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, METRIC(filterx_jit_cache_hits_total), NULL, 0);
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &cache_hits);
+
+  stats_cluster_single_key_set(&sc_key, METRIC(filterx_jit_cache_misses_total), NULL, 0);
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &cache_misses);
+
+  _format_saved_compile_time_key(&sc_key);
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &cache_saved_compile_time);
+  stats_unlock();
+}
+
+#endif
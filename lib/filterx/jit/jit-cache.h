@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef FILTERX_JIT_CACHE_H
+#define FILTERX_JIT_CACHE_H
+
+#include "syslog-ng.h"
+
+#if SYSLOG_NG_ENABLE_JIT
+
+#include <llvm-c/Types.h>
+#include <llvm-c/TargetMachine.h>
+
+/*
+ * On-disk cache of compiled FilterX JIT modules.
+ *
+ * Objects are keyed by a hash of the module's bitcode, the LLVM version
+ * and the target (triple, CPU, features), so that a configuration
+ * (re)load with unchanged FilterX blocks can skip optimization and code
+ * generation.  The module must not contain process specific addresses,
+ * see filterx_jit_ir_get_address_symbol().
+ */
+
+gchar *filterx_jit_cache_compute_key(LLVMModuleRef mod, LLVMTargetMachineRef tm);
+LLVMMemoryBufferRef filterx_jit_cache_load(const gchar *cache_dir, const gchar *key);
+void filterx_jit_cache_store(const gchar *cache_dir, const gchar *key, LLVMMemoryBufferRef object,
+                             gint64 compile_time_usec);
+
+void filterx_jit_cache_global_init(void);
+void filterx_jit_cache_global_deinit(void);
+
+#endif
+
+#endif
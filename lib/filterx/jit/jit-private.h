@@ -53,6 +53,18 @@ struct _FilterXJIT
 
   FilterXJITFFI ffi;
 
+  /* object cache, process specific addresses are referenced through symbols */
+  gchar *cache_dir;
+  GHashTable *address_symbols;
+  GPtrArray *addresses;
+
+  /* tiered compilation, see filterx_jit_compile_block_async() */
+  guint hot_threshold;
+  GThreadPool *compile_pool;
+  gint compile_pool_shutdown;
+  GHashTable *block_names;
+  GHashTable *compiled_blocks;
+
   FilterXJITDebugInfo debug_info_mode;
   LLVMDIBuilderRef debug;
   gint debug_ir_text_memfd;
@@ -60,6 +72,8 @@ struct _FilterXJIT
   gboolean mod_finalized;
 };
 
+FilterXIRValue filterx_jit_ir_get_address_symbol(FilterXJIT *self, gconstpointer p);
+
 #else
 
 struct _FilterXJIT
@@ -23,6 +23,7 @@
 #include "filterx/jit/jit.h"
 #include "filterx/jit/jit-private.h"
 #include "filterx/jit/bc-loader.h"
+#include "filterx/jit/jit-cache.h"
 #include "filterx/jit/ffi.h"
 #include "filterx/filterx-scope-var-layout.h"
 #include "messages.h"
@@ -47,6 +48,7 @@
 #include <unistd.h>
 #include <sys/mman.h>
 
+#define ADDRESS_SYMBOL_PREFIX "fx_jit_address_"
 #define DEBUG_VERSION_KEY "Debug Info Version"
 #define DWARF_VERSION_KEY "Dwarf Version"
 
@@ -117,6 +119,33 @@ filterx_jit_get_ir_builder(FilterXJIT *self)
   return self->ir;
 }
 
+/*
+ * Pointers embedded in the IR (e.g. FilterXExpr instances) are different
+ * on each configuration load, so they are referenced through external
+ * symbols, which are defined as absolute symbols in filterx_jit_finalize().
+ * This makes the module (and its compiled object) cacheable.
+ */
+FilterXIRValue
+filterx_jit_ir_get_address_symbol(FilterXJIT *self, gconstpointer p)
+{
+  g_assert(!self->mod_finalized);
+
+  LLVMValueRef symbol = g_hash_table_lookup(self->address_symbols, p);
+  if (symbol)
+    return symbol;
+
+  gchar name[64];
+  g_snprintf(name, sizeof(name), ADDRESS_SYMBOL_PREFIX "%u", self->addresses->len);
+
+  /* a zero sized array does not let LLVM assume anything about the pointed object */
+  symbol = LLVMAddGlobal(self->mod, LLVMArrayType(LLVMInt8TypeInContext(self->ctx), 0), name);
+  LLVMSetLinkage(symbol, LLVMExternalLinkage);
+
+  g_hash_table_insert(self->address_symbols, (gpointer) p, symbol);
+  g_ptr_array_add(self->addresses, (gpointer) p);
+  return symbol;
+}
+
 static inline LLVMMetadataRef
 _create_debug_info_block(FilterXJIT *self, const gchar *block_name, const gchar *file, gint line)
 {
@@ -213,6 +242,7 @@ filterx_jit_ir_add_new_block(FilterXJIT *self, const gchar *block_name)
 
   gchar *fqn = _create_fully_qualified_block_name(self, block_name);
   self->current_ir_block = LLVMAddFunction(self->mod, fqn, _block_function_type(self));
+  g_hash_table_add(self->block_names, g_strdup(LLVMGetValueName(self->current_ir_block)));
   _set_unwind_attributes(self, self->current_ir_block);
   _inherit_libfilterx_function_attributes(self, self->current_ir_block);
   g_free(fqn);
@@ -413,6 +443,267 @@ _link_libfilterx(FilterXJIT *self, GError **error)
   return TRUE;
 }
 
+static gboolean
+_define_address_symbols(FilterXJIT *self, GError **error)
+{
+  if (!self->addresses || self->addresses->len == 0)
+    return TRUE;
+
+  LLVMJITCSymbolMapPair *symbols = g_new0(LLVMJITCSymbolMapPair, self->addresses->len);
+  for (guint i = 0; i < self->addresses->len; i++)
+    {
+      gchar name[64];
+      g_snprintf(name, sizeof(name), ADDRESS_SYMBOL_PREFIX "%u", i);
+
+      symbols[i].Name = LLVMOrcLLJITMangleAndIntern(self->j, name);
+      symbols[i].Sym.Address = (LLVMOrcExecutorAddress) (guintptr) g_ptr_array_index(self->addresses, i);
+      symbols[i].Sym.Flags.GenericFlags = LLVMJITSymbolGenericFlagsExported;
+    }
+
+  /* the symbol names are consumed */
+  LLVMOrcMaterializationUnitRef mu = LLVMOrcAbsoluteSymbols(symbols, self->addresses->len);
+  g_free(symbols);
+
+  LLVMErrorRef err = LLVMOrcJITDylibDefine(LLVMOrcLLJITGetMainJITDylib(self->j), mu);
+  if (err)
+    {
+      LLVMOrcDisposeMaterializationUnit(mu);
+      _llvm_error_to_fxjit_error(err, error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static inline gboolean
+_is_cache_enabled(FilterXJIT *self)
+{
+  /* LLVM IR debug info refers to a per-process memfd, it would never be a hit */
+  return self->cache_dir && self->debug_info_mode != FILTERX_JIT_DEBUG_INFO_LLVM_IR;
+}
+
+static LLVMMemoryBufferRef
+_compile_to_object(FilterXJIT *self, LLVMModuleRef mod, GError **error)
+{
+  LLVMErrorRef err = _optimize_module(self, mod);
+  if (err)
+    {
+      _llvm_error_to_fxjit_error(err, error);
+      return NULL;
+    }
+
+  LLVMMemoryBufferRef object = NULL;
+  gchar *error_msg = NULL;
+  if (LLVMTargetMachineEmitToMemoryBuffer(self->tm, mod, LLVMObjectFile, &error_msg, &object))
+    {
+      _fxjit_error(error_msg, error);
+      LLVMDisposeMessage(error_msg);
+      return NULL;
+    }
+
+  return object;
+}
+
+/* mod is consumed on success */
+static gboolean
+_add_module_with_cache(FilterXJIT *self, LLVMModuleRef mod, GError **error)
+{
+  gchar *key = filterx_jit_cache_compute_key(mod, self->tm);
+  LLVMMemoryBufferRef object = filterx_jit_cache_load(self->cache_dir, key);
+
+  if (!object)
+    {
+      gint64 start = g_get_monotonic_time();
+      object = _compile_to_object(self, mod, error);
+      if (!object)
+        {
+          g_free(key);
+          return FALSE;
+        }
+      filterx_jit_cache_store(self->cache_dir, key, object, g_get_monotonic_time() - start);
+    }
+  g_free(key);
+
+  /* object is consumed */
+  LLVMOrcJITDylibRef jit_dylib = LLVMOrcLLJITGetMainJITDylib(self->j);
+  LLVMErrorRef err = LLVMOrcLLJITAddObjectFile(self->j, jit_dylib, object);
+  if (err)
+    {
+      _llvm_error_to_fxjit_error(err, error);
+      return FALSE;
+    }
+
+  LLVMDisposeModule(mod);
+  return TRUE;
+}
+
+/*
+ * Tiered compilation
+ *
+ * Blocks are executed by the interpreter until they get hot, then they are
+ * compiled one-by-one on a background thread.  The finalized module is kept
+ * as the source of the per-block modules, it is only accessed from the
+ * compiler thread from that point on.
+ */
+
+typedef struct _FilterXJITCompileRequest
+{
+  gchar *block_name;
+  FilterXJITExecFunc *exec_func;
+} FilterXJITCompileRequest;
+
+static void
+_compile_request_free(FilterXJITCompileRequest *request)
+{
+  g_free(request->block_name);
+  g_free(request);
+}
+
+/* clone the module, keeping only a single block, the rest of the code is internalized for the optimizer */
+static LLVMModuleRef
+_extract_block_module(FilterXJIT *self, const gchar *fqn)
+{
+  LLVMValueRef block = LLVMGetNamedFunction(self->mod, fqn);
+  if (!block || LLVMIsDeclaration(block))
+    return NULL;
+
+  LLVMModuleRef mod = LLVMCloneModule(self->mod);
+
+  LLVMValueRef fn = LLVMGetFirstFunction(mod);
+  while (fn)
+    {
+      LLVMValueRef next = LLVMGetNextFunction(fn);
+      const gchar *name = LLVMGetValueName(fn);
+
+      if (strcmp(name, fqn) != 0)
+        {
+          if (g_hash_table_contains(self->block_names, name))
+            LLVMDeleteFunction(fn);
+          else if (!LLVMIsDeclaration(fn) && LLVMGetLinkage(fn) == LLVMExternalLinkage)
+            LLVMSetLinkage(fn, LLVMInternalLinkage);
+        }
+      fn = next;
+    }
+
+  for (LLVMValueRef g = LLVMGetFirstGlobal(mod); g; g = LLVMGetNextGlobal(g))
+    {
+      if (!LLVMIsDeclaration(g) && LLVMGetLinkage(g) == LLVMExternalLinkage)
+        LLVMSetLinkage(g, LLVMInternalLinkage);
+    }
+
+  return mod;
+}
+
+static gboolean
+_add_block_module(FilterXJIT *self, const gchar *fqn, GError **error)
+{
+  if (g_hash_table_contains(self->compiled_blocks, fqn))
+    return TRUE;
+
+  LLVMModuleRef mod = _extract_block_module(self, fqn);
+  if (!mod)
+    {
+      _fxjit_error("No IR code was generated for the block", error);
+      return FALSE;
+    }
+
+  if (_is_cache_enabled(self))
+    {
+      if (!_add_module_with_cache(self, mod, error))
+        {
+          LLVMDisposeModule(mod);
+          return FALSE;
+        }
+    }
+  else
+    {
+      LLVMOrcThreadSafeModuleRef ts_mod = LLVMOrcCreateNewThreadSafeModule(mod, self->ts_ctx);
+      LLVMErrorRef err = LLVMOrcLLJITAddLLVMIRModule(self->j, LLVMOrcLLJITGetMainJITDylib(self->j), ts_mod);
+      if (err)
+        {
+          _llvm_error_to_fxjit_error(err, error);
+          LLVMOrcDisposeThreadSafeModule(ts_mod);
+          return FALSE;
+        }
+    }
+
+  g_hash_table_add(self->compiled_blocks, g_strdup(fqn));
+  return TRUE;
+}
+
+/* runs in the compiler thread */
+static void
+_compile_block_worker(gpointer data, gpointer user_data)
+{
+  FilterXJITCompileRequest *request = (FilterXJITCompileRequest *) data;
+  FilterXJIT *self = (FilterXJIT *) user_data;
+
+  if (g_atomic_int_get(&self->compile_pool_shutdown))
+    goto exit;
+
+  gint64 start = g_get_monotonic_time();
+  GError *error = NULL;
+  gchar *fqn = _create_fully_qualified_block_name(self, request->block_name);
+
+  /* the lookup materializes (optimizes and compiles) the module */
+  FilterXJITAddress addr = 0;
+  if (_add_block_module(self, fqn, &error))
+    addr = filterx_jit_lookup(self, request->block_name, &error);
+  g_free(fqn);
+
+  if (!addr)
+    {
+      msg_warning("FilterX JIT compilation of hot block failed, continuing with interpreted evaluation",
+                  evt_tag_str("block", request->block_name),
+                  evt_tag_str("error", error ? error->message : "unknown"));
+      g_clear_error(&error);
+      goto exit;
+    }
+
+  g_atomic_pointer_set(request->exec_func, (FilterXJITExecFunc) addr);
+
+  msg_debug("FilterX block JIT compiled",
+            evt_tag_str("block", request->block_name),
+            evt_tag_str("module_name", self->mod_name),
+            evt_tag_long("compile_time_usec", g_get_monotonic_time() - start));
+
+exit:
+  _compile_request_free(request);
+}
+
+/*
+ * Compiles the block in the background and stores the address of the
+ * compiled function in *exec_func once it is ready.  The storage behind
+ * exec_func must be valid until filterx_jit_free() is called.
+ */
+void
+filterx_jit_compile_block_async(FilterXJIT *self, const gchar *block_name, FilterXJITExecFunc *exec_func)
+{
+  g_assert(self->mod_finalized && self->compile_pool);
+
+  FilterXJITCompileRequest *request = g_new0(FilterXJITCompileRequest, 1);
+  request->block_name = g_strdup(block_name);
+  request->exec_func = exec_func;
+
+  g_thread_pool_push(self->compile_pool, request, NULL);
+}
+
+void
+filterx_jit_set_hot_threshold(FilterXJIT *self, guint hot_threshold)
+{
+  g_assert(!self->mod_finalized);
+
+  self->hot_threshold = hot_threshold;
+  if (hot_threshold > 0 && !self->compile_pool)
+    self->compile_pool = g_thread_pool_new(_compile_block_worker, self, 1, FALSE, NULL);
+}
+
+guint
+filterx_jit_get_hot_threshold(FilterXJIT *self)
+{
+  return self->hot_threshold;
+}
+
 gboolean
 filterx_jit_finalize(FilterXJIT *self, GError **error)
 {
@@ -436,6 +727,29 @@ filterx_jit_finalize(FilterXJIT *self, GError **error)
   if (!_verify_module(self, error))
     return FALSE;
 
+  if (!_define_address_symbols(self, error))
+    return FALSE;
+
+  if (self->hot_threshold > 0)
+    {
+      msg_trace("FilterXJIT finalized, blocks are compiled once they get hot",
+                evt_tag_str("module_name", self->mod_name),
+                evt_tag_int("hot_threshold", self->hot_threshold));
+      self->mod_finalized = TRUE;
+      return TRUE;
+    }
+
+  if (_is_cache_enabled(self))
+    {
+      if (!_add_module_with_cache(self, self->mod, error))
+        return FALSE;
+
+      self->mod = NULL;
+      msg_trace("FilterXJIT finalized from object", evt_tag_str("module_name", self->mod_name));
+      self->mod_finalized = TRUE;
+      return TRUE;
+    }
+
   LLVMOrcThreadSafeModuleRef ts_mod = LLVMOrcCreateNewThreadSafeModule(self->mod, self->ts_ctx);
 
   LLVMOrcJITDylibRef jit_dylib = LLVMOrcLLJITGetMainJITDylib(self->j);
@@ -448,6 +762,9 @@ filterx_jit_finalize(FilterXJIT *self, GError **error)
       return FALSE;
     }
 
+  /* the module is owned by the JIT from now on */
+  self->mod = NULL;
+
   msg_trace("FilterXJIT finalized", evt_tag_str("module_name", self->mod_name));
 
   self->mod_finalized = TRUE;
@@ -585,6 +902,16 @@ _setup_debug_info(FilterXJIT *self, LLVMOrcLLJITBuilderRef jit_builder)
                                  0, "", 0, LLVMDWARFEmissionFull, 0, FALSE, FALSE, "", 0, "", 0);
 }
 
+void
+filterx_jit_set_cache_dir(FilterXJIT *self, const gchar *cache_dir)
+{
+  g_assert(!self->mod_finalized);
+  g_assert(self->addresses->len == 0);
+
+  g_free(self->cache_dir);
+  self->cache_dir = g_strdup(cache_dir);
+}
+
 FilterXJIT *
 filterx_jit_new(const gchar *module_name, FilterXJITDebugInfo debug_info, GError **error)
 {
@@ -594,6 +921,10 @@ filterx_jit_new(const gchar *module_name, FilterXJITDebugInfo debug_info, GError
   self->mod_name = g_strdup(module_name);
   self->debug_info_mode = debug_info;
   self->debug_ir_text_memfd = -1;
+  self->address_symbols = g_hash_table_new(g_direct_hash, g_direct_equal);
+  self->addresses = g_ptr_array_new();
+  self->block_names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  self->compiled_blocks = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 
 #if SYSLOG_NG_HAVE_DECL_LLVMORCCREATENEWTHREADSAFECONTEXTFROMLLVMCONTEXT
   self->ctx = LLVMContextCreate();
@@ -647,6 +978,13 @@ filterx_jit_free(FilterXJIT *self)
   if (!self)
     return;
 
+  if (self->compile_pool)
+    {
+      /* pending requests are dropped, a running compilation is waited for */
+      g_atomic_int_set(&self->compile_pool_shutdown, TRUE);
+      g_thread_pool_free(self->compile_pool, FALSE, TRUE);
+    }
+
   if (self->debug)
     LLVMDisposeDIBuilder(self->debug);
   if (self->j)
@@ -655,7 +993,7 @@ filterx_jit_free(FilterXJIT *self)
     LLVMDisposeTargetMachine(self->tm);
   LLVMDisposeBuilder(self->ir);
   self->ctx = NULL;
-  if (!self->mod_finalized)
+  if (self->mod)
     LLVMDisposeModule(self->mod);
   if (self->libfilterx)
     LLVMDisposeModule(self->libfilterx);
@@ -666,6 +1004,11 @@ filterx_jit_free(FilterXJIT *self)
 
   msg_trace("FilterXJIT destroyed", evt_tag_str("module_name", self->mod_name));
 
+  g_hash_table_destroy(self->address_symbols);
+  g_ptr_array_free(self->addresses, TRUE);
+  g_hash_table_destroy(self->block_names);
+  g_hash_table_destroy(self->compiled_blocks);
+  g_free(self->cache_dir);
   g_free(self->mod_name);
   g_free(self);
 }
@@ -675,6 +1018,7 @@ filterx_jit_global_init(void)
 {
   LLVMInitializeNativeTarget();
   LLVMInitializeNativeAsmPrinter();
+  filterx_jit_cache_global_init();
 
   /* For debugging: -time-passes -pass-remarks=inline -pass-remarks-missed=inline -pass-remarks-analysis=inline */
   const gchar *extra_args = g_getenv("SYSLOG_NG_FILTERX_JIT_LLVM_ARGS");
@@ -701,6 +1045,7 @@ exit:
 void
 filterx_jit_global_deinit(void)
 {
+  filterx_jit_cache_global_deinit();
   LLVMShutdown();
 }
 
@@ -711,6 +1056,12 @@ FilterXJIT *filterx_jit_new(const gchar *module_name, FilterXJITDebugInfo debug_
   return NULL;
 }
 void filterx_jit_free(FilterXJIT *self) {}
+void filterx_jit_set_cache_dir(FilterXJIT *self, const gchar *cache_dir) {}
+void filterx_jit_set_hot_threshold(FilterXJIT *self, guint hot_threshold) {}
+guint filterx_jit_get_hot_threshold(FilterXJIT *self)
+{
+  return 0;
+}
 void filterx_jit_global_init(void) {}
 void filterx_jit_global_deinit(void) {}
 
@@ -744,5 +1095,9 @@ FilterXJITAddress filterx_jit_lookup(FilterXJIT *self, const gchar *block_name,
 {
   g_assert_not_reached();
 }
+void filterx_jit_compile_block_async(FilterXJIT *self, const gchar *block_name, FilterXJITExecFunc *exec_func)
+{
+  g_assert_not_reached();
+}
 
 #endif
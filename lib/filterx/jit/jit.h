@@ -33,6 +33,15 @@
  * 3. Finalize the FilterXJIT instance (filterx_jit_finalize()):
  *    - no IR codegen is possible from this point,
  *    - JIT-compiled FilterX blocks are ready to be used (filterx_jit_lookup())
+ *
+ * With a non-zero hot threshold, filterx_jit_finalize() does not compile
+ * anything: blocks run in the interpreter and the caller requests their
+ * compilation with filterx_jit_compile_block_async() once they were
+ * executed hot_threshold times.
+ *
+ * If a cache directory is set, the compiled module is stored there and
+ * loaded as an object file instead of being compiled again if the
+ * generated IR is unchanged (e.g. on reload).
  */
 
 #if SYSLOG_NG_HAVE_MEMFD_CREATE
@@ -76,6 +85,11 @@ typedef FilterXObject *(*FilterXJITExecFunc)(struct _FilterXEvalContext *ctx);
 FilterXJIT *filterx_jit_new(const gchar *module_name, FilterXJITDebugInfo debug_info, GError **error);
 void filterx_jit_free(FilterXJIT *self);
 
+/* must be called before generating IR code */
+void filterx_jit_set_cache_dir(FilterXJIT *self, const gchar *cache_dir);
+void filterx_jit_set_hot_threshold(FilterXJIT *self, guint hot_threshold);
+guint filterx_jit_get_hot_threshold(FilterXJIT *self);
+
 /* IR */
 FilterXIRBuilder filterx_jit_get_ir_builder(FilterXJIT *self);
 void filterx_jit_ir_add_new_block(FilterXJIT *self, const gchar *block_name);
@@ -95,6 +109,7 @@ void filterx_jit_ir_set_source_location(FilterXJIT *self, const gchar *file, gin
 /* JIT */
 gboolean filterx_jit_finalize(FilterXJIT *self, GError **error);
 FilterXJITAddress filterx_jit_lookup(FilterXJIT *self, const gchar *block_name, GError **error);
+void filterx_jit_compile_block_async(FilterXJIT *self, const gchar *block_name, FilterXJITExecFunc *exec_func);
 
 void filterx_jit_global_init(void);
 void filterx_jit_global_deinit(void);
@@ -38,49 +38,45 @@
 #include "scratch-buffers.h"
 #include "utf8utils.h"
 #include "tls-support.h"
-#include "str-utils.h"
 
 #include "logmsg/type-hinting.h"
 
-#define JSMN_STATIC 1
-#define JSMN_STRICT 1
-#define JSMN_PARENT_LINKS 1
-#include "jsmn.h"
+#include "scanner/json-scanner/json-scanner.h"
+
+#define FILTERX_JSON_MAX_TOKENS 65536
 
 TLS_BLOCK_START
 {
-  jsmntok_t *jsmn_tokens;
-  gint jsmn_tokens_len;
+  JSONScanner json_scanner;
+  gboolean json_scanner_initialized;
 }
 TLS_BLOCK_END;
 
-#define jsmn_tokens      __tls_deref(jsmn_tokens)
-#define jsmn_tokens_len  __tls_deref(jsmn_tokens_len)
+#define json_scanner              __tls_deref(json_scanner)
+#define json_scanner_initialized  __tls_deref(json_scanner_initialized)
 
 /* JSON parsing */
 
 static FilterXObject *
-filterx_object_from_jsmn_tokens(const gchar *json_text, gsize json_len, jsmntok_t **tokens, jsmntok_t *sentinel);
+filterx_object_from_json_tokens(const gchar *json_text, const JSONToken *tokens, guint32 *token_idx);
 
 static FilterXObject *
-_convert_from_json_object(const gchar *json_text, gsize json_len,
-                          jsmntok_t **tokens, jsmntok_t *sentinel)
+_convert_from_json_object(const gchar *json_text, const JSONToken *tokens, guint32 *token_idx)
 {
   FilterXObject *res = filterx_dict_new();
 
   filterx_object_cow_prepare(&res);
 
   /* NOTE: skip object token */
-  jsmntok_t *token = *tokens;
-  gsize elements = token->size;
-  token++;
-  for (gint i = 0; i < elements && token < sentinel; i++)
+  const JSONToken *token = &tokens[*token_idx];
+  guint32 idx = *token_idx + 1;
+  for (guint32 i = 0; i < token->size; i++)
     {
-      FilterXObject *key = filterx_object_from_jsmn_tokens(json_text, json_len, &token, sentinel);
+      FilterXObject *key = filterx_object_from_json_tokens(json_text, tokens, &idx);
       if (!key)
         goto error;
 
-      FilterXObject *value = filterx_object_from_jsmn_tokens(json_text, json_len, &token, sentinel);
+      FilterXObject *value = filterx_object_from_json_tokens(json_text, tokens, &idx);
       if (!value)
         {
           filterx_object_unref(key);
@@ -95,7 +91,7 @@ _convert_from_json_object(const gchar *json_text, gsize json_len,
           goto error;
         }
     }
-  *tokens = token;
+  *token_idx = idx;
   filterx_object_set_dirty(res, FALSE);
   return res;
 error:
@@ -104,19 +100,17 @@ error:
 }
 
 static FilterXObject *
-_convert_from_json_array(const gchar *json_text, gsize json_len,
-                         jsmntok_t **tokens, jsmntok_t *sentinel)
+_convert_from_json_array(const gchar *json_text, const JSONToken *tokens, guint32 *token_idx)
 {
   FilterXObject *res = filterx_list_new();
   filterx_object_cow_prepare(&res);
 
   /* NOTE: skip list token */
-  jsmntok_t *token = *tokens;
-  gsize elements = token->size;
-  token++;
-  for (gint i = 0; i < elements && token < sentinel; i++)
+  const JSONToken *token = &tokens[*token_idx];
+  guint32 idx = *token_idx + 1;
+  for (guint32 i = 0; i < token->size; i++)
     {
-      FilterXObject *o = filterx_object_from_jsmn_tokens(json_text, json_len, &token, sentinel);
+      FilterXObject *o = filterx_object_from_json_tokens(json_text, tokens, &idx);
       if (!o)
         goto error;
 
@@ -127,7 +121,7 @@ _convert_from_json_array(const gchar *json_text, gsize json_len,
           goto error;
         }
     }
-  *tokens = token;
+  *token_idx = idx;
   filterx_object_set_dirty(res, FALSE);
   return res;
 error:
@@ -136,7 +130,7 @@ error:
 }
 
 static FilterXObject *
-_convert_from_json_number(const gchar *json_text, gsize json_len, jsmntok_t *token)
+_convert_from_json_number(const gchar *json_text, const JSONToken *token)
 {
   gchar buf[64];
   GenericNumber gn;
@@ -154,194 +148,132 @@ _convert_from_json_number(const gchar *json_text, gsize json_len, jsmntok_t *tok
 }
 
 static FilterXObject *
-_convert_from_json_primitive(const gchar *json_text, gsize json_len,
-                             jsmntok_t **tokens, jsmntok_t *sentinel)
+_convert_from_json_string(const gchar *json_text, const JSONToken *token)
 {
+  FilterXObject *result;
+
+  if (!(token->flags & JSON_TOKEN_FLAG_ESCAPED))
+    {
+      result = filterx_string_new(&json_text[token->start], token->end - token->start);
+      filterx_string_mark_safe_without_json_escaping(result);
+    }
+  else
+    {
+      result = filterx_string_new_from_json_literal(&json_text[token->start], token->end - token->start);
+    }
+  return result;
+}
 
+static FilterXObject *
+filterx_object_from_json_tokens(const gchar *json_text, const JSONToken *tokens, guint32 *token_idx)
+{
   FilterXObject *result = NULL;
-  jsmntok_t *token = *tokens;
+  const JSONToken *token = &tokens[*token_idx];
 
-  switch (json_text[token->start])
+  switch (token->type)
     {
-    case 't':
-      if (strn_eq_strz(&json_text[token->start], "true", token->end - token->start))
-        result = filterx_boolean_new(TRUE);
+    case JSON_TOKEN_OBJECT:
+      return _convert_from_json_object(json_text, tokens, token_idx);
+    case JSON_TOKEN_ARRAY:
+      return _convert_from_json_array(json_text, tokens, token_idx);
+    case JSON_TOKEN_STRING:
+      result = _convert_from_json_string(json_text, token);
       break;
-    case 'f':
-      if (strn_eq_strz(&json_text[token->start], "false", token->end - token->start))
-        result = filterx_boolean_new(FALSE);
+    case JSON_TOKEN_NUMBER:
+      result = _convert_from_json_number(json_text, token);
       break;
-    case 'n':
-      if (strn_eq_strz(&json_text[token->start], "null", token->end - token->start))
-        result = filterx_null_new();
+    case JSON_TOKEN_TRUE:
+      result = filterx_boolean_new(TRUE);
       break;
-    default:
-      result = _convert_from_json_number(json_text, json_len, token);
+    case JSON_TOKEN_FALSE:
+      result = filterx_boolean_new(FALSE);
       break;
+    case JSON_TOKEN_NULL:
+      result = filterx_null_new();
+      break;
+    default:
+      g_assert_not_reached();
     }
   if (result)
-    *tokens = token + 1;
+    *token_idx = token->next;
   return result;
 }
 
-
-static FilterXObject *
-_convert_from_json_string(const gchar *json_text, gsize json_len,
-                          jsmntok_t **tokens, jsmntok_t *sentinel)
+static JSONScanner *
+_get_json_scanner(void)
 {
-
-  FilterXObject *result = NULL;
-  jsmntok_t *token = *tokens;
-
-  if (token->flags & JSMN_STRING_NO_ESCAPE)
+  if (!json_scanner_initialized)
     {
-      result = filterx_string_new(&json_text[token->start], token->end - token->start);
-      filterx_string_mark_safe_without_json_escaping(result);
+      json_scanner_init(&json_scanner, NULL, 0);
+      json_scanner_set_max_tokens(&json_scanner, FILTERX_JSON_MAX_TOKENS);
+      json_scanner_initialized = TRUE;
     }
-  else
-    {
-      result = filterx_string_new_from_json_literal(&json_text[token->start], token->end - token->start);
-    }
-  if (result)
-    *tokens = token + 1;
-  return result;
+  return &json_scanner;
 }
 
-static FilterXObject *
-filterx_object_from_jsmn_tokens(const gchar *json_text, gsize json_len, jsmntok_t **tokens, jsmntok_t *sentinel)
+static void
+_set_json_scanner_error(JSONScannerResult result, gsize error_pos, const gchar *repr, gsize repr_len,
+                        GError **error)
 {
-  FilterXObject *result = NULL;
-
-  jsmntok_t *token = *tokens;
+  const gint excerpt_len = 20;
+  gint pos = MIN(error_pos, repr_len);
+  gint prologue_start = MAX(pos - excerpt_len, 0);
+  gint prologue_len = pos - prologue_start;
 
-  if (token >= sentinel)
-    return NULL;
-
-  switch (token->type)
+  switch (result)
     {
-    case JSMN_OBJECT:
-      result = _convert_from_json_object(json_text, json_len, &token, sentinel);
+    case JSON_SCANNER_ERROR_TOO_LARGE:
+      g_set_error(error, FILTERX_JSON_ERROR, FILTERX_JSON_ERROR_TOO_LARGE,
+                  "JSON text too large, number of tokens exceeds the maximum of %d tokens (size %" G_GSIZE_FORMAT " bytes)",
+                  FILTERX_JSON_MAX_TOKENS, repr_len);
       break;
-    case JSMN_ARRAY:
-      result = _convert_from_json_array(json_text, json_len, &token, sentinel);
-      break;
-    case JSMN_STRING:
-      g_assert(token->start <= token->end && token->end < json_len);
-      result = _convert_from_json_string(json_text, json_len, &token, sentinel);
+    case JSON_SCANNER_ERROR_INVALID:
+    case JSON_SCANNER_ERROR_TOO_DEEP:
+    {
+      gint epilogue_len = MIN(excerpt_len, (gint) repr_len - pos - 1);
+      g_set_error(error, FILTERX_JSON_ERROR, FILTERX_JSON_ERROR_INVALID,
+                  "JSON parse error at %d, excerpt: %.*s>%c<%.*s",
+                  pos,
+                  prologue_len, &repr[prologue_start],
+                  repr[pos],
+                  epilogue_len, &repr[pos + 1]);
       break;
-    case JSMN_PRIMITIVE:
-      g_assert(token->start <= token->end && token->end < json_len);
-      result = _convert_from_json_primitive(json_text, json_len, &token, sentinel);
+    }
+    case JSON_SCANNER_ERROR_INCOMPLETE:
+      g_set_error(error, FILTERX_JSON_ERROR, FILTERX_JSON_ERROR_INCOMPLETE,
+                  "JSON text incomplete, excerpt: %.*s",
+                  prologue_len, &repr[prologue_start]);
       break;
-    case JSMN_UNDEFINED:
+    case JSON_SCANNER_ERROR_MULTIPLE_VALUES:
+      g_set_error(error, FILTERX_JSON_ERROR, FILTERX_JSON_ERROR_STORE_ERROR,
+                  "Expected a single JSON object, multiple top-level objects found");
       break;
     default:
       g_assert_not_reached();
     }
-  *tokens = token;
-  return result;
 }
 
 FilterXObject *
 filterx_object_from_json(const gchar *repr, gssize repr_len, GError **error)
 {
-  const gint min_tokens = 256;
-  const gint max_tokens = 65536;
-
   g_return_val_if_fail(error == NULL || (*error) == NULL, NULL);
 
   if (repr_len < 0)
     repr_len = strlen(repr);
 
-  jsmn_parser parser;
-  jsmn_init(&parser);
-
-  if (jsmn_tokens == NULL)
-    {
-      jsmn_tokens_len = min_tokens;
-      jsmn_tokens = g_new(jsmntok_t, jsmn_tokens_len);
-    }
-
-  gint r;
-  gboolean try_again;
-  do
-    {
-      try_again = FALSE;
-
-      r = jsmn_parse(&parser, repr, repr_len, jsmn_tokens, jsmn_tokens_len);
-      if (r == JSMN_ERROR_NOMEM && jsmn_tokens_len < max_tokens)
-        {
-          jsmn_tokens_len *= 2;
-          jsmn_tokens = g_renew(jsmntok_t, jsmn_tokens, jsmn_tokens_len);
-          try_again = TRUE;
-        }
-    }
-  while (try_again);
-
-  if (r < 0)
+  JSONScanner *scanner = _get_json_scanner();
+  JSONScannerResult result = json_scanner_scan(scanner, repr, repr_len);
+  if (result != JSON_SCANNER_SUCCESS)
     {
-      switch (r)
-        {
-        case JSMN_ERROR_NOMEM:
-          g_set_error(error, FILTERX_JSON_ERROR, FILTERX_JSON_ERROR_TOO_LARGE,
-                      "JSON text too large, number of tokens exceeds the maximum of %d tokens (size %ld bytes)",
-                      max_tokens, repr_len);
-          break;
-        case JSMN_ERROR_INVAL:
-        {
-          const gint excerpt_len = 20;
-          gint prologue_start = MAX((gint) parser.pos - excerpt_len, 0);
-          if (prologue_start < 0)
-            prologue_start = 0;
-          gint prologue_len = excerpt_len;
-          if (prologue_start + prologue_len > parser.pos)
-            prologue_len = parser.pos - prologue_start;
-
-          gint epilogue_len = excerpt_len;
-          if (parser.pos + epilogue_len + 1 > repr_len)
-            epilogue_len = repr_len - parser.pos - 1;
-          g_set_error(error, FILTERX_JSON_ERROR, FILTERX_JSON_ERROR_INVALID,
-                      "JSON parse error at %d, excerpt: %.*s>%c<%.*s",
-                      parser.pos,
-                      prologue_len, &repr[prologue_start],
-                      repr[parser.pos],
-                      epilogue_len, &repr[parser.pos+1]);
-          break;
-        }
-        case JSMN_ERROR_PART:
-        {
-          const gint excerpt_len = 20;
-          gint prologue_start = (gint) parser.pos - excerpt_len;
-          if (prologue_start < 0)
-            prologue_start = 0;
-          gint prologue_len = excerpt_len;
-          if (prologue_start + prologue_len > parser.pos)
-            prologue_len = parser.pos - prologue_start;
-          g_set_error(error, FILTERX_JSON_ERROR, FILTERX_JSON_ERROR_INCOMPLETE,
-                      "JSON text incomplete, excerpt: %.*s",
-                      prologue_len, &repr[prologue_start]);
-          break;
-        }
-        default:
-          g_assert_not_reached();
-        }
+      _set_json_scanner_error(result, json_scanner_get_error_pos(scanner), repr, repr_len, error);
       return NULL;
     }
 
-  jsmntok_t *tokens = jsmn_tokens;
-  FilterXObject *res = filterx_object_from_jsmn_tokens(repr, repr_len, &tokens, tokens + r);
+  guint32 token_idx = 0;
+  FilterXObject *res = filterx_object_from_json_tokens(repr, json_scanner_get_tokens(scanner), &token_idx);
 
   if (!res)
-    {
-      g_set_error(error, FILTERX_JSON_ERROR, FILTERX_JSON_ERROR_STORE_ERROR, "Invalid JSON, unrecognized token");
-    }
-  else if (tokens != jsmn_tokens + r)
-    {
-      g_set_error(error, FILTERX_JSON_ERROR, FILTERX_JSON_ERROR_STORE_ERROR,
-                  "Expected a single JSON object, multiple top-level objects found");
-      filterx_object_unref(res);
-      res = NULL;
-    }
+    g_set_error(error, FILTERX_JSON_ERROR, FILTERX_JSON_ERROR_STORE_ERROR, "Invalid JSON, unrecognized token");
 
   return res;
 }
@@ -419,8 +351,11 @@ filterx_json_repr_thread_init(void)
 void
 filterx_json_repr_thread_deinit(void)
 {
-  g_free(jsmn_tokens);
-  jsmn_tokens = NULL;
+  if (json_scanner_initialized)
+    {
+      json_scanner_deinit(&json_scanner);
+      json_scanner_initialized = FALSE;
+    }
 }
 
 GQuark
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include "libtest/filterx-lib.h"
+
+#include "filterx/func-in-list.h"
+#include "filterx/object-string.h"
+#include "filterx/object-primitive.h"
+#include "filterx/expr-function.h"
+#include "filterx/expr-literal.h"
+#include "filterx/filterx-eval.h"
+
+#include "apphook.h"
+#include "scratch-buffers.h"
+
+#include <glib/gstdio.h>
+#include <unistd.h>
+
+static gchar *list_file;
+
+static FilterXExpr *
+_create_in_list_expr(FilterXObject *value, const gchar *filename, gboolean substring, GError **error)
+{
+  GList *args = NULL;
+  args = g_list_append(args, filterx_function_arg_new(NULL, filterx_object_expr_new(value)));
+  args = g_list_append(args, filterx_function_arg_new(NULL, filterx_literal_new(filterx_string_new(filename, -1))));
+  if (substring)
+    args = g_list_append(args, filterx_function_arg_new("substring", filterx_literal_new(filterx_boolean_new(TRUE))));
+
+  return filterx_function_in_list_new(filterx_function_args_new(args, NULL), error);
+}
+
+static gboolean
+_eval_in_list(const gchar *value, gboolean substring)
+{
+  GError *error = NULL;
+  FilterXExpr *fn = _create_in_list_expr(filterx_string_new(value, -1), list_file, substring, &error);
+  cr_assert_null(error);
+
+  FilterXObject *res = init_and_eval_expr(fn);
+  cr_assert_not_null(res);
+  gboolean result = filterx_object_truthy(res);
+
+  filterx_object_unref(res);
+  filterx_expr_unref(fn);
+  return result;
+}
+
+Test(filterx_func_in_list, test_value_is_one_of_the_lines)
+{
+  cr_assert(_eval_in_list("evil.example.com", FALSE));
+  cr_assert(_eval_in_list("another-needle", FALSE));
+  cr_assert_not(_eval_in_list("www.evil.example.com", FALSE));
+  cr_assert_not(_eval_in_list("", FALSE));
+}
+
+Test(filterx_func_in_list, test_value_contains_any_of_the_lines)
+{
+  cr_assert(_eval_in_list("www.evil.example.com", TRUE));
+  cr_assert(_eval_in_list("there is another-needle in the haystack", TRUE));
+  cr_assert_not(_eval_in_list("evil.example.org", TRUE));
+}
+
+Test(filterx_func_in_list, test_non_string_value_is_an_error)
+{
+  GError *error = NULL;
+  FilterXExpr *fn = _create_in_list_expr(filterx_integer_new(42), list_file, FALSE, &error);
+  cr_assert_null(error);
+
+  FilterXObject *res = init_and_eval_expr(fn);
+  cr_assert_null(res);
+
+  filterx_expr_unref(fn);
+}
+
+Test(filterx_func_in_list, test_missing_file_fails_construction)
+{
+  GError *error = NULL;
+  FilterXExpr *fn = _create_in_list_expr(filterx_string_new("foo", -1), "/nonexistent/in-list.list", FALSE, &error);
+
+  cr_assert_null(fn);
+  cr_assert_not_null(error);
+  g_error_free(error);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  init_libtest_filterx();
+
+  gint fd = g_file_open_tmp("test_func_in_list_XXXXXX", &list_file, NULL);
+  cr_assert(fd >= 0);
+  close(fd);
+  cr_assert(g_file_set_contents(list_file, "evil.example.com\nanother-needle\n", -1, NULL));
+}
+
+static void
+teardown(void)
+{
+  g_unlink(list_file);
+  g_free(list_file);
+  scratch_buffers_explicit_gc();
+  deinit_libtest_filterx();
+  app_shutdown();
+}
+
+TestSuite(filterx_func_in_list, .init = setup, .fini = teardown);
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "filterx/jit/jit.h"
+#include "filterx/jit/jit-private.h"
+#include "apphook.h"
+
+#include <glib/gstdio.h>
+
+static gint first_marker;
+static gint second_marker;
+
+static FilterXJIT *
+_new_jit(const gchar *cache_dir)
+{
+  GError *error = NULL;
+  FilterXJIT *jit = filterx_jit_new("test_jit_cache", FILTERX_JIT_DEBUG_INFO_FILTERX, &error);
+
+  cr_assert_not_null(jit, "%s", error ? error->message : "unknown error");
+  filterx_jit_set_cache_dir(jit, cache_dir);
+  return jit;
+}
+
+/* the address is referenced through an fx_jit_address_<N> symbol, so it is not part of the cache key */
+static void
+_add_block_returning(FilterXJIT *jit, const gchar *block_name, gconstpointer address)
+{
+  filterx_jit_ir_add_new_block(jit, block_name);
+  filterx_jit_ir_finish_current_block(jit, filterx_jit_ir_get_address_symbol(jit, address));
+}
+
+static void
+_finalize(FilterXJIT *jit)
+{
+  GError *error = NULL;
+
+  cr_assert(filterx_jit_finalize(jit, &error), "%s", error ? error->message : "unknown error");
+}
+
+static gpointer
+_exec_block(FilterXJIT *jit, const gchar *block_name)
+{
+  GError *error = NULL;
+  FilterXJITAddress addr = filterx_jit_lookup(jit, block_name, &error);
+
+  cr_assert(addr, "%s", error ? error->message : "unknown error");
+  return ((FilterXJITExecFunc) addr)(NULL);
+}
+
+/* returns the path of the only entry in the cache */
+static gchar *
+_get_cache_entry(const gchar *cache_dir, gint expected_entries)
+{
+  GDir *dir = g_dir_open(cache_dir, 0, NULL);
+  gchar *path = NULL;
+  gint entries = 0;
+  const gchar *name;
+
+  cr_assert_not_null(dir);
+  while ((name = g_dir_read_name(dir)))
+    {
+      g_free(path);
+      path = g_build_filename(cache_dir, name, NULL);
+      entries++;
+    }
+  g_dir_close(dir);
+
+  cr_assert_eq(entries, expected_entries);
+  return path;
+}
+
+static void
+_remove_cache_dir(gchar *cache_dir)
+{
+  GDir *dir = g_dir_open(cache_dir, 0, NULL);
+  const gchar *name;
+
+  while ((name = g_dir_read_name(dir)))
+    {
+      gchar *path = g_build_filename(cache_dir, name, NULL);
+      g_unlink(path);
+      g_free(path);
+    }
+  g_dir_close(dir);
+  g_rmdir(cache_dir);
+  g_free(cache_dir);
+}
+
+static ino_t
+_get_inode(const gchar *path)
+{
+  GStatBuf st;
+
+  cr_assert_eq(g_stat(path, &st), 0);
+  return st.st_ino;
+}
+
+Test(filterx_jit_cache, unchanged_module_is_loaded_from_the_cache)
+{
+  gchar *cache_dir = g_dir_make_tmp("test_jit_cache_XXXXXX", NULL);
+
+  FilterXJIT *jit = _new_jit(cache_dir);
+  _add_block_returning(jit, "block", &first_marker);
+  _finalize(jit);
+  cr_assert_eq(_exec_block(jit, "block"), &first_marker);
+  filterx_jit_free(jit);
+
+  gchar *entry = _get_cache_entry(cache_dir, 1);
+  ino_t entry_inode = _get_inode(entry);
+
+  /* a reload generates the same IR, only the addresses bound to the symbols differ */
+  jit = _new_jit(cache_dir);
+  _add_block_returning(jit, "block", &second_marker);
+  _finalize(jit);
+  cr_assert_eq(_exec_block(jit, "block"), &second_marker);
+  filterx_jit_free(jit);
+
+  g_free(_get_cache_entry(cache_dir, 1));
+  cr_assert_eq(_get_inode(entry), entry_inode, "cache entry was rewritten instead of being loaded");
+
+  g_free(entry);
+  _remove_cache_dir(cache_dir);
+}
+
+Test(filterx_jit_cache, changed_module_gets_a_new_cache_entry)
+{
+  gchar *cache_dir = g_dir_make_tmp("test_jit_cache_XXXXXX", NULL);
+
+  FilterXJIT *jit = _new_jit(cache_dir);
+  _add_block_returning(jit, "block", &first_marker);
+  _finalize(jit);
+  filterx_jit_free(jit);
+
+  jit = _new_jit(cache_dir);
+  _add_block_returning(jit, "block", &first_marker);
+  _add_block_returning(jit, "another_block", &second_marker);
+  _finalize(jit);
+  cr_assert_eq(_exec_block(jit, "block"), &first_marker);
+  cr_assert_eq(_exec_block(jit, "another_block"), &second_marker);
+  filterx_jit_free(jit);
+
+  g_free(_get_cache_entry(cache_dir, 2));
+  _remove_cache_dir(cache_dir);
+}
+
+Test(filterx_jit_cache, invalid_cache_entry_is_recompiled)
+{
+  gchar *cache_dir = g_dir_make_tmp("test_jit_cache_XXXXXX", NULL);
+
+  FilterXJIT *jit = _new_jit(cache_dir);
+  _add_block_returning(jit, "block", &first_marker);
+  _finalize(jit);
+  filterx_jit_free(jit);
+
+  gchar *entry = _get_cache_entry(cache_dir, 1);
+  cr_assert(g_file_set_contents(entry, "garbage", -1, NULL));
+
+  jit = _new_jit(cache_dir);
+  _add_block_returning(jit, "block", &first_marker);
+  _finalize(jit);
+  cr_assert_eq(_exec_block(jit, "block"), &first_marker);
+  filterx_jit_free(jit);
+
+  gchar *contents;
+  cr_assert(g_file_get_contents(entry, &contents, NULL, NULL));
+  cr_assert(g_str_has_prefix(contents, "FXJITOBJ"), "invalid cache entry was not replaced");
+  g_free(contents);
+
+  g_free(entry);
+  _remove_cache_dir(cache_dir);
+}
+
+TestSuite(filterx_jit_cache, .init = app_startup, .fini = app_shutdown);
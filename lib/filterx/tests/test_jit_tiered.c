@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "filterx/jit/jit.h"
+#include "filterx/jit/jit-private.h"
+#include "apphook.h"
+
+#include <glib/gstdio.h>
+
+#define COMPILE_TIMEOUT_USEC (60 * G_USEC_PER_SEC)
+
+static gint first_marker;
+static gint second_marker;
+
+static FilterXJIT *
+_new_tiered_jit(const gchar *cache_dir)
+{
+  GError *error = NULL;
+  FilterXJIT *jit = filterx_jit_new("test_jit_tiered", FILTERX_JIT_DEBUG_INFO_FILTERX, &error);
+
+  cr_assert_not_null(jit, "%s", error ? error->message : "unknown error");
+  filterx_jit_set_cache_dir(jit, cache_dir);
+  filterx_jit_set_hot_threshold(jit, 1);
+
+  filterx_jit_ir_add_new_block(jit, "first");
+  filterx_jit_ir_finish_current_block(jit, filterx_jit_ir_get_address_symbol(jit, &first_marker));
+  filterx_jit_ir_add_new_block(jit, "second");
+  filterx_jit_ir_finish_current_block(jit, filterx_jit_ir_get_address_symbol(jit, &second_marker));
+
+  cr_assert(filterx_jit_finalize(jit, &error), "%s", error ? error->message : "unknown error");
+  return jit;
+}
+
+static FilterXJITExecFunc
+_wait_for_compilation(FilterXJITExecFunc *exec_func)
+{
+  gint64 deadline = g_get_monotonic_time() + COMPILE_TIMEOUT_USEC;
+  FilterXJITExecFunc func;
+
+  while (!(func = g_atomic_pointer_get(exec_func)))
+    {
+      cr_assert(g_get_monotonic_time() < deadline, "hot block was not compiled in time");
+      g_usleep(1000);
+    }
+  return func;
+}
+
+static gint
+_count_cache_entries(const gchar *cache_dir)
+{
+  GDir *dir = g_dir_open(cache_dir, 0, NULL);
+  gint entries = 0;
+
+  cr_assert_not_null(dir);
+  while (g_dir_read_name(dir))
+    entries++;
+  g_dir_close(dir);
+  return entries;
+}
+
+static void
+_remove_cache_dir(gchar *cache_dir)
+{
+  GDir *dir = g_dir_open(cache_dir, 0, NULL);
+  const gchar *name;
+
+  while ((name = g_dir_read_name(dir)))
+    {
+      gchar *path = g_build_filename(cache_dir, name, NULL);
+      g_unlink(path);
+      g_free(path);
+    }
+  g_dir_close(dir);
+  g_rmdir(cache_dir);
+  g_free(cache_dir);
+}
+
+Test(filterx_jit_tiered, blocks_are_only_compiled_when_requested)
+{
+  FilterXJIT *jit = _new_tiered_jit(NULL);
+  FilterXJITExecFunc first = NULL, second = NULL, missing = NULL, first_again = NULL;
+  GError *error = NULL;
+
+  /* nothing is compiled by finalize */
+  cr_assert_eq(filterx_jit_lookup(jit, "first", &error), 0);
+  g_clear_error(&error);
+
+  filterx_jit_compile_block_async(jit, "first", &first);
+  cr_assert_eq(_wait_for_compilation(&first)(NULL), (gpointer) &first_marker);
+  cr_assert_null(g_atomic_pointer_get(&second));
+
+  /* the requests are served in order by a single compiler thread */
+  filterx_jit_compile_block_async(jit, "missing", &missing);
+  filterx_jit_compile_block_async(jit, "second", &second);
+  cr_assert_eq(_wait_for_compilation(&second)(NULL), (gpointer) &second_marker);
+  cr_assert_null(g_atomic_pointer_get(&missing), "a block without IR code was compiled");
+
+  /* a block that is already compiled is not added again */
+  filterx_jit_compile_block_async(jit, "first", &first_again);
+  cr_assert_eq(_wait_for_compilation(&first_again), first);
+
+  filterx_jit_free(jit);
+}
+
+Test(filterx_jit_tiered, hot_blocks_are_cached_one_by_one)
+{
+  gchar *cache_dir = g_dir_make_tmp("test_jit_tiered_XXXXXX", NULL);
+  FilterXJITExecFunc first = NULL, second = NULL;
+
+  FilterXJIT *jit = _new_tiered_jit(cache_dir);
+  cr_assert_eq(_count_cache_entries(cache_dir), 0);
+
+  filterx_jit_compile_block_async(jit, "first", &first);
+  _wait_for_compilation(&first);
+  cr_assert_eq(_count_cache_entries(cache_dir), 1);
+
+  filterx_jit_compile_block_async(jit, "second", &second);
+  _wait_for_compilation(&second);
+  cr_assert_eq(_count_cache_entries(cache_dir), 2);
+  filterx_jit_free(jit);
+
+  /* after a restart the blocks are loaded from the cache */
+  first = NULL;
+  jit = _new_tiered_jit(cache_dir);
+  filterx_jit_compile_block_async(jit, "first", &first);
+  cr_assert_eq(_wait_for_compilation(&first)(NULL), (gpointer) &first_marker);
+  cr_assert_eq(_count_cache_entries(cache_dir), 2);
+  filterx_jit_free(jit);
+
+  _remove_cache_dir(cache_dir);
+}
+
+TestSuite(filterx_jit_tiered, .init = app_startup, .fini = app_shutdown);
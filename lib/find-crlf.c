@@ -21,72 +21,345 @@
  *
  */
 #include "find-crlf.h"
+#include "cpu-features.h"
 
 #include <string.h>
-/**
- * This is an optimized version of finding either a CR or LF or NUL
- * character in a buffer.  It is used to find these line terminators in
- * syslog traffic.
- *
- * It uses an algorithm very similar to what there's in libc memchr/strchr.
- **/
-const gchar *
-find_cr_or_lf_or_nul(const gchar *s, gsize n)
+
+#if CPU_FEATURES_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#if CPU_FEATURES_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+/*
+ * Line terminator scanning kernels.  They all look for any of three
+ * terminator characters (repeat one if you need less), and store the
+ * offsets of the matches in s[0..n) into offsets, stopping as soon as
+ * max_offsets matches are found.  Returning the first match only is
+ * the special case of max_offsets == 1.
+ */
+typedef gsize (*FindTerminatorsFunc)(const gchar *s, gsize n, const gchar *terminators,
+                                     guint32 *offsets, gsize max_offsets);
+
+static inline gboolean
+_is_terminator(gchar c, const gchar *terminators)
 {
-  const gchar *char_ptr;
-  gulong *longword_ptr;
-  gulong longword, magic_bits, cr_charmask, lf_charmask;
-  const char CR = '\r';
-  const char LF = '\n';
+  return c == terminators[0] || c == terminators[1] || c == terminators[2];
+}
+
+/* collect matches from s[start..n) byte by byte, used for the unaligned
+ * head and the tail of the vectorized loops */
+static inline gsize
+_collect_terminators_bytewise(const gchar *s, gsize start, gsize n, const gchar *terminators,
+                              guint32 *offsets, gsize found, gsize max_offsets)
+{
+  for (gsize i = start; i < n && found < max_offsets; i++)
+    {
+      if (_is_terminator(s[i], terminators))
+        offsets[found++] = i;
+    }
+  return found;
+}
+
+/*
+ * The portable version uses an algorithm very similar to what there's in
+ * libc memchr/strchr: it checks a long word at a time for a zero byte
+ * after XOR-ing it with the terminator characters.
+ */
+static inline gboolean
+_longword_has_zero_byte(gulong longword)
+{
+  const gulong ones = ((gulong) -1) / 0xff;
+  const gulong highs = ones * 0x80;
+
+  return ((longword - ones) & ~longword & highs) != 0;
+}
+
+static gsize
+_find_terminators_scalar(const gchar *s, gsize n, const gchar *terminators, guint32 *offsets, gsize max_offsets)
+{
+  gulong masks[3];
+  gsize found = 0;
+  gsize i = 0;
+
+  for (gint t = 0; t < 3; t++)
+    memset(&masks[t], terminators[t], sizeof(masks[t]));
 
   /* align input to long boundary */
-  for (char_ptr = s; n > 0 && ((gulong) char_ptr & (sizeof(longword) - 1)) != 0; ++char_ptr, n--)
+  for (; i < n && ((gulong) (s + i) & (sizeof(gulong) - 1)) != 0; i++)
     {
-      if (*char_ptr == CR || *char_ptr == LF || *char_ptr == 0)
-        return char_ptr;
+      if (_is_terminator(s[i], terminators))
+        {
+          offsets[found++] = i;
+          if (found == max_offsets)
+            return found;
+        }
     }
 
-  longword_ptr = (gulong *) char_ptr;
+  for (; i + sizeof(gulong) <= n; i += sizeof(gulong))
+    {
+      gulong longword = *(const gulong *) (s + i);
 
-#if GLIB_SIZEOF_LONG == 8
-  magic_bits = 0x7efefefefefefeffL;
-#elif GLIB_SIZEOF_LONG == 4
-  magic_bits = 0x7efefeffL;
-#else
-#error "unknown architecture"
-#endif
-  memset(&cr_charmask, CR, sizeof(cr_charmask));
-  memset(&lf_charmask, LF, sizeof(lf_charmask));
+      if (_longword_has_zero_byte(longword ^ masks[0]) ||
+          _longword_has_zero_byte(longword ^ masks[1]) ||
+          _longword_has_zero_byte(longword ^ masks[2]))
+        {
+          found = _collect_terminators_bytewise(s, i, i + sizeof(gulong), terminators, offsets, found, max_offsets);
+          if (found == max_offsets)
+            return found;
+        }
+    }
+
+  return _collect_terminators_bytewise(s, i, n, terminators, offsets, found, max_offsets);
+}
+
+#if CPU_FEATURES_HAVE_X86_SIMD
+
+__attribute__((target("sse2")))
+static gsize
+_find_terminators_sse2(const gchar *s, gsize n, const gchar *terminators, guint32 *offsets, gsize max_offsets)
+{
+  const __m128i t0 = _mm_set1_epi8(terminators[0]);
+  const __m128i t1 = _mm_set1_epi8(terminators[1]);
+  const __m128i t2 = _mm_set1_epi8(terminators[2]);
+  gsize found = 0;
+  gsize i = 0;
 
-  while (n > sizeof(longword))
+  for (; i + 16 <= n; i += 16)
     {
-      longword = *longword_ptr++;
-      if ((((longword + magic_bits) ^ ~longword) & ~magic_bits) != 0 ||
-          ((((longword ^ cr_charmask) + magic_bits) ^ ~(longword ^ cr_charmask)) & ~magic_bits) != 0 ||
-          ((((longword ^ lf_charmask) + magic_bits) ^ ~(longword ^ lf_charmask)) & ~magic_bits) != 0)
+      __m128i chunk = _mm_loadu_si128((const __m128i *) (s + i));
+      __m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, t0), _mm_cmpeq_epi8(chunk, t1)),
+                                     _mm_cmpeq_epi8(chunk, t2));
+      guint32 mask = (guint32) _mm_movemask_epi8(matches);
+
+      while (mask)
         {
-          gint i;
+          offsets[found++] = i + __builtin_ctz(mask);
+          if (found == max_offsets)
+            return found;
+          mask &= mask - 1;
+        }
+    }
+  return _collect_terminators_bytewise(s, i, n, terminators, offsets, found, max_offsets);
+}
 
-          char_ptr = (gchar *) (longword_ptr - 1);
+__attribute__((target("avx2")))
+static gsize
+_find_terminators_avx2(const gchar *s, gsize n, const gchar *terminators, guint32 *offsets, gsize max_offsets)
+{
+  const __m256i t0 = _mm256_set1_epi8(terminators[0]);
+  const __m256i t1 = _mm256_set1_epi8(terminators[1]);
+  const __m256i t2 = _mm256_set1_epi8(terminators[2]);
+  gsize found = 0;
+  gsize i = 0;
+
+  for (; i + 32 <= n; i += 32)
+    {
+      __m256i chunk = _mm256_loadu_si256((const __m256i *) (s + i));
+      __m256i matches = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, t0), _mm256_cmpeq_epi8(chunk, t1)),
+                                        _mm256_cmpeq_epi8(chunk, t2));
+      guint32 mask = (guint32) _mm256_movemask_epi8(matches);
 
-          for (i = 0; i < sizeof(longword); i++)
-            {
-              if (*char_ptr == CR || *char_ptr == LF || *char_ptr == 0)
-                return char_ptr;
-              char_ptr++;
-            }
+      while (mask)
+        {
+          offsets[found++] = i + __builtin_ctz(mask);
+          if (found == max_offsets)
+            return found;
+          mask &= mask - 1;
         }
-      n -= sizeof(longword);
     }
+  return _collect_terminators_bytewise(s, i, n, terminators, offsets, found, max_offsets);
+}
 
-  char_ptr = (gchar *) longword_ptr;
+__attribute__((target("avx512bw")))
+static gsize
+_find_terminators_avx512bw(const gchar *s, gsize n, const gchar *terminators, guint32 *offsets, gsize max_offsets)
+{
+  const __m512i t0 = _mm512_set1_epi8(terminators[0]);
+  const __m512i t1 = _mm512_set1_epi8(terminators[1]);
+  const __m512i t2 = _mm512_set1_epi8(terminators[2]);
+  gsize found = 0;
+  gsize i = 0;
 
-  while (n-- > 0)
+  for (; i + 64 <= n; i += 64)
     {
-      if (*char_ptr == CR || *char_ptr == LF || *char_ptr == 0)
-        return char_ptr;
-      ++char_ptr;
+      __m512i chunk = _mm512_loadu_si512((const void *) (s + i));
+      guint64 mask = _mm512_cmpeq_epi8_mask(chunk, t0) |
+                     _mm512_cmpeq_epi8_mask(chunk, t1) |
+                     _mm512_cmpeq_epi8_mask(chunk, t2);
+
+      while (mask)
+        {
+          offsets[found++] = i + __builtin_ctzll(mask);
+          if (found == max_offsets)
+            return found;
+          mask &= mask - 1;
+        }
     }
+  return _collect_terminators_bytewise(s, i, n, terminators, offsets, found, max_offsets);
+}
+
+#endif
+
+#if CPU_FEATURES_HAVE_NEON
+
+static gsize
+_find_terminators_neon(const gchar *s, gsize n, const gchar *terminators, guint32 *offsets, gsize max_offsets)
+{
+  const uint8x16_t t0 = vdupq_n_u8((guint8) terminators[0]);
+  const uint8x16_t t1 = vdupq_n_u8((guint8) terminators[1]);
+  const uint8x16_t t2 = vdupq_n_u8((guint8) terminators[2]);
+  gsize found = 0;
+  gsize i = 0;
+
+  for (; i + 16 <= n; i += 16)
+    {
+      uint8x16_t chunk = vld1q_u8((const uint8_t *) (s + i));
+      uint8x16_t matches = vorrq_u8(vorrq_u8(vceqq_u8(chunk, t0), vceqq_u8(chunk, t1)), vceqq_u8(chunk, t2));
+      /* narrow the byte mask to 4 bits per byte, NEON has no movemask */
+      guint64 mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+
+      while (mask)
+        {
+          gint bit = __builtin_ctzll(mask);
+
+          offsets[found++] = i + (bit >> 2);
+          if (found == max_offsets)
+            return found;
+          mask &= ~(G_GUINT64_CONSTANT(0xf) << bit);
+        }
+    }
+  return _collect_terminators_bytewise(s, i, n, terminators, offsets, found, max_offsets);
+}
+
+#endif
+
+static FindCrlfSIMDLevel find_terminators_simd_level = FIND_CRLF_SIMD_NONE;
+static FindTerminatorsFunc find_terminators = NULL;
+
+gboolean
+find_crlf_set_simd_level(FindCrlfSIMDLevel level)
+{
+  FindTerminatorsFunc func;
+
+  switch (level)
+    {
+    case FIND_CRLF_SIMD_NONE:
+      func = _find_terminators_scalar;
+      break;
+#if CPU_FEATURES_HAVE_X86_SIMD
+    case FIND_CRLF_SIMD_SSE2:
+      if (!cpu_supports_sse2())
+        return FALSE;
+      func = _find_terminators_sse2;
+      break;
+    case FIND_CRLF_SIMD_AVX2:
+      if (!cpu_supports_avx2())
+        return FALSE;
+      func = _find_terminators_avx2;
+      break;
+    case FIND_CRLF_SIMD_AVX512BW:
+      if (!cpu_supports_avx512bw())
+        return FALSE;
+      func = _find_terminators_avx512bw;
+      break;
+#endif
+#if CPU_FEATURES_HAVE_NEON
+    case FIND_CRLF_SIMD_NEON:
+      func = _find_terminators_neon;
+      break;
+#endif
+    default:
+      return FALSE;
+    }
+
+  find_terminators_simd_level = level;
+  find_terminators = func;
+  return TRUE;
+}
+
+FindCrlfSIMDLevel
+find_crlf_get_simd_level(void)
+{
+  return find_terminators_simd_level;
+}
+
+/* resolved on first use, racing threads store the same values */
+static inline FindTerminatorsFunc
+_get_find_terminators(void)
+{
+  if (G_UNLIKELY(!find_terminators))
+    {
+      if (!find_crlf_set_simd_level(FIND_CRLF_SIMD_AVX512BW) &&
+          !find_crlf_set_simd_level(FIND_CRLF_SIMD_AVX2) &&
+          !find_crlf_set_simd_level(FIND_CRLF_SIMD_SSE2) &&
+          !find_crlf_set_simd_level(FIND_CRLF_SIMD_NEON))
+        find_crlf_set_simd_level(FIND_CRLF_SIMD_NONE);
+    }
+  return find_terminators;
+}
+
+static inline gsize
+_find_all_terminators(const gchar *s, gsize n, const gchar *terminators, guint32 *offsets, gsize max_offsets)
+{
+  if (max_offsets == 0)
+    return 0;
+  return _get_find_terminators()(s, n, terminators, offsets, max_offsets);
+}
+
+static inline const gchar *
+_find_first_terminator(const gchar *s, gsize n, const gchar *terminators)
+{
+  guint32 offset;
+
+  if (_find_all_terminators(s, n, terminators, &offset, 1) == 0)
+    return NULL;
+  return s + offset;
+}
+
+/**
+ * This is an optimized version of finding either a CR or LF or NUL
+ * character in a buffer.  It is used to find these line terminators in
+ * syslog traffic.
+ **/
+const gchar *
+find_cr_or_lf_or_nul(const gchar *s, gsize n)
+{
+  static const gchar terminators[3] = { '\r', '\n', '\0' };
+
+  return _find_first_terminator(s, n, terminators);
+}
+
+gsize
+find_all_cr_or_lf_or_nul(const gchar *s, gsize n, guint32 *offsets, gsize max_offsets)
+{
+  static const gchar terminators[3] = { '\r', '\n', '\0' };
+
+  return _find_all_terminators(s, n, terminators, offsets, max_offsets);
+}
+
+const gchar *
+find_lf_or_nul(const gchar *s, gsize n)
+{
+  static const gchar terminators[3] = { '\n', '\0', '\0' };
+
+  return _find_first_terminator(s, n, terminators);
+}
+
+gsize
+find_all_lf_or_nul(const gchar *s, gsize n, guint32 *offsets, gsize max_offsets)
+{
+  static const gchar terminators[3] = { '\n', '\0', '\0' };
+
+  return _find_all_terminators(s, n, terminators, offsets, max_offsets);
+}
+
+gsize
+find_all_char(const gchar *s, gsize n, gchar c, guint32 *offsets, gsize max_offsets)
+{
+  const gchar terminators[3] = { c, c, c };
 
-  return NULL;
+  return _find_all_terminators(s, n, terminators, offsets, max_offsets);
 }
@@ -25,6 +25,30 @@
 
 #include "syslog-ng.h"
 
+typedef enum
+{
+  FIND_CRLF_SIMD_NONE,
+  FIND_CRLF_SIMD_SSE2,
+  FIND_CRLF_SIMD_AVX2,
+  FIND_CRLF_SIMD_AVX512BW,
+  FIND_CRLF_SIMD_NEON,
+} FindCrlfSIMDLevel;
+
+/* the best available implementation is selected automatically, these are
+ * for tests and benchmarks */
+gboolean find_crlf_set_simd_level(FindCrlfSIMDLevel level);
+FindCrlfSIMDLevel find_crlf_get_simd_level(void);
+
 const gchar *find_cr_or_lf_or_nul(const gchar *s, gsize n);
+const gchar *find_lf_or_nul(const gchar *s, gsize n);
+
+/*
+ * Multi-terminator variants: store the offsets (relative to s) of up to
+ * max_offsets terminators into offsets in a single pass and return the
+ * number found.  The buffer must be smaller than 4GB.
+ */
+gsize find_all_cr_or_lf_or_nul(const gchar *s, gsize n, guint32 *offsets, gsize max_offsets);
+gsize find_all_lf_or_nul(const gchar *s, gsize n, guint32 *offsets, gsize max_offsets);
+gsize find_all_char(const gchar *s, gsize n, gchar c, guint32 *offsets, gsize max_offsets);
 
 #endif
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "logmatcher-hyperscan.h"
+
+#if SYSLOG_NG_ENABLE_HYPERSCAN
+
+#include "messages.h"
+#include "str-utils.h"
+
+#include <hs.h>
+
+struct _LogMatcherHyperscanSet
+{
+  GPtrArray *expressions;
+  GArray *flags;
+  hs_database_t *database;
+};
+
+/* hs_scratch_t is per-thread and is grown to fit every database it is used with */
+static GPrivate scratch_key = G_PRIVATE_INIT((GDestroyNotify) hs_free_scratch);
+
+static hs_scratch_t *
+_get_scratch(const hs_database_t *database)
+{
+  hs_scratch_t *scratch = g_private_get(&scratch_key);
+  hs_scratch_t *prev_scratch = scratch;
+
+  if (hs_alloc_scratch(database, &scratch) != HS_SUCCESS)
+    return NULL;
+
+  /* hs_alloc_scratch() frees the old scratch area if it had to grow it */
+  if (scratch != prev_scratch)
+    g_private_set(&scratch_key, scratch);
+  return scratch;
+}
+
+static gboolean
+_translate_flags(gint flags, guint *hs_flags, GError **error)
+{
+  if (flags & LMF_STORE_MATCHES)
+    {
+      g_set_error(error, LOG_TEMPLATE_ERROR, 0, "The hyperscan matcher does not support the store-matches flag");
+      return FALSE;
+    }
+  if (flags & LMF_NEWLINE)
+    {
+      g_set_error(error, LOG_TEMPLATE_ERROR, 0, "The hyperscan matcher does not support the newline flag");
+      return FALSE;
+    }
+
+  *hs_flags = HS_FLAG_SINGLEMATCH | HS_FLAG_ALLOWEMPTY;
+  if (flags & LMF_ICASE)
+    *hs_flags |= HS_FLAG_CASELESS;
+  /* no HS_FLAG_UCP: the pcre matcher does not set PCRE2_UCP either, so
+   * \w, \d and \b only match ASCII characters in both */
+  if (flags & LMF_UTF8)
+    *hs_flags |= HS_FLAG_UTF8;
+  return TRUE;
+}
+
+LogMatcherHyperscanSet *
+log_matcher_hyperscan_set_new(void)
+{
+  LogMatcherHyperscanSet *self = g_new0(LogMatcherHyperscanSet, 1);
+
+  self->expressions = g_ptr_array_new_with_free_func(g_free);
+  self->flags = g_array_new(FALSE, FALSE, sizeof(guint));
+  return self;
+}
+
+/* patterns using PCRE features that Hyperscan lacks (backreferences,
+ * lookarounds, etc) are rejected here, so the caller can fall back to PCRE */
+gboolean
+log_matcher_hyperscan_set_add_pattern(LogMatcherHyperscanSet *self, const gchar *pattern, gint flags,
+                                      GError **error)
+{
+  hs_database_t *database = NULL;
+  hs_compile_error_t *compile_error = NULL;
+  guint hs_flags;
+
+  g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+  g_assert(!self->database);
+
+  if (!_translate_flags(flags, &hs_flags, error))
+    return FALSE;
+
+  if (hs_compile(pattern, hs_flags, HS_MODE_BLOCK, NULL, &database, &compile_error) != HS_SUCCESS)
+    {
+      g_set_error(error, LOG_TEMPLATE_ERROR, 0, "Failed to compile hyperscan expression >>>%s<<< `%s'",
+                  pattern, compile_error->message);
+      hs_free_compile_error(compile_error);
+      return FALSE;
+    }
+  hs_free_database(database);
+
+  g_ptr_array_add(self->expressions, g_strdup(pattern));
+  g_array_append_val(self->flags, hs_flags);
+  return TRUE;
+}
+
+gboolean
+log_matcher_hyperscan_set_compile(LogMatcherHyperscanSet *self, GError **error)
+{
+  hs_compile_error_t *compile_error = NULL;
+  guint num_patterns = self->expressions->len;
+  guint ids[num_patterns];
+
+  g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+  for (guint i = 0; i < num_patterns; i++)
+    ids[i] = i;
+
+  hs_free_database(self->database);
+  self->database = NULL;
+  if (hs_compile_multi((const gchar *const *) self->expressions->pdata, (const guint *) self->flags->data, ids,
+                       num_patterns, HS_MODE_BLOCK, NULL, &self->database, &compile_error) != HS_SUCCESS)
+    {
+      g_set_error(error, LOG_TEMPLATE_ERROR, 0, "Failed to compile hyperscan database: %s",
+                  compile_error->message);
+      hs_free_compile_error(compile_error);
+      return FALSE;
+    }
+  return TRUE;
+}
+
+static gint
+_on_match(guint id, unsigned long long from, unsigned long long to, guint flags, gpointer user_data)
+{
+  gboolean *matched = (gboolean *) user_data;
+
+  *matched = TRUE;
+
+  /* stop scanning, we are only interested in whether any of the patterns match */
+  return 1;
+}
+
+gboolean
+log_matcher_hyperscan_set_match(LogMatcherHyperscanSet *self, const gchar *value, gssize value_len)
+{
+  gboolean matched = FALSE;
+
+  if (value_len < 0)
+    value_len = strlen(value);
+
+  hs_scratch_t *scratch = _get_scratch(self->database);
+  if (!scratch)
+    {
+      msg_error("Error allocating hyperscan scratch space");
+      return FALSE;
+    }
+
+  hs_error_t rc = hs_scan(self->database, value, value_len, 0, scratch, _on_match, &matched);
+  if (rc != HS_SUCCESS && rc != HS_SCAN_TERMINATED)
+    msg_error("Error while matching regexp",
+              evt_tag_int("error_code", rc));
+  return matched;
+}
+
+gboolean
+log_matcher_hyperscan_set_match_value(LogMatcherHyperscanSet *self, LogMessage *msg, NVHandle value_handle)
+{
+  gssize value_len = 0;
+  const gchar *value = log_msg_get_value(msg, value_handle, &value_len);
+
+  return log_matcher_hyperscan_set_match(self, value, value_len);
+}
+
+gint
+log_matcher_hyperscan_set_get_size(LogMatcherHyperscanSet *self)
+{
+  return self->expressions->len;
+}
+
+void
+log_matcher_hyperscan_set_free(LogMatcherHyperscanSet *self)
+{
+  hs_free_database(self->database);
+  g_ptr_array_free(self->expressions, TRUE);
+  g_array_free(self->flags, TRUE);
+  g_free(self);
+}
+#endif
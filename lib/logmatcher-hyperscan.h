@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef LOGMATCHER_HYPERSCAN_H_INCLUDED
+#define LOGMATCHER_HYPERSCAN_H_INCLUDED
+
+#include "logmatcher.h"
+
+/*
+ * A set of regular expressions compiled into a single Hyperscan
+ * database, the value is scanned once to decide whether any of the
+ * patterns match.  Only match semantics are supported: no capture groups
+ * and no replacement.
+ */
+typedef struct _LogMatcherHyperscanSet LogMatcherHyperscanSet;
+
+LogMatcherHyperscanSet *log_matcher_hyperscan_set_new(void);
+gboolean log_matcher_hyperscan_set_add_pattern(LogMatcherHyperscanSet *self, const gchar *pattern, gint flags,
+                                               GError **error);
+gboolean log_matcher_hyperscan_set_compile(LogMatcherHyperscanSet *self, GError **error);
+gboolean log_matcher_hyperscan_set_match(LogMatcherHyperscanSet *self, const gchar *value, gssize value_len);
+gboolean log_matcher_hyperscan_set_match_value(LogMatcherHyperscanSet *self, LogMessage *msg, NVHandle value_handle);
+gint log_matcher_hyperscan_set_get_size(LogMatcherHyperscanSet *self);
+void log_matcher_hyperscan_set_free(LogMatcherHyperscanSet *self);
+
+LogMatcher *log_matcher_hyperscan_new(const LogMatcherOptions *options);
+
+#endif
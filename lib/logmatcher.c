@@ -22,6 +22,7 @@
  */
 
 #include "logmatcher.h"
+#include "logmatcher-hyperscan.h"
 #include "messages.h"
 #include "cfg.h"
 #include "str-utils.h"
@@ -734,6 +735,68 @@ log_matcher_pcre_set_nv_prefix(LogMatcher *s, const gchar *prefix)
     }
 }
 
+#if SYSLOG_NG_ENABLE_HYPERSCAN
+
+/* hyperscan support, match only */
+
+typedef struct _LogMatcherHyperscan
+{
+  LogMatcher super;
+  LogMatcherHyperscanSet *set;
+} LogMatcherHyperscan;
+
+static gboolean
+log_matcher_hyperscan_compile(LogMatcher *s, const gchar *re, GError **error)
+{
+  LogMatcherHyperscan *self = (LogMatcherHyperscan *) s;
+
+  g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+  log_matcher_store_pattern(s, re);
+
+  if (self->set)
+    log_matcher_hyperscan_set_free(self->set);
+  self->set = log_matcher_hyperscan_set_new();
+
+  if (!log_matcher_hyperscan_set_add_pattern(self->set, re, s->flags, error))
+    return FALSE;
+
+  return log_matcher_hyperscan_set_compile(self->set, error);
+}
+
+static gboolean
+log_matcher_hyperscan_match(LogMatcher *s, LogMessage *msg, gint value_handle, const gchar *value, gssize value_len)
+{
+  LogMatcherHyperscan *self = (LogMatcherHyperscan *) s;
+
+  return log_matcher_hyperscan_set_match(self->set, value, value_len);
+}
+
+static void
+log_matcher_hyperscan_free(LogMatcher *s)
+{
+  LogMatcherHyperscan *self = (LogMatcherHyperscan *) s;
+
+  if (self->set)
+    log_matcher_hyperscan_set_free(self->set);
+  log_matcher_free_method(s);
+}
+
+LogMatcher *
+log_matcher_hyperscan_new(const LogMatcherOptions *options)
+{
+  LogMatcherHyperscan *self = g_new0(LogMatcherHyperscan, 1);
+
+  log_matcher_init(&self->super, options);
+  self->super.compile = log_matcher_hyperscan_compile;
+  self->super.match = log_matcher_hyperscan_match;
+  self->super.replace = NULL;
+  self->super.free_fn = log_matcher_hyperscan_free;
+
+  return &self->super;
+}
+
+#endif
+
 typedef LogMatcher *(*LogMatcherConstructFunc)(const LogMatcherOptions *options);
 
 gboolean
@@ -797,6 +860,9 @@ struct
   { "pcre", log_matcher_pcre_re_new },
   { "string", log_matcher_string_new },
   { "glob", log_matcher_glob_new },
+#if SYSLOG_NG_ENABLE_HYPERSCAN
+  { "hyperscan", log_matcher_hyperscan_new },
+#endif
   { NULL, NULL },
 };
 
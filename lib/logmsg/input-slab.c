@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "logmsg/input-slab.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-single.h"
+
+static StatsCounterItem *count_pinned_bytes;
+
+InputSlab *
+input_slab_new(gsize size)
+{
+  InputSlab *self = g_malloc(sizeof(InputSlab) + size);
+
+  g_atomic_counter_set(&self->ref_cnt, 1);
+  self->retired = FALSE;
+  self->size = size;
+  return self;
+}
+
+/* only valid as long as nobody else holds a reference */
+InputSlab *
+input_slab_realloc(InputSlab *self, gsize size)
+{
+  g_assert(!input_slab_is_shared(self));
+
+  self = g_realloc(self, sizeof(InputSlab) + size);
+  self->size = size;
+  return self;
+}
+
+InputSlab *
+input_slab_ref(InputSlab *self)
+{
+  g_atomic_counter_inc(&self->ref_cnt);
+  return self;
+}
+
+void
+input_slab_unref(InputSlab *self)
+{
+  if (self && g_atomic_counter_dec_and_test(&self->ref_cnt))
+    {
+      if (self->retired)
+        stats_counter_sub(count_pinned_bytes, self->size);
+      g_free(self);
+    }
+}
+
+/* drop the owner's reference, the slab lives on as long as messages refer to it */
+void
+input_slab_retire(InputSlab *self)
+{
+  if (!self)
+    return;
+
+  self->retired = TRUE;
+  stats_counter_add(count_pinned_bytes, self->size);
+  input_slab_unref(self);
+}
+
+void
+input_slab_register_stats(void)
+{
+  StatsClusterKey sc_key;
+
+  stats_cluster_single_key_set(&sc_key, METRIC(events_pinned_input_bytes), NULL, 0);
+  stats_register_counter(1, &sc_key, SC_TYPE_SINGLE_VALUE, &count_pinned_bytes);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef LOGMSG_INPUT_SLAB_H_INCLUDED
+#define LOGMSG_INPUT_SLAB_H_INCLUDED
+
+#include "syslog-ng.h"
+#include "atomic.h"
+
+/*
+ * InputSlab is a reference counted input buffer.  It is owned by the
+ * LogProto instance that reads into it, while LogMessage instances parsed
+ * from its contents may hold additional references, so that their
+ * payload can point into the slab instead of copying the data.
+ *
+ * The owner never writes into parts of the slab that was handed out to
+ * messages, rather it retires the slab and allocates a new one.  Retired
+ * slabs are only kept alive by the messages that reference them, the
+ * amount of memory held this way is tracked by the
+ * events_pinned_input_bytes metric.
+ */
+typedef struct _InputSlab
+{
+  GAtomicCounter ref_cnt;
+  gboolean retired;
+  gsize size;
+  guchar data[];
+} InputSlab;
+
+InputSlab *input_slab_new(gsize size);
+InputSlab *input_slab_realloc(InputSlab *self, gsize size);
+InputSlab *input_slab_ref(InputSlab *self);
+void input_slab_unref(InputSlab *self);
+void input_slab_retire(InputSlab *self);
+
+void input_slab_register_stats(void);
+
+static inline gboolean
+input_slab_is_shared(InputSlab *self)
+{
+  return g_atomic_counter_get(&self->ref_cnt) > 1;
+}
+
+static inline gboolean
+input_slab_contains(InputSlab *self, const gchar *data, gsize len)
+{
+  const guchar *p = (const guchar *) data;
+
+  return p >= self->data && len <= self->size && p <= self->data + self->size - len;
+}
+
+#endif
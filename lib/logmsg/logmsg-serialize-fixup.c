@@ -243,6 +243,12 @@ _validate_entry(LogMessageSerializationState *state, NVEntry *entry)
   if ((guint8 *)entry + entry->alloc_len > ((guint8 *)nvtable + nvtable->size))
     return FALSE;
 
+  /* external values point to memory outside of the NVTable, they are
+   * never serialized.  Earlier versions didn't zero the flags, those are
+   * masked out later in _update_entry() */
+  if ((state->nvtable_flags & NVT_SUPPORTS_UNSET) && entry->external)
+    return FALSE;
+
   if (!entry->indirect)
     {
       if (entry->alloc_len < NV_ENTRY_DIRECT_HDR + entry->name_len + 1 + entry->vdirect.value_len + 1)
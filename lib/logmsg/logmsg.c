@@ -447,6 +447,21 @@ _unshare_payload_if_needed(LogMessage *self, guint32 memory_needed)
     }
 }
 
+/* values shorter than this are cheaper to copy than to reference */
+#define LOGMSG_MIN_BORROWED_VALUE_LEN 32
+
+static inline gboolean
+_is_value_borrowable_from_input_slab(LogMessage *self, const gchar *value, gssize value_len)
+{
+  /* NOTE: builtin values are expected to be NUL terminated, so we only
+   * borrow values that are followed by a NUL character in the slab */
+  return self->input_slab &&
+         value_len >= LOGMSG_MIN_BORROWED_VALUE_LEN &&
+         value_len <= NV_TABLE_MAX_BYTES &&
+         input_slab_contains(self->input_slab, value, value_len + 1) &&
+         value[value_len] == '\0';
+}
+
 static inline gboolean
 _grow_payload(LogMessage *self, const gchar *operation, gsize extra_space)
 {
@@ -510,16 +525,32 @@ log_msg_set_value_with_type(LogMessage *self, NVHandle handle,
                 evt_tag_msg_reference(self));
     }
 
-  _unshare_payload_if_needed(self, name_len + value_len + 2);
-
-  /* we need a loop here as a single realloc may not be enough. Might help
-   * if we pass how much bytes we need though. */
-
   guint32 memory_needed = 0;
-  while (!nv_table_add_value(self->payload, handle, name, name_len, value, value_len, type, &new_entry, &memory_needed))
+  if (_is_value_borrowable_from_input_slab(self, value, value_len))
     {
-      if (!_grow_payload(self, "set_value", memory_needed))
-        break;
+      /* zero-copy: the value stays in the input buffer, which we hold a reference to */
+      _unshare_payload_if_needed(self, name_len + 1);
+
+      while (!nv_table_add_value_external(self->payload, handle, name, name_len, value, value_len, type, &new_entry,
+                                          &memory_needed))
+        {
+          if (!_grow_payload(self, "set_value_external", memory_needed))
+            break;
+        }
+    }
+  else
+    {
+      _unshare_payload_if_needed(self, name_len + value_len + 2);
+
+      /* we need a loop here as a single realloc may not be enough. Might help
+       * if we pass how much bytes we need though. */
+
+      while (!nv_table_add_value(self->payload, handle, name, name_len, value, value_len, type, &new_entry,
+                                 &memory_needed))
+        {
+          if (!_grow_payload(self, "set_value", memory_needed))
+            break;
+        }
     }
 
   if (new_entry)
@@ -1203,6 +1234,30 @@ log_msg_set_daddr_ref(LogMessage *self, GSockAddr *daddr)
   self->flags |= LF_STATE_OWN_DADDR;
 }
 
+/**
+ * log_msg_set_input_slab:
+ * @self: LogMessage instance
+ * @slab: the input buffer the message is about to be parsed from
+ *
+ * Values set from within @slab that are followed by a NUL character are
+ * stored as references instead of copies, which is why @slab is kept
+ * alive as long as the message is.
+ **/
+void
+log_msg_set_input_slab(LogMessage *self, InputSlab *slab)
+{
+  input_slab_unref(self->input_slab);
+  self->input_slab = slab ? input_slab_ref(slab) : NULL;
+}
+
+/* drop the reference to the input buffer if none of the values point into it */
+void
+log_msg_release_unused_input_slab(LogMessage *self)
+{
+  if (self->input_slab && !nv_table_has_external_values(self->payload))
+    log_msg_set_input_slab(self, NULL);
+}
+
 /**
  * log_msg_init:
  * @self: LogMessage instance
@@ -1267,6 +1322,7 @@ log_msg_clear(LogMessage *self)
   if (log_msg_chk_flag(self, LF_STATE_OWN_DADDR))
     g_sockaddr_unref(self->daddr);
   self->daddr = NULL;
+  log_msg_set_input_slab(self, NULL);
 
   /* clear "local", "utf8", "internal", "mark" and similar flags, we start afresh */
   self->flags = LF_STATE_OWN_MASK;
@@ -1376,8 +1432,10 @@ log_msg_clone_cow(LogMessage *msg, const LogPathOptions *path_options)
   /* every field _must_ be initialized explicitly if its direct
    * copying would cause problems (like copying a pointer by value) */
 
-  /* reference the original message */
+  /* reference the original message, it keeps the input buffer alive for
+   * values that may point into it */
   self->original = log_msg_ref(msg);
+  self->input_slab = NULL;
   self->ack_and_ref_and_abort_and_suspended = LOGMSG_REFCACHE_REF_TO_VALUE(1) + LOGMSG_REFCACHE_ACK_TO_VALUE(
                                                 0) + LOGMSG_REFCACHE_ABORT_TO_VALUE(0);
   g_atomic_int_set(&self->cur_node, 0);
@@ -1500,6 +1558,7 @@ _log_msg_free(LogMessage *self)
 
   if (self->original)
     log_msg_unref(self->original);
+  input_slab_unref(self->input_slab);
 
   stats_counter_sub(count_allocated_bytes, self->allocated_bytes);
 
@@ -1721,6 +1780,8 @@ log_msg_register_stats(void)
   stats_cluster_single_key_set(&sc_key, METRIC(events_allocated_bytes), NULL, 0);
   stats_cluster_single_key_add_legacy_alias(&sc_key, SCS_GLOBAL, "msg_allocated_bytes", NULL);
   stats_register_counter(1, &sc_key, SC_TYPE_SINGLE_VALUE, &count_allocated_bytes);
+
+  input_slab_register_stats();
   stats_unlock();
 }
 
@@ -31,6 +31,7 @@
 #include "timeutils/unixtime.h"
 #include "logmsg/nvtable.h"
 #include "logmsg/tags.h"
+#include "logmsg/input-slab.h"
 #include "messages.h"
 
 #include <sys/types.h>
@@ -315,6 +316,11 @@ struct _LogMessage
   GSockAddr *saddr;
   GSockAddr *daddr;
 
+  /* the input buffer this message was parsed from, values in the payload
+   * may point into it instead of being copied, see
+   * log_msg_set_input_slab().  Not shared with clones. */
+  InputSlab *input_slab;
+
   UnixTime timestamps[LM_TS_MAX];
 
   /* the next available node */
@@ -717,6 +723,8 @@ void log_msg_set_saddr(LogMessage *self, GSockAddr *saddr);
 void log_msg_set_saddr_ref(LogMessage *self, GSockAddr *saddr);
 void log_msg_set_daddr(LogMessage *self, GSockAddr *daddr);
 void log_msg_set_daddr_ref(LogMessage *self, GSockAddr *daddr);
+void log_msg_set_input_slab(LogMessage *self, InputSlab *slab);
+void log_msg_release_unused_input_slab(LogMessage *self);
 
 
 LogMessageQueueNode *log_msg_alloc_queue_node(LogMessage *msg, const LogPathOptions *path_options);
@@ -241,6 +241,17 @@ nv_table_serialize(LogMessageSerializationState *state, NVTable *self)
   NVTableMetaData meta_data = { 0 };
   SerializeArchive *sa = state->sa;
 
+  if (G_UNLIKELY(nv_table_has_external_values(self)))
+    {
+      /* values pointing outside of the NVTable can't be written as is,
+       * compaction converts them to direct values */
+      NVTable *compacted = nv_table_compact(self);
+      gboolean result = nv_table_serialize(state, compacted);
+
+      nv_table_unref(compacted);
+      return result;
+    }
+
   _fill_meta_data(self, &meta_data);
   _write_meta_data(sa, &meta_data);
 
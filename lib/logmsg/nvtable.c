@@ -269,7 +269,7 @@ nv_table_resolve_indirect(NVTable *self, NVEntry *entry, gssize *length)
 static inline const gchar *
 nv_table_resolve_direct(NVTable *self, NVEntry *entry, gssize *length)
 {
-  g_assert(!entry->indirect);
+  g_assert(!entry->indirect && !entry->external);
 
   if (length)
     *length = entry->vdirect.value_len;
@@ -293,6 +293,8 @@ nv_table_resolve_entry(NVTable *self, NVEntry *entry, gssize *length, NVType *ty
 
   if (entry->indirect)
     return nv_table_resolve_indirect(self, entry, length);
+  else if (entry->external)
+    return nv_table_resolve_external(entry, length);
   else
     return nv_table_resolve_direct(self, entry, length);
 }
@@ -459,7 +461,7 @@ _overwrite_with_a_direct_entry(NVTable *self, NVHandle handle, NVEntry *entry, c
   gchar *dst;
 
   /* this value already exists and the new value fits in the old space */
-  if (!entry->indirect)
+  if (!entry->indirect && !entry->external)
     {
       dst = entry->vdirect.data + entry->name_len + 1;
 
@@ -469,8 +471,9 @@ _overwrite_with_a_direct_entry(NVTable *self, NVHandle handle, NVEntry *entry, c
     }
   else
     {
-      /* this was an indirect entry, convert it */
+      /* this was an indirect or external entry, convert it */
       entry->indirect = 0;
+      entry->external = 0;
       entry->vdirect.value_len = value_len;
 
       if (!nv_table_is_handle_static(self, handle))
@@ -586,6 +589,11 @@ nv_table_unset_value(NVTable *self, NVHandle handle, guint32 *memory_needed)
       entry->vindirect.ofs = 0;
       entry->vindirect.len = 0;
     }
+  else if (entry->external)
+    {
+      entry->vexternal.len = 0;
+      memcpy(entry->vexternal.ptr, &null_string, sizeof(null_string));
+    }
   else
     {
       entry->vdirect.value_len = 0;
@@ -608,8 +616,9 @@ nv_table_set_indirect_entry(NVTable *self, NVHandle handle, NVEntry *entry, cons
   if (entry->indirect)
     return;
 
-  /* previously a non-indirect entry, convert it */
+  /* previously a direct or external entry, convert it */
   entry->indirect = 1;
+  entry->external = 0;
 
   if (!nv_table_is_handle_static(self, handle))
     {
@@ -717,6 +726,85 @@ nv_table_add_value_indirect(NVTable *self, NVHandle handle, const gchar *name, g
   return TRUE;
 }
 
+static void
+nv_table_set_external_entry(NVTable *self, NVHandle handle, NVEntry *entry, const gchar *name, gsize name_len,
+                            const gchar *value, gsize value_len, NVType type)
+{
+  entry->indirect = 0;
+  entry->external = 1;
+  entry->unset = FALSE;
+  entry->type = type;
+  entry->vexternal.len = value_len;
+  memcpy(entry->vexternal.ptr, &value, sizeof(value));
+
+  if (!nv_table_is_handle_static(self, handle))
+    {
+      entry->name_len = name_len;
+      memmove(entry->vexternal.name, name, name_len + 1);
+    }
+  else
+    {
+      entry->name_len = 0;
+    }
+}
+
+/*
+ * Store a reference to @value instead of copying it.  @value must be NUL
+ * terminated and the caller has to make sure that it remains valid as long
+ * as this NVTable (or any of its clones) is alive.
+ */
+gboolean
+nv_table_add_value_external(NVTable *self, NVHandle handle,
+                            const gchar *name, gsize name_len,
+                            const gchar *value, gsize value_len,
+                            NVType type,
+                            gboolean *new_entry,
+                            guint32 *memory_needed)
+{
+  NVEntry *entry;
+  NVIndexEntry *index_entry, *index_slot;
+  guint32 ofs, mem = 0;
+
+  g_assert(value_len <= NV_TABLE_MAX_BYTES);
+
+  if (new_entry)
+    *new_entry = FALSE;
+
+  mem += NV_TABLE_BOUND(NV_ENTRY_EXTERNAL_SIZE(name_len)) + sizeof(NVIndexEntry);
+  entry = nv_table_get_entry(self, handle, &index_entry, &index_slot);
+  if (!nv_table_break_references_to_entry(self, handle, entry, &mem))
+    {
+      *memory_needed += mem;
+      return FALSE;
+    }
+
+  if (entry && entry->alloc_len >= NV_ENTRY_EXTERNAL_SIZE(entry->name_len))
+    {
+      nv_table_set_external_entry(self, handle, entry, name, name_len, value, value_len, type);
+      return TRUE;
+    }
+  else if (!entry && new_entry)
+    *new_entry = TRUE;
+
+  if (!_alloc_index_entry(self, handle, &index_entry, index_slot))
+    {
+      *memory_needed += mem;
+      return FALSE;
+    }
+
+  entry = nv_table_alloc_value(self, NV_ENTRY_EXTERNAL_SIZE(nv_table_is_handle_static(self, handle) ? 0 : name_len));
+  if (G_UNLIKELY(!entry))
+    {
+      *memory_needed += mem;
+      return FALSE;
+    }
+
+  ofs = nv_table_get_ofs_for_an_entry(self, entry);
+  nv_table_set_external_entry(self, handle, entry, name, name_len, value, value_len, type);
+  nv_table_set_table_entry(self, handle, ofs, index_entry);
+  return TRUE;
+}
+
 static gboolean
 nv_table_call_foreach(NVHandle handle, NVEntry *entry, NVIndexEntry *index_entry, gpointer user_data)
 {
@@ -928,7 +1016,8 @@ _compact_foreach_entry(NVHandle handle, NVEntry *entry, NVIndexEntry *index_entr
 
   if (!entry->indirect)
     {
-      value = nv_table_resolve_direct(old, entry, &value_len);
+      /* external values are converted to direct ones, so that the result is self-contained */
+      value = nv_table_resolve_entry(old, entry, &value_len, NULL);
 
       guint32 memory_needed = 0;
       gboolean value_successfully_added =
@@ -958,10 +1047,36 @@ _compact_foreach_entry(NVHandle handle, NVEntry *entry, NVIndexEntry *index_entr
   return FALSE;
 }
 
+static gboolean
+_sum_external_values_size(NVHandle handle, NVEntry *entry, NVIndexEntry *index_entry, gpointer user_data)
+{
+  gsize *external_size = (gsize *) user_data;
+
+  if (entry->external && !entry->unset)
+    *external_size += NV_TABLE_BOUND(NV_ENTRY_DIRECT_SIZE(entry->name_len, entry->vexternal.len));
+  return FALSE;
+}
+
+static gboolean
+_is_external_entry(NVHandle handle, NVEntry *entry, NVIndexEntry *index_entry, gpointer user_data)
+{
+  return entry->external && !entry->unset;
+}
+
+gboolean
+nv_table_has_external_values(NVTable *self)
+{
+  return nv_table_foreach_entry(self, _is_external_entry, NULL);
+}
+
 NVTable *
 nv_table_compact(NVTable *self)
 {
-  gint new_size = self->size;
+  gsize new_size = self->size;
+
+  nv_table_foreach_entry(self, _sum_external_values_size, &new_size);
+  new_size = MIN(NV_TABLE_BOUND(new_size), NV_TABLE_MAX_BYTES);
+
   NVTable *new = g_malloc(new_size);
   gpointer args[2] = { self, new };
 
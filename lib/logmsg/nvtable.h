@@ -27,6 +27,8 @@
 #include "syslog-ng.h"
 #include "nvhandle-descriptors.h"
 
+#include <string.h>
+
 typedef struct _NVTable NVTable;
 typedef struct _NVRegistry NVRegistry;
 typedef struct _NVIndexEntry NVIndexEntry;
@@ -147,7 +149,8 @@ struct _NVEntry
              referenced:1,
              unset:1,
              type_present:1,
-             __bit_padding:4;
+             external:1,
+             __bit_padding:3;
     };
     guint8 flags;
   };
@@ -188,6 +191,18 @@ struct _NVEntry
 
       gchar name[0];
     } vindirect;
+
+    /* the value is stored outside of the NVTable (e.g. in an InputSlab),
+     * whoever sets such a value is responsible for keeping that memory
+     * around while the NVTable is alive.  These entries are never
+     * serialized, they are converted to direct values first. */
+    struct
+    {
+      guint32 len;
+      /* NVEntry instances are only 4 byte aligned, access via memcpy() */
+      gchar ptr[sizeof(const gchar *)];
+      gchar name[0];
+    } vexternal;
   };
 };
 
@@ -195,12 +210,15 @@ struct _NVEntry
 #define NV_ENTRY_DIRECT_SIZE(name_len, value_len) ((value_len) + NV_ENTRY_DIRECT_HDR + (name_len) + 2)
 #define NV_ENTRY_INDIRECT_HDR (sizeof(NVEntry))
 #define NV_ENTRY_INDIRECT_SIZE(name_len) (NV_ENTRY_INDIRECT_HDR + name_len + 1)
+#define NV_ENTRY_EXTERNAL_SIZE(name_len) NV_ENTRY_INDIRECT_SIZE(name_len)
 
 static inline const gchar *
 nv_entry_get_name(NVEntry *self)
 {
   if (self->indirect)
     return self->vindirect.name;
+  else if (self->external)
+    return self->vexternal.name;
   else
     return self->vdirect.data;
 }
@@ -309,6 +327,13 @@ gboolean nv_table_add_value_indirect(NVTable *self, NVHandle handle,
                                      NVType type,
                                      gboolean *new_entry,
                                      guint32 *memory_needed);
+gboolean nv_table_add_value_external(NVTable *self, NVHandle handle,
+                                     const gchar *name, gsize name_len,
+                                     const gchar *value, gsize value_len,
+                                     NVType type,
+                                     gboolean *new_entry,
+                                     guint32 *memory_needed);
+gboolean nv_table_has_external_values(NVTable *self);
 
 gboolean nv_table_foreach(NVTable *self, NVRegistry *registry, NVTableForeachFunc func, gpointer user_data);
 gboolean nv_table_foreach_entry(NVTable *self, NVTableForeachEntryFunc func, gpointer user_data);
@@ -379,6 +404,17 @@ nv_table_alloc_check(NVTable *self, gsize alloc_size)
 NVEntry *nv_table_get_entry_slow(NVTable *self, NVHandle handle, NVIndexEntry **index_entry, NVIndexEntry **index_slot);
 const gchar *nv_table_resolve_indirect(NVTable *self, NVEntry *entry, gssize *len);
 
+static inline const gchar *
+nv_table_resolve_external(NVEntry *entry, gssize *length)
+{
+  const gchar *value;
+
+  memcpy(&value, entry->vexternal.ptr, sizeof(value));
+  if (length)
+    *length = entry->vexternal.len;
+  return value;
+}
+
 
 static inline NVEntry *
 __nv_table_get_entry(NVTable *self, NVHandle handle, guint16 num_static_entries, NVIndexEntry **index_entry,
@@ -443,6 +479,8 @@ nv_table_get_value(NVTable *self, NVHandle handle, gssize *length, NVType *type)
     *type = entry->type;
   if (!entry->indirect)
     {
+      if (G_UNLIKELY(entry->external))
+        return nv_table_resolve_external(entry, length);
       if (length)
         *length = entry->vdirect.value_len;
       return entry->vdirect.data + entry->name_len + 1;
@@ -1180,3 +1180,90 @@ Test(nvtable, test_nvtable_compact_skips_unset_values)
 
   nv_table_unref(tab2);
 }
+
+Test(nvtable, test_nvtable_external_values_point_to_the_original_buffer)
+{
+  NVTable *tab;
+  gssize size = 9999;
+  const gchar *value;
+  const gchar *external_value = "external-foo";
+  guint32 memory_needed = 0;
+
+  tab = nv_table_new(STATIC_VALUES, STATIC_VALUES, 1024);
+  nv_table_add_value(tab, STATIC_HANDLE, STATIC_NAME, strlen(STATIC_NAME), "static-foo", 10, 0, NULL, &memory_needed);
+  cr_assert_not(nv_table_has_external_values(tab));
+
+  cr_assert(nv_table_add_value_external(tab, DYN_HANDLE, DYN_NAME, strlen(DYN_NAME),
+                                        external_value, strlen(external_value), 0, NULL, &memory_needed));
+  cr_assert(nv_table_has_external_values(tab));
+
+  value = nv_table_get_value(tab, DYN_HANDLE, &size, NULL);
+  cr_assert_eq(value, external_value);
+  cr_assert_eq(size, strlen(external_value));
+
+  /* overwriting the external value copies the new one into the table */
+  nv_table_add_value(tab, DYN_HANDLE, DYN_NAME, strlen(DYN_NAME), "dyn-foo", 7, 0, NULL, &memory_needed);
+  cr_assert_not(nv_table_has_external_values(tab));
+  assert_nvtable(tab, DYN_HANDLE, "dyn-foo", 7);
+
+  nv_table_add_value_external(tab, DYN_HANDLE, DYN_NAME, strlen(DYN_NAME),
+                              external_value, strlen(external_value), 0, NULL, &memory_needed);
+  nv_table_unset_value(tab, DYN_HANDLE, &memory_needed);
+  cr_assert_not(nv_table_has_external_values(tab));
+  value = nv_table_get_value(tab, DYN_HANDLE, &size, NULL);
+  cr_assert_null(value);
+  cr_assert_eq(size, 0);
+
+  nv_table_unref(tab);
+}
+
+Test(nvtable, test_nvtable_indirect_values_can_reference_external_ones)
+{
+  NVTable *tab;
+  const gchar *external_value = "external-foo";
+  const gchar *indirect_nv_name = "indirect-name";
+  guint32 memory_needed = 0;
+
+  tab = nv_table_new(STATIC_VALUES, STATIC_VALUES, 1024);
+  nv_table_add_value_external(tab, STATIC_HANDLE, STATIC_NAME, strlen(STATIC_NAME),
+                              external_value, strlen(external_value), 0, NULL, &memory_needed);
+  nv_table_add_value_indirect(tab, DYN_HANDLE, indirect_nv_name, strlen(indirect_nv_name),
+                              &(NVReferencedSlice)
+  {
+    STATIC_HANDLE, 9, 3
+  }, 0, NULL, &memory_needed);
+  assert_nvtable(tab, DYN_HANDLE, "foo", 3);
+
+  /* the referenced value changes, the indirect one keeps its original value */
+  nv_table_add_value(tab, STATIC_HANDLE, STATIC_NAME, strlen(STATIC_NAME), "static-bar", 10, 0, NULL, &memory_needed);
+  assert_nvtable(tab, DYN_HANDLE, "foo", 3);
+
+  nv_table_unref(tab);
+}
+
+Test(nvtable, test_nvtable_compact_copies_external_values_into_the_table)
+{
+  NVTable *tab1, *tab2;
+  gssize size = 9999;
+  const gchar *value;
+  gchar *external_value = g_strdup("external-foo");
+  guint32 memory_needed = 0;
+
+  tab1 = nv_table_new(STATIC_VALUES, STATIC_VALUES, 64);
+  nv_table_add_value_external(tab1, DYN_HANDLE, DYN_NAME, strlen(DYN_NAME),
+                              external_value, strlen(external_value), 0, NULL, &memory_needed);
+
+  tab2 = nv_table_compact(tab1);
+  nv_table_unref(tab1);
+  cr_assert_not(nv_table_has_external_values(tab2));
+
+  /* the compacted table does not refer to the original buffer anymore */
+  memset(external_value, 'x', strlen(external_value));
+  g_free(external_value);
+
+  value = nv_table_get_value(tab2, DYN_HANDLE, &size, NULL);
+  cr_assert_str_eq(value, "external-foo");
+  cr_assert_eq(size, 12);
+
+  nv_table_unref(tab2);
+}
@@ -67,6 +67,92 @@ _log_proto_buffered_server_fallback_non_persistent(LogProtoBufferedServer *self)
   return self->persist_state == NULL;
 }
 
+/*
+ * In zero-copy mode our buffer is an InputSlab, parts of which may be
+ * referenced by messages we already returned.  Those parts must not
+ * change, so when we are about to write there and the slab is still
+ * referenced, we continue in a new slab instead.
+ */
+static void
+log_proto_buffered_server_replace_slab(LogProtoBufferedServer *self, LogProtoBufferedServerState *state,
+                                       gsize buffer_size)
+{
+  InputSlab *new_slab = input_slab_new(buffer_size);
+
+  /* keep the unprocessed data at the same offset, as our position tracking refers to it */
+  if (state->pending_buffer_pos < state->pending_buffer_end && state->pending_buffer_end <= self->slab->size &&
+      state->pending_buffer_end <= buffer_size)
+    memcpy(new_slab->data + state->pending_buffer_pos, self->slab->data + state->pending_buffer_pos,
+           state->pending_buffer_end - state->pending_buffer_pos);
+
+  input_slab_retire(self->slab);
+  self->slab = new_slab;
+  self->slab_pinned_end = 0;
+  self->buffer = self->slab->data;
+}
+
+static void
+log_proto_buffered_server_resize_buffer(LogProtoBufferedServer *self, LogProtoBufferedServerState *state,
+                                        gsize buffer_size)
+{
+  if (!self->zero_copy)
+    {
+      self->buffer = g_realloc(self->buffer, buffer_size);
+      return;
+    }
+
+  if (self->slab && input_slab_is_shared(self->slab))
+    {
+      log_proto_buffered_server_replace_slab(self, state, buffer_size);
+      return;
+    }
+
+  if (!self->slab)
+    self->slab = input_slab_new(buffer_size);
+  else
+    self->slab = input_slab_realloc(self->slab, buffer_size);
+
+  self->slab_pinned_end = 0;
+  self->buffer = self->slab->data;
+}
+
+static inline void
+log_proto_buffered_server_prepare_write(LogProtoBufferedServer *self, LogProtoBufferedServerState *state,
+                                        gsize write_pos)
+{
+  if (!self->slab || write_pos >= self->slab_pinned_end)
+    return;
+
+  if (input_slab_is_shared(self->slab))
+    log_proto_buffered_server_replace_slab(self, state, state->buffer_size);
+  else
+    self->slab_pinned_end = 0;
+}
+
+/* NUL terminate the returned message in place and let it borrow our slab */
+static void
+log_proto_buffered_server_lend_message(LogProtoBufferedServer *self, const guchar *msg, gsize msg_len,
+                                       LogTransportAuxData *aux)
+{
+  if (!aux || !self->slab || !input_slab_contains(self->slab, (const gchar *) msg, msg_len))
+    return;
+
+  LogProtoBufferedServerState *state = log_proto_buffered_server_get_state(self);
+  gsize msg_end = msg + msg_len - self->buffer;
+
+  /* the byte following the message must be one we don't need anymore */
+  if (msg_end >= state->buffer_size ||
+      (msg_end >= state->pending_buffer_pos && msg_end < state->pending_buffer_end))
+    goto exit;
+
+  self->buffer[msg_end] = 0;
+  self->slab_pinned_end = MAX(self->slab_pinned_end, msg_end + 1);
+  log_transport_aux_data_set_input_slab(aux, self->slab);
+
+exit:
+  log_proto_buffered_server_put_state(self);
+}
+
 static gboolean
 log_proto_buffered_server_convert_from_raw(LogProtoBufferedServer *self, const guchar *raw_buffer, gsize raw_buffer_len)
 {
@@ -130,7 +216,7 @@ log_proto_buffered_server_convert_from_raw(LogProtoBufferedServer *self, const g
                   if (state->buffer_size > self->super.options->max_buffer_size)
                     state->buffer_size = self->super.options->max_buffer_size;
 
-                  self->buffer = g_realloc(self->buffer, state->buffer_size);
+                  log_proto_buffered_server_resize_buffer(self, state, state->buffer_size);
                 }
               else
                 {
@@ -191,9 +277,10 @@ log_proto_buffered_server_apply_state(LogProtoBufferedServer *self, PersistEntry
   if (!self->buffer)
     {
       gssize buffer_size = MAX(state->buffer_size, self->super.options->init_buffer_size);
-      self->buffer = g_malloc(buffer_size);
+      log_proto_buffered_server_resize_buffer(self, state, buffer_size);
       state->buffer_size = buffer_size;
     }
+  log_proto_buffered_server_prepare_write(self, state, 0);
   state->pending_buffer_end = 0;
 
   if (state->file_inode &&
@@ -412,7 +499,7 @@ log_proto_buffered_server_convert_state(LogProtoBufferedServer *self, guint8 per
       if (!self->buffer || state->buffer_size < buffer_len)
         {
           gsize buffer_size = MAX(self->super.options->init_buffer_size, buffer_len);
-          self->buffer = g_realloc(self->buffer, buffer_size);
+          log_proto_buffered_server_resize_buffer(self, state, buffer_size);
         }
       serialize_archive_free(archive);
 
@@ -682,6 +769,10 @@ log_proto_buffered_server_split_buffer(LogProtoBufferedServer *self, LogProtoBuf
   if (*buffer_start == self->buffer)
     return;
 
+  gsize buffer_start_pos = *buffer_start - self->buffer;
+  log_proto_buffered_server_prepare_write(self, state, 0);
+  *buffer_start = self->buffer + buffer_start_pos;
+
   /* move partial message to the beginning of the buffer to make space for new data */
   memmove(self->buffer, *buffer_start, buffer_bytes);
   state->pending_buffer_pos = 0;
@@ -760,7 +851,7 @@ static inline void
 log_proto_buffered_server_allocate_buffer(LogProtoBufferedServer *self, LogProtoBufferedServerState *state)
 {
   state->buffer_size = self->super.options->init_buffer_size;
-  self->buffer = g_malloc(state->buffer_size);
+  log_proto_buffered_server_resize_buffer(self, state, state->buffer_size);
 }
 
 static inline gint
@@ -784,6 +875,7 @@ log_proto_buffered_server_fetch_into_buffer(LogProtoBufferedServer *self)
 
   if (G_UNLIKELY(!self->buffer))
     log_proto_buffered_server_allocate_buffer(self, state);
+  log_proto_buffered_server_prepare_write(self, state, state->pending_buffer_end);
 
   if (self->convert == (GIConv) -1)
     {
@@ -1027,6 +1119,9 @@ exit:
     self->super.status = result;
   else
     {
+      if (result == LPS_SUCCESS && *msg && self->zero_copy)
+        log_proto_buffered_server_lend_message(self, *msg, *msg_len, aux);
+
       if (result == LPS_SUCCESS && bookmark && *msg)
         {
           _buffered_server_bookmark_fill(self, bookmark);
@@ -1062,7 +1157,10 @@ log_proto_buffered_server_free_method(LogProtoServer *s)
 
   log_transport_aux_data_destroy(&self->buffer_aux);
 
-  g_free(self->buffer);
+  if (self->slab)
+    input_slab_retire(self->slab);
+  else
+    g_free(self->buffer);
   if (self->state1)
     {
       g_free(self->state1);
@@ -1092,4 +1190,5 @@ log_proto_buffered_server_init(LogProtoBufferedServer *self, LogTransport *trans
     self->convert = (GIConv) -1;
   self->stream_based = TRUE;
   self->pos_tracking = log_proto_server_is_position_tracked(&self->super);
+  self->zero_copy = options->zero_copy_input;
 }
@@ -82,7 +82,10 @@ struct _LogProtoBufferedServer
                stream_based:1,
 
                no_multi_read:1,
-               flush_partial_message:1;
+               flush_partial_message:1,
+
+               /* self->buffer points into self->slab, see zero-copy-input() */
+               zero_copy:1;
   gint fetch_state;
   GIOStatus io_status;
   LogProtoBufferedServerState *state1;
@@ -90,6 +93,9 @@ struct _LogProtoBufferedServer
   PersistEntryHandle persist_handle;
   GIConv convert;
   guchar *buffer;
+  InputSlab *slab;
+  /* the part of the slab below this offset may be referenced by messages */
+  gsize slab_pinned_end;
 
   GIConv reverse_convert;
   gchar *reverse_buffer;
@@ -70,6 +70,12 @@ log_proto_client_options_set_timeout(LogProtoClientOptions *options, gint timeou
   options->idle_timeout = timeout;
 }
 
+void
+log_proto_client_options_set_write_batch_size(LogProtoClientOptions *options, gint write_batch_size)
+{
+  options->write_batch_size = write_batch_size;
+}
+
 gint
 log_proto_client_options_get_timeout(LogProtoClientOptions *options)
 {
@@ -81,6 +87,7 @@ log_proto_client_options_defaults(LogProtoClientOptions *options)
 {
   options->drop_input = FALSE;
   options->idle_timeout = 0;
+  options->write_batch_size = 1;
 }
 
 void
@@ -35,6 +35,9 @@ typedef struct _LogProtoClientOptions
 {
   gboolean drop_input;
   gint idle_timeout;
+  /* number of messages to coalesce into a single write, set by
+   * write-batch-size(), the default of 1 disables batching */
+  gint write_batch_size;
 } LogProtoClientOptions;
 
 typedef union _LogProtoClientOptionsStorage
@@ -55,6 +58,7 @@ typedef struct
 
 void log_proto_client_options_set_drop_input(LogProtoClientOptions *options, gboolean drop_input);
 void log_proto_client_options_set_timeout(LogProtoClientOptions *options, gint timeout);
+void log_proto_client_options_set_write_batch_size(LogProtoClientOptions *options, gint write_batch_size);
 gint log_proto_client_options_get_timeout(LogProtoClientOptions *options);
 
 void log_proto_client_options_defaults(LogProtoClientOptions *options);
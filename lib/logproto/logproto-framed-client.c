@@ -33,13 +33,9 @@ typedef struct _LogProtoFramedClient
   guchar frame_hdr_buf[9];
 } LogProtoFramedClient;
 
-static LogProtoStatus
-log_proto_framed_client_post(LogProtoClient *s, LogMessage *logmsg, guchar *msg, gsize msg_len, gboolean *consumed)
+static gsize
+_truncate_msg_len(const guchar *msg, gsize msg_len)
 {
-  LogProtoFramedClient *self = (LogProtoFramedClient *) s;
-  gint frame_hdr_len;
-  LogProtoStatus status;
-
   if (msg_len > 9999999)
     {
       static const guchar *warn_msg;
@@ -52,6 +48,25 @@ log_proto_framed_client_post(LogProtoClient *s, LogMessage *logmsg, guchar *msg,
         }
       msg_len = 9999999;
     }
+  return msg_len;
+}
+
+static gsize
+log_proto_framed_client_format_frame_header(LogProtoTextClient *s, const guchar *msg, gsize *msg_len,
+                                            guchar *frame_header)
+{
+  *msg_len = _truncate_msg_len(msg, *msg_len);
+  return g_snprintf((gchar *) frame_header, LOG_PROTO_TEXT_CLIENT_MAX_FRAME_HEADER, "%" G_GSIZE_FORMAT " ", *msg_len);
+}
+
+static LogProtoStatus
+log_proto_framed_client_post(LogProtoClient *s, LogMessage *logmsg, guchar *msg, gsize msg_len, gboolean *consumed)
+{
+  LogProtoFramedClient *self = (LogProtoFramedClient *) s;
+  gint frame_hdr_len;
+  LogProtoStatus status;
+
+  msg_len = _truncate_msg_len(msg, msg_len);
 
   status = LPS_SUCCESS;
   while (status == LPS_SUCCESS && !(*consumed) && self->super.partial == NULL)
@@ -80,7 +95,14 @@ log_proto_framed_client_new(LogTransport *transport, const LogProtoClientOptions
   LogProtoFramedClient *self = g_new0(LogProtoFramedClient, 1);
 
   log_proto_text_client_init(&self->super, transport, options);
-  self->super.super.post = log_proto_framed_client_post;
-  self->super.state = LPFCS_FRAME_SEND;
+  if (log_proto_text_client_is_batched(&self->super))
+    {
+      self->super.format_frame_header = log_proto_framed_client_format_frame_header;
+    }
+  else
+    {
+      self->super.super.post = log_proto_framed_client_post;
+      self->super.state = LPFCS_FRAME_SEND;
+    }
   return &self->super.super;
 }
@@ -52,6 +52,8 @@ struct _LogProtoServerOptions
   gint max_buffer_size;
   gint init_buffer_size;
   gint idle_timeout;
+  /* let messages reference the input buffer instead of copying values out of it */
+  gboolean zero_copy_input;
   AckTrackerFactory *ack_tracker_factory;
 };
 
@@ -24,6 +24,8 @@
 #include "messages.h"
 
 #include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
 
 static LogProtoStatus log_proto_text_client_flush(LogProtoClient *s);
 
@@ -35,7 +37,7 @@ log_proto_text_client_poll_prepare(LogProtoClient *s, GIOCondition *cond, GIOCon
   *cond = G_IO_OUT | G_IO_IN;
   *idle_cond = G_IO_IN;
 
-  return self->partial != NULL;
+  return self->partial != NULL || self->batch.count > 0;
 }
 
 static gboolean
@@ -47,7 +49,7 @@ log_proto_unidirectional_text_client_poll_prepare(LogProtoClient *s, GIOConditio
   *cond = G_IO_OUT;
   *idle_cond = 0;
 
-  return self->partial != NULL;
+  return self->partial != NULL || self->batch.count > 0;
 }
 
 static LogProtoStatus
@@ -213,6 +215,162 @@ log_proto_text_client_post(LogProtoClient *s, LogMessage *logmsg, guchar *msg, g
   return log_proto_text_client_submit_write(s, msg, msg_len, (GDestroyNotify) g_free, -1);
 }
 
+/*
+ * Vectored write mode
+ *
+ * Messages posted by LogWriter are not written one-by-one, rather they
+ * are collected (along with their optional frame header) and written out
+ * with a single writev() call once the batch is full or LogWriter asks us
+ * to flush.  In case of a partial write, the messages that were written
+ * completely are acked, the rest stays in the batch along with the
+ * position within the first element.
+ */
+static gint
+_batch_fill_iov(LogProtoTextClient *self)
+{
+  gint iov_count = 0;
+  gsize skip = self->batch.pos;
+
+  for (gint i = 0; i < self->batch.count; i++)
+    {
+      LogProtoTextClientBatchElem *elem = &self->batch.elems[i];
+
+      if (skip < elem->frame_header_len)
+        {
+          self->batch.iov[iov_count].iov_base = elem->frame_header + skip;
+          self->batch.iov[iov_count].iov_len = elem->frame_header_len - skip;
+          iov_count++;
+          skip = 0;
+        }
+      else
+        {
+          skip -= elem->frame_header_len;
+        }
+
+      self->batch.iov[iov_count].iov_base = elem->msg + skip;
+      self->batch.iov[iov_count].iov_len = elem->msg_len - skip;
+      iov_count++;
+      skip = 0;
+    }
+  return iov_count;
+}
+
+static void
+_batch_consume(LogProtoTextClient *self, gsize written)
+{
+  gint acked = 0;
+
+  written += self->batch.pos;
+  while (acked < self->batch.count)
+    {
+      LogProtoTextClientBatchElem *elem = &self->batch.elems[acked];
+      gsize elem_len = elem->frame_header_len + elem->msg_len;
+
+      if (written < elem_len)
+        break;
+
+      written -= elem_len;
+      g_free(elem->msg);
+      acked++;
+    }
+
+  self->batch.count -= acked;
+  memmove(self->batch.elems, &self->batch.elems[acked], self->batch.count * sizeof(self->batch.elems[0]));
+  self->batch.pos = written;
+
+  if (acked > 0)
+    log_proto_client_msg_ack(&self->super, acked);
+}
+
+static LogProtoStatus
+log_proto_text_client_flush_batch(LogProtoClient *s)
+{
+  LogProtoTextClient *self = (LogProtoTextClient *) s;
+
+  if (self->batch.count == 0)
+    return LPS_SUCCESS;
+
+  gint iov_count = _batch_fill_iov(self);
+  gssize rc = log_transport_stack_writev(&self->super.transport_stack, self->batch.iov, iov_count);
+  if (rc < 0)
+    {
+      if (errno != EAGAIN && errno != EINTR)
+        {
+          msg_error("I/O error occurred while writing",
+                    evt_tag_int("fd", self->super.transport_stack.fd),
+                    evt_tag_error(EVT_TAG_OSERROR));
+          return LPS_ERROR;
+        }
+
+      return LPS_SUCCESS;
+    }
+
+  _batch_consume(self, rc);
+  return self->batch.count > 0 ? LPS_PARTIAL : LPS_SUCCESS;
+}
+
+static LogProtoStatus
+log_proto_text_client_post_batched(LogProtoClient *s, LogMessage *logmsg, guchar *msg, gsize msg_len,
+                                   gboolean *consumed)
+{
+  LogProtoTextClient *self = (LogProtoTextClient *) s;
+
+  *consumed = FALSE;
+  if (self->batch.count >= self->batch.size)
+    {
+      const LogProtoStatus status = log_proto_text_client_flush_batch(s);
+
+      /* don't consume a new message if the flush failed or if it couldn't
+       * make room for it */
+      if (status == LPS_ERROR)
+        return status;
+      if (self->batch.count >= self->batch.size)
+        return LPS_PARTIAL;
+    }
+
+  LogProtoTextClientBatchElem *elem = &self->batch.elems[self->batch.count++];
+
+  elem->frame_header_len = self->format_frame_header
+                           ? self->format_frame_header(self, msg, &msg_len, elem->frame_header)
+                           : 0;
+  elem->msg = msg;
+  elem->msg_len = msg_len;
+  *consumed = TRUE;
+
+  if (self->batch.count == self->batch.size)
+    return log_proto_text_client_flush_batch(s);
+
+  return LPS_SUCCESS;
+}
+
+static void
+_batch_init(LogProtoTextClient *self, gint batch_size)
+{
+#ifdef IOV_MAX
+  /* every message may take two iovec entries: frame header and payload */
+  if (batch_size > IOV_MAX / 2)
+    batch_size = IOV_MAX / 2;
+#endif
+
+  self->batch.size = batch_size;
+  self->batch.elems = g_new(LogProtoTextClientBatchElem, batch_size);
+  self->batch.iov = g_new(struct iovec, batch_size * 2);
+
+  self->super.post = log_proto_text_client_post_batched;
+  self->super.flush = log_proto_text_client_flush_batch;
+}
+
+static void
+_batch_free(LogProtoTextClient *self)
+{
+  for (gint i = 0; i < self->batch.count; i++)
+    g_free(self->batch.elems[i].msg);
+  self->batch.count = 0;
+
+  g_free(self->batch.elems);
+  g_free(self->batch.iov);
+}
+
 void
 log_proto_text_client_free(LogProtoClient *s)
 {
@@ -220,6 +378,7 @@ log_proto_text_client_free(LogProtoClient *s)
   if (self->partial_free)
     self->partial_free(self->partial);
   self->partial = NULL;
+  _batch_free(self);
   log_proto_client_free_method(s);
 };
 
@@ -233,6 +392,9 @@ log_proto_text_client_init(LogProtoTextClient *self, LogTransport *transport, co
   self->super.post = log_proto_text_client_post;
   self->super.free_fn = log_proto_text_client_free;
   self->next_state = -1;
+
+  if (options->write_batch_size > 1)
+    _batch_init(self, options->write_batch_size);
 }
 
 LogProtoClient *
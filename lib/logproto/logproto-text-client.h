@@ -25,14 +25,45 @@
 
 #include "logproto-client.h"
 
-typedef struct _LogProtoTextClient
+#define LOG_PROTO_TEXT_CLIENT_MAX_FRAME_HEADER 16
+
+typedef struct _LogProtoTextClientBatchElem
+{
+  guchar frame_header[LOG_PROTO_TEXT_CLIENT_MAX_FRAME_HEADER];
+  gsize frame_header_len;
+  guchar *msg;
+  gsize msg_len;
+} LogProtoTextClientBatchElem;
+
+typedef struct _LogProtoTextClient LogProtoTextClient;
+struct _LogProtoTextClient
 {
   LogProtoClient super;
   gint state, next_state;
   guchar *partial;
   GDestroyNotify partial_free;
   gsize partial_len, partial_pos;
-} LogProtoTextClient;
+
+  /* vectored write mode (enabled by write_batch_size): posted messages are
+   * collected and written out with a single writev() call, the number of
+   * acked messages is derived from the number of bytes actually written */
+  gsize (*format_frame_header)(LogProtoTextClient *self, const guchar *msg, gsize *msg_len, guchar *frame_header);
+  struct
+  {
+    gint size;
+    gint count;
+    /* number of bytes already written from the first element */
+    gsize pos;
+    LogProtoTextClientBatchElem *elems;
+    struct iovec *iov;
+  } batch;
+};
+
+static inline gboolean
+log_proto_text_client_is_batched(LogProtoTextClient *self)
+{
+  return self->batch.size > 0;
+}
 
 LogProtoStatus log_proto_text_client_submit_write(LogProtoClient *s, guchar *msg, gsize msg_len,
                                                   GDestroyNotify msg_free, gint next_state);
@@ -22,6 +22,7 @@
  */
 #include "logproto-text-server.h"
 #include "messages.h"
+#include "find-crlf.h"
 
 #include <string.h>
 
@@ -39,6 +40,41 @@ log_proto_text_server_poll_prepare_method(LogProtoServer *s, GIOCondition *cond,
   return avail ? LPPA_FORCE_SCHEDULE_FETCH : LPPA_POLL_IO;
 }
 
+static inline void
+log_proto_text_server_reset_eol_batch(LogProtoTextServer *self)
+{
+  self->eol_batch.scan_start = 0;
+  self->eol_batch.pos = 0;
+  self->eol_batch.len = 0;
+}
+
+/* find the first EOL in buffer[from..to), positions returned by the
+ * previous scan are used as long as they cover this range */
+static const guchar *
+log_proto_text_server_find_eol(LogProtoTextServer *self, guint32 from, guint32 to)
+{
+  LogProtoTextServerEOLBatch *batch = &self->eol_batch;
+
+  if (batch->scan_start <= from)
+    {
+      while (batch->pos < batch->len && batch->eols[batch->pos] < from)
+        batch->pos++;
+
+      if (batch->pos < batch->len)
+        return batch->eols[batch->pos] < to ? self->super.buffer + batch->eols[batch->pos] : NULL;
+    }
+
+  batch->scan_start = from;
+  batch->pos = 0;
+  batch->len = self->find_eoms(self->super.buffer + from, to - from, batch->eols, G_N_ELEMENTS(batch->eols));
+  if (batch->len == 0)
+    return NULL;
+
+  for (guint32 i = 0; i < batch->len; i++)
+    batch->eols[i] += from;
+  return self->super.buffer + batch->eols[0];
+}
+
 static gint
 log_proto_text_server_accumulate_line(LogProtoTextServer *self, const guchar *msg, gsize msg_len,
                                       gssize consumed_len)
@@ -74,7 +110,7 @@ log_proto_text_server_try_extract(LogProtoTextServer *self, LogProtoBufferedServ
        * read further data, or the buffer already contains a
        * complete line */
 
-      eom = self->find_eom(self->super.buffer + next_line_pos, state->pending_buffer_end - next_line_pos);
+      eom = log_proto_text_server_find_eol(self, next_line_pos, state->pending_buffer_end);
       if (eom)
         next_eol_pos = eom - self->super.buffer;
     }
@@ -228,7 +264,9 @@ log_proto_text_server_locate_next_eol(LogProtoTextServer *self, LogProtoBuffered
     }
   else
     {
-      eol = self->find_eom(buffer_start + self->consumed_len + 1, buffer_bytes - self->consumed_len - 1);
+      guint32 from = buffer_start + self->consumed_len + 1 - self->super.buffer;
+
+      eol = log_proto_text_server_find_eol(self, from, from + buffer_bytes - self->consumed_len - 1);
     }
   return eol;
 }
@@ -283,6 +321,10 @@ log_proto_text_server_fetch_from_buffer(LogProtoBufferedServer *s, const guchar
 
   gboolean result = _fetch_msg_from_buffer(self, state, buffer_start, buffer_bytes, msg, msg_len);
 
+  /* the buffer is going to be moved or refilled, EOL positions become invalid */
+  if (!result || state->pending_buffer_pos == state->pending_buffer_end)
+    log_proto_text_server_reset_eol_batch(self);
+
   log_proto_buffered_server_put_state(&self->super);
   return result;
 }
@@ -293,6 +335,7 @@ log_proto_text_server_flush(LogProtoBufferedServer *s)
   LogProtoTextServer *self = (LogProtoTextServer *) s;
   self->consumed_len = -1;
   self->cached_eol_pos = 0;
+  log_proto_text_server_reset_eol_batch(self);
 }
 
 void
@@ -321,9 +364,10 @@ log_proto_text_server_restart_with_state(LogProtoServer *s, PersistState *persis
   const guchar *buffer_start = self->super.buffer + state->pending_buffer_pos;
   gsize buffer_bytes = state->pending_buffer_end - state->pending_buffer_pos;
 
+  log_proto_text_server_reset_eol_batch(self);
   if (buffer_bytes > 0)
     {
-      const guchar *eom = self->find_eom(buffer_start, buffer_bytes);
+      const guchar *eom = log_proto_text_server_find_eol(self, state->pending_buffer_pos, state->pending_buffer_end);
       if (eom)
         self->cached_eol_pos = eom - self->super.buffer;
     }
@@ -341,6 +385,12 @@ log_proto_text_server_free(LogProtoServer *s)
   log_proto_buffered_server_free_method(&self->super.super);
 }
 
+static gsize
+_find_nl_or_nul_as_eoms(const guchar *s, gsize n, guint32 *offsets, gsize max_offsets)
+{
+  return find_all_lf_or_nul((const gchar *) s, n, offsets, max_offsets);
+}
+
 void
 log_proto_text_server_init(LogProtoTextServer *self, LogTransport *transport, const LogProtoServerOptions *options)
 {
@@ -350,7 +400,7 @@ log_proto_text_server_init(LogProtoTextServer *self, LogTransport *transport, co
   self->super.super.restart_with_state = log_proto_text_server_restart_with_state;
   self->super.fetch_from_buffer = log_proto_text_server_fetch_from_buffer;
   self->super.flush = log_proto_text_server_flush;
-  self->find_eom = find_eom;
+  self->find_eoms = _find_nl_or_nul_as_eoms;
   self->super.stream_based = TRUE;
   self->consumed_len = -1;
 }
@@ -364,10 +414,10 @@ log_proto_text_server_new(LogTransport *transport, const LogProtoServerOptions *
   return &self->super.super;
 }
 
-static const guchar *
-_find_nl_as_eom(const guchar *s, gsize n)
+static gsize
+_find_nl_as_eoms(const guchar *s, gsize n, guint32 *offsets, gsize max_offsets)
 {
-  return memchr(s, '\n', n);
+  return find_all_char((const gchar *) s, n, '\n', offsets, max_offsets);
 }
 
 LogProtoServer *
@@ -376,14 +426,14 @@ log_proto_text_with_nuls_server_new(LogTransport *transport, const LogProtoServe
   LogProtoTextServer *self = g_new0(LogProtoTextServer, 1);
 
   log_proto_text_server_init(self, transport, options);
-  self->find_eom = _find_nl_as_eom;
+  self->find_eoms = _find_nl_as_eoms;
   return &self->super.super;
 }
 
-static const guchar *
-_find_nul_as_eom(const guchar *s, gsize n)
+static gsize
+_find_nul_as_eoms(const guchar *s, gsize n, guint32 *offsets, gsize max_offsets)
 {
-  return memchr(s, 0, n);
+  return find_all_char((const gchar *) s, n, '\0', offsets, max_offsets);
 }
 
 LogProtoServer *
@@ -392,6 +442,6 @@ log_proto_nul_terminated_server_new(LogTransport *transport, const LogProtoServe
   LogProtoTextServer *self = g_new0(LogProtoTextServer, 1);
 
   log_proto_text_server_init(self, transport, options);
-  self->find_eom = _find_nul_as_eom;
+  self->find_eoms = _find_nul_as_eoms;
   return &self->super.super;
 }
@@ -26,15 +26,29 @@
 #include "logproto-buffered-server.h"
 #include "multi-line/multi-line-logic.h"
 
+#define LOG_PROTO_TEXT_SERVER_EOL_BATCH_SIZE 64
+
+/* EOL positions (relative to the buffer) found by the last scan starting
+ * at scan_start, this way the buffer is scanned once for a batch of lines */
+typedef struct _LogProtoTextServerEOLBatch
+{
+  guint32 scan_start;
+  guint32 pos;
+  guint32 len;
+  guint32 eols[LOG_PROTO_TEXT_SERVER_EOL_BATCH_SIZE];
+} LogProtoTextServerEOLBatch;
+
 typedef struct _LogProtoTextServer LogProtoTextServer;
 struct _LogProtoTextServer
 {
   LogProtoBufferedServer super;
   MultiLineLogic *multi_line;
 
-  const guchar *(*find_eom)(const guchar *s, gsize n);
+  /* stores the offsets of up to max_offsets EOM characters in s[0..n) */
+  gsize (*find_eoms)(const guchar *s, gsize n, guint32 *offsets, gsize max_offsets);
   gint32 consumed_len;
   gint32 cached_eol_pos;
+  LogProtoTextServerEOLBatch eol_batch;
 };
 
 void log_proto_text_server_set_multi_line(LogProtoServer *s, MultiLineLogic *multi_line);
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include "libtest/mock-transport.h"
+
+#include "logproto/logproto-text-client.h"
+#include "logproto/logproto-framed-client.h"
+
+static gint text_client_messages_acked;
+
+static void
+_ack_callback(gint num_acked, gpointer user_data)
+{
+  text_client_messages_acked += num_acked;
+}
+
+static LogProtoClient *
+_construct_batched_client(LogProtoClient *(*construct)(LogTransport *, const LogProtoClientOptions *),
+                          LogTransport *transport, gint batch_size)
+{
+  static LogProtoClientOptions options;
+  LogProtoClientFlowControlFuncs flow_control_funcs =
+  {
+    .ack_callback = _ack_callback,
+  };
+
+  log_proto_client_options_defaults(&options);
+  log_proto_client_options_set_write_batch_size(&options, batch_size);
+
+  LogProtoClient *proto = construct(transport, &options);
+  log_proto_client_set_client_flow_control(proto, &flow_control_funcs);
+  text_client_messages_acked = 0;
+  return proto;
+}
+
+static void
+_post_message(LogProtoClient *proto, const gchar *payload, LogProtoStatus expected_status)
+{
+  gboolean consumed = FALSE;
+
+  LogProtoStatus status = log_proto_client_post(proto, NULL, (guchar *) g_strdup(payload), strlen(payload), &consumed);
+  cr_assert_eq(status, expected_status, "status=%d", status);
+  cr_assert(consumed);
+}
+
+static void
+_assert_written(LogTransport *transport, const gchar *expected)
+{
+  gchar output[1024] = {0};
+
+  log_transport_mock_read_from_write_buffer((LogTransportMock *) transport, output, sizeof(output) - 1);
+  cr_assert_str_eq(output, expected);
+}
+
+Test(log_proto, test_text_client_batched_messages_are_written_on_flush)
+{
+  LogTransport *transport = log_transport_mock_stream_new(NULL, 0);
+  LogProtoClient *proto = _construct_batched_client(log_proto_text_client_new, transport, 10);
+
+  _post_message(proto, "foo\n", LPS_SUCCESS);
+  _post_message(proto, "bar\n", LPS_SUCCESS);
+  _assert_written(transport, "");
+  cr_assert_eq(text_client_messages_acked, 0);
+
+  cr_assert_eq(log_proto_client_flush(proto), LPS_SUCCESS);
+  _assert_written(transport, "foo\nbar\n");
+  cr_assert_eq(text_client_messages_acked, 2);
+
+  log_proto_client_free(proto);
+}
+
+Test(log_proto, test_text_client_batch_is_written_automatically_once_full)
+{
+  LogTransport *transport = log_transport_mock_stream_new(NULL, 0);
+  LogProtoClient *proto = _construct_batched_client(log_proto_text_client_new, transport, 3);
+
+  _post_message(proto, "1\n", LPS_SUCCESS);
+  _post_message(proto, "2\n", LPS_SUCCESS);
+  _post_message(proto, "3\n", LPS_SUCCESS);
+  _assert_written(transport, "1\n2\n3\n");
+  cr_assert_eq(text_client_messages_acked, 3);
+
+  log_proto_client_free(proto);
+}
+
+Test(log_proto, test_text_client_batched_partial_writes_ack_only_complete_messages)
+{
+  LogTransport *transport = log_transport_mock_stream_new(NULL, 0);
+  LogProtoClient *proto = _construct_batched_client(log_proto_text_client_new, transport, 10);
+
+  log_transport_mock_set_write_chunk_limit((LogTransportMock *) transport, 5);
+
+  _post_message(proto, "foo\n", LPS_SUCCESS);
+  _post_message(proto, "bar\n", LPS_SUCCESS);
+  _post_message(proto, "baz\n", LPS_SUCCESS);
+
+  cr_assert_eq(log_proto_client_flush(proto), LPS_PARTIAL);
+  cr_assert_eq(text_client_messages_acked, 1);
+  cr_assert_eq(log_proto_client_flush(proto), LPS_PARTIAL);
+  cr_assert_eq(text_client_messages_acked, 2);
+  cr_assert_eq(log_proto_client_flush(proto), LPS_SUCCESS);
+  cr_assert_eq(text_client_messages_acked, 3);
+
+  _assert_written(transport, "foo\nbar\nbaz\n");
+
+  log_proto_client_free(proto);
+}
+
+Test(log_proto, test_framed_client_batched_messages_get_frame_headers)
+{
+  LogTransport *transport = log_transport_mock_stream_new(NULL, 0);
+  LogProtoClient *proto = _construct_batched_client(log_proto_framed_client_new, transport, 10);
+
+  log_transport_mock_set_write_chunk_limit((LogTransportMock *) transport, 3);
+
+  _post_message(proto, "foo", LPS_SUCCESS);
+  _post_message(proto, "barbaz", LPS_SUCCESS);
+
+  LogProtoStatus status;
+  while ((status = log_proto_client_flush(proto)) == LPS_PARTIAL)
+    ;
+  cr_assert_eq(status, LPS_SUCCESS);
+
+  _assert_written(transport, "3 foo6 barbaz");
+  cr_assert_eq(text_client_messages_acked, 2);
+
+  log_proto_client_free(proto);
+}
@@ -364,6 +364,31 @@ Test(log_proto, test_log_proto_text_server_invalid_encoding)
   log_proto_server_free(proto);
 }
 
+Test(log_proto, test_log_proto_text_server_many_lines_in_a_single_read)
+{
+  /* more lines than LOG_PROTO_TEXT_SERVER_EOL_BATCH_SIZE, spanning a buffer split */
+  GString *input = g_string_new("");
+  gint num_lines = LOG_PROTO_TEXT_SERVER_EOL_BATCH_SIZE * 2 + 10;
+
+  for (gint i = 0; i < num_lines; i++)
+    g_string_append_printf(input, "line%03d%s", i, i % 2 ? "\n" : "\r\n");
+
+  proto_server_options.max_msg_size = 1024;
+  LogProtoServer *proto = log_proto_text_server_new(log_transport_mock_stream_new(input->str, input->len, LTM_EOF),
+                                                    get_inited_proto_server_options());
+
+  for (gint i = 0; i < num_lines; i++)
+    {
+      gchar expected[16];
+
+      g_snprintf(expected, sizeof(expected), "line%03d", i);
+      assert_proto_server_fetch(proto, expected, -1);
+    }
+  assert_proto_server_fetch_failure(proto, LPS_EOF, NULL);
+  log_proto_server_free(proto);
+  g_string_free(input, TRUE);
+}
+
 Test(log_proto, test_log_proto_text_server_multi_read)
 {
   LogProtoServer *proto;
@@ -718,3 +743,56 @@ Test(log_proto, buffer_split_with_encoding_and_position_tracking)
   g_string_free(data_smaller, TRUE);
   g_string_free(data, TRUE);
 }
+
+static const guchar *
+_fetch_zero_copy_message(LogProtoServer *proto, LogTransportAuxData *aux, gsize *msg_len)
+{
+  const guchar *msg = NULL;
+  gboolean may_read = TRUE;
+  Bookmark bookmark;
+  LogProtoStatus status;
+
+  do
+    {
+      log_transport_aux_data_reinit(aux);
+      status = log_proto_server_fetch(proto, &msg, msg_len, &may_read, aux, &bookmark);
+    }
+  while ((status == LPS_SUCCESS || status == LPS_AGAIN) && msg == NULL && may_read);
+  cr_assert_not_null(msg);
+  return msg;
+}
+
+Test(log_proto, test_log_proto_text_server_zero_copy_input_lends_the_buffer_to_messages)
+{
+  LogTransportAuxData aux1, aux2;
+  const guchar *msg1, *msg2;
+  gsize msg_len;
+
+  proto_server_options.zero_copy_input = TRUE;
+  LogProtoServer *proto = construct_test_proto(
+                            log_transport_mock_stream_new(
+                              "foo\n", -1,
+                              "barbaz\n", -1,
+                              LTM_EOF));
+
+  log_transport_aux_data_init(&aux1);
+  log_transport_aux_data_init(&aux2);
+
+  msg1 = _fetch_zero_copy_message(proto, &aux1, &msg_len);
+  cr_assert_eq(msg_len, 3);
+  cr_assert_str_eq((const gchar *) msg1, "foo");
+  cr_assert_not_null(aux1.input_slab);
+  cr_assert(input_slab_contains(aux1.input_slab, (const gchar *) msg1, msg_len + 1));
+
+  /* the next read would overwrite "foo", it has to go into a new slab */
+  msg2 = _fetch_zero_copy_message(proto, &aux2, &msg_len);
+  cr_assert_eq(msg_len, 6);
+  cr_assert_str_eq((const gchar *) msg2, "barbaz");
+  cr_assert_not_null(aux2.input_slab);
+  cr_assert_neq(aux1.input_slab, aux2.input_slab);
+  cr_assert_str_eq((const gchar *) msg1, "foo");
+
+  log_transport_aux_data_destroy(&aux1);
+  log_transport_aux_data_destroy(&aux2);
+  log_proto_server_free(proto);
+}
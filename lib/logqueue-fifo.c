@@ -44,27 +44,31 @@ QueueType log_queue_fifo_type = "FIFO";
  *
  *   - has a per-thread, unlocked input queue where threads can put their items
  *
- *   - has a locked wait-queue where items go once the per-thread input
- *     would be overflown or if the input thread goes to sleep (e.g.  one
- *     lock acquisition per a longer period)
+ *   - has a lock-free (multi-producer, single-consumer) wait-queue where
+ *     items go once the per-thread input would be overflown or if the
+ *     input thread goes to sleep
  *
  *   - has an unlocked output queue where items from the wait queue go, once
  *     it becomes depleted.
  *
  * This means that items flow in this sequence from one list to the next:
  *
- *    input queue (per-thread) -> wait queue (locked) -> output queue (single-threaded)
+ *    input queue (per-thread) -> wait queue (MPSC) -> output queue (single-threaded)
  *
  * Fastpath is:
  *   - input threads putting elements on their per-thread queue (lockless)
  *   - output threads removing elements from the output queue (lockless)
  *
  * Slowpath:
- *   - input queue is overflown (or the input thread goes to sleep), wait
- *     queue mutex is grabbed, all elements are put to the wait queue.
+ *   - input queue is overflown (or the input thread goes to sleep), all
+ *     elements are linked to the tail of the wait queue with a single
+ *     atomic exchange.
  *
- *   - output queue is depleted, wait queue mutex is grabbed, all elements
- *     on the wait queue is put to the output queue
+ *   - output queue is depleted, the elements on the wait queue are moved
+ *     to the output queue.
+ *
+ * The queue lock is only taken to notify a consumer that registered a
+ * parallel push callback, see log_queue_push_notify_lockless().
  *
  * Threading assumptions:
  *   - the head of the queue is only manipulated from the output thread
@@ -89,17 +93,38 @@ typedef struct _OverflowQueue
   gint non_flow_controlled_len;
 } OverflowQueue;
 
+/*
+ * Intrusive MPSC queue (Dmitry Vyukov's algorithm), linked through the
+ * next pointer of LogMessageQueueNode->list.  Producers only touch @tail,
+ * the consumer (the output thread) only touches @head.  The lengths are
+ * updated atomically: producers increase them before linking the items,
+ * so they may be ahead of what the consumer can already see, but never
+ * behind it.
+ */
+typedef struct _WaitQueue
+{
+  struct iv_list_head *head;
+  struct iv_list_head *tail;
+  struct iv_list_head stub;
+  gint len;
+} WaitQueue;
+
 typedef struct _LogQueueFifo
 {
   LogQueue super;
 
   /* scalable qoverflow implementation */
   OverflowQueue output_queue;
-  OverflowQueue wait_queue;
+  WaitQueue wait_queue;
   OverflowQueue backlog_queue; /* entries that were sent but not acked yet */
 
   gint log_fifo_size;
 
+  /* number of non flow-controlled messages in the wait and output queues,
+   * producers reserve room here before linking their items, see
+   * _reserve_non_flow_controlled_slots() */
+  gint non_flow_controlled_len;
+
   struct
   {
     StatsClusterKey *capacity_sc_key;
@@ -124,13 +149,90 @@ log_queue_fifo_get_length(LogQueue *s)
 {
   LogQueueFifo *self = (LogQueueFifo *) s;
 
-  return self->wait_queue.len + self->output_queue.len;
+  return g_atomic_int_get(&self->wait_queue.len) + self->output_queue.len;
 }
 
-static gint64
-log_queue_fifo_get_non_flow_controlled_length(LogQueueFifo *self)
+/*
+ * Reserves room for at most @n non flow-controlled messages and returns
+ * the number of messages that still fit into log-fifo-size(). The check
+ * and the reservation is a single atomic step, so concurrent producers
+ * cannot overshoot the limit together. Rewinding the backlog does not
+ * reserve, it may push the length above the limit, in which case nothing
+ * fits until the output thread catches up.
+ */
+static gint
+_reserve_non_flow_controlled_slots(LogQueueFifo *self, gint n)
+{
+  gint len, reserved;
+
+  do
+    {
+      len = g_atomic_int_get(&self->non_flow_controlled_len);
+      reserved = MIN(n, MAX(0, self->log_fifo_size - len));
+      if (reserved == 0)
+        return 0;
+    }
+  while (!g_atomic_int_compare_and_exchange(&self->non_flow_controlled_len, len, len + reserved));
+
+  return reserved;
+}
+
+static void
+_wait_queue_init(WaitQueue *self)
+{
+  self->stub.next = NULL;
+  self->head = &self->stub;
+  self->tail = &self->stub;
+  self->len = 0;
+}
+
+/* can be called from any thread, links the chain of @first .. @last to the tail */
+static void
+_wait_queue_push_chain(WaitQueue *self, struct iv_list_head *first, struct iv_list_head *last)
+{
+  last->next = NULL;
+  struct iv_list_head *prev = g_atomic_pointer_exchange((gpointer *) &self->tail, last);
+  g_atomic_pointer_set(&prev->next, first);
+}
+
+/*
+ * Can only run from the output thread. Returns NULL if the queue is empty
+ * or if a producer is in the middle of linking its items, in which case
+ * the caller will see them on its next attempt.
+ */
+static LogMessageQueueNode *
+_wait_queue_pop(WaitQueue *self)
 {
-  return self->wait_queue.non_flow_controlled_len + self->output_queue.non_flow_controlled_len;
+  struct iv_list_head *head = self->head;
+  struct iv_list_head *next = g_atomic_pointer_get(&head->next);
+
+  if (head == &self->stub)
+    {
+      if (!next)
+        return NULL;
+      self->head = next;
+      head = next;
+      next = g_atomic_pointer_get(&head->next);
+    }
+
+  if (next)
+    {
+      self->head = next;
+      return iv_list_entry(head, LogMessageQueueNode, list);
+    }
+
+  if (head != g_atomic_pointer_get(&self->tail))
+    return NULL;
+
+  _wait_queue_push_chain(self, &self->stub, &self->stub);
+
+  next = g_atomic_pointer_get(&head->next);
+  if (next)
+    {
+      self->head = next;
+      return iv_list_entry(head, LogMessageQueueNode, list);
+    }
+  return NULL;
 }
 
 gboolean
@@ -201,76 +303,46 @@ log_queue_fifo_drop_messages_from_input_queue(LogQueueFifo *self, InputQueue *in
             evt_tag_str("persist_name", self->super.persist_name));
 }
 
-static inline gboolean
-log_queue_fifo_calculate_num_of_messages_to_drop(LogQueueFifo *self, InputQueue *input_queue,
-                                                 gint *num_of_messages_to_drop)
-{
-  /* since we're in the input thread, queue_len will be racy.  It can
-   * increase due to log_queue_fifo_rewind_backlog() and can also decrease
-   * as items are removed from the output queue using log_queue_pop_head().
-   *
-   * The only reason we're using it here is to check for qoverflow
-   * overflows, however the only side-effect of the race (if lost) is that
-   * we would lose a couple of message too many or add some more messages to
-   * qoverflow than permitted by the user.  Since if flow-control is used,
-   * the fifo size should be sized larger than the potential window sizes,
-   * otherwise we can lose messages anyway, this is not deemed a cost to
-   * justify proper locking in this case.
-   */
-
-  gint queue_len = log_queue_fifo_get_non_flow_controlled_length(self);
-  guint16 input_queue_len = input_queue->non_flow_controlled_len;
-
-  gboolean drop_messages = queue_len + input_queue_len > self->log_fifo_size;
-  if (!drop_messages)
-    return FALSE;
-
-  /* NOTE: MAX is needed here to ensure that the lost race on queue_len
-   * doesn't result in n < 0 */
-  *num_of_messages_to_drop = input_queue_len - MAX(0, (self->log_fifo_size - queue_len));
-
-  return TRUE;
-}
-
-/* move items from the per-thread input queue to the lock-protected "wait" queue */
+/* move items from the per-thread input queue to the "wait" queue */
 static void
-log_queue_fifo_move_input_unlocked(LogQueueFifo *self, gint thread_index)
+log_queue_fifo_move_input_to_wait_queue(LogQueueFifo *self, gint thread_index)
 {
-  gint num_of_messages_to_drop;
-  gboolean drop_messages = log_queue_fifo_calculate_num_of_messages_to_drop(self, &self->input_queues[thread_index],
-                           &num_of_messages_to_drop);
+  InputQueue *input_queue = &self->input_queues[thread_index];
+  gint input_queue_len = input_queue->non_flow_controlled_len;
+  gint num_of_messages_to_drop = input_queue_len - _reserve_non_flow_controlled_slots(self, input_queue_len);
 
-  if (drop_messages)
+  if (num_of_messages_to_drop > 0)
     {
       /* slow path, the input thread's queue would overflow the queue, let's drop some messages */
-      log_queue_fifo_drop_messages_from_input_queue(self, &self->input_queues[thread_index], num_of_messages_to_drop);
+      log_queue_fifo_drop_messages_from_input_queue(self, input_queue, num_of_messages_to_drop);
     }
 
-  log_queue_queued_messages_add(&self->super, self->input_queues[thread_index].len);
-  log_queue_memory_usage_add(&self->super, self->input_queues[thread_index].total_size);
+  if (iv_list_empty(&input_queue->items))
+    return;
+
+  log_queue_queued_messages_add(&self->super, input_queue->len);
+  log_queue_memory_usage_add(&self->super, input_queue->total_size);
+
+  g_atomic_int_add(&self->wait_queue.len, input_queue->len);
+  _wait_queue_push_chain(&self->wait_queue, input_queue->items.next, input_queue->items.prev);
 
-  iv_list_splice_tail_init(&self->input_queues[thread_index].items, &self->wait_queue.items);
-  self->wait_queue.len += self->input_queues[thread_index].len;
-  self->wait_queue.non_flow_controlled_len += self->input_queues[thread_index].non_flow_controlled_len;
-  self->input_queues[thread_index].len = 0;
-  self->input_queues[thread_index].non_flow_controlled_len = 0;
-  self->input_queues[thread_index].total_size = 0;
+  INIT_IV_LIST_HEAD(&input_queue->items);
+  input_queue->len = 0;
+  input_queue->non_flow_controlled_len = 0;
+  input_queue->total_size = 0;
 }
 
 /* explicitly move input to the wait queue, to be called from the input thread */
 static void
 log_queue_fifo_move_input(LogQueueFifo *self, gint thread_index)
 {
-  g_mutex_lock(&self->super.lock);
-  log_queue_fifo_move_input_unlocked(self, thread_index);
-  log_queue_push_notify(&self->super);
-  g_mutex_unlock(&self->super.lock);
+  log_queue_fifo_move_input_to_wait_queue(self, thread_index);
+  log_queue_push_notify_lockless(&self->super);
 }
 
-/* move items from the per-thread input queue to the lock-protected
- * "wait" queue, but grabbing locks first. This is registered as a
- * callback to be called when the input worker thread finishes its
- * job.
+/* move items from the per-thread input queue to the "wait" queue. This
+ * is registered as a callback to be called when the input worker thread
+ * finishes its job.
  */
 static gpointer
 log_queue_fifo_input_batch_callback(gpointer user_data)
@@ -286,12 +358,12 @@ log_queue_fifo_input_batch_callback(gpointer user_data)
   return NULL;
 }
 
-/* lock must be held */
+/* reserves the room for the message if it is kept */
 static inline gboolean
 _message_has_to_be_dropped(LogQueueFifo *self, const LogPathOptions *path_options)
 {
   return !path_options->flow_control_requested
-         && log_queue_fifo_get_non_flow_controlled_length(self) >= self->log_fifo_size;
+         && _reserve_non_flow_controlled_slots(self, 1) == 0;
 }
 
 /**
@@ -383,12 +455,9 @@ log_queue_fifo_push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *pat
 
   /* slow path, put the pending item and the whole input queue to the wait_queue */
 
-  g_mutex_lock(&self->super.lock);
-
   if (_message_has_to_be_dropped(self, path_options))
     {
       log_queue_dropped_messages_inc(&self->super);
-      g_mutex_unlock(&self->super.lock);
 
       log_msg_drop(msg, path_options, AT_PROCESSED);
 
@@ -402,17 +471,13 @@ log_queue_fifo_push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *pat
   log_msg_write_protect(msg);
   node = log_msg_alloc_queue_node(msg, path_options);
 
-  iv_list_add_tail(&node->list, &self->wait_queue.items);
-  self->wait_queue.len++;
-
-  if (!path_options->flow_control_requested)
-    self->wait_queue.non_flow_controlled_len++;
-
-  log_queue_push_notify(&self->super);
   log_queue_queued_messages_inc(&self->super);
-
   log_queue_memory_usage_add(&self->super, log_msg_get_size(msg));
-  g_mutex_unlock(&self->super.lock);
+
+  g_atomic_int_inc(&self->wait_queue.len);
+  _wait_queue_push_chain(&self->wait_queue, &node->list, &node->list);
+
+  log_queue_push_notify_lockless(&self->super);
 
   log_msg_unref(msg);
 }
@@ -423,14 +488,23 @@ log_queue_fifo_push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *pat
 static inline void
 _move_items_from_wait_queue_to_output_queue(LogQueueFifo *self)
 {
-  /* slow path, output queue is empty, get some elements from the wait queue */
-  g_mutex_lock(&self->super.lock);
-  iv_list_splice_tail_init(&self->wait_queue.items, &self->output_queue.items);
-  self->output_queue.len = self->wait_queue.len;
-  self->output_queue.non_flow_controlled_len = self->wait_queue.non_flow_controlled_len;
-  self->wait_queue.len = 0;
-  self->wait_queue.non_flow_controlled_len = 0;
-  g_mutex_unlock(&self->super.lock);
+  /* slow path, output queue is empty, get some elements from the wait queue.
+   *
+   * Only the items already accounted for in wait_queue.len are taken, so
+   * that the length never goes negative even if a producer is just linking
+   * its chain. */
+  gint available = g_atomic_int_get(&self->wait_queue.len);
+  gint moved = 0;
+  LogMessageQueueNode *node;
+
+  while (moved < available && (node = _wait_queue_pop(&self->wait_queue)))
+    {
+      iv_list_add_tail(&node->list, &self->output_queue.items);
+      moved++;
+    }
+
+  self->output_queue.len += moved;
+  g_atomic_int_add(&self->wait_queue.len, -moved);
 }
 
 /*
@@ -476,7 +550,7 @@ log_queue_fifo_pop_head(LogQueue *s, LogPathOptions *path_options)
       self->output_queue.len--;
 
       if (!node->flow_control_requested)
-        self->output_queue.non_flow_controlled_len--;
+        g_atomic_int_add(&self->non_flow_controlled_len, -1);
 
       iv_list_del_init(&node->list);
     }
@@ -488,7 +562,8 @@ log_queue_fifo_pop_head(LogQueue *s, LogPathOptions *path_options)
        * however we don't touch them here, they'll be migrated to the
        * wait_queue once the input threads finish their processing (or
        * the high watermark is reached). Also, they are unlocked, so
-       * no way to touch them safely.
+       * no way to touch them safely.  The same applies to items on
+       * the wait queue that a producer has not finished linking yet.
        */
       return NULL;
     }
@@ -577,7 +652,7 @@ log_queue_fifo_rewind_backlog_all(LogQueue *s)
   iv_list_splice_tail_init(&self->backlog_queue.items, &self->output_queue.items);
 
   self->output_queue.len += self->backlog_queue.len;
-  self->output_queue.non_flow_controlled_len += self->backlog_queue.non_flow_controlled_len;
+  g_atomic_int_add(&self->non_flow_controlled_len, self->backlog_queue.non_flow_controlled_len);
   log_queue_queued_messages_add(&self->super, self->backlog_queue.len);
   self->backlog_queue.len = 0;
   self->backlog_queue.non_flow_controlled_len = 0;
@@ -609,7 +684,7 @@ log_queue_fifo_rewind_backlog(LogQueue *s, guint rewind_count)
       if (!node->flow_control_requested)
         {
           self->backlog_queue.non_flow_controlled_len--;
-          self->output_queue.non_flow_controlled_len++;
+          g_atomic_int_inc(&self->non_flow_controlled_len);
         }
 
       log_queue_queued_messages_inc(&self->super);
@@ -684,7 +759,7 @@ log_queue_fifo_free(LogQueue *s)
       log_queue_fifo_free_queue(&self->input_queues[i].items);
     }
 
-  log_queue_fifo_free_queue(&self->wait_queue.items);
+  _move_items_from_wait_queue_to_output_queue(self);
   log_queue_fifo_free_queue(&self->output_queue.items);
   log_queue_fifo_free_queue(&self->backlog_queue.items);
 
@@ -731,7 +806,7 @@ log_queue_fifo_new(gint log_fifo_size, const gchar *persist_name, gint stats_lev
       self->input_queues[i].cb.func = log_queue_fifo_input_batch_callback;
       self->input_queues[i].cb.user_data = self;
     }
-  INIT_IV_LIST_HEAD(&self->wait_queue.items);
+  _wait_queue_init(&self->wait_queue);
   INIT_IV_LIST_HEAD(&self->output_queue.items);
   INIT_IV_LIST_HEAD(&self->backlog_queue.items);
 
@@ -123,6 +123,24 @@ log_queue_push_notify(LogQueue *self)
     }
 }
 
+/*
+ * Same as log_queue_push_notify(), but to be used by queue implementations
+ * that add items without holding self->lock.  The new items must already
+ * be visible to log_queue_get_length() when this is called:
+ * log_queue_check_items() re-checks the length after registering its
+ * callback, so either the consumer sees the items or we see the callback.
+ */
+void
+log_queue_push_notify_lockless(LogQueue *self)
+{
+  if (!g_atomic_pointer_get(&self->parallel_push_notify))
+    return;
+
+  g_mutex_lock(&self->lock);
+  log_queue_push_notify(self);
+  g_mutex_unlock(&self->lock);
+}
+
 void
 log_queue_reset_parallel_push(LogQueue *self)
 {
@@ -164,11 +182,17 @@ log_queue_check_items(LogQueue *self, gint *timeout, LogQueuePushNotifyFunc para
   num_elements = log_queue_get_length(self);
   if (num_elements == 0)
     {
-      self->parallel_push_notify = parallel_push_notify;
       self->parallel_push_data = user_data;
       self->parallel_push_data_destroy = user_data_destroy;
-      g_mutex_unlock(&self->lock);
-      return FALSE;
+      g_atomic_pointer_set(&self->parallel_push_notify, parallel_push_notify);
+
+      /* pairs with log_queue_push_notify_lockless() */
+      num_elements = log_queue_get_length(self);
+      if (num_elements == 0)
+        {
+          g_mutex_unlock(&self->lock);
+          return FALSE;
+        }
     }
 
   /* consume the user_data reference as we won't use the callback */
@@ -282,8 +306,8 @@ _register_shared_counters(LogQueue *self, gint stats_level, StatsClusterKeyBuild
 
   stats_lock();
   {
-    stats_register_counter(stats_level, self->metrics.shared.output_events_sc_key, SC_TYPE_QUEUED,
-                           &self->metrics.shared.queued_messages);
+    stats_register_sharded_counter(stats_level, self->metrics.shared.output_events_sc_key, SC_TYPE_QUEUED,
+                                   &self->metrics.shared.queued_messages);
     stats_register_counter(stats_level, self->metrics.shared.output_events_sc_key, SC_TYPE_DROPPED,
                            &self->metrics.shared.dropped_messages);
     stats_register_counter(stats_level, self->metrics.shared.memory_usage_sc_key, SC_TYPE_SINGLE_VALUE,
@@ -483,7 +483,11 @@ log_reader_handle_line(LogReader *self, const guchar *line, gsize length, LogTra
             evt_tag_mem("input", line, length),
             evt_tag_msg_reference(m));
 
+  if (aux && aux->input_slab)
+    log_msg_set_input_slab(m, aux->input_slab);
+
   msg_format_parse_into(&self->options->parse_options, m, line, &length);
+  log_msg_release_unused_input_slab(m);
   if (length == 0 && !(self->options->flags & LR_EMPTY_LINES))
     {
       log_msg_unref(m);
@@ -59,13 +59,14 @@ _reinject_message(LogPipe *front_pipe, LogMessage *msg, const LogPathOptions *pa
 /* LogSchedulerBatch */
 
 LogSchedulerBatch *
-_batch_new(struct iv_list_head *elements)
+_batch_new(struct iv_list_head *elements, gsize len)
 {
   LogSchedulerBatch *batch = g_new0(LogSchedulerBatch, 1);
 
   INIT_IV_LIST_HEAD(&batch->elements);
   INIT_IV_LIST_HEAD(&batch->list);
   iv_list_splice_tail(elements, &batch->elements);
+  batch->len = len;
   return batch;
 }
 
@@ -77,13 +78,88 @@ _batch_free(LogSchedulerBatch *batch)
 
 /* LogSchedulerPartition */
 
+/* runs in the partition's own "thread", returns the number of messages processed */
+static gsize
+_process_batch(LogSchedulerPartition *partition, LogSchedulerBatch *batch)
+{
+  struct iv_list_head *msg_list_head, *next_msg_list_head;
+  gsize msgs_processed = 0;
+
+  iv_list_for_each_safe(msg_list_head, next_msg_list_head, &batch->elements)
+  {
+    LogMessageQueueNode *node = iv_list_entry(msg_list_head, LogMessageQueueNode, list);
+
+    iv_list_del(&node->list);
+
+    LogMessage *msg = log_msg_ref(node->msg);
+
+    LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+    path_options.ack_needed = node->ack_needed;
+    path_options.flow_control_requested = node->flow_control_requested;
+
+    log_msg_free_queue_node(node);
+
+    _reinject_message(partition->front_pipe, msg, &path_options, partition->metrics.processing_latency);
+
+    msgs_processed++;
+    stats_counter_inc(partition->metrics.processed_events_total);
+  }
+  _batch_free(batch);
+  return msgs_processed;
+}
+
+/*
+ * Runs in the partition's own "thread" if work-stealing is enabled: takes
+ * a batch from the tail of the partition with the most queued messages.
+ * The owner of that partition consumes its batches from the head, so the
+ * two only compete for batches_lock.
+ */
+static LogSchedulerBatch *
+_steal_batch(LogSchedulerPartition *thief)
+{
+  LogScheduler *scheduler = thief->scheduler;
+  LogSchedulerPartition *victim = NULL;
+  gssize victim_queued_events = 0;
+
+  for (gint i = 0; i < scheduler->options->num_partitions; i++)
+    {
+      LogSchedulerPartition *candidate = &scheduler->partitions[i];
+      gssize queued_events = atomic_gssize_racy_get(&candidate->queued_events);
+
+      if (candidate != thief && queued_events > victim_queued_events)
+        {
+          victim = candidate;
+          victim_queued_events = queued_events;
+        }
+    }
+
+  if (!victim)
+    return NULL;
+
+  LogSchedulerBatch *batch = NULL;
+
+  g_mutex_lock(&victim->batches_lock);
+  if (!iv_list_empty(&victim->batches))
+    {
+      batch = iv_list_entry(victim->batches.prev, LogSchedulerBatch, list);
+      iv_list_del(&batch->list);
+    }
+  g_mutex_unlock(&victim->batches_lock);
+
+  if (batch)
+    {
+      atomic_gssize_sub(&victim->queued_events, batch->len);
+      stats_counter_add(thief->metrics.stolen_events_total, batch->len);
+    }
+  return batch;
+}
+
 /* runs in its own "thread" */
 static void
 _work(gpointer s, gpointer arg)
 {
   LogSchedulerPartition *partition = (LogSchedulerPartition *) s;
   struct iv_list_head *batch_list_head, *next_batch_list_head;
-  struct iv_list_head *msg_list_head, *next_msg_list_head;
 
   /*
    * We need to occasionally return from this job,
@@ -117,34 +193,26 @@ _work(gpointer s, gpointer arg)
         /* remove the first batch from the batches list */
         LogSchedulerBatch *batch = iv_list_entry(batch_list_head, LogSchedulerBatch, list);
         iv_list_del(&batch->list);
+        atomic_gssize_sub(&partition->queued_events, batch->len);
 
-        iv_list_for_each_safe(msg_list_head, next_msg_list_head, &batch->elements)
-        {
-          LogMessageQueueNode *node = iv_list_entry(msg_list_head, LogMessageQueueNode, list);
-
-          iv_list_del(&node->list);
-
-          LogMessage *msg = log_msg_ref(node->msg);
-
-          LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
-          path_options.ack_needed = node->ack_needed;
-          path_options.flow_control_requested = node->flow_control_requested;
-
-          log_msg_free_queue_node(node);
-
-          _reinject_message(partition->front_pipe, msg, &path_options, partition->metrics.processing_latency);
-
-          msgs_processed++;
-          stats_counter_inc(partition->metrics.processed_events_total);
-
-          /* We process the current batch even if we bumped into the limit during its processing. */
-          fetch_limit_reached = partition->log_fetch_limit > 0 && msgs_processed >= partition->log_fetch_limit;
-        }
-        _batch_free(batch);
+        /* We process the current batch even if we bump into the limit during its processing. */
+        msgs_processed += _process_batch(partition, batch);
+        fetch_limit_reached = partition->log_fetch_limit > 0 && msgs_processed >= partition->log_fetch_limit;
       }
       g_mutex_lock(&partition->batches_lock);
     }
   g_mutex_unlock(&partition->batches_lock);
+
+  if (!partition->scheduler->options->work_stealing)
+    return;
+
+  /* our own batches are depleted, help out the busiest partition */
+  LogSchedulerBatch *batch;
+  while (!fetch_limit_reached && (batch = _steal_batch(partition)))
+    {
+      msgs_processed += _process_batch(partition, batch);
+      fetch_limit_reached = partition->log_fetch_limit > 0 && msgs_processed >= partition->log_fetch_limit;
+    }
 }
 
 /* runs in the main thread */
@@ -171,12 +239,49 @@ _complete(gpointer s, gpointer arg)
     main_loop_io_worker_job_force_submit(&partition->io_job, NULL);
 }
 
+/* runs in the source thread */
+static gboolean
+_partition_try_start_flush(LogSchedulerPartition *partition)
+{
+  gboolean trigger_flush = FALSE;
+
+  g_mutex_lock(&partition->batches_lock);
+  if (!partition->flush_running)
+    partition->flush_running = trigger_flush = TRUE;
+  g_mutex_unlock(&partition->batches_lock);
+
+  if (trigger_flush)
+    main_loop_io_worker_job_submit_continuation(&partition->io_job, NULL);
+  return trigger_flush;
+}
+
+/* runs in the source thread, start an idle partition, so that it steals work from the busy ones */
+static void
+_wake_up_idle_partition(LogScheduler *self, LogSchedulerPartition *busy_partition)
+{
+  gint num_partitions = self->options->num_partitions;
+
+  for (gint i = 1; i < num_partitions; i++)
+    {
+      LogSchedulerPartition *partition = &self->partitions[(busy_partition->index + i) % num_partitions];
+
+      /* racy pre-check to avoid taking the lock of every busy partition */
+      if (partition->flush_running)
+        continue;
+
+      if (_partition_try_start_flush(partition))
+        return;
+    }
+}
+
 /* runs in the source thread */
 static void
 _partition_add_batch(LogSchedulerPartition *partition, LogSchedulerBatch *batch)
 {
   gboolean trigger_flush = FALSE;
 
+  atomic_gssize_add(&partition->queued_events, batch->len);
+
   g_mutex_lock(&partition->batches_lock);
   if (!partition->flush_running)
     partition->flush_running = trigger_flush = TRUE;
@@ -185,6 +290,8 @@ _partition_add_batch(LogSchedulerPartition *partition, LogSchedulerBatch *batch)
 
   if (trigger_flush)
     main_loop_io_worker_job_submit_continuation(&partition->io_job, NULL);
+  else if (partition->scheduler->options->work_stealing)
+    _wake_up_idle_partition(partition->scheduler, partition);
 }
 
 static void
@@ -218,9 +325,24 @@ _format_processed_events_key(LogSchedulerPartition *partition, const gchar *sche
 }
 
 static void
-_partition_init(LogSchedulerPartition *partition, LogPipe *front_pipe, gsize log_fetch_limit, const gchar *scheduler_id,
-                gint partition_index, StatsAggregator *processing_latency)
+_format_queued_events_key(LogSchedulerPartition *partition, const gchar *scheduler_id, gint partition_index,
+                          StatsClusterKey *sc_key)
 {
+  _format_sc_key(partition, scheduler_id, partition_index, sc_key, METRIC(parallelized_queued_events));
+}
+
+static void
+_format_stolen_events_key(LogSchedulerPartition *partition, const gchar *scheduler_id, gint partition_index,
+                          StatsClusterKey *sc_key)
+{
+  _format_sc_key(partition, scheduler_id, partition_index, sc_key, METRIC(parallelized_stolen_events_total));
+}
+
+static void
+_partition_init(LogSchedulerPartition *partition, LogScheduler *scheduler, gint partition_index)
+{
+  const gchar *scheduler_id = scheduler->id;
+
   main_loop_io_worker_job_init(&partition->io_job);
   partition->io_job.type = MLIOJ_PROCESSING;
   partition->io_job.user_data = partition;
@@ -229,8 +351,11 @@ _partition_init(LogSchedulerPartition *partition, LogPipe *front_pipe, gsize log
   partition->io_job.engage = NULL;
   partition->io_job.release = NULL;
 
-  partition->front_pipe = front_pipe;
-  partition->log_fetch_limit = log_fetch_limit;
+  partition->scheduler = scheduler;
+  partition->index = partition_index;
+  partition->front_pipe = scheduler->front_pipe;
+  partition->log_fetch_limit = scheduler->options->log_fetch_limit;
+  atomic_gssize_set(&partition->queued_events, 0);
 
   INIT_IV_LIST_HEAD(&partition->batches);
   g_mutex_init(&partition->batches_lock);
@@ -246,9 +371,17 @@ _partition_init(LogSchedulerPartition *partition, LogPipe *front_pipe, gsize log
                                  &partition->metrics.processed_events_total_key);
     stats_register_counter(4, &partition->metrics.processed_events_total_key, SC_TYPE_SINGLE_VALUE,
                            &partition->metrics.processed_events_total);
+
+    _format_queued_events_key(partition, scheduler_id, partition_index, &partition->metrics.queued_events_key);
+    stats_register_external_counter(4, &partition->metrics.queued_events_key, SC_TYPE_SINGLE_VALUE,
+                                    &partition->queued_events);
+
+    _format_stolen_events_key(partition, scheduler_id, partition_index, &partition->metrics.stolen_events_total_key);
+    stats_register_counter(4, &partition->metrics.stolen_events_total_key, SC_TYPE_SINGLE_VALUE,
+                           &partition->metrics.stolen_events_total);
   }
   stats_unlock();
-  partition->metrics.processing_latency = processing_latency;
+  partition->metrics.processing_latency = scheduler->processing_latency;
 }
 
 void
@@ -262,8 +395,14 @@ _partition_clear(LogSchedulerPartition *partition)
                              &partition->metrics.assigned_events_total);
     stats_unregister_counter(&partition->metrics.processed_events_total_key, SC_TYPE_SINGLE_VALUE,
                              &partition->metrics.processed_events_total);
+    stats_unregister_external_counter(&partition->metrics.queued_events_key, SC_TYPE_SINGLE_VALUE,
+                                      &partition->queued_events);
+    stats_unregister_counter(&partition->metrics.stolen_events_total_key, SC_TYPE_SINGLE_VALUE,
+                             &partition->metrics.stolen_events_total);
     stats_cluster_key_cloned_free(&partition->metrics.assigned_events_total_key);
     stats_cluster_key_cloned_free(&partition->metrics.processed_events_total_key);
+    stats_cluster_key_cloned_free(&partition->metrics.queued_events_key);
+    stats_cluster_key_cloned_free(&partition->metrics.stolen_events_total_key);
   }
   stats_unlock();
   partition->metrics.processing_latency = NULL;
@@ -309,7 +448,8 @@ _move_batch_to_partition(LogScheduler *self, LogSchedulerThreadState *thread_sta
   stats_aggregator_add_data_point(thread_state->metrics.batch_size, thread_state->partitions[partition_index].len);
 
   /* form the new batch, hand over the accumulated elements in batch_by_partition */
-  LogSchedulerBatch *batch = _batch_new(&thread_state->partitions[partition_index].elements);
+  LogSchedulerBatch *batch = _batch_new(&thread_state->partitions[partition_index].elements,
+                                        thread_state->partitions[partition_index].len);
   INIT_IV_LIST_HEAD(&thread_state->partitions[partition_index].elements);
   thread_state->partitions[partition_index].len = 0;
 
@@ -374,6 +514,7 @@ _thread_state_init(LogScheduler *self, LogSchedulerThreadState *state, gint inde
 
   state->last_partition = index % self->options->num_partitions;
 
+  state->partitions = g_new0(LogSchedulerThreadPartition, self->options->num_partitions);
   for (gint i = 0; i < self->options->num_partitions; i++)
     {
       INIT_IV_LIST_HEAD(&state->partitions[i].elements);
@@ -383,6 +524,12 @@ _thread_state_init(LogScheduler *self, LogSchedulerThreadState *state, gint inde
   state->metrics.input_batch_size = self->input_batch_size;
 }
 
+static void
+_thread_state_clear(LogSchedulerThreadState *state)
+{
+  g_free(state->partitions);
+}
+
 static void
 _init_thread_states(LogScheduler *self)
 {
@@ -392,13 +539,22 @@ _init_thread_states(LogScheduler *self)
     }
 }
 
+static void
+_free_thread_states(LogScheduler *self)
+{
+  for (gint i = 0; i < self->num_input_threads; i++)
+    {
+      _thread_state_clear(&self->input_thread_states[i]);
+    }
+}
+
 static void
 _init_partitions(LogScheduler *self)
 {
+  self->partitions = g_new0(LogSchedulerPartition, self->options->num_partitions);
   for (gint i = 0; i < self->options->num_partitions; i++)
     {
-      _partition_init(&self->partitions[i], self->front_pipe, self->options->log_fetch_limit, self->id, i,
-                      self->processing_latency);
+      _partition_init(&self->partitions[i], self, i);
     }
 }
 
@@ -409,6 +565,7 @@ _free_partitions(LogScheduler *self)
     {
       _partition_clear(&self->partitions[i]);
     }
+  g_free(self->partitions);
 }
 
 gboolean
@@ -558,6 +715,7 @@ log_scheduler_free(LogScheduler *self)
   _deinit_scheduler_metrics(self);
   log_pipe_unref(self->front_pipe);
   _free_partitions(self);
+  _free_thread_states(self);
   g_free(self->id);
   g_free(self);
 }
@@ -624,6 +782,7 @@ log_scheduler_options_defaults(LogSchedulerOptions *options)
   options->batch_size = -1;
   options->partition_key = NULL;
   options->log_fetch_limit = 1000;
+  options->work_stealing = FALSE;
 }
 
 #define STRINGIFY(x) #x
@@ -644,6 +803,12 @@ log_scheduler_options_init(LogSchedulerOptions *options, GlobalConfig *cfg)
     }
   if (options->batch_size == -1)
     options->batch_size = 100;
+  if (options->work_stealing && options->partition_key)
+    {
+      msg_warning("WARNING: parallelize() work-stealing() cannot be used together with partition-key(), "
+                  "as it would break the ordering of messages within a partition, disabling work-stealing");
+      options->work_stealing = FALSE;
+    }
 
   return TRUE;
 }
@@ -32,12 +32,15 @@
 #include <iv_list.h>
 #include <iv_event.h>
 
-#define LOGSCHEDULER_MAX_PARTITIONS 32
+#define LOGSCHEDULER_MAX_PARTITIONS 1024
+
+struct _LogScheduler;
 
 typedef struct _LogSchedulerBatch
 {
   struct iv_list_head elements;
   struct iv_list_head list;
+  gsize len;
 } LogSchedulerBatch;
 
 typedef struct _LogSchedulerPartition
@@ -46,27 +49,37 @@ typedef struct _LogSchedulerPartition
   struct iv_list_head batches;
   gboolean flush_running;
   MainLoopIOWorkerJob io_job;
+  struct _LogScheduler *scheduler;
+  gint index;
   LogPipe *front_pipe;
   gsize log_fetch_limit;
+
+  /* number of messages in batches waiting for this partition */
+  atomic_gssize queued_events;
   struct
   {
     StatsClusterKey assigned_events_total_key;
     StatsClusterKey processed_events_total_key;
+    StatsClusterKey queued_events_key;
+    StatsClusterKey stolen_events_total_key;
     StatsCounterItem *assigned_events_total;
     StatsCounterItem *processed_events_total;
+    StatsCounterItem *stolen_events_total;
 
     StatsAggregator *processing_latency;
   } metrics;
 } LogSchedulerPartition;
 
+typedef struct _LogSchedulerThreadPartition
+{
+  struct iv_list_head elements;
+  guint32 len;
+} LogSchedulerThreadPartition;
+
 typedef struct _LogSchedulerThreadState
 {
   WorkerBatchCallback batch_callback;
-  struct
-  {
-    struct iv_list_head elements;
-    guint32 len;
-  } partitions[LOGSCHEDULER_MAX_PARTITIONS];
+  LogSchedulerThreadPartition *partitions;
 
   gint last_partition;
   gint current_batch_size;
@@ -84,6 +97,7 @@ typedef struct _LogSchedulerOptions
   gint batch_size;
   LogTemplate *partition_key;
   gsize log_fetch_limit;
+  gboolean work_stealing;
 } LogSchedulerOptions;
 
 typedef struct _LogScheduler
@@ -92,7 +106,7 @@ typedef struct _LogScheduler
   LogPipe *front_pipe;
   LogSchedulerOptions *options;
   gint num_input_threads;
-  LogSchedulerPartition partitions[LOGSCHEDULER_MAX_PARTITIONS];
+  LogSchedulerPartition *partitions;
   StatsCounterItem *parallelize_failed_events_total;
   StatsAggregator *processing_latency;
   StatsAggregator *batch_size;
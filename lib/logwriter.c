@@ -1488,7 +1488,8 @@ _register_counters(LogWriter *self)
     stats_register_counter(level, self->metrics.output_events_key, SC_TYPE_SUPPRESSED,
                            &self->metrics.suppressed_messages);
   stats_register_counter(level, self->metrics.output_events_key, SC_TYPE_DROPPED, &self->metrics.dropped_messages);
-  stats_register_counter(level, self->metrics.output_events_key, SC_TYPE_WRITTEN, &self->metrics.written_messages);
+  stats_register_sharded_counter(level, self->metrics.output_events_key, SC_TYPE_WRITTEN,
+                                 &self->metrics.written_messages);
 
 
   gchar stats_instance[1024];
@@ -1498,7 +1499,8 @@ _register_counters(LogWriter *self)
   StatsClusterKey sc_legacy_processed;
   stats_cluster_single_key_legacy_set_with_name(&sc_legacy_processed, self->options->stats_source | SCS_DESTINATION,
                                                 self->stats_id, stats_instance, "processed");
-  stats_register_counter(level, &sc_legacy_processed, SC_TYPE_SINGLE_VALUE, &self->metrics.processed_messages);
+  stats_register_sharded_counter(level, &sc_legacy_processed, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.processed_messages);
 
   StatsClusterKey sc_key_truncated_count;
   stats_cluster_single_key_legacy_set_with_name(&sc_key_truncated_count, self->options->stats_source | SCS_DESTINATION,
@@ -32,8 +32,12 @@
 
 #define METRIC_NAMES(M) \
   M(classified_events_total) \
+  M(correlation_contexts) \
+  M(correlation_lock_contentions_total) \
+  M(correlation_lock_wait_seconds_total) \
   M(disk_queue_capacity_bytes) \
   M(disk_queue_capacity) \
+  M(disk_queue_commit_latency_seconds) \
   M(disk_queue_dir_available_bytes) \
   M(disk_queue_disk_allocated_bytes) \
   M(disk_queue_disk_usage_bytes) \
@@ -42,7 +46,11 @@
   M(disk_queue_processed_events_total) \
   M(event_processing_latency_seconds) \
   M(events_allocated_bytes) \
+  M(events_pinned_input_bytes) \
   M(filtered_events_total) \
+  M(filterx_jit_cache_hits_total) \
+  M(filterx_jit_cache_misses_total) \
+  M(filterx_jit_cache_saved_compile_time_seconds) \
   M(fx_xxx_evals_total) \
   M(input_event_bytes_total) \
   M(input_events_total) \
@@ -80,6 +88,8 @@
   M(parallelized_processed_events_total) \
   M(parallelized_batch_size) \
   M(parallelized_input_batch_size) \
+  M(parallelized_queued_events) \
+  M(parallelized_stolen_events_total) \
   M(parsed_events_total) \
   M(route_egress_total) \
   M(route_ingress_total) \
@@ -89,6 +99,7 @@
   M(socket_max_connections) \
   M(socket_receive_buffer_max_bytes) \
   M(socket_receive_buffer_used_bytes) \
+  M(socket_receive_datagrams_per_syscall) \
   M(socket_receive_dropped_packets_total) \
   M(socket_rejected_connections_total) \
   M(stats_level) \
@@ -81,6 +81,16 @@ log_rewrite_init_method(LogPipe *s)
   return TRUE;
 }
 
+gboolean
+log_rewrite_deinit_method(LogPipe *s)
+{
+  LogRewrite *self = (LogRewrite *) s;
+
+  if (self->condition)
+    filter_expr_deinit(self->condition, log_pipe_get_config(s));
+  return TRUE;
+}
+
 void
 log_rewrite_free_method(LogPipe *s)
 {
@@ -101,5 +111,6 @@ log_rewrite_init_instance(LogRewrite *self, GlobalConfig *cfg)
   self->super.free_fn = log_rewrite_free_method;
   self->super.queue = log_rewrite_queue;
   self->super.init = log_rewrite_init_method;
+  self->super.deinit = log_rewrite_deinit_method;
   self->value_handle = LM_V_MESSAGE;
 }
@@ -40,6 +40,7 @@ struct _LogRewrite
 
 /* LogRewrite, abstract class */
 gboolean log_rewrite_init_method(LogPipe *s);
+gboolean log_rewrite_deinit_method(LogPipe *s);
 void log_rewrite_clone_method(LogRewrite *dst, const LogRewrite *src);
 
 void log_rewrite_set_condition(LogRewrite *s, FilterExprNode *condition);
@@ -0,0 +1,686 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "json-scanner.h"
+#include "cpu-features.h"
+#include "str-format.h"
+
+#include <string.h>
+
+#if CPU_FEATURES_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#if CPU_FEATURES_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+#define JSON_SCANNER_INITIAL_TOKENS 256
+#define JSON_TOKEN_NO_PARENT G_MAXUINT32
+
+/*
+ * String scanning kernels: return the offset of the first character in
+ * s[0..n) that terminates the plain part of a JSON string, e.g.  a quote,
+ * a backslash or a NUL character, or n if there is none.
+ */
+
+static gsize
+_find_string_special_scalar(const gchar *s, gsize n)
+{
+  for (gsize i = 0; i < n; i++)
+    {
+      gchar c = s[i];
+
+      if (c == '"' || c == '\\' || c == '\0')
+        return i;
+    }
+  return n;
+}
+
+#if CPU_FEATURES_HAVE_X86_SIMD
+
+__attribute__((target("sse4.2")))
+static gsize
+_find_string_special_sse42(const gchar *s, gsize n)
+{
+  const __m128i specials = _mm_setr_epi8('"', '\\', '\0', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+  gsize i = 0;
+
+  for (; i + 16 <= n; i += 16)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *) (s + i));
+      gint idx = _mm_cmpestri(specials, 3, chunk, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+
+      if (idx < 16)
+        return i + idx;
+    }
+  return i + _find_string_special_scalar(s + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static gsize
+_find_string_special_avx2(const gchar *s, gsize n)
+{
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i nul = _mm256_setzero_si256();
+  gsize i = 0;
+
+  for (; i + 32 <= n; i += 32)
+    {
+      __m256i chunk = _mm256_loadu_si256((const __m256i *) (s + i));
+      __m256i matches = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote),
+                                                        _mm256_cmpeq_epi8(chunk, backslash)),
+                                        _mm256_cmpeq_epi8(chunk, nul));
+      guint32 mask = (guint32) _mm256_movemask_epi8(matches);
+
+      if (mask)
+        return i + __builtin_ctz(mask);
+    }
+  return i + _find_string_special_scalar(s + i, n - i);
+}
+
+#endif
+
+#if CPU_FEATURES_HAVE_NEON
+
+static gsize
+_find_string_special_neon(const gchar *s, gsize n)
+{
+  const uint8x16_t quote = vdupq_n_u8('"');
+  const uint8x16_t backslash = vdupq_n_u8('\\');
+  gsize i = 0;
+
+  for (; i + 16 <= n; i += 16)
+    {
+      uint8x16_t chunk = vld1q_u8((const uint8_t *) (s + i));
+      uint8x16_t matches = vorrq_u8(vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash)),
+                                    vceqzq_u8(chunk));
+      /* narrow the byte mask to 4 bits per byte, NEON has no movemask */
+      guint64 mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+
+      if (mask)
+        return i + (__builtin_ctzll(mask) >> 2);
+    }
+  return i + _find_string_special_scalar(s + i, n - i);
+}
+
+#endif
+
+gboolean
+json_scanner_set_simd_level(JSONScanner *self, JSONScannerSIMDLevel level)
+{
+  switch (level)
+    {
+    case JSON_SCANNER_SIMD_NONE:
+      self->find_string_special = _find_string_special_scalar;
+      break;
+#if CPU_FEATURES_HAVE_X86_SIMD
+    case JSON_SCANNER_SIMD_SSE42:
+      if (!cpu_supports_sse42())
+        return FALSE;
+      self->find_string_special = _find_string_special_sse42;
+      break;
+    case JSON_SCANNER_SIMD_AVX2:
+      if (!cpu_supports_avx2())
+        return FALSE;
+      self->find_string_special = _find_string_special_avx2;
+      break;
+#endif
+#if CPU_FEATURES_HAVE_NEON
+    case JSON_SCANNER_SIMD_NEON:
+      self->find_string_special = _find_string_special_neon;
+      break;
+#endif
+    default:
+      return FALSE;
+    }
+  self->simd_level = level;
+  return TRUE;
+}
+
+static void
+_select_simd_level(JSONScanner *self)
+{
+  if (json_scanner_set_simd_level(self, JSON_SCANNER_SIMD_AVX2) ||
+      json_scanner_set_simd_level(self, JSON_SCANNER_SIMD_SSE42) ||
+      json_scanner_set_simd_level(self, JSON_SCANNER_SIMD_NEON))
+    return;
+
+  json_scanner_set_simd_level(self, JSON_SCANNER_SIMD_NONE);
+}
+
+/* scanning */
+
+typedef enum
+{
+  JSS_EXPECT_VALUE,
+  JSS_EXPECT_VALUE_OR_CLOSE,
+  JSS_EXPECT_KEY,
+  JSS_EXPECT_KEY_OR_CLOSE,
+  JSS_EXPECT_COLON,
+  JSS_EXPECT_COMMA_OR_CLOSE,
+} JSONScannerState;
+
+static inline JSONScannerResult
+_fail(JSONScanner *self, JSONScannerResult result, gsize pos)
+{
+  self->error_pos = pos;
+  return result;
+}
+
+/* an unexpected character is an error, the end of the input means we need more */
+static inline JSONScannerResult
+_fail_unexpected(JSONScanner *self, const gchar *input, gsize input_len, gsize pos)
+{
+  if (pos >= input_len || input[pos] == '\0')
+    return _fail(self, JSON_SCANNER_ERROR_INCOMPLETE, pos);
+  return _fail(self, JSON_SCANNER_ERROR_INVALID, pos);
+}
+
+static inline gboolean
+_is_whitespace(gchar c)
+{
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static inline gsize
+_skip_whitespace(const gchar *input, gsize input_len, gsize pos)
+{
+  while (pos < input_len && _is_whitespace(input[pos]))
+    pos++;
+  return pos;
+}
+
+static inline gsize
+_skip_digits(const gchar *input, gsize input_len, gsize pos)
+{
+  while (pos < input_len && g_ascii_isdigit(input[pos]))
+    pos++;
+  return pos;
+}
+
+/* numbers and literals must be followed by something that can close them */
+static inline gboolean
+_is_value_terminated(const gchar *input, gsize input_len, gsize pos)
+{
+  if (pos >= input_len)
+    return TRUE;
+
+  gchar c = input[pos];
+  return _is_whitespace(c) || c == ',' || c == ']' || c == '}' || c == '\0';
+}
+
+static inline gboolean
+_is_value_start(gchar c)
+{
+  return c == '{' || c == '[' || c == '"' || c == '-' || g_ascii_isdigit(c) || c == 't' || c == 'f' || c == 'n';
+}
+
+static gboolean
+_grow_tokens(JSONScanner *self)
+{
+  if (self->max_tokens && self->tokens_size >= self->max_tokens)
+    return FALSE;
+
+  gsize new_size = MAX(self->tokens_size * 2, JSON_SCANNER_INITIAL_TOKENS);
+  if (self->max_tokens)
+    new_size = MIN(new_size, self->max_tokens);
+
+  if (self->tokens && self->tokens == self->preallocated_tokens)
+    {
+      JSONToken *tokens = g_new(JSONToken, new_size);
+
+      memcpy(tokens, self->tokens, self->num_tokens * sizeof(JSONToken));
+      self->tokens = tokens;
+    }
+  else
+    {
+      self->tokens = g_renew(JSONToken, self->tokens, new_size);
+    }
+  self->tokens_size = new_size;
+  return TRUE;
+}
+
+static inline JSONToken *
+_alloc_token(JSONScanner *self, JSONTokenType type, gsize start, gsize end, guint32 parent)
+{
+  if (G_UNLIKELY(self->num_tokens == self->tokens_size) && !_grow_tokens(self))
+    return NULL;
+
+  JSONToken *token = &self->tokens[self->num_tokens++];
+  token->type = type;
+  token->flags = 0;
+  token->start = start;
+  token->end = end;
+  token->size = 0;
+  token->next = self->num_tokens;
+  token->parent = parent;
+  return token;
+}
+
+static JSONScannerResult
+_scan_string(JSONScanner *self, const gchar *input, gsize input_len, gsize *pos, guint32 parent)
+{
+  gsize start = *pos + 1;
+  gsize end = start;
+  guint8 flags = 0;
+
+  while (TRUE)
+    {
+      end += self->find_string_special(&input[end], input_len - end);
+      if (end >= input_len || input[end] == '\0')
+        return _fail(self, JSON_SCANNER_ERROR_INCOMPLETE, *pos);
+
+      if (input[end] == '"')
+        break;
+
+      /* backslash */
+      flags |= JSON_TOKEN_FLAG_ESCAPED;
+      end++;
+      if (end >= input_len)
+        return _fail(self, JSON_SCANNER_ERROR_INCOMPLETE, *pos);
+
+      switch (input[end])
+        {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+          end++;
+          break;
+        case 'u':
+          for (gint i = 1; i <= 4; i++)
+            {
+              if (!(end + i < input_len && g_ascii_isxdigit(input[end + i])))
+                return _fail_unexpected(self, input, input_len, end + i);
+            }
+          end += 5;
+          break;
+        default:
+          return _fail_unexpected(self, input, input_len, end);
+        }
+    }
+
+  JSONToken *token = _alloc_token(self, JSON_TOKEN_STRING, start, end, parent);
+  if (!token)
+    return _fail(self, JSON_SCANNER_ERROR_TOO_LARGE, *pos);
+
+  token->flags = flags;
+  *pos = end + 1;
+  return JSON_SCANNER_SUCCESS;
+}
+
+static JSONScannerResult
+_scan_number(JSONScanner *self, const gchar *input, gsize input_len, gsize *pos, guint32 parent)
+{
+  gsize start = *pos;
+  gsize end = start;
+  guint8 flags = 0;
+
+  if (input[end] == '-')
+    end++;
+
+  if (end < input_len && input[end] == '0')
+    end++;
+  else if (end < input_len && input[end] >= '1' && input[end] <= '9')
+    end = _skip_digits(input, input_len, end);
+  else
+    return _fail_unexpected(self, input, input_len, end);
+
+  if (end < input_len && input[end] == '.')
+    {
+      flags |= JSON_TOKEN_FLAG_FLOAT;
+      end++;
+      if (!(end < input_len && g_ascii_isdigit(input[end])))
+        return _fail_unexpected(self, input, input_len, end);
+      end = _skip_digits(input, input_len, end);
+    }
+
+  if (end < input_len && (input[end] == 'e' || input[end] == 'E'))
+    {
+      flags |= JSON_TOKEN_FLAG_FLOAT;
+      end++;
+      if (end < input_len && (input[end] == '+' || input[end] == '-'))
+        end++;
+      if (!(end < input_len && g_ascii_isdigit(input[end])))
+        return _fail_unexpected(self, input, input_len, end);
+      end = _skip_digits(input, input_len, end);
+    }
+
+  if (!_is_value_terminated(input, input_len, end))
+    return _fail(self, JSON_SCANNER_ERROR_INVALID, end);
+
+  JSONToken *token = _alloc_token(self, JSON_TOKEN_NUMBER, start, end, parent);
+  if (!token)
+    return _fail(self, JSON_SCANNER_ERROR_TOO_LARGE, start);
+
+  token->flags = flags;
+  *pos = end;
+  return JSON_SCANNER_SUCCESS;
+}
+
+static JSONScannerResult
+_scan_literal(JSONScanner *self, const gchar *input, gsize input_len, gsize *pos, guint32 parent,
+              const gchar *literal, gsize literal_len, JSONTokenType type)
+{
+  gsize start = *pos;
+  gsize available = MIN(input_len - start, literal_len);
+
+  if (memcmp(&input[start], literal, available) != 0)
+    return _fail(self, JSON_SCANNER_ERROR_INVALID, start);
+  if (available < literal_len)
+    return _fail(self, JSON_SCANNER_ERROR_INCOMPLETE, start);
+
+  gsize end = start + literal_len;
+  if (!_is_value_terminated(input, input_len, end))
+    return _fail(self, JSON_SCANNER_ERROR_INVALID, end);
+
+  if (!_alloc_token(self, type, start, end, parent))
+    return _fail(self, JSON_SCANNER_ERROR_TOO_LARGE, start);
+
+  *pos = end;
+  return JSON_SCANNER_SUCCESS;
+}
+
+static JSONScannerResult
+_scan_scalar(JSONScanner *self, const gchar *input, gsize input_len, gsize *pos, guint32 parent)
+{
+  switch (input[*pos])
+    {
+    case '"':
+      return _scan_string(self, input, input_len, pos, parent);
+    case 't':
+      return _scan_literal(self, input, input_len, pos, parent, "true", 4, JSON_TOKEN_TRUE);
+    case 'f':
+      return _scan_literal(self, input, input_len, pos, parent, "false", 5, JSON_TOKEN_FALSE);
+    case 'n':
+      return _scan_literal(self, input, input_len, pos, parent, "null", 4, JSON_TOKEN_NULL);
+    default:
+      if (input[*pos] == '-' || g_ascii_isdigit(input[*pos]))
+        return _scan_number(self, input, input_len, pos, parent);
+      return _fail(self, JSON_SCANNER_ERROR_INVALID, *pos);
+    }
+}
+
+JSONScannerResult
+json_scanner_scan(JSONScanner *self, const gchar *input, gsize input_len)
+{
+  JSONScannerState state = JSS_EXPECT_VALUE;
+  JSONScannerResult result;
+  guint32 container = JSON_TOKEN_NO_PARENT;
+  gsize depth = 0;
+  gsize pos = 0;
+
+  self->num_tokens = 0;
+  self->error_pos = 0;
+
+  /* token offsets are 32 bits */
+  if (input_len >= G_MAXUINT32)
+    return _fail(self, JSON_SCANNER_ERROR_TOO_LARGE, 0);
+
+  while (TRUE)
+    {
+      pos = _skip_whitespace(input, input_len, pos);
+      if (pos >= input_len || input[pos] == '\0')
+        return _fail(self, JSON_SCANNER_ERROR_INCOMPLETE, pos);
+
+      gchar c = input[pos];
+
+      switch (state)
+        {
+        case JSS_EXPECT_KEY_OR_CLOSE:
+          if (c == '}')
+            goto close_container;
+        /* fallthrough */
+        case JSS_EXPECT_KEY:
+          if (c != '"')
+            return _fail(self, JSON_SCANNER_ERROR_INVALID, pos);
+
+          self->tokens[container].size++;
+          result = _scan_string(self, input, input_len, &pos, container);
+          if (result != JSON_SCANNER_SUCCESS)
+            return result;
+          state = JSS_EXPECT_COLON;
+          continue;
+
+        case JSS_EXPECT_COLON:
+          if (c != ':')
+            return _fail(self, JSON_SCANNER_ERROR_INVALID, pos);
+          pos++;
+          state = JSS_EXPECT_VALUE;
+          continue;
+
+        case JSS_EXPECT_COMMA_OR_CLOSE:
+          if (c == ',')
+            {
+              pos++;
+              state = self->tokens[container].type == JSON_TOKEN_OBJECT ? JSS_EXPECT_KEY : JSS_EXPECT_VALUE;
+              continue;
+            }
+          if (c == '}' || c == ']')
+            goto close_container;
+          return _fail(self, JSON_SCANNER_ERROR_INVALID, pos);
+
+        case JSS_EXPECT_VALUE_OR_CLOSE:
+          if (c == ']')
+            goto close_container;
+          break;
+
+        case JSS_EXPECT_VALUE:
+          break;
+
+        default:
+          g_assert_not_reached();
+        }
+
+      /* a value starts at pos */
+      if (container != JSON_TOKEN_NO_PARENT && self->tokens[container].type == JSON_TOKEN_ARRAY)
+        self->tokens[container].size++;
+
+      if (c == '{' || c == '[')
+        {
+          if (self->max_depth && depth >= self->max_depth)
+            return _fail(self, JSON_SCANNER_ERROR_TOO_DEEP, pos);
+
+          if (!_alloc_token(self, c == '{' ? JSON_TOKEN_OBJECT : JSON_TOKEN_ARRAY, pos, pos, container))
+            return _fail(self, JSON_SCANNER_ERROR_TOO_LARGE, pos);
+
+          container = self->num_tokens - 1;
+          depth++;
+          pos++;
+          state = c == '{' ? JSS_EXPECT_KEY_OR_CLOSE : JSS_EXPECT_VALUE_OR_CLOSE;
+          continue;
+        }
+
+      result = _scan_scalar(self, input, input_len, &pos, container);
+      if (result != JSON_SCANNER_SUCCESS)
+        return result;
+
+      if (container == JSON_TOKEN_NO_PARENT)
+        break;
+      state = JSS_EXPECT_COMMA_OR_CLOSE;
+      continue;
+
+close_container:
+      if ((c == '}') != (self->tokens[container].type == JSON_TOKEN_OBJECT))
+        return _fail(self, JSON_SCANNER_ERROR_INVALID, pos);
+
+      pos++;
+      self->tokens[container].end = pos;
+      self->tokens[container].next = self->num_tokens;
+      container = self->tokens[container].parent;
+      depth--;
+
+      if (container == JSON_TOKEN_NO_PARENT)
+        break;
+      state = JSS_EXPECT_COMMA_OR_CLOSE;
+    }
+
+  pos = _skip_whitespace(input, input_len, pos);
+  if (pos < input_len && input[pos] != '\0')
+    return _fail(self, _is_value_start(input[pos]) ? JSON_SCANNER_ERROR_MULTIPLE_VALUES : JSON_SCANNER_ERROR_INVALID,
+                 pos);
+
+  return JSON_SCANNER_SUCCESS;
+}
+
+/* unescaping */
+
+#define IS_UTF16_HIGH_SURROGATE(cp) (((cp) & 0xFC00) == 0xD800)
+#define IS_UTF16_LOW_SURROGATE(cp) (((cp) & 0xFC00) == 0xDC00)
+#define DECODE_UTF16_SURROGATE_PAIR(high, low) ((((high) & 0x3FF) << 10) + ((low) & 0x3FF) + 0x10000)
+#define UNICODE_REPLACEMENT_CP 0xFFFD
+
+static gchar
+_unescape_character(gchar c)
+{
+  switch (c)
+    {
+    case 'b':
+      return '\b';
+    case 'f':
+      return '\f';
+    case 'n':
+      return '\n';
+    case 'r':
+      return '\r';
+    case 't':
+      return '\t';
+    default:
+      /* '"', '\\' and '/' stand for themselves */
+      return c;
+    }
+}
+
+void
+json_scanner_append_unescaped_string(GString *result, const gchar *str, gsize str_len)
+{
+  const gchar *end = str + str_len;
+  glong high_surrogate = 0;
+
+  while (str < end)
+    {
+      const gchar *backslash = memchr(str, '\\', end - str);
+      const gchar *segment_end = backslash ? backslash : end;
+
+      if (high_surrogate && segment_end != str)
+        {
+          /* high surrogate followed by something else than an escape */
+          g_string_append_unichar(result, UNICODE_REPLACEMENT_CP);
+          high_surrogate = 0;
+        }
+      g_string_append_len(result, str, segment_end - str);
+
+      if (!backslash || backslash + 1 == end)
+        break;
+
+      str = backslash + 1;
+      if (*str != 'u')
+        {
+          if (high_surrogate)
+            {
+              g_string_append_unichar(result, UNICODE_REPLACEMENT_CP);
+              high_surrogate = 0;
+            }
+          g_string_append_c(result, _unescape_character(*str));
+          str++;
+          continue;
+        }
+
+      str++;
+      gsize left = end - str;
+      glong codepoint;
+      if (!scan_hex_int(&str, &left, 4, &codepoint))
+        continue;
+
+      if (IS_UTF16_HIGH_SURROGATE(codepoint))
+        {
+          if (high_surrogate)
+            g_string_append_unichar(result, UNICODE_REPLACEMENT_CP);
+          high_surrogate = codepoint;
+          continue;
+        }
+
+      if (IS_UTF16_LOW_SURROGATE(codepoint))
+        {
+          codepoint = high_surrogate ? DECODE_UTF16_SURROGATE_PAIR(high_surrogate, codepoint) : UNICODE_REPLACEMENT_CP;
+        }
+      else if (high_surrogate)
+        {
+          g_string_append_unichar(result, UNICODE_REPLACEMENT_CP);
+        }
+      high_surrogate = 0;
+
+      if (codepoint)
+        g_string_append_unichar(result, (gunichar) codepoint);
+    }
+
+  if (high_surrogate)
+    g_string_append_unichar(result, UNICODE_REPLACEMENT_CP);
+}
+
+const gchar *
+json_scanner_result_to_string(JSONScannerResult result)
+{
+  switch (result)
+    {
+    case JSON_SCANNER_SUCCESS:
+      return "success";
+    case JSON_SCANNER_ERROR_INVALID:
+      return "invalid JSON syntax";
+    case JSON_SCANNER_ERROR_INCOMPLETE:
+      return "incomplete JSON text";
+    case JSON_SCANNER_ERROR_MULTIPLE_VALUES:
+      return "multiple top-level JSON values";
+    case JSON_SCANNER_ERROR_TOO_LARGE:
+      return "JSON text too large";
+    case JSON_SCANNER_ERROR_TOO_DEEP:
+      return "JSON nesting too deep";
+    default:
+      g_assert_not_reached();
+    }
+}
+
+void
+json_scanner_init(JSONScanner *self, JSONToken *preallocated_tokens, gsize preallocated_tokens_size)
+{
+  memset(self, 0, sizeof(*self));
+  self->preallocated_tokens = preallocated_tokens;
+  self->tokens = preallocated_tokens;
+  self->tokens_size = preallocated_tokens ? preallocated_tokens_size : 0;
+  _select_simd_level(self);
+}
+
+void
+json_scanner_deinit(JSONScanner *self)
+{
+  if (self->tokens != self->preallocated_tokens)
+    g_free(self->tokens);
+  self->tokens = NULL;
+  self->tokens_size = 0;
+  self->num_tokens = 0;
+}
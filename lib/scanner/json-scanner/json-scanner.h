@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef JSON_SCANNER_H_INCLUDED
+#define JSON_SCANNER_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/*
+ * JSONScanner is a validating JSON tokenizer that produces a flat array of
+ * tokens (a "tape") instead of an object tree.  Tokens are stored in
+ * document order: a container is followed by its children, an object
+ * member is a key string token followed by its value.  Consumers walk the
+ * tape and store the values directly into their destination (a LogMessage,
+ * a FilterX dict, etc), without building an intermediate DOM.
+ *
+ * The token array is reused between scans, and it can be preallocated
+ * by the caller (e.g.  on the stack), in which case small documents are
+ * scanned without any heap allocation.
+ *
+ * The scanning of string contents, which dominates the runtime for typical
+ * log payloads, uses SIMD kernels (AVX2, SSE4.2 or NEON) when available.
+ */
+
+typedef enum
+{
+  JSON_TOKEN_OBJECT,
+  JSON_TOKEN_ARRAY,
+  JSON_TOKEN_STRING,
+  JSON_TOKEN_NUMBER,
+  JSON_TOKEN_TRUE,
+  JSON_TOKEN_FALSE,
+  JSON_TOKEN_NULL,
+} JSONTokenType;
+
+enum
+{
+  /* the string contains escape sequences, it needs to be unescaped before use */
+  JSON_TOKEN_FLAG_ESCAPED = 0x01,
+  /* the number has a fraction or an exponent part */
+  JSON_TOKEN_FLAG_FLOAT = 0x02,
+};
+
+typedef struct _JSONToken
+{
+  guint8 type;
+  guint8 flags;
+  /* strings exclude the enclosing quotes, containers include their brackets */
+  guint32 start;
+  guint32 end;
+  /* number of members (objects) or elements (arrays) */
+  guint32 size;
+  /* index of the next token that is not part of this one */
+  guint32 next;
+  /* index of the enclosing container, G_MAXUINT32 at the top level */
+  guint32 parent;
+} JSONToken;
+
+typedef enum
+{
+  JSON_SCANNER_SUCCESS = 0,
+  JSON_SCANNER_ERROR_INVALID,
+  JSON_SCANNER_ERROR_INCOMPLETE,
+  JSON_SCANNER_ERROR_MULTIPLE_VALUES,
+  JSON_SCANNER_ERROR_TOO_LARGE,
+  JSON_SCANNER_ERROR_TOO_DEEP,
+} JSONScannerResult;
+
+typedef enum
+{
+  JSON_SCANNER_SIMD_NONE,
+  JSON_SCANNER_SIMD_SSE42,
+  JSON_SCANNER_SIMD_AVX2,
+  JSON_SCANNER_SIMD_NEON,
+} JSONScannerSIMDLevel;
+
+typedef gsize (*JSONScannerFindStringSpecialFunc)(const gchar *s, gsize n);
+
+typedef struct _JSONScanner
+{
+  JSONToken *tokens;
+  gsize num_tokens;
+  gsize tokens_size;
+  JSONToken *preallocated_tokens;
+  gsize max_tokens;
+  gsize max_depth;
+  gsize error_pos;
+
+  JSONScannerSIMDLevel simd_level;
+  JSONScannerFindStringSpecialFunc find_string_special;
+} JSONScanner;
+
+void json_scanner_init(JSONScanner *self, JSONToken *preallocated_tokens, gsize preallocated_tokens_size);
+void json_scanner_deinit(JSONScanner *self);
+gboolean json_scanner_set_simd_level(JSONScanner *self, JSONScannerSIMDLevel level);
+
+JSONScannerResult json_scanner_scan(JSONScanner *self, const gchar *input, gsize input_len);
+
+void json_scanner_append_unescaped_string(GString *result, const gchar *str, gsize str_len);
+const gchar *json_scanner_result_to_string(JSONScannerResult result);
+
+/* 0 means unlimited */
+static inline void
+json_scanner_set_max_tokens(JSONScanner *self, gsize max_tokens)
+{
+  self->max_tokens = max_tokens;
+}
+
+/* 0 means unlimited */
+static inline void
+json_scanner_set_max_depth(JSONScanner *self, gsize max_depth)
+{
+  self->max_depth = max_depth;
+}
+
+static inline const JSONToken *
+json_scanner_get_tokens(JSONScanner *self)
+{
+  return self->tokens;
+}
+
+static inline gsize
+json_scanner_get_num_tokens(JSONScanner *self)
+{
+  return self->num_tokens;
+}
+
+static inline gsize
+json_scanner_get_error_pos(JSONScanner *self)
+{
+  return self->error_pos;
+}
+
+static inline JSONScannerSIMDLevel
+json_scanner_get_simd_level(JSONScanner *self)
+{
+  return self->simd_level;
+}
+
+#endif
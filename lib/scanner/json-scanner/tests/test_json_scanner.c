@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include <criterion/parameterized.h>
+
+#include "json-scanner.h"
+
+static JSONScannerSIMDLevel simd_levels[] =
+{
+  JSON_SCANNER_SIMD_NONE,
+  JSON_SCANNER_SIMD_SSE42,
+  JSON_SCANNER_SIMD_AVX2,
+  JSON_SCANNER_SIMD_NEON,
+};
+
+static JSONScanner scanner;
+static JSONToken preallocated_tokens[4];
+
+static void
+_init_scanner(JSONScannerSIMDLevel level)
+{
+  json_scanner_init(&scanner, preallocated_tokens, G_N_ELEMENTS(preallocated_tokens));
+  if (!json_scanner_set_simd_level(&scanner, level))
+    cr_skip_test("SIMD level %d is not supported on this platform", level);
+}
+
+static JSONScannerResult
+_scan(const gchar *input)
+{
+  return json_scanner_scan(&scanner, input, strlen(input));
+}
+
+static void
+_assert_token(gsize idx, JSONTokenType type, const gchar *input, const gchar *expected_text)
+{
+  cr_assert(idx < json_scanner_get_num_tokens(&scanner));
+
+  const JSONToken *token = &json_scanner_get_tokens(&scanner)[idx];
+  cr_assert_eq(token->type, type, "token %" G_GSIZE_FORMAT " has unexpected type %d", idx, token->type);
+  cr_assert_eq(token->end - token->start, strlen(expected_text));
+  cr_assert(strncmp(&input[token->start], expected_text, strlen(expected_text)) == 0,
+            "token %" G_GSIZE_FORMAT " text mismatch: %.*s", idx, token->end - token->start, &input[token->start]);
+}
+
+ParameterizedTestParameters(json_scanner, test_object_members_follow_their_container)
+{
+  return cr_make_param_array(JSONScannerSIMDLevel, simd_levels, G_N_ELEMENTS(simd_levels));
+}
+
+ParameterizedTest(JSONScannerSIMDLevel *level, json_scanner, test_object_members_follow_their_container)
+{
+  _init_scanner(*level);
+
+  const gchar *input = "{\"foo\": \"bar\", \"list\": [1, -2.5e3, true, false, null], \"empty\": {}}";
+  cr_assert_eq(_scan(input), JSON_SCANNER_SUCCESS);
+  cr_assert_eq(json_scanner_get_num_tokens(&scanner), 13);
+
+  const JSONToken *tokens = json_scanner_get_tokens(&scanner);
+  _assert_token(0, JSON_TOKEN_OBJECT, input, input);
+  cr_assert_eq(tokens[0].size, 3);
+  cr_assert_eq(tokens[0].next, 13);
+
+  _assert_token(1, JSON_TOKEN_STRING, input, "foo");
+  _assert_token(2, JSON_TOKEN_STRING, input, "bar");
+  _assert_token(3, JSON_TOKEN_STRING, input, "list");
+  _assert_token(4, JSON_TOKEN_ARRAY, input, "[1, -2.5e3, true, false, null]");
+  cr_assert_eq(tokens[4].size, 5);
+  cr_assert_eq(tokens[4].next, 10);
+  cr_assert_eq(tokens[4].parent, 0);
+
+  _assert_token(5, JSON_TOKEN_NUMBER, input, "1");
+  cr_assert_not(tokens[5].flags & JSON_TOKEN_FLAG_FLOAT);
+  _assert_token(6, JSON_TOKEN_NUMBER, input, "-2.5e3");
+  cr_assert(tokens[6].flags & JSON_TOKEN_FLAG_FLOAT);
+  _assert_token(7, JSON_TOKEN_TRUE, input, "true");
+  _assert_token(8, JSON_TOKEN_FALSE, input, "false");
+  _assert_token(9, JSON_TOKEN_NULL, input, "null");
+  cr_assert_eq(tokens[9].parent, 4);
+
+  _assert_token(10, JSON_TOKEN_STRING, input, "empty");
+  _assert_token(11, JSON_TOKEN_OBJECT, input, "{}");
+  cr_assert_eq(tokens[11].size, 0);
+
+  json_scanner_deinit(&scanner);
+}
+
+ParameterizedTestParameters(json_scanner, test_long_strings_with_escapes)
+{
+  return cr_make_param_array(JSONScannerSIMDLevel, simd_levels, G_N_ELEMENTS(simd_levels));
+}
+
+ParameterizedTest(JSONScannerSIMDLevel *level, json_scanner, test_long_strings_with_escapes)
+{
+  _init_scanner(*level);
+
+  /* make sure the special characters fall on all kinds of block offsets */
+  GString *input = g_string_new("[");
+  for (gint i = 0; i < 70; i++)
+    {
+      g_string_append_c(input, '"');
+      for (gint j = 0; j < i; j++)
+        g_string_append_c(input, 'a' + j % 26);
+      if (i % 2)
+        g_string_append(input, "\\\"x\\u00e9");
+      g_string_append(input, "\",");
+    }
+  g_string_append(input, "\"\"]");
+
+  cr_assert_eq(json_scanner_scan(&scanner, input->str, input->len), JSON_SCANNER_SUCCESS);
+
+  const JSONToken *tokens = json_scanner_get_tokens(&scanner);
+  cr_assert_eq(tokens[0].size, 71);
+  for (gint i = 0; i < 70; i++)
+    {
+      const JSONToken *token = &tokens[i + 1];
+
+      cr_assert_eq(token->type, JSON_TOKEN_STRING);
+      cr_assert_eq(token->end - token->start, i + (i % 2 ? 9 : 0));
+      cr_assert_eq(!!(token->flags & JSON_TOKEN_FLAG_ESCAPED), i % 2);
+    }
+
+  g_string_free(input, TRUE);
+  json_scanner_deinit(&scanner);
+}
+
+ParameterizedTestParameters(json_scanner, test_invalid_inputs_are_rejected)
+{
+  return cr_make_param_array(JSONScannerSIMDLevel, simd_levels, G_N_ELEMENTS(simd_levels));
+}
+
+ParameterizedTest(JSONScannerSIMDLevel *level, json_scanner, test_invalid_inputs_are_rejected)
+{
+  _init_scanner(*level);
+
+  cr_assert_eq(_scan("{\"foo\": 1,}"), JSON_SCANNER_ERROR_INVALID);
+  cr_assert_eq(json_scanner_get_error_pos(&scanner), 10);
+  cr_assert_eq(_scan("[1 2]"), JSON_SCANNER_ERROR_INVALID);
+  cr_assert_eq(_scan("{1: 2}"), JSON_SCANNER_ERROR_INVALID);
+  cr_assert_eq(_scan("{'foo': 'bar'}"), JSON_SCANNER_ERROR_INVALID);
+  cr_assert_eq(_scan("[}"), JSON_SCANNER_ERROR_INVALID);
+  cr_assert_eq(_scan("01"), JSON_SCANNER_ERROR_INVALID);
+  cr_assert_eq(_scan("truex"), JSON_SCANNER_ERROR_INVALID);
+  cr_assert_eq(_scan("\"\\x\""), JSON_SCANNER_ERROR_INVALID);
+  cr_assert_eq(_scan("\"\\u12g4\""), JSON_SCANNER_ERROR_INVALID);
+
+  cr_assert_eq(_scan(""), JSON_SCANNER_ERROR_INCOMPLETE);
+  cr_assert_eq(_scan("{\"foo\":"), JSON_SCANNER_ERROR_INCOMPLETE);
+  cr_assert_eq(_scan("[\"foo"), JSON_SCANNER_ERROR_INCOMPLETE);
+  cr_assert_eq(json_scanner_get_error_pos(&scanner), 1);
+  cr_assert_eq(_scan("tru"), JSON_SCANNER_ERROR_INCOMPLETE);
+  cr_assert_eq(_scan("1."), JSON_SCANNER_ERROR_INCOMPLETE);
+
+  cr_assert_eq(_scan("{} {}"), JSON_SCANNER_ERROR_MULTIPLE_VALUES);
+  cr_assert_eq(_scan("{} x"), JSON_SCANNER_ERROR_INVALID);
+
+  json_scanner_deinit(&scanner);
+}
+
+Test(json_scanner, test_scalars_at_the_top_level)
+{
+  _init_scanner(JSON_SCANNER_SIMD_NONE);
+
+  cr_assert_eq(_scan("  42  "), JSON_SCANNER_SUCCESS);
+  _assert_token(0, JSON_TOKEN_NUMBER, "  42  ", "42");
+  cr_assert_eq(_scan("\"foo\""), JSON_SCANNER_SUCCESS);
+  _assert_token(0, JSON_TOKEN_STRING, "\"foo\"", "foo");
+  cr_assert_eq(_scan("null"), JSON_SCANNER_SUCCESS);
+  _assert_token(0, JSON_TOKEN_NULL, "null", "null");
+
+  json_scanner_deinit(&scanner);
+}
+
+Test(json_scanner, test_limits)
+{
+  _init_scanner(JSON_SCANNER_SIMD_NONE);
+
+  json_scanner_set_max_tokens(&scanner, 8);
+  cr_assert_eq(_scan("[1, 2, 3, 4, 5, 6, 7]"), JSON_SCANNER_SUCCESS);
+  cr_assert_eq(_scan("[1, 2, 3, 4, 5, 6, 7, 8]"), JSON_SCANNER_ERROR_TOO_LARGE);
+
+  json_scanner_set_max_depth(&scanner, 2);
+  cr_assert_eq(_scan("[[1]]"), JSON_SCANNER_SUCCESS);
+  cr_assert_eq(_scan("[[[1]]]"), JSON_SCANNER_ERROR_TOO_DEEP);
+
+  json_scanner_deinit(&scanner);
+}
+
+static void
+_assert_unescaped(const gchar *escaped, const gchar *expected)
+{
+  GString *result = g_string_new("");
+
+  json_scanner_append_unescaped_string(result, escaped, strlen(escaped));
+  cr_assert_str_eq(result->str, expected);
+  g_string_free(result, TRUE);
+}
+
+Test(json_scanner, test_unescape)
+{
+  _assert_unescaped("foo", "foo");
+  _assert_unescaped("foo\\nbar\\t\\\"\\\\\\/", "foo\nbar\t\"\\/");
+  _assert_unescaped("\\u00e9", "\xc3\xa9");
+  _assert_unescaped("\\ud83d\\ude00", "\xf0\x9f\x98\x80");
+  _assert_unescaped("\\ud83dx", "\xef\xbf\xbdx");
+  _assert_unescaped("\\ude00", "\xef\xbf\xbd");
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "stats/stats-counter.h"
+#include "mainloop-worker.h"
+
+G_STATIC_ASSERT((STATS_COUNTER_SHARDS & (STATS_COUNTER_SHARDS - 1)) == 0);
+G_STATIC_ASSERT(sizeof(StatsCounterShard) == STATS_COUNTER_SHARD_SIZE);
+
+/* threads without a worker ID (e.g. the main thread) share the first shard */
+gint
+stats_counter_get_shard_index(void)
+{
+  return (main_loop_worker_get_thread_index() + 1) & (STATS_COUNTER_SHARDS - 1);
+}
+
+/*
+ * The unsharded value is still part of the sum, so this is safe even if
+ * the counter is being updated concurrently.  Aliases copy the shards
+ * pointer when they are registered, so sharding has to be enabled before
+ * that.
+ */
+void
+stats_counter_enable_sharding(StatsCounterItem *counter)
+{
+  if (!counter || counter->external || counter->shards)
+    return;
+
+  StatsCounterShard *shards = g_new0(StatsCounterShard, STATS_COUNTER_SHARDS);
+  g_atomic_pointer_set(&counter->shards, shards);
+}
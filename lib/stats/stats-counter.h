@@ -28,6 +28,21 @@
 
 #define STATS_COUNTER_MAX_VALUE G_MAXSIZE
 
+/* must be a power of 2 */
+#define STATS_COUNTER_SHARDS 16
+#define STATS_COUNTER_SHARD_SIZE 64
+
+/*
+ * Counters updated by many threads can be sharded: updates go to a slot
+ * selected by the current worker thread, each on its own cache line, while
+ * readers sum the slots up.
+ */
+typedef union _StatsCounterShard
+{
+  atomic_gssize value;
+  gchar _pad[STATS_COUNTER_SHARD_SIZE];
+} StatsCounterShard;
+
 typedef struct _StatsCounterItem
 {
   union
@@ -35,25 +50,39 @@ typedef struct _StatsCounterItem
     atomic_gssize value;
     atomic_gssize *value_ref;
   };
+  /* owned unless the counter is external, aliases share the shards of the aliased counter */
+  StatsCounterShard *shards;
   gchar *name;
   gint type;
   gboolean external;
 } StatsCounterItem;
 
 
+gint stats_counter_get_shard_index(void);
+void stats_counter_enable_sharding(StatsCounterItem *counter);
+
 static gboolean
 stats_counter_read_only(StatsCounterItem *counter)
 {
   return counter->external;
 }
 
+static inline atomic_gssize *
+_stats_counter_get_value_to_update(StatsCounterItem *counter)
+{
+  if (G_LIKELY(!counter->shards))
+    return &counter->value;
+
+  return &counter->shards[stats_counter_get_shard_index()].value;
+}
+
 static inline void
 stats_counter_add(StatsCounterItem *counter, gssize add)
 {
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_add(&counter->value, add);
+      atomic_gssize_add(_stats_counter_get_value_to_update(counter), add);
     }
 }
 
@@ -63,7 +92,7 @@ stats_counter_sub(StatsCounterItem *counter, gssize sub)
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_sub(&counter->value, sub);
+      atomic_gssize_sub(_stats_counter_get_value_to_update(counter), sub);
     }
 }
 
@@ -73,7 +102,7 @@ stats_counter_inc(StatsCounterItem *counter)
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_inc(&counter->value);
+      atomic_gssize_inc(_stats_counter_get_value_to_update(counter));
     }
 }
 
@@ -83,15 +112,28 @@ stats_counter_dec(StatsCounterItem *counter)
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_dec(&counter->value);
+      atomic_gssize_dec(_stats_counter_get_value_to_update(counter));
     }
 }
 
+/*
+ * On a sharded counter the shards are drained one by one with atomic
+ * exchanges before the new value is stored, so set() is not linearizable
+ * against concurrent add()/inc() calls: an update racing with it is either
+ * overwritten or kept on top of the new value, but never torn.  Sharding is
+ * meant for counters that are only set when they are reset.
+ */
 static inline void
 stats_counter_set(StatsCounterItem *counter, gsize value)
 {
   if (counter && !stats_counter_read_only(counter))
     {
+      if (counter->shards)
+        {
+          for (gint i = 0; i < STATS_COUNTER_SHARDS; i++)
+            atomic_gssize_set_and_get(&counter->shards[i].value, 0);
+        }
+
       atomic_gssize_set(&counter->value, value);
     }
 }
@@ -107,6 +149,12 @@ stats_counter_get(StatsCounterItem *counter)
         result = atomic_gssize_get_unsigned(&counter->value);
       else
         result = atomic_gssize_get_unsigned(counter->value_ref);
+
+      if (counter->shards)
+        {
+          for (gint i = 0; i < STATS_COUNTER_SHARDS; i++)
+            result += atomic_gssize_get_unsigned(&counter->shards[i].value);
+        }
     }
   return result;
 }
@@ -129,6 +177,8 @@ stats_counter_get_name(StatsCounterItem *counter)
 static inline void
 stats_counter_clear(StatsCounterItem *counter)
 {
+  if (!counter->external)
+    g_free(counter->shards);
   g_free(counter->name);
   memset(counter, 0, sizeof(*counter));
 }
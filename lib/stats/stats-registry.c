@@ -233,6 +233,21 @@ stats_register_counter(gint stats_level, const StatsClusterKey *sc_key, gint typ
   return _register_counter(stats_level, sc_key, type, FALSE, counter);
 }
 
+/*
+ * Same as stats_register_counter(), but the counter is sharded, see
+ * StatsCounterShard.  Use it for counters that are updated by multiple
+ * worker threads on the hot path.
+ */
+StatsCluster *
+stats_register_sharded_counter(gint stats_level, const StatsClusterKey *sc_key, gint type,
+                               StatsCounterItem **counter)
+{
+  StatsCluster *sc = _register_counter(stats_level, sc_key, type, FALSE, counter);
+
+  stats_counter_enable_sharding(*counter);
+  return sc;
+}
+
 StatsCluster *
 stats_register_external_counter(gint stats_level, const StatsClusterKey *sc_key, gint type,
                                 atomic_gssize *external_counter)
@@ -243,7 +258,11 @@ stats_register_external_counter(gint stats_level, const StatsClusterKey *sc_key,
 StatsCluster *
 stats_register_alias_counter(gint level, const StatsClusterKey *sc_key, gint type, StatsCounterItem *aliased_counter)
 {
-  return stats_register_external_counter(level, sc_key, type, &aliased_counter->value);
+  StatsCluster *sc = stats_register_external_counter(level, sc_key, type, &aliased_counter->value);
+
+  if (sc && aliased_counter->shards)
+    stats_cluster_get_counter(sc, type)->shards = aliased_counter->shards;
+  return sc;
 }
 
 StatsCluster *
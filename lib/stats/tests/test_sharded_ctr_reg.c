@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "apphook.h"
+#include "stats/stats-cluster.h"
+#include "stats/stats-cluster-logpipe.h"
+#include "stats/stats-counter.h"
+#include "stats/stats-registry.h"
+
+#define NUM_THREADS 8
+#define NUM_INCREMENTS 10000
+
+static StatsCounterItem *
+_register_sharded_counter(const gchar *id)
+{
+  StatsCounterItem *counter = NULL;
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_GLOBAL, id, NULL);
+  stats_register_sharded_counter(0, &sc_key, SC_TYPE_PROCESSED, &counter);
+  stats_unlock();
+
+  return counter;
+}
+
+static void
+_unregister_counter(const gchar *id, StatsCounterItem **counter)
+{
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_GLOBAL, id, NULL);
+  stats_unregister_counter(&sc_key, SC_TYPE_PROCESSED, counter);
+  stats_unlock();
+}
+
+Test(stats_sharded_counter, sharded_counter_behaves_like_a_regular_one)
+{
+  StatsCounterItem *counter = _register_sharded_counter("test_ctr");
+
+  cr_assert_not_null(counter->shards);
+
+  stats_counter_inc(counter);
+  stats_counter_add(counter, 10);
+  stats_counter_dec(counter);
+  stats_counter_sub(counter, 3);
+  cr_expect_eq(stats_counter_get(counter), 7);
+
+  stats_counter_set(counter, 42);
+  cr_expect_eq(stats_counter_get(counter), 42);
+  stats_counter_inc(counter);
+  cr_expect_eq(stats_counter_get(counter), 43);
+
+  _unregister_counter("test_ctr", &counter);
+}
+
+Test(stats_sharded_counter, sharding_keeps_the_value_of_a_counter_already_in_use)
+{
+  StatsCounterItem *counter = NULL;
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_GLOBAL, "test_ctr", NULL);
+  stats_register_counter(0, &sc_key, SC_TYPE_PROCESSED, &counter);
+  stats_unlock();
+
+  stats_counter_add(counter, 5);
+
+  StatsCounterItem *sharded_counter = _register_sharded_counter("test_ctr");
+  cr_assert_eq(counter, sharded_counter);
+  stats_counter_add(sharded_counter, 5);
+  cr_expect_eq(stats_counter_get(counter), 10);
+
+  _unregister_counter("test_ctr", &sharded_counter);
+  _unregister_counter("test_ctr", &counter);
+}
+
+Test(stats_sharded_counter, alias_of_sharded_counter_sums_the_shards)
+{
+  StatsCounterItem *counter = _register_sharded_counter("test_ctr");
+  StatsCounterItem *alias_counter;
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_GLOBAL, "test_ctr.alias", NULL);
+  StatsCluster *sc = stats_register_alias_counter(0, &sc_key, SC_TYPE_PROCESSED, counter);
+  alias_counter = stats_cluster_get_counter(sc, SC_TYPE_PROCESSED);
+  stats_unlock();
+
+  stats_counter_add(counter, 12);
+  cr_expect_eq(stats_counter_get(alias_counter), 12);
+
+  stats_lock();
+  stats_unregister_alias_counter(&sc_key, SC_TYPE_PROCESSED, counter);
+  stats_unlock();
+
+  _unregister_counter("test_ctr", &counter);
+}
+
+static gpointer
+_increment_thread(gpointer user_data)
+{
+  StatsCounterItem *counter = user_data;
+
+  for (gint i = 0; i < NUM_INCREMENTS; i++)
+    stats_counter_inc(counter);
+  return NULL;
+}
+
+Test(stats_sharded_counter, concurrent_increments_are_not_lost)
+{
+  StatsCounterItem *counter = _register_sharded_counter("test_ctr");
+  GThread *threads[NUM_THREADS];
+
+  for (gint i = 0; i < NUM_THREADS; i++)
+    threads[i] = g_thread_new(NULL, _increment_thread, counter);
+  for (gint i = 0; i < NUM_THREADS; i++)
+    g_thread_join(threads[i]);
+
+  cr_expect_eq(stats_counter_get(counter), NUM_THREADS * NUM_INCREMENTS);
+
+  _unregister_counter("test_ctr", &counter);
+}
+
+Test(stats_sharded_counter, set_racing_with_increments_keeps_the_counter_consistent)
+{
+  StatsCounterItem *counter = _register_sharded_counter("test_ctr");
+  GThread *threads[NUM_THREADS];
+
+  for (gint i = 0; i < NUM_THREADS; i++)
+    threads[i] = g_thread_new(NULL, _increment_thread, counter);
+  for (gint i = 0; i < 100; i++)
+    {
+      stats_counter_set(counter, 0);
+      cr_assert_leq(stats_counter_get(counter), NUM_THREADS * NUM_INCREMENTS);
+    }
+  for (gint i = 0; i < NUM_THREADS; i++)
+    g_thread_join(threads[i]);
+
+  cr_expect_leq(stats_counter_get(counter), NUM_THREADS * NUM_INCREMENTS);
+
+  stats_counter_set(counter, 42);
+  cr_expect_eq(stats_counter_get(counter), 42);
+
+  _unregister_counter("test_ctr", &counter);
+}
+
+TestSuite(stats_sharded_counter, .init = app_startup, .fini = app_shutdown);
@@ -0,0 +1,683 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "string-set.h"
+#include "file-monitor.h"
+#include "mainloop.h"
+#include "mainloop-worker.h"
+#include "messages.h"
+
+#include <string.h>
+
+#define STRING_SET_NONE G_MAXUINT32
+
+typedef struct _StringSetEntry
+{
+  guint32 hash;
+  guint32 offset;
+  guint32 len;
+} StringSetEntry;
+
+/* node of the trie while the automaton is being built */
+typedef struct _StringSetTrieNode
+{
+  guint32 first_child;
+  guint32 next_sibling;
+  guint8 ch;
+  gboolean match;
+} StringSetTrieNode;
+
+typedef struct _StringSetState
+{
+  guint32 fail;
+  guint32 first_transition;
+  guint16 num_transitions;
+  gboolean match;
+} StringSetState;
+
+struct _StringSet
+{
+  StringSetMode mode;
+  gboolean compiled;
+  gsize size;
+
+  /* strings as added, in a single string pool */
+  GString *pool;
+  GArray *entries;
+
+  /* STRING_SET_EXACT */
+  struct
+  {
+    StringSetEntry *slots;
+    guint32 mask;
+  } table;
+
+  /* STRING_SET_SUBSTRING
+   *
+   * Transitions of a state are stored in the transition_chars and
+   * transition_targets arrays, sorted by character.  The root state has a
+   * dense transition table, so that the common case of a character not
+   * starting any of the strings is a single lookup.
+   */
+  struct
+  {
+    StringSetState *states;
+    guint8 *transition_chars;
+    guint32 *transition_targets;
+    guint32 root[256];
+  } automaton;
+};
+
+/* FNV-1a */
+static inline guint32
+_hash(const gchar *str, gsize len)
+{
+  guint32 h = 2166136261U;
+
+  for (gsize i = 0; i < len; i++)
+    {
+      h ^= (guint8) str[i];
+      h *= 16777619U;
+    }
+  return h;
+}
+
+void
+string_set_add(StringSet *self, const gchar *str, gssize len)
+{
+  g_assert(!self->compiled);
+
+  if (len < 0)
+    len = strlen(str);
+
+  StringSetEntry entry =
+  {
+    .hash = _hash(str, len),
+    .offset = self->pool->len,
+    .len = len,
+  };
+  g_string_append_len(self->pool, str, len);
+  g_array_append_val(self->entries, entry);
+}
+
+/* exact matching */
+
+static inline gboolean
+_slot_equals(StringSet *self, StringSetEntry *slot, guint32 hash, const gchar *value, gsize len)
+{
+  return slot->hash == hash && slot->len == len && memcmp(self->pool->str + slot->offset, value, len) == 0;
+}
+
+static void
+_compile_table(StringSet *self)
+{
+  guint32 num_slots = 16;
+
+  while (num_slots < self->entries->len * 2)
+    num_slots <<= 1;
+
+  self->table.mask = num_slots - 1;
+  self->table.slots = g_new(StringSetEntry, num_slots);
+  for (guint32 i = 0; i < num_slots; i++)
+    self->table.slots[i].offset = STRING_SET_NONE;
+
+  for (guint i = 0; i < self->entries->len; i++)
+    {
+      StringSetEntry *entry = &g_array_index(self->entries, StringSetEntry, i);
+      const gchar *str = self->pool->str + entry->offset;
+      guint32 slot_ndx = entry->hash & self->table.mask;
+
+      while (self->table.slots[slot_ndx].offset != STRING_SET_NONE)
+        {
+          if (_slot_equals(self, &self->table.slots[slot_ndx], entry->hash, str, entry->len))
+            break;
+          slot_ndx = (slot_ndx + 1) & self->table.mask;
+        }
+
+      if (self->table.slots[slot_ndx].offset == STRING_SET_NONE)
+        {
+          self->table.slots[slot_ndx] = *entry;
+          self->size++;
+        }
+    }
+}
+
+static gboolean
+_match_exact(StringSet *self, const gchar *value, gsize len)
+{
+  guint32 hash = _hash(value, len);
+
+  for (guint32 slot_ndx = hash & self->table.mask;
+       self->table.slots[slot_ndx].offset != STRING_SET_NONE;
+       slot_ndx = (slot_ndx + 1) & self->table.mask)
+    {
+      if (_slot_equals(self, &self->table.slots[slot_ndx], hash, value, len))
+        return TRUE;
+    }
+  return FALSE;
+}
+
+/* substring matching, Aho-Corasick */
+
+static guint32
+_trie_find_child(GArray *nodes, guint32 node, guint8 ch)
+{
+  for (guint32 child = g_array_index(nodes, StringSetTrieNode, node).first_child;
+       child != STRING_SET_NONE;
+       child = g_array_index(nodes, StringSetTrieNode, child).next_sibling)
+    {
+      if (g_array_index(nodes, StringSetTrieNode, child).ch == ch)
+        return child;
+    }
+  return STRING_SET_NONE;
+}
+
+static void
+_trie_insert(StringSet *self, GArray *nodes, const gchar *str, gsize len)
+{
+  guint32 node = 0;
+
+  for (gsize i = 0; i < len; i++)
+    {
+      guint8 ch = (guint8) str[i];
+      guint32 child = _trie_find_child(nodes, node, ch);
+
+      if (child == STRING_SET_NONE)
+        {
+          StringSetTrieNode new_node =
+          {
+            .first_child = STRING_SET_NONE,
+            .next_sibling = g_array_index(nodes, StringSetTrieNode, node).first_child,
+            .ch = ch,
+          };
+          child = nodes->len;
+          g_array_append_val(nodes, new_node);
+          g_array_index(nodes, StringSetTrieNode, node).first_child = child;
+        }
+      node = child;
+    }
+
+  StringSetTrieNode *terminal = &g_array_index(nodes, StringSetTrieNode, node);
+  if (!terminal->match)
+    {
+      terminal->match = TRUE;
+      self->size++;
+    }
+}
+
+static void
+_compute_failure_links(StringSet *self, GArray *nodes)
+{
+  guint32 *queue = g_new(guint32, nodes->len);
+  guint32 head = 0, tail = 0;
+
+  self->automaton.states[0].fail = 0;
+  queue[tail++] = 0;
+  while (head < tail)
+    {
+      guint32 parent = queue[head++];
+
+      for (guint32 child = g_array_index(nodes, StringSetTrieNode, parent).first_child;
+           child != STRING_SET_NONE;
+           child = g_array_index(nodes, StringSetTrieNode, child).next_sibling)
+        {
+          guint8 ch = g_array_index(nodes, StringSetTrieNode, child).ch;
+          guint32 fail = 0;
+
+          queue[tail++] = child;
+          if (parent != 0)
+            {
+              guint32 candidate = self->automaton.states[parent].fail;
+              guint32 target;
+
+              while ((target = _trie_find_child(nodes, candidate, ch)) == STRING_SET_NONE && candidate != 0)
+                candidate = self->automaton.states[candidate].fail;
+
+              if (target != STRING_SET_NONE)
+                fail = target;
+            }
+
+          /* parents are processed before their children, so the state we
+           * fail over to has its match flag finalized already */
+          self->automaton.states[child].fail = fail;
+          self->automaton.states[child].match = g_array_index(nodes, StringSetTrieNode, child).match ||
+                                                self->automaton.states[fail].match;
+        }
+    }
+  g_free(queue);
+}
+
+static void
+_compile_transitions(StringSet *self, GArray *nodes)
+{
+  guint32 num_transitions = nodes->len - 1;
+  guint32 transition_ndx = 0;
+
+  self->automaton.transition_chars = g_new(guint8, MAX(num_transitions, 1));
+  self->automaton.transition_targets = g_new(guint32, MAX(num_transitions, 1));
+
+  for (guint32 node = 0; node < nodes->len; node++)
+    {
+      StringSetState *state = &self->automaton.states[node];
+
+      state->first_transition = transition_ndx;
+      for (guint32 child = g_array_index(nodes, StringSetTrieNode, node).first_child;
+           child != STRING_SET_NONE;
+           child = g_array_index(nodes, StringSetTrieNode, child).next_sibling)
+        {
+          guint8 ch = g_array_index(nodes, StringSetTrieNode, child).ch;
+          guint32 pos = transition_ndx;
+
+          /* insertion sort, most states have a single transition */
+          while (pos > state->first_transition && self->automaton.transition_chars[pos - 1] > ch)
+            {
+              self->automaton.transition_chars[pos] = self->automaton.transition_chars[pos - 1];
+              self->automaton.transition_targets[pos] = self->automaton.transition_targets[pos - 1];
+              pos--;
+            }
+          self->automaton.transition_chars[pos] = ch;
+          self->automaton.transition_targets[pos] = child;
+          transition_ndx++;
+        }
+      state->num_transitions = transition_ndx - state->first_transition;
+    }
+
+  for (gint ch = 0; ch < 256; ch++)
+    {
+      guint32 child = _trie_find_child(nodes, 0, ch);
+      self->automaton.root[ch] = child != STRING_SET_NONE ? child : 0;
+    }
+}
+
+static void
+_compile_automaton(StringSet *self)
+{
+  GArray *nodes = g_array_new(FALSE, FALSE, sizeof(StringSetTrieNode));
+  StringSetTrieNode root =
+  {
+    .first_child = STRING_SET_NONE,
+    .next_sibling = STRING_SET_NONE,
+  };
+
+  g_array_append_val(nodes, root);
+  for (guint i = 0; i < self->entries->len; i++)
+    {
+      StringSetEntry *entry = &g_array_index(self->entries, StringSetEntry, i);
+      _trie_insert(self, nodes, self->pool->str + entry->offset, entry->len);
+    }
+
+  self->automaton.states = g_new0(StringSetState, nodes->len);
+  self->automaton.states[0].match = g_array_index(nodes, StringSetTrieNode, 0).match;
+  _compute_failure_links(self, nodes);
+  _compile_transitions(self, nodes);
+
+  g_array_free(nodes, TRUE);
+
+  /* the automaton does not refer to the strings themselves */
+  g_string_free(self->pool, TRUE);
+  self->pool = NULL;
+}
+
+static inline guint32
+_automaton_step(StringSet *self, guint32 state_ndx, guint8 ch)
+{
+  while (state_ndx != 0)
+    {
+      StringSetState *state = &self->automaton.states[state_ndx];
+      guint32 lo = state->first_transition;
+      guint32 end = lo + state->num_transitions;
+      guint32 hi = end;
+
+      while (lo < hi)
+        {
+          guint32 mid = (lo + hi) / 2;
+
+          if (self->automaton.transition_chars[mid] < ch)
+            lo = mid + 1;
+          else
+            hi = mid;
+        }
+      if (lo < end && self->automaton.transition_chars[lo] == ch)
+        return self->automaton.transition_targets[lo];
+
+      state_ndx = state->fail;
+    }
+  return self->automaton.root[ch];
+}
+
+static gboolean
+_match_substring(StringSet *self, const gchar *value, gsize len)
+{
+  guint32 state_ndx = 0;
+
+  if (self->automaton.states[0].match)
+    return TRUE;
+
+  for (gsize i = 0; i < len; i++)
+    {
+      state_ndx = _automaton_step(self, state_ndx, (guint8) value[i]);
+      if (self->automaton.states[state_ndx].match)
+        return TRUE;
+    }
+  return FALSE;
+}
+
+void
+string_set_compile(StringSet *self)
+{
+  g_assert(!self->compiled);
+
+  if (self->mode == STRING_SET_EXACT)
+    _compile_table(self);
+  else
+    _compile_automaton(self);
+
+  g_array_free(self->entries, TRUE);
+  self->entries = NULL;
+  self->compiled = TRUE;
+}
+
+gboolean
+string_set_match(StringSet *self, const gchar *value, gsize len)
+{
+  g_assert(self->compiled);
+
+  if (self->mode == STRING_SET_EXACT)
+    return _match_exact(self, value, len);
+  return _match_substring(self, value, len);
+}
+
+gsize
+string_set_get_size(StringSet *self)
+{
+  return self->size;
+}
+
+StringSet *
+string_set_new(StringSetMode mode)
+{
+  StringSet *self = g_new0(StringSet, 1);
+
+  self->mode = mode;
+  self->pool = g_string_sized_new(1024);
+  self->entries = g_array_new(FALSE, FALSE, sizeof(StringSetEntry));
+  return self;
+}
+
+void
+string_set_free(StringSet *self)
+{
+  if (!self)
+    return;
+
+  if (self->pool)
+    g_string_free(self->pool, TRUE);
+  if (self->entries)
+    g_array_free(self->entries, TRUE);
+  g_free(self->table.slots);
+  g_free(self->automaton.states);
+  g_free(self->automaton.transition_chars);
+  g_free(self->automaton.transition_targets);
+  g_free(self);
+}
+
+/* one string per line, empty lines are ignored */
+StringSet *
+string_set_load_file(const gchar *filename, StringSetMode mode, GError **error)
+{
+  gchar *contents;
+  gsize length;
+
+  if (!g_file_get_contents(filename, &contents, &length, error))
+    return NULL;
+
+  StringSet *self = string_set_new(mode);
+  const gchar *line = contents;
+  const gchar *end = contents + length;
+
+  while (line < end)
+    {
+      const gchar *eol = memchr(line, '\n', end - line);
+      if (!eol)
+        eol = end;
+
+      gsize line_len = eol - line;
+      if (line_len > 0 && line[line_len - 1] == '\r')
+        line_len--;
+      if (line_len > 0)
+        string_set_add(self, line, line_len);
+      line = eol + 1;
+    }
+  g_free(contents);
+
+  string_set_compile(self);
+  return self;
+}
+
+/* StringSetFile */
+
+#define STRING_SET_FILE_READER_SHARDS 16
+#define STRING_SET_FILE_READER_SHARD_SIZE 64
+
+/* Number of lookups using the set, per generation.  Lookups are counted in
+ * the slot of the current worker thread, each on its own cache line, so
+ * that they don't contend with each other. */
+typedef union _StringSetFileReaders
+{
+  gint count[2];
+  gchar _pad[STRING_SET_FILE_READER_SHARD_SIZE];
+} StringSetFileReaders;
+
+struct _StringSetFile
+{
+  gchar *filename;
+  StringSetMode mode;
+  /* published with an atomic store, lookups do not lock */
+  StringSet *set;
+  gint generation;
+  StringSetFileReaders readers[STRING_SET_FILE_READER_SHARDS];
+  /* the previous set, freed once the lookups that may use it are finished */
+  StringSet *retired_set;
+  gint retired_generation;
+  FileMonitor *file_monitor;
+  gboolean monitoring;
+};
+
+static StringSet *
+_set_read_begin(StringSetFile *self, gint **readers)
+{
+  gint shard = (main_loop_worker_get_thread_index() + 1) & (STRING_SET_FILE_READER_SHARDS - 1);
+
+  while (TRUE)
+    {
+      gint generation = g_atomic_int_get(&self->generation);
+
+      *readers = &self->readers[shard].count[generation];
+      g_atomic_int_inc(*readers);
+
+      /* if a reload flipped the generation before we were counted, it may
+       * have found our generation drained already, and the next reload
+       * would not wait for us */
+      if (g_atomic_int_get(&self->generation) == generation)
+        break;
+
+      g_atomic_int_add(*readers, -1);
+    }
+
+  return g_atomic_pointer_get(&self->set);
+}
+
+static void
+_set_read_end(StringSetFile *self, gint *readers)
+{
+  g_atomic_int_add(readers, -1);
+}
+
+static gboolean
+_set_generation_drained(StringSetFile *self, gint generation)
+{
+  for (gint i = 0; i < STRING_SET_FILE_READER_SHARDS; i++)
+    {
+      if (g_atomic_int_get(&self->readers[i].count[generation]) != 0)
+        return FALSE;
+    }
+  return TRUE;
+}
+
+static void
+_free_retired_set(StringSetFile *self, gboolean wait)
+{
+  if (!self->retired_set)
+    return;
+
+  while (!_set_generation_drained(self, self->retired_generation))
+    {
+      if (!wait)
+        return;
+      g_thread_yield();
+    }
+
+  string_set_free(self->retired_set);
+  self->retired_set = NULL;
+}
+
+static void
+_publish_set(StringSetFile *self, StringSet *new_set)
+{
+  _free_retired_set(self, TRUE);
+
+  self->retired_set = self->set;
+  self->retired_generation = self->generation;
+
+  g_atomic_pointer_set(&self->set, new_set);
+  g_atomic_int_set(&self->generation, !self->retired_generation);
+
+  _free_retired_set(self, FALSE);
+}
+
+gboolean
+string_set_file_match(StringSetFile *self, const gchar *value, gsize len)
+{
+  gint *readers;
+  StringSet *set = _set_read_begin(self, &readers);
+
+  gboolean result = string_set_match(set, value, len);
+
+  _set_read_end(self, readers);
+  return result;
+}
+
+gboolean
+string_set_file_reload(StringSetFile *self, GError **error)
+{
+  main_loop_assert_main_thread();
+
+  StringSet *set = string_set_load_file(self->filename, self->mode, error);
+
+  if (!set)
+    return FALSE;
+
+  _publish_set(self, set);
+  return TRUE;
+}
+
+static gboolean
+_file_monitor_callback(const FileMonitorEvent *event, gpointer user_data)
+{
+  StringSetFile *self = (StringSetFile *) user_data;
+
+  if (event->event == DELETED)
+    {
+      msg_error("String set file was deleted, keeping the current list of strings",
+                evt_tag_str("file_name", self->filename));
+      return TRUE;
+    }
+
+  main_loop_assert_main_thread();
+
+  GError *error = NULL;
+  if (!string_set_file_reload(self, &error))
+    {
+      msg_error("Error reloading string set file, keeping the current list of strings",
+                evt_tag_str("file_name", self->filename),
+                evt_tag_str("error", error->message));
+      g_clear_error(&error);
+      return TRUE;
+    }
+
+  msg_info("String set file reloaded",
+           evt_tag_str("file_name", self->filename),
+           evt_tag_long("strings", string_set_get_size(self->set)));
+  return TRUE;
+}
+
+StringSetFile *
+string_set_file_new(const gchar *filename, StringSetMode mode, GError **error)
+{
+  StringSet *set = string_set_load_file(filename, mode, error);
+
+  if (!set)
+    return NULL;
+
+  StringSetFile *self = g_new0(StringSetFile, 1);
+  self->filename = g_strdup(filename);
+  self->mode = mode;
+  self->set = set;
+
+  self->file_monitor = file_monitor_new(self->filename);
+  file_monitor_add_watch(self->file_monitor, _file_monitor_callback, self);
+  return self;
+}
+
+void
+string_set_file_start_monitoring(StringSetFile *self)
+{
+  if (self->monitoring)
+    return;
+
+  file_monitor_start(self->file_monitor);
+  self->monitoring = TRUE;
+}
+
+void
+string_set_file_stop_monitoring(StringSetFile *self)
+{
+  if (!self->monitoring)
+    return;
+
+  file_monitor_stop(self->file_monitor);
+  self->monitoring = FALSE;
+}
+
+void
+string_set_file_free(StringSetFile *self)
+{
+  if (!self)
+    return;
+
+  string_set_file_stop_monitoring(self);
+  file_monitor_free(self->file_monitor);
+  _free_retired_set(self, TRUE);
+  string_set_free(self->set);
+  g_free(self->filename);
+  g_free(self);
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef STRING_SET_H_INCLUDED
+#define STRING_SET_H_INCLUDED 1
+
+#include "syslog-ng.h"
+
+/*
+ * StringSet is an immutable set of strings, compiled for fast lookups.
+ *
+ * Strings are added with string_set_add(), then string_set_compile()
+ * builds the lookup structure, after which the set can be used by any
+ * number of threads concurrently.  Depending on the mode, the set is
+ * compiled into:
+ *
+ *   - STRING_SET_EXACT: an open addressing hash table, string_set_match()
+ *     returns TRUE if the value is equal to one of the strings.
+ *
+ *   - STRING_SET_SUBSTRING: an Aho-Corasick automaton,
+ *     string_set_match() returns TRUE if the value contains any of the
+ *     strings.
+ *
+ * The cost of a lookup depends on the length of the value, not on the
+ * number of strings in the set.
+ */
+typedef enum
+{
+  STRING_SET_EXACT,
+  STRING_SET_SUBSTRING,
+} StringSetMode;
+
+typedef struct _StringSet StringSet;
+
+StringSet *string_set_new(StringSetMode mode);
+void string_set_add(StringSet *self, const gchar *str, gssize len);
+void string_set_compile(StringSet *self);
+gboolean string_set_match(StringSet *self, const gchar *value, gsize len);
+gsize string_set_get_size(StringSet *self);
+void string_set_free(StringSet *self);
+
+StringSet *string_set_load_file(const gchar *filename, StringSetMode mode, GError **error);
+
+/*
+ * StringSetFile is a StringSet loaded from a file with one string per
+ * line.  Between string_set_file_start_monitoring() and
+ * string_set_file_stop_monitoring() the file is monitored and reloaded when
+ * it changes, without the need for a configuration reload.  Reloading
+ * happens in the main thread, while string_set_file_match() can be called
+ * from any thread without locking: the previous set is freed once the
+ * lookups that may still use it are finished.
+ */
+typedef struct _StringSetFile StringSetFile;
+
+StringSetFile *string_set_file_new(const gchar *filename, StringSetMode mode, GError **error);
+gboolean string_set_file_match(StringSetFile *self, const gchar *value, gsize len);
+gboolean string_set_file_reload(StringSetFile *self, GError **error);
+void string_set_file_start_monitoring(StringSetFile *self);
+void string_set_file_stop_monitoring(StringSetFile *self);
+void string_set_file_free(StringSetFile *self);
+
+#endif
@@ -32,6 +32,7 @@
 
 typedef struct _LogTemplateOptions LogTemplateOptions;
 typedef struct _LogTemplate LogTemplate;
+typedef struct _LogTemplateProgram LogTemplateProgram;
 
 /* template expansion options that can be influenced by the user and
  * is static throughout the runtime for a given configuration. There
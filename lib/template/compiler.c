@@ -443,6 +443,81 @@ error:
   return result;
 }
 
+/* literal text that can be prepended to the next instruction */
+static gboolean
+_is_foldable_literal(LogTemplateElem *e, GList *next)
+{
+  return next && log_template_elem_is_literal_string(e) && e->text_len > 0;
+}
+
+static guint8
+_elem_to_opcode(LogTemplateElem *e)
+{
+  switch (e->type)
+    {
+    case LTE_MACRO:
+      return e->macro == M_NONE ? LTI_TEXT : LTI_MACRO;
+    case LTE_VALUE:
+      return LTI_VALUE;
+    case LTE_FUNC:
+      return LTI_FUNC;
+    default:
+      g_assert_not_reached();
+    }
+}
+
+/*
+ * Flattens the list of elements into a single allocation: the instruction
+ * array is followed by a pool holding the (folded) literal prefixes.  The
+ * instructions refer to the elements, so the program has to be freed
+ * before the element list.
+ */
+LogTemplateProgram *
+log_template_compiler_generate_program(GList *compiled_template)
+{
+  gint num_instrs = 0;
+  gsize text_size = 0;
+
+  for (GList *l = compiled_template; l; l = l->next)
+    {
+      LogTemplateElem *e = (LogTemplateElem *) l->data;
+
+      text_size += e->text_len;
+      if (!_is_foldable_literal(e, l->next))
+        num_instrs++;
+    }
+
+  LogTemplateProgram *program = g_malloc0(sizeof(LogTemplateProgram) +
+                                          num_instrs * sizeof(LogTemplateInstr) + text_size);
+  gchar *text_pos = (gchar *) &program->instrs[num_instrs];
+  const gchar *prefix = text_pos;
+
+  for (GList *l = compiled_template; l; l = l->next)
+    {
+      LogTemplateElem *e = (LogTemplateElem *) l->data;
+
+      memcpy(text_pos, e->text, e->text_len);
+      text_pos += e->text_len;
+      if (_is_foldable_literal(e, l->next))
+        continue;
+
+      LogTemplateInstr *instr = &program->instrs[program->num_instrs++];
+      instr->opcode = _elem_to_opcode(e);
+      instr->msg_ref = e->msg_ref;
+      if (instr->opcode == LTI_VALUE)
+        instr->value_handle = e->value_handle;
+      else if (instr->opcode == LTI_MACRO)
+        instr->macro = e->macro;
+      instr->text = prefix;
+      instr->text_len = text_pos - prefix;
+      instr->elem = e;
+
+      prefix = text_pos;
+    }
+  g_assert(program->num_instrs == num_instrs);
+  return program;
+}
+
 void
 log_template_compiler_init(LogTemplateCompiler *self, LogTemplate *template)
 {
@@ -40,5 +40,7 @@ gboolean log_template_compiler_compile(LogTemplateCompiler *self, GList **compil
 void log_template_compiler_init(LogTemplateCompiler *self, LogTemplate *template);
 void log_template_compiler_clear(LogTemplateCompiler *self);
 
+LogTemplateProgram *log_template_compiler_generate_program(GList *compiled_template);
+
 
 #endif
@@ -55,14 +55,9 @@ _should_render(const gchar *value, LogMessageValueType value_type, LogMessageVal
 }
 
 static void
-log_template_append_elem_value(LogTemplate *self, LogTemplateElem *e, LogTemplateEvalOptions *options,
-                               LogMessage *msg, LogMessageValueType *type, GString *result)
+_append_value(LogTemplate *self, LogTemplateElem *e, const gchar *value, gssize value_len,
+              LogMessageValueType value_type, LogMessageValueType *type, GString *result)
 {
-  const gchar *value = NULL;
-  gssize value_len = -1;
-  LogMessageValueType value_type = LM_VT_NONE;
-
-  value = log_msg_get_value_with_type(msg, e->value_handle, &value_len, &value_type);
   if (value && _should_render(value, value_type, self->type_hint))
     {
       g_string_append_len(result, value, value_len);
@@ -83,6 +78,17 @@ log_template_append_elem_value(LogTemplate *self, LogTemplateElem *e, LogTemplat
   *type = _propagate_type(*type, value_type);
 }
 
+static inline void
+log_template_append_instr_value(LogTemplate *self, LogTemplateInstr *instr, LogMessage *msg,
+                                LogMessageValueType *type, GString *result)
+{
+  gssize value_len = -1;
+  LogMessageValueType value_type = LM_VT_NONE;
+  const gchar *value = log_msg_get_value_with_type(msg, instr->value_handle, &value_len, &value_type);
+
+  _append_value(self, instr->elem, value, value_len, value_type, type, result);
+}
+
 static void
 log_template_append_elem_macro(LogTemplate *self, LogTemplateElem *e, LogTemplateEvalOptions *options,
                                LogMessage *msg, LogMessageValueType *type, GString *result)
@@ -130,9 +136,7 @@ log_template_append_format_value_and_type_with_context(LogTemplate *self, LogMes
                                                        LogTemplateEvalOptions *options,
                                                        GString *result, LogMessageValueType *type)
 {
-  LogTemplateElem *e;
   LogMessageValueType t = LM_VT_NONE;
-  gboolean first_elem = TRUE;
   GString *target_buffer = result;
 
   if (!options->opts)
@@ -149,25 +153,32 @@ log_template_append_format_value_and_type_with_context(LogTemplate *self, LogMes
   if (escape)
     target_buffer = scratch_buffers_alloc();
 
-  for (GList *p = self->compiled_template; p; p = g_list_next(p), first_elem = FALSE)
+  for (gint i = 0; i < self->program->num_instrs; i++)
     {
+      LogTemplateInstr *instr = &self->program->instrs[i];
       gint msg_ndx;
 
-      if (!first_elem)
+      if (i > 0)
         {
-          /* this is the 2nd elem in the compiled template, we are
+          /* this is the 2nd instruction in the program, we are
            * concatenating multiple elements, convert the value to string */
 
           t = LM_VT_STRING;
         }
 
-      e = (LogTemplateElem *) p->data;
-      if (e->text)
+      if (instr->text_len)
         {
-          g_string_append_len(result, e->text, e->text_len);
           /* concatenating literal text */
-          if (e->text_len)
+          g_string_append_len(result, instr->text, instr->text_len);
+          t = LM_VT_STRING;
+        }
+
+      if (instr->opcode == LTI_TEXT)
+        {
+          /* escaping the empty expansion of a literal yields a string too */
+          if (escape)
             t = LM_VT_STRING;
+          continue;
         }
 
       /* NOTE: msg_ref is 1 larger than the index specified by the user in
@@ -176,31 +187,31 @@ log_template_append_format_value_and_type_with_context(LogTemplate *self, LogMes
        *
        * msg_ref == 0 means that the user didn't specify msg_ref
        * msg_ref >= 1 means that the user supplied the given msg_ref, 1 is equal to @0 */
-      if (e->msg_ref > num_messages)
+      if (instr->msg_ref > num_messages)
         {
           /* msg_ref out of range, we expand to empty string without evaluating the element */
           t = LM_VT_STRING;
           continue;
         }
-      msg_ndx = num_messages - e->msg_ref;
+      msg_ndx = num_messages - instr->msg_ref;
 
       /* value and macro can't understand a context, assume that no msg_ref means @0 */
-      if (e->msg_ref == 0)
+      if (instr->msg_ref == 0)
         msg_ndx--;
 
       if (escape)
         g_string_truncate(target_buffer, 0);
 
-      switch (e->type)
+      switch (instr->opcode)
         {
-        case LTE_VALUE:
-          log_template_append_elem_value(self, e, options, messages[msg_ndx], &t, target_buffer);
+        case LTI_VALUE:
+          log_template_append_instr_value(self, instr, messages[msg_ndx], &t, target_buffer);
           break;
-        case LTE_MACRO:
-          log_template_append_elem_macro(self, e, options, messages[msg_ndx], &t, target_buffer);
+        case LTI_MACRO:
+          log_template_append_elem_macro(self, instr->elem, options, messages[msg_ndx], &t, target_buffer);
           break;
-        case LTE_FUNC:
-          log_template_append_elem_func(self, e, options, messages, num_messages, msg_ndx, &t, target_buffer);
+        case LTI_FUNC:
+          log_template_append_elem_func(self, instr->elem, options, messages, num_messages, msg_ndx, &t, target_buffer);
           break;
         default:
           g_assert_not_reached();
@@ -218,7 +229,7 @@ log_template_append_format_value_and_type_with_context(LogTemplate *self, LogMes
     }
   if (type)
     {
-      if (first_elem && t == LM_VT_NONE)
+      if (self->program->num_instrs == 0 && t == LM_VT_NONE)
         {
           /* empty template string, use LM_VT_STRING before applying the type-cast */
           t = LM_VT_STRING;
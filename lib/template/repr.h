@@ -69,5 +69,41 @@ log_template_elem_is_literal_string(const LogTemplateElem *self)
 
 void log_template_elem_free_list(GList *el);
 
+/*
+ * The flat representation of a compiled template that is used for
+ * evaluation.  Each instruction appends its literal prefix and then
+ * performs its operation.  Literal-only elements are folded into the
+ * prefix of the next instruction, name-value pair lookups carry their
+ * handle inline, the original element is only consulted for default
+ * values and function calls.
+ */
+enum
+{
+  LTI_TEXT,
+  LTI_VALUE,
+  LTI_MACRO,
+  LTI_FUNC
+};
+
+typedef struct _LogTemplateInstr
+{
+  guint8 opcode;
+  guint16 msg_ref;
+  union
+  {
+    guint macro;
+    NVHandle value_handle;
+  };
+  gsize text_len;
+  const gchar *text;
+  LogTemplateElem *elem;
+} LogTemplateInstr;
+
+struct _LogTemplateProgram
+{
+  gint num_instrs;
+  LogTemplateInstr instrs[];
+};
+
 
 #endif
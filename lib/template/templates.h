@@ -50,6 +50,7 @@ struct _LogTemplate
   gchar *name;
   gchar *template_str;
   GList *compiled_template;
+  LogTemplateProgram *program;
   GlobalConfig *cfg;
   guint top_level:1, escape:1, def_inline:1, trivial:1, literal:1;
 
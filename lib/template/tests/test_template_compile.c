@@ -376,6 +376,58 @@ Test(template_compile, test_unknown_function)
                            type = LTE_MACRO, msg_ref = 0);
 }
 
+static void
+assert_instr(gint ndx, guint8 opcode, const gchar *text)
+{
+  cr_assert_lt(ndx, template->program->num_instrs);
+
+  LogTemplateInstr *instr = &template->program->instrs[ndx];
+  cr_assert_eq(instr->opcode, opcode, "Bad opcode in instruction #%d", ndx);
+  cr_assert_eq(instr->text_len, strlen(text), "Bad literal prefix length in instruction #%d", ndx);
+  cr_assert(memcmp(instr->text, text, instr->text_len) == 0, "Bad literal prefix in instruction #%d", ndx);
+}
+
+Test(template_compile, test_program_has_one_instruction_per_element_with_literal_prefixes)
+{
+  assert_template_compile("${foo} bar $(hello) $DATE trailing");
+  cr_assert_eq(template->program->num_instrs, 4);
+  assert_instr(0, LTI_VALUE, "");
+  cr_assert_eq(template->program->instrs[0].value_handle, log_msg_get_value_handle("foo"));
+  assert_instr(1, LTI_FUNC, " bar ");
+  assert_instr(2, LTI_MACRO, " ");
+  cr_assert_eq(template->program->instrs[2].macro, M_DATE);
+  assert_instr(3, LTI_TEXT, " trailing");
+
+  assert_template_compile("");
+  cr_assert_eq(template->program->num_instrs, 0);
+
+  log_template_compile_literal_string(template, "literal");
+  cr_assert_eq(template->program->num_instrs, 1);
+  assert_instr(0, LTI_TEXT, "literal");
+}
+
+Test(template_compile, test_program_folds_literal_elements_into_the_next_instruction)
+{
+  GList *elems = NULL;
+
+  elems = g_list_append(elems, log_template_elem_new_macro("foo", M_NONE, NULL, 0));
+  elems = g_list_append(elems, log_template_elem_new_macro("bar", M_NONE, NULL, 0));
+  elems = g_list_append(elems, log_template_elem_new_value(" ", "baz", NULL, 0));
+  elems = g_list_append(elems, log_template_elem_new_macro("qux", M_NONE, NULL, 0));
+
+  LogTemplateProgram *program = log_template_compiler_generate_program(elems);
+  cr_assert_eq(program->num_instrs, 2);
+  cr_assert_eq(program->instrs[0].opcode, LTI_VALUE);
+  cr_assert_eq(program->instrs[0].text_len, 7);
+  cr_assert(memcmp(program->instrs[0].text, "foobar ", 7) == 0);
+  cr_assert_eq(program->instrs[1].opcode, LTI_TEXT);
+  cr_assert_eq(program->instrs[1].text_len, 3);
+  cr_assert(memcmp(program->instrs[1].text, "qux", 3) == 0);
+
+  g_free(program);
+  log_template_elem_free_list(elems);
+}
+
 static void
 setup(void)
 {
@@ -54,6 +54,9 @@ Test(template_speed, test_template_speed)
   perftest_template("$DATE $FACILITY.$PRIORITY $HOST $MSGHDR$MSG $SEQNO\n");
   perftest_template("${APP.VALUE} ${APP.VALUE2}\n");
   perftest_template("$DATE ${HOST:--} ${PROGRAM:--} ${PID:--} ${MSGID:--} ${SDATA:--} $MSG\n");
+  perftest_template("literal string without any macros\n");
+  perftest_template("${HOST}\n");
+  perftest_template("host=${HOST} program=${PROGRAM} pid=${PID} app=${APP.VALUE} msg=${MSG}\n");
 
   app_shutdown();
 }
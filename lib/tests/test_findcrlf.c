@@ -24,6 +24,7 @@
 #include <criterion/parameterized.h>
 
 #include "find-crlf.h"
+#include "libtest/stopwatch.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -165,3 +166,109 @@ ParameterizedTest(struct findcrlf_params *params, findcrlf, test)
                 "EOM is at wrong location. msg=%s, eom_ofs=%d, eom=%s\n",
                 params->msg, (gint) params->eom_ofs, eom);
 }
+
+static const FindCrlfSIMDLevel simd_levels[] =
+{
+  FIND_CRLF_SIMD_NONE,
+  FIND_CRLF_SIMD_SSE2,
+  FIND_CRLF_SIMD_AVX2,
+  FIND_CRLF_SIMD_AVX512BW,
+  FIND_CRLF_SIMD_NEON,
+};
+
+static void
+_fill_test_buffer(gchar *buffer, gsize len, gint line_len)
+{
+  for (gsize i = 0; i < len; i++)
+    buffer[i] = 'a' + i % 26;
+
+  for (gsize i = line_len - 1; i < len; i += line_len)
+    buffer[i] = "\n\r\0"[(i / line_len) % 3];
+}
+
+static void
+_assert_all_terminators_found(const gchar *buffer, gsize len, gsize max_offsets)
+{
+  guint32 offsets[1024];
+  gsize found = find_all_cr_or_lf_or_nul(buffer, len, offsets, max_offsets);
+  gsize expected = 0;
+
+  for (gsize i = 0; i < len && expected < max_offsets; i++)
+    {
+      if (buffer[i] != '\r' && buffer[i] != '\n' && buffer[i] != '\0')
+        continue;
+
+      cr_assert(expected < found, "terminator not found, ofs=%" G_GSIZE_FORMAT, i);
+      cr_assert_eq(offsets[expected], i, "terminator at wrong location, expected=%" G_GSIZE_FORMAT ", found=%u",
+                   i, offsets[expected]);
+      expected++;
+    }
+  cr_assert_eq(found, expected);
+
+  const gchar *first = find_cr_or_lf_or_nul(buffer, len);
+  if (found == 0)
+    cr_assert_null(first);
+  else
+    cr_assert_eq(first - buffer, offsets[0]);
+}
+
+Test(findcrlf, test_all_simd_levels_find_every_terminator)
+{
+  gchar buffer[1024 + 64];
+
+  for (gint level = 0; level < G_N_ELEMENTS(simd_levels); level++)
+    {
+      if (!find_crlf_set_simd_level(simd_levels[level]))
+        continue;
+
+      for (gint line_len = 1; line_len < 150; line_len += 7)
+        {
+          /* unaligned start and lengths that are not multiples of the vector width */
+          for (gint start = 0; start < 64; start += 13)
+            {
+              _fill_test_buffer(buffer + start, 1024 - start, line_len);
+              _assert_all_terminators_found(buffer + start, 1024 - start - line_len / 2, 1024);
+              _assert_all_terminators_found(buffer + start, 1024 - start, 3);
+            }
+        }
+    }
+}
+
+#define PERF_BUFFER_SIZE 65536
+#define PERF_ITERATIONS 2000
+
+Test(findcrlf, test_performance)
+{
+  gchar *buffer = g_malloc(PERF_BUFFER_SIZE);
+  guint32 offsets[64];
+
+  _fill_test_buffer(buffer, PERF_BUFFER_SIZE, 120);
+  for (gint level = 0; level < G_N_ELEMENTS(simd_levels); level++)
+    {
+      if (!find_crlf_set_simd_level(simd_levels[level]))
+        continue;
+
+      start_stopwatch();
+      for (gint i = 0; i < PERF_ITERATIONS; i++)
+        {
+          const gchar *p = buffer;
+          const gchar *end = buffer + PERF_BUFFER_SIZE;
+
+          while (p < end && (p = find_cr_or_lf_or_nul(p, end - p)))
+            p++;
+        }
+      stop_stopwatch_and_display_result(PERF_ITERATIONS, "find_cr_or_lf_or_nul() one by one, simd_level=%d", level);
+
+      start_stopwatch();
+      for (gint i = 0; i < PERF_ITERATIONS; i++)
+        {
+          gsize pos = 0;
+          gsize found;
+
+          while ((found = find_all_cr_or_lf_or_nul(buffer + pos, PERF_BUFFER_SIZE - pos, offsets, G_N_ELEMENTS(offsets))))
+            pos += offsets[found - 1] + 1;
+        }
+      stop_stopwatch_and_display_result(PERF_ITERATIONS, "find_all_cr_or_lf_or_nul() in batches, simd_level=%d", level);
+    }
+  g_free(buffer);
+}
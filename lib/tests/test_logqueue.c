@@ -179,7 +179,7 @@ Test(logqueue, test_zero_diskbuf_and_normal_acks)
   stats_cluster_key_builder_free(driver_sck_builder);
   stats_cluster_key_builder_free(queue_sck_builder);
 
-  cr_assert_eq(atomic_gssize_racy_get(&q->metrics.shared.queued_messages->value), 0);
+  cr_assert_eq(stats_counter_get(q->metrics.shared.queued_messages), 0);
 
   fed_messages = 0;
   acked_messages = 0;
@@ -384,6 +384,157 @@ Test(logqueue, log_queue_fifo_should_drop_only_non_flow_controlled_messages_thre
   log_queue_unref(q);
 }
 
+#define SLOW_PATH_PRODUCERS 4
+#define SLOW_PATH_MESSAGES_PER_PRODUCER 10000
+
+typedef struct _SlowPathProducer
+{
+  LogQueue *queue;
+  gint id;
+} SlowPathProducer;
+
+static gpointer
+_slow_path_feed_thread(gpointer args)
+{
+  SlowPathProducer *producer = args;
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  path_options.flow_control_requested = TRUE;
+
+  /* not a worker thread, so every message goes directly to the wait queue */
+  for (gint i = 0; i < SLOW_PATH_MESSAGES_PER_PRODUCER; i++)
+    {
+      LogMessage *msg = log_msg_new_empty();
+
+      msg->rcptid = producer->id * SLOW_PATH_MESSAGES_PER_PRODUCER + i;
+      log_queue_push_tail(producer->queue, msg, &path_options);
+    }
+  return NULL;
+}
+
+Test(logqueue, log_queue_fifo_concurrent_slow_path_producers_keep_per_producer_order)
+{
+  StatsClusterKeyBuilder *driver_sck_builder = stats_cluster_key_builder_new();
+  StatsClusterKeyBuilder *queue_sck_builder = stats_cluster_key_builder_new();
+  LogQueue *q = log_queue_fifo_new(OVERFLOW_SIZE, NULL, STATS_LEVEL0, driver_sck_builder, queue_sck_builder);
+  stats_cluster_key_builder_free(driver_sck_builder);
+  stats_cluster_key_builder_free(queue_sck_builder);
+
+  SlowPathProducer producers[SLOW_PATH_PRODUCERS];
+  GThread *threads[SLOW_PATH_PRODUCERS];
+  gint next_expected[SLOW_PATH_PRODUCERS] = {0};
+
+  for (gint i = 0; i < SLOW_PATH_PRODUCERS; i++)
+    {
+      producers[i].queue = q;
+      producers[i].id = i;
+      threads[i] = g_thread_new(NULL, _slow_path_feed_thread, &producers[i]);
+    }
+
+  gint received = 0;
+  while (received < SLOW_PATH_PRODUCERS * SLOW_PATH_MESSAGES_PER_PRODUCER)
+    {
+      LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+      LogMessage *msg = log_queue_pop_head(q, &path_options);
+
+      if (!msg)
+        continue;
+
+      gint id = msg->rcptid / SLOW_PATH_MESSAGES_PER_PRODUCER;
+      gint seq = msg->rcptid % SLOW_PATH_MESSAGES_PER_PRODUCER;
+      cr_assert_eq(seq, next_expected[id], "messages of producer %d got reordered", id);
+      next_expected[id]++;
+      received++;
+
+      log_queue_ack_backlog(q, 1);
+      log_msg_unref(msg);
+    }
+
+  for (gint i = 0; i < SLOW_PATH_PRODUCERS; i++)
+    g_thread_join(threads[i]);
+
+  cr_assert_eq(log_queue_get_length(q), 0);
+  cr_assert_eq(stats_counter_get(q->metrics.shared.dropped_messages), 0);
+  log_queue_unref(q);
+}
+
+#define CAPPED_PRODUCERS 8
+#define CAPPED_MESSAGES_PER_PRODUCER 2000
+#define CAPPED_FIFO_SIZE 100
+
+static gpointer
+_capped_feed_thread(gpointer args)
+{
+  SlowPathProducer *producer = args;
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  /* every other producer is a worker and goes through its input queue */
+  gboolean worker = producer->id % 2 == 0;
+
+  if (worker)
+    {
+      iv_init();
+      main_loop_worker_thread_start(MLW_ASYNC_WORKER);
+    }
+
+  for (gint i = 0; i < CAPPED_MESSAGES_PER_PRODUCER; i++)
+    {
+      log_queue_push_tail(producer->queue, log_msg_new_empty(), &path_options);
+      if (worker && i % 16 == 0)
+        main_loop_worker_invoke_batch_callbacks();
+    }
+
+  if (worker)
+    {
+      main_loop_worker_invoke_batch_callbacks();
+      main_loop_worker_thread_stop();
+      iv_deinit();
+    }
+  return NULL;
+}
+
+Test(logqueue, log_queue_fifo_concurrent_producers_do_not_exceed_log_fifo_size)
+{
+  main_loop_worker_allocate_thread_space(CAPPED_PRODUCERS / 2);
+  main_loop_worker_finalize_thread_space();
+
+  StatsClusterKeyBuilder *driver_sck_builder = stats_cluster_key_builder_new();
+  StatsClusterKeyBuilder *queue_sck_builder = stats_cluster_key_builder_new();
+  LogQueue *q = log_queue_fifo_new(CAPPED_FIFO_SIZE, NULL, STATS_LEVEL0, driver_sck_builder, queue_sck_builder);
+  stats_cluster_key_builder_free(driver_sck_builder);
+  stats_cluster_key_builder_free(queue_sck_builder);
+
+  SlowPathProducer producers[CAPPED_PRODUCERS];
+  GThread *threads[CAPPED_PRODUCERS];
+
+  for (gint i = 0; i < CAPPED_PRODUCERS; i++)
+    {
+      producers[i].queue = q;
+      producers[i].id = i;
+      threads[i] = g_thread_new(NULL, _capped_feed_thread, &producers[i]);
+    }
+
+  for (gint i = 0; i < CAPPED_PRODUCERS; i++)
+    g_thread_join(threads[i]);
+
+  cr_assert_eq(log_queue_get_length(q), CAPPED_FIFO_SIZE);
+  cr_assert_eq(stats_counter_get(q->metrics.shared.dropped_messages),
+               CAPPED_PRODUCERS * CAPPED_MESSAGES_PER_PRODUCER - CAPPED_FIFO_SIZE);
+
+  /* the room of the consumed messages can be reused */
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  LogMessage *msg = log_queue_pop_head(q, &path_options);
+  cr_assert_not_null(msg);
+  log_queue_ack_backlog(q, 1);
+  log_msg_unref(msg);
+
+  log_queue_push_tail(q, log_msg_new_empty(), &path_options);
+  cr_assert_eq(log_queue_get_length(q), CAPPED_FIFO_SIZE);
+  cr_assert_eq(stats_counter_get(q->metrics.shared.dropped_messages),
+               CAPPED_PRODUCERS * CAPPED_MESSAGES_PER_PRODUCER - CAPPED_FIFO_SIZE);
+
+  log_queue_unref(q);
+}
+
 Test(logqueue, log_queue_fifo_multiple_queues)
 {
   const gint fifo_size = 1;
@@ -22,7 +22,7 @@
 #include <criterion/criterion.h>
 #include "libtest/cr_template.h"
 
-#include "logscheduler.h"
+#include "logscheduler.c"
 #include "apphook.h"
 
 typedef struct TestPipe
@@ -105,6 +105,137 @@ Test(logscheduler, test_log_scheduler_can_be_constructed)
   _destroy_test_pipe(test_pipe);
 }
 
+Test(logscheduler, test_log_scheduler_supports_more_than_32_partitions_with_work_stealing)
+{
+  LogSchedulerOptions options;
+  TestPipe *test_pipe = _construct_test_pipe();
+  LogScheduler *s;
+
+  log_scheduler_options_defaults(&options);
+  options.num_partitions = 64;
+  options.work_stealing = TRUE;
+  log_scheduler_options_init(&options, configuration);
+  cr_assert_eq(options.num_partitions, 64);
+  cr_assert(options.work_stealing);
+
+  s = log_scheduler_new(&options, &test_pipe->super, "id");
+
+  LogMessage *msg = create_sample_message();
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  log_scheduler_push(s, msg, &path_options);
+
+  cr_assert(test_pipe->messages_count == 1);
+  log_scheduler_free(s);
+  log_scheduler_options_destroy(&options);
+  _destroy_test_pipe(test_pipe);
+}
+
+Test(logscheduler, test_log_scheduler_work_stealing_is_disabled_with_partition_key)
+{
+  LogSchedulerOptions options;
+
+  log_scheduler_options_defaults(&options);
+  options.num_partitions = 4;
+  options.work_stealing = TRUE;
+  log_scheduler_options_set_partition_key_ref(&options, compile_template("$HOST"));
+  log_scheduler_options_init(&options, configuration);
+
+  cr_assert_not(options.work_stealing);
+  log_scheduler_options_destroy(&options);
+}
+
+#if SYSLOG_NG_HAVE_IV_WORK_POOL_SUBMIT_CONTINUATION
+
+/* queues a batch without starting the partition, its worker is run by the test */
+static void
+_queue_numbered_batch(LogSchedulerPartition *partition, gint first, gint len)
+{
+  struct iv_list_head elements = IV_LIST_HEAD_INIT(elements);
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  for (gint i = first; i < first + len; i++)
+    {
+      LogMessage *msg = create_sample_message();
+      gchar seq[16];
+
+      g_snprintf(seq, sizeof(seq), "%d", i);
+      log_msg_set_value_by_name(msg, "seq", seq, -1);
+
+      LogMessageQueueNode *node = log_msg_alloc_queue_node(msg, &path_options);
+      iv_list_add_tail(&node->list, &elements);
+      log_msg_unref(msg);
+    }
+
+  atomic_gssize_add(&partition->queued_events, len);
+  iv_list_add_tail(&_batch_new(&elements, len)->list, &partition->batches);
+}
+
+static void
+_assert_next_messages(TestPipe *test_pipe, gint first, gint len)
+{
+  cr_assert_geq(g_queue_get_length(test_pipe->messages), len);
+
+  for (gint i = first; i < first + len; i++)
+    {
+      LogMessage *msg = g_queue_pop_head(test_pipe->messages);
+      gchar seq[16];
+
+      g_snprintf(seq, sizeof(seq), "%d", i);
+      cr_assert_str_eq(log_msg_get_value_by_name(msg, "seq", NULL), seq);
+      log_msg_unref(msg);
+    }
+}
+
+Test(logscheduler, test_log_scheduler_idle_partition_steals_batches_of_a_busy_one)
+{
+  LogSchedulerOptions options;
+  TestPipe *test_pipe = _construct_test_pipe();
+  const gint batch_size = 10;
+
+  log_scheduler_options_defaults(&options);
+  options.num_partitions = 2;
+  options.work_stealing = TRUE;
+  options.log_fetch_limit = batch_size;
+  log_scheduler_options_init(&options, configuration);
+
+  LogScheduler *s = log_scheduler_new(&options, &test_pipe->super, "id");
+  LogSchedulerPartition *busy = &s->partitions[0];
+  LogSchedulerPartition *idle = &s->partitions[1];
+
+  for (gint i = 0; i < 4; i++)
+    _queue_numbered_batch(busy, i * batch_size, batch_size);
+
+  /* the idle partition takes the batch queued last, and processes it in order */
+  _work(idle, NULL);
+  cr_assert_eq(test_pipe->messages_count, batch_size);
+  cr_assert_eq(atomic_gssize_get(&busy->queued_events), 3 * batch_size);
+  _assert_next_messages(test_pipe, 3 * batch_size, batch_size);
+
+  /* the owner still consumes its own batches from the head */
+  _work(busy, NULL);
+  _assert_next_messages(test_pipe, 0, batch_size);
+
+  _work(idle, NULL);
+  _assert_next_messages(test_pipe, 2 * batch_size, batch_size);
+
+  _work(busy, NULL);
+  _assert_next_messages(test_pipe, batch_size, batch_size);
+
+  /* nothing is left to steal and nothing is lost */
+  _work(idle, NULL);
+  cr_assert(iv_list_empty(&busy->batches));
+  cr_assert_eq(atomic_gssize_get(&busy->queued_events), 0);
+  cr_assert_eq(atomic_gssize_get(&idle->queued_events), 0);
+  cr_assert_eq(test_pipe->messages_count, 4 * batch_size);
+  cr_assert(g_queue_is_empty(test_pipe->messages));
+
+  log_scheduler_free(s);
+  log_scheduler_options_destroy(&options);
+  _destroy_test_pipe(test_pipe);
+}
+
+#endif
+
 static void
 setup(void)
 {
@@ -25,6 +25,7 @@
 #include "libtest/cr_template.h"
 
 #include "logmatcher.h"
+#include "logmatcher-hyperscan.h"
 #include "apphook.h"
 #include "plugin.h"
 #include "cfg.h"
@@ -243,6 +244,74 @@ Test(matcher, glob_match)
                  FALSE, _construct_matcher(0, log_matcher_glob_new));
 }
 
+#if SYSLOG_NG_ENABLE_HYPERSCAN
+
+Test(matcher, hyperscan_match)
+{
+  testcase_match("árvíztűrőtükörfúrógép", "^árvíz",
+                 TRUE, _construct_matcher(0, log_matcher_hyperscan_new));
+  testcase_match("árvíztűrőtükörfúrógép", "tükör",
+                 TRUE, _construct_matcher(0, log_matcher_hyperscan_new));
+  testcase_match("árvíztűrőtükörfúrógép", "^tükör",
+                 FALSE, _construct_matcher(0, log_matcher_hyperscan_new));
+  testcase_match("PTHREAD support", "pthread",
+                 FALSE, _construct_matcher(0, log_matcher_hyperscan_new));
+  testcase_match("PTHREAD support", "pthread",
+                 TRUE, _construct_matcher(LMF_ICASE, log_matcher_hyperscan_new));
+  testcase_match("anything", "",
+                 TRUE, _construct_matcher(0, log_matcher_hyperscan_new));
+}
+
+Test(matcher, hyperscan_utf8_flag_matches_the_same_as_pcre)
+{
+  LogMatcher *(*constructors[])(const LogMatcherOptions *options) = { log_matcher_pcre_re_new, log_matcher_hyperscan_new };
+
+  for (gint i = 0; i < G_N_ELEMENTS(constructors); i++)
+    {
+      /* character classes are ASCII only, even in utf8 mode */
+      testcase_match("árvíztűrő", "^\\w+$", FALSE, _construct_matcher(LMF_UTF8, constructors[i]));
+      testcase_match("árvíztűrő", "^\\W", TRUE, _construct_matcher(LMF_UTF8, constructors[i]));
+      testcase_match("tűrő", "t\\b", TRUE, _construct_matcher(LMF_UTF8, constructors[i]));
+
+      /* but the dot matches whole characters */
+      testcase_match("árvíztűrő", "^.{9}$", TRUE, _construct_matcher(LMF_UTF8, constructors[i]));
+    }
+}
+
+Test(matcher, hyperscan_rejects_unsupported_patterns_and_flags)
+{
+  LogMatcher *m = _construct_matcher(0, log_matcher_hyperscan_new);
+  cr_assert_not(log_matcher_compile(m, "(wiki)\\1", NULL));
+  cr_assert_not(log_matcher_is_replace_supported(m));
+  log_matcher_unref(m);
+
+  m = _construct_matcher(LMF_STORE_MATCHES, log_matcher_hyperscan_new);
+  cr_assert_not(log_matcher_compile(m, "wiki", NULL));
+  log_matcher_unref(m);
+}
+
+Test(matcher, hyperscan_set_matches_if_any_of_the_patterns_match)
+{
+  LogMatcherHyperscanSet *set = log_matcher_hyperscan_set_new();
+
+  cr_assert(log_matcher_hyperscan_set_add_pattern(set, "^foo", 0, NULL));
+  cr_assert(log_matcher_hyperscan_set_add_pattern(set, "bar$", 0, NULL));
+  cr_assert(log_matcher_hyperscan_set_add_pattern(set, "BAZ", LMF_ICASE, NULL));
+  cr_assert_not(log_matcher_hyperscan_set_add_pattern(set, "(a)\\1", 0, NULL));
+  cr_assert_eq(log_matcher_hyperscan_set_get_size(set), 3);
+  cr_assert(log_matcher_hyperscan_set_compile(set, NULL));
+
+  cr_assert(log_matcher_hyperscan_set_match(set, "foo qux", -1));
+  cr_assert(log_matcher_hyperscan_set_match(set, "qux bar", -1));
+  cr_assert(log_matcher_hyperscan_set_match(set, "qux baz qux", -1));
+  cr_assert_not(log_matcher_hyperscan_set_match(set, "qux foo bar qux", -1));
+  cr_assert_not(log_matcher_hyperscan_set_match(set, "qux foo bar qux", 7));
+
+  log_matcher_hyperscan_set_free(set);
+}
+
+#endif
+
 Test(matcher, iso88592_never, .description = "match in iso-8859-2 never matches")
 {
   testcase_match("\xe1rv\xedzt\xfbr\xf5t\xfck\xf6rf\xfar\xf3g\xe9p",
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include <criterion/criterion.h>
+
+#include "string-set.h"
+#include "apphook.h"
+
+#include <glib/gstdio.h>
+#include <unistd.h>
+
+static StringSet *
+_compile_string_set(StringSetMode mode, const gchar *strings[])
+{
+  StringSet *set = string_set_new(mode);
+
+  for (gint i = 0; strings[i]; i++)
+    string_set_add(set, strings[i], -1);
+  string_set_compile(set);
+  return set;
+}
+
+static gboolean
+_match(StringSet *set, const gchar *value)
+{
+  return string_set_match(set, value, strlen(value));
+}
+
+static gchar *
+_write_temp_file(const gchar *contents)
+{
+  gchar *filename = NULL;
+  gint fd = g_file_open_tmp("test_string_set_XXXXXX", &filename, NULL);
+
+  cr_assert(fd >= 0);
+  close(fd);
+  cr_assert(g_file_set_contents(filename, contents, -1, NULL));
+  return filename;
+}
+
+Test(string_set, test_exact_mode_matches_whole_values_only)
+{
+  const gchar *strings[] = { "foo", "bar", "foobar", "", NULL };
+  StringSet *set = _compile_string_set(STRING_SET_EXACT, strings);
+
+  cr_assert(_match(set, "foo"));
+  cr_assert(_match(set, "bar"));
+  cr_assert(_match(set, "foobar"));
+  cr_assert(_match(set, ""));
+  cr_assert_not(_match(set, "fo"));
+  cr_assert_not(_match(set, "foob"));
+  cr_assert_not(_match(set, "xfoo"));
+  cr_assert_not(string_set_match(set, "foobar", 5));
+
+  string_set_free(set);
+}
+
+Test(string_set, test_exact_mode_with_many_strings)
+{
+  StringSet *set = string_set_new(STRING_SET_EXACT);
+
+  for (gint i = 0; i < 10000; i++)
+    {
+      gchar *str = g_strdup_printf("host-%d.example.com", i);
+      string_set_add(set, str, -1);
+      g_free(str);
+    }
+  string_set_compile(set);
+
+  cr_assert_eq(string_set_get_size(set), 10000);
+  cr_assert(_match(set, "host-0.example.com"));
+  cr_assert(_match(set, "host-9999.example.com"));
+  cr_assert_not(_match(set, "host-10000.example.com"));
+  cr_assert_not(_match(set, "host-1.example.co"));
+
+  string_set_free(set);
+}
+
+Test(string_set, test_duplicates_are_counted_once)
+{
+  const gchar *strings[] = { "foo", "bar", "foo", NULL };
+  StringSet *set;
+
+  set = _compile_string_set(STRING_SET_EXACT, strings);
+  cr_assert_eq(string_set_get_size(set), 2);
+  string_set_free(set);
+
+  set = _compile_string_set(STRING_SET_SUBSTRING, strings);
+  cr_assert_eq(string_set_get_size(set), 2);
+  string_set_free(set);
+}
+
+Test(string_set, test_substring_mode_matches_if_value_contains_any_of_the_strings)
+{
+  const gchar *strings[] = { "he", "she", "his", "hers", NULL };
+  StringSet *set = _compile_string_set(STRING_SET_SUBSTRING, strings);
+
+  cr_assert(_match(set, "he"));
+  cr_assert(_match(set, "ushers"));
+  cr_assert(_match(set, "this"));
+  cr_assert(_match(set, "xxxxxxxxxxxxxxxxxxxxxhis"));
+  cr_assert_not(_match(set, "hi"));
+  cr_assert_not(_match(set, "s h e"));
+  cr_assert_not(_match(set, ""));
+
+  string_set_free(set);
+}
+
+Test(string_set, test_substring_mode_follows_failure_links_to_shorter_strings)
+{
+  const gchar *strings[] = { "abcd", "bce", "cx", NULL };
+  StringSet *set = _compile_string_set(STRING_SET_SUBSTRING, strings);
+
+  /* "abc" fails over to "bc" and then "bce" has to be found */
+  cr_assert(_match(set, "abce"));
+  /* "abc" fails over to "c", followed by "cx" */
+  cr_assert(_match(set, "abcx"));
+  cr_assert_not(_match(set, "abcabc"));
+  cr_assert(_match(set, "aabcabcd"));
+
+  string_set_free(set);
+}
+
+Test(string_set, test_substring_mode_with_binary_data)
+{
+  StringSet *set = string_set_new(STRING_SET_SUBSTRING);
+
+  string_set_add(set, "\xff\x00\x01", 3);
+  string_set_compile(set);
+
+  cr_assert(string_set_match(set, "a\xff\x00\x01z", 5));
+  cr_assert_not(string_set_match(set, "a\xff\x00\x02z", 5));
+
+  string_set_free(set);
+}
+
+Test(string_set, test_empty_set_matches_nothing)
+{
+  const gchar *strings[] = { NULL };
+  StringSet *set;
+
+  set = _compile_string_set(STRING_SET_EXACT, strings);
+  cr_assert_not(_match(set, ""));
+  cr_assert_not(_match(set, "foo"));
+  string_set_free(set);
+
+  set = _compile_string_set(STRING_SET_SUBSTRING, strings);
+  cr_assert_not(_match(set, ""));
+  cr_assert_not(_match(set, "foo"));
+  string_set_free(set);
+}
+
+Test(string_set, test_load_file_ignores_empty_lines_and_line_terminators)
+{
+  gchar *filename = _write_temp_file("foo\r\n\nbar\nbaz");
+  StringSet *set = string_set_load_file(filename, STRING_SET_EXACT, NULL);
+
+  cr_assert_not_null(set);
+  cr_assert_eq(string_set_get_size(set), 3);
+  cr_assert(_match(set, "foo"));
+  cr_assert(_match(set, "bar"));
+  cr_assert(_match(set, "baz"));
+  cr_assert_not(_match(set, ""));
+  cr_assert_not(_match(set, "foo\r"));
+
+  string_set_free(set);
+  g_unlink(filename);
+  g_free(filename);
+}
+
+Test(string_set, test_load_file_fails_for_missing_file)
+{
+  GError *error = NULL;
+
+  cr_assert_null(string_set_load_file("/nonexistent/string-set.list", STRING_SET_EXACT, &error));
+  cr_assert_not_null(error);
+  g_clear_error(&error);
+
+  cr_assert_null(string_set_file_new("/nonexistent/string-set.list", STRING_SET_EXACT, &error));
+  cr_assert_not_null(error);
+  g_clear_error(&error);
+}
+
+Test(string_set, test_string_set_file_reload_replaces_the_set)
+{
+  gchar *filename = _write_temp_file("foo\n");
+  StringSetFile *list = string_set_file_new(filename, STRING_SET_SUBSTRING, NULL);
+
+  cr_assert_not_null(list);
+  cr_assert(string_set_file_match(list, "xfoox", 5));
+  cr_assert_not(string_set_file_match(list, "xbarx", 5));
+
+  cr_assert(g_file_set_contents(filename, "bar\n", -1, NULL));
+  cr_assert(string_set_file_reload(list, NULL));
+  cr_assert_not(string_set_file_match(list, "xfoox", 5));
+  cr_assert(string_set_file_match(list, "xbarx", 5));
+
+  /* a failed reload keeps the current set */
+  g_unlink(filename);
+  cr_assert_not(string_set_file_reload(list, NULL));
+  cr_assert(string_set_file_match(list, "xbarx", 5));
+
+  string_set_file_free(list);
+  g_free(filename);
+}
+
+Test(string_set, test_string_set_file_consecutive_reloads_free_the_retired_sets)
+{
+  gchar *filename = _write_temp_file("foo\n");
+  StringSetFile *list = string_set_file_new(filename, STRING_SET_EXACT, NULL);
+
+  cr_assert_not_null(list);
+  string_set_file_start_monitoring(list);
+  string_set_file_start_monitoring(list);
+
+  const gchar *contents[] = { "bar\n", "baz\n", "qux\n" };
+  for (gint i = 0; i < G_N_ELEMENTS(contents); i++)
+    {
+      cr_assert(g_file_set_contents(filename, contents[i], -1, NULL));
+      cr_assert(string_set_file_reload(list, NULL));
+      cr_assert(string_set_file_match(list, contents[i], 3));
+      cr_assert_not(string_set_file_match(list, "foo", 3));
+    }
+
+  string_set_file_stop_monitoring(list);
+  string_set_file_stop_monitoring(list);
+  string_set_file_free(list);
+  g_unlink(filename);
+  g_free(filename);
+}
+
+TestSuite(string_set, .init = app_startup, .fini = app_shutdown);
@@ -54,13 +54,27 @@ ParameterizedTestParameters(test_utf8utils, test_escaped_binary)
     {"'text'", "\\'text\\'", AUTF8_UNSAFE_APOSTROPHE, -1},
     {"\xc3""\xa1 non zero terminated", "\\xc3", 0, 1},
     {"\xc3""\xa1 non zero terminated", "á", 0, 2},
+    /* longer than the vectorized scanning width */
+    {
+      "a rather long line without anything to escape in it, at all",
+      "a rather long line without anything to escape in it, at all", 0, -1
+    },
+    {
+      "a rather long line with \"quotes\" and\ta tab after the first 32 bytes\n",
+      "a rather long line with \\\"quotes\\\" and\\ta tab after the first 32 bytes\\n", AUTF8_UNSAFE_QUOTE, -1
+    },
+    {
+      "0123456789abcdef0123456789abcdefárvíztűrő\x01 0123456789abcdef0123456789abcdef\xad",
+      "0123456789abcdef0123456789abcdefárvíztűrő\\x01 0123456789abcdef0123456789abcdef\\xad", 0, -1
+    },
   };
 
   return cr_make_param_array(StringValueList, string_value_list,
                              sizeof(string_value_list) / sizeof(string_value_list[0]));
 }
 
-ParameterizedTest(StringValueList *string_value_list, test_utf8utils, test_escaped_binary)
+ParameterizedTest(StringValueList *string_value_list, test_utf8utils, test_escaped_binary,
+                  .init = utf8utils_global_init)
 {
   GString *escaped_str = g_string_sized_new(64);
 
@@ -88,13 +102,22 @@ ParameterizedTestParameters(test_utf8utils, test_escaped_text)
     {"Á\xadÉ", "Á\\\\xadÉ", 0, -1},
     {"\"text\"", "\\\"text\\\"", AUTF8_UNSAFE_QUOTE, -1},
     {"\"te't\"", "\\\"te\\'t\\\"", AUTF8_UNSAFE_QUOTE|AUTF8_UNSAFE_APOSTROPHE, -1},
+    {
+      "0123456789abcdef0123456789abcdefárvíztűrőtükörfúrógép",
+      "0123456789abcdef0123456789abcdefárvíztűrőtükörfúrógép", AUTF8_UNSAFE_QUOTE, -1
+    },
+    {
+      "0123456789abcdef0123456789abcdefárvíztűrő'tükörfúrógép",
+      "0123456789abcdef0123456789abcdefárvíztűrő\\'tükörfúrógép", AUTF8_UNSAFE_APOSTROPHE, -1
+    },
   };
 
   return cr_make_param_array(StringValueList, string_value_list,
                              sizeof(string_value_list) / sizeof(string_value_list[0]));
 }
 
-ParameterizedTest(StringValueList *string_value_list, test_utf8utils, test_escaped_text)
+ParameterizedTest(StringValueList *string_value_list, test_utf8utils, test_escaped_text,
+                  .init = utf8utils_global_init)
 {
   gchar *escaped_str = convert_unsafe_utf8_to_escaped_text(string_value_list->str, string_value_list->str_len,
                                                            string_value_list->unsafe_flags);
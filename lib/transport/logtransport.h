@@ -69,6 +69,9 @@ struct _LogTransport
   void (*shutdown)(LogTransport *self);
   void (*free_fn)(LogTransport *self);
   void (*register_stats)(LogTransport *self, StatsClusterKeyBuilder *kb);
+  /* returns TRUE if the transport holds input that was already received
+   * from the kernel, but not yet returned by read() */
+  gboolean (*has_buffered_input)(LogTransport *self);
 
   /* read ahead */
   struct
@@ -109,6 +112,9 @@ log_transport_poll_prepare(LogTransport *self, GIOCondition *cond)
   if (self->ra.buf_len != self->ra.pos)
     return TRUE;
 
+  if (self->has_buffered_input && self->has_buffered_input(self))
+    return TRUE;
+
   return FALSE;
 }
 
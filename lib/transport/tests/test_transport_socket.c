@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "transport/transport-socket.h"
+#include "apphook.h"
+
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+
+static gint fds[2];
+
+static void
+_send_datagram(const gchar *payload)
+{
+  cr_assert(send(fds[1], payload, strlen(payload), 0) == strlen(payload));
+}
+
+static LogTransport *
+_construct_dgram_transport(gint batch_size)
+{
+  LogTransport *t = log_transport_dgram_socket_new(fds[0]);
+
+  cr_assert(log_transport_dgram_socket_set_recv_batch_size(t, batch_size));
+  return t;
+}
+
+static void
+_assert_read_datagram(LogTransport *t, const gchar *expected)
+{
+  gchar buf[64] = {0};
+  LogTransportAuxData aux;
+
+  log_transport_aux_data_init(&aux);
+  gssize rc = log_transport_read(t, buf, sizeof(buf) - 1, &aux);
+  cr_assert(rc == strlen(expected), "unexpected rc = %" G_GSSIZE_FORMAT, rc);
+  cr_assert_str_eq(buf, expected);
+  log_transport_aux_data_destroy(&aux);
+}
+
+static void
+_assert_read_would_block(LogTransport *t)
+{
+  gchar buf[64];
+
+  cr_assert(log_transport_read(t, buf, sizeof(buf), NULL) == -1);
+  cr_assert(errno == EAGAIN);
+}
+
+Test(transport_socket, test_dgram_read_without_batching_returns_datagrams_one_by_one)
+{
+  LogTransport *t = _construct_dgram_transport(1);
+  GIOCondition cond;
+
+  _send_datagram("foo");
+  _send_datagram("bar");
+
+  _assert_read_datagram(t, "foo");
+  cr_assert_not(log_transport_poll_prepare(t, &cond));
+  _assert_read_datagram(t, "bar");
+  _assert_read_would_block(t);
+
+  log_transport_free(t);
+}
+
+#if SYSLOG_NG_HAVE_RECVMMSG
+
+Test(transport_socket, test_dgram_batched_read_keeps_datagram_boundaries)
+{
+  LogTransport *t = _construct_dgram_transport(16);
+  GIOCondition cond;
+
+  _send_datagram("foo");
+  _send_datagram("barbaz");
+  _send_datagram("");
+  _send_datagram("qux");
+
+  /* the first read() fetches all pending datagrams */
+  _assert_read_datagram(t, "foo");
+  cr_assert(log_transport_poll_prepare(t, &cond));
+
+  /* make sure the rest is not coming from the socket anymore */
+  _send_datagram("late");
+
+  _assert_read_datagram(t, "barbaz");
+  /* the empty datagram is skipped */
+  _assert_read_datagram(t, "qux");
+  cr_assert_not(log_transport_poll_prepare(t, &cond));
+
+  _assert_read_datagram(t, "late");
+  _assert_read_would_block(t);
+
+  log_transport_free(t);
+}
+
+Test(transport_socket, test_dgram_batched_read_wraps_around_when_batch_is_full)
+{
+  LogTransport *t = _construct_dgram_transport(2);
+  GIOCondition cond;
+
+  _send_datagram("1");
+  _send_datagram("2");
+  _send_datagram("3");
+
+  _assert_read_datagram(t, "1");
+  cr_assert(log_transport_poll_prepare(t, &cond));
+  _assert_read_datagram(t, "2");
+  cr_assert_not(log_transport_poll_prepare(t, &cond));
+  _assert_read_datagram(t, "3");
+  _assert_read_would_block(t);
+
+  log_transport_free(t);
+}
+
+#endif
+
+static void
+setup(void)
+{
+  app_startup();
+  cr_assert(socketpair(AF_UNIX, SOCK_DGRAM, 0, fds) == 0);
+  fcntl(fds[0], F_SETFL, O_NONBLOCK);
+}
+
+static void
+teardown(void)
+{
+  close(fds[0]);
+  close(fds[1]);
+  app_shutdown();
+}
+
+TestSuite(transport_socket, .init = setup, .fini = teardown);
@@ -23,6 +23,7 @@
 #define TRANSPORT_TRANSPORT_AUX_DATA_H_INCLUDED
 
 #include "gsockaddr.h"
+#include "logmsg/input-slab.h"
 #include <string.h>
 
 typedef struct _LogTransportAuxData
@@ -31,6 +32,8 @@ typedef struct _LogTransportAuxData
   GSockAddr *local_addr;
   struct timespec timestamp;
   gint proto;
+  /* the input buffer the message was read into, if it can be borrowed */
+  InputSlab *input_slab;
   gchar data[1536];
   gsize end_ptr;
 } LogTransportAuxData;
@@ -47,6 +50,7 @@ log_transport_aux_data_init(LogTransportAuxData *self)
       self->timestamp.tv_sec = 0;
       self->timestamp.tv_nsec = 0;
       self->proto = 0;
+      self->input_slab = NULL;
     }
 }
 
@@ -57,6 +61,7 @@ log_transport_aux_data_destroy(LogTransportAuxData *self)
     {
       g_sockaddr_unref(self->peer_addr);
       g_sockaddr_unref(self->local_addr);
+      input_slab_unref(self->input_slab);
     }
 }
 
@@ -79,6 +84,8 @@ log_transport_aux_data_copy(LogTransportAuxData *dst, LogTransportAuxData *src)
       memcpy(dst, src, data_to_copy);
       g_sockaddr_ref(dst->peer_addr);
       g_sockaddr_ref(dst->local_addr);
+      if (dst->input_slab)
+        input_slab_ref(dst->input_slab);
     }
 }
 
@@ -123,6 +130,16 @@ log_transport_aux_data_set_local_addr_ref(LogTransportAuxData *self, GSockAddr *
   self->local_addr = local_addr;
 }
 
+static inline void
+log_transport_aux_data_set_input_slab(LogTransportAuxData *self, InputSlab *input_slab)
+{
+  if (!self)
+    return;
+
+  input_slab_unref(self->input_slab);
+  self->input_slab = input_slab_ref(input_slab);
+}
+
 static inline void
 log_transport_aux_data_set_timestamp(LogTransportAuxData *self, const struct timespec *timestamp)
 {
@@ -22,10 +22,13 @@
 
 #include "transport-socket.h"
 #include "messages.h"
+#include "stats/stats-cluster-key-builder.h"
+#include "stats/aggregator/stats-aggregator-registry.h"
 
 #include <errno.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/uio.h>
 
 static gint
 _determine_address_family(gint fd)
@@ -123,6 +126,8 @@ _setup_fd(LogTransportSocket *self, gint fd)
 
 #if defined(SYSLOG_NG_HAVE_CTRLBUF_IN_MSGHDR)
 
+#define LOG_TRANSPORT_SOCKET_CTLBUF_SIZE 256
+
 static void
 _parse_cmsg_to_aux(LogTransportSocket *self, struct msghdr *msg, LogTransportAuxData *aux)
 {
@@ -167,7 +172,7 @@ log_transport_socket_read_method(LogTransport *s, gpointer buf, gsize buflen, Lo
   struct iovec iov[1];
   struct sockaddr_storage ss;
 #if defined(SYSLOG_NG_HAVE_CTRLBUF_IN_MSGHDR)
-  gchar ctlbuf[256];
+  gchar ctlbuf[LOG_TRANSPORT_SOCKET_CTLBUF_SIZE];
   msg.msg_control = ctlbuf;
   msg.msg_controllen = sizeof(ctlbuf);
 #endif
@@ -191,6 +196,205 @@ log_transport_socket_read_method(LogTransport *s, gpointer buf, gsize buflen, Lo
   return rc;
 }
 
+#if SYSLOG_NG_HAVE_RECVMMSG
+
+/*
+ * Batched datagram receive
+ *
+ * Instead of reading a single datagram with recvmsg() each time the
+ * LogProto layer asks for input, we fetch up to batch_size datagrams
+ * with a single recvmmsg() call into a ring of preallocated slots and hand
+ * them out one by one in subsequent read() calls, each with its own
+ * source address and control data. The number of syscalls is reduced
+ * accordingly, while the LogProto layer sees the same datagram boundaries
+ * as before.
+ */
+struct _LogTransportSocketRecvBatch
+{
+  gint size;
+  /* number of datagrams received by the last recvmmsg() call and the next one to return */
+  gint filled;
+  gint pos;
+
+  gsize slot_size;
+  guchar *slots;
+  struct mmsghdr *msgs;
+  struct iovec *iovs;
+  struct sockaddr_storage *addrs;
+#if defined(SYSLOG_NG_HAVE_CTRLBUF_IN_MSGHDR)
+  gchar *ctlbufs;
+#endif
+
+  StatsAggregator *datagrams_per_syscall;
+};
+
+static void
+_recv_batch_free_slots(LogTransportSocketRecvBatch *self)
+{
+  g_free(self->slots);
+  self->slots = NULL;
+  self->slot_size = 0;
+}
+
+static void
+_recv_batch_alloc_slots(LogTransportSocketRecvBatch *self, gsize slot_size)
+{
+  _recv_batch_free_slots(self);
+  self->slot_size = slot_size;
+  self->slots = g_malloc(self->size * slot_size);
+}
+
+static void
+_recv_batch_prepare_slots(LogTransportSocketRecvBatch *self)
+{
+  for (gint i = 0; i < self->size; i++)
+    {
+      struct msghdr *msg = &self->msgs[i].msg_hdr;
+
+      self->iovs[i].iov_base = self->slots + i * self->slot_size;
+      self->iovs[i].iov_len = self->slot_size;
+
+      memset(msg, 0, sizeof(*msg));
+      msg->msg_name = &self->addrs[i];
+      msg->msg_namelen = sizeof(self->addrs[i]);
+      msg->msg_iov = &self->iovs[i];
+      msg->msg_iovlen = 1;
+#if defined(SYSLOG_NG_HAVE_CTRLBUF_IN_MSGHDR)
+      msg->msg_control = self->ctlbufs + i * LOG_TRANSPORT_SOCKET_CTLBUF_SIZE;
+      msg->msg_controllen = LOG_TRANSPORT_SOCKET_CTLBUF_SIZE;
+#endif
+      self->msgs[i].msg_len = 0;
+    }
+}
+
+static gint
+_recv_batch_fill(LogTransportSocket *self, gsize buflen)
+{
+  LogTransportSocketRecvBatch *batch = self->recv_batch;
+  gint rc;
+
+  /* the slots are sized to the buffer the LogProto layer offers us, so
+   * that we never truncate more than a plain recvmsg() would */
+  if (batch->slot_size < buflen)
+    _recv_batch_alloc_slots(batch, buflen);
+
+  _recv_batch_prepare_slots(batch);
+  batch->filled = batch->pos = 0;
+
+  do
+    {
+      rc = recvmmsg(self->super.fd, batch->msgs, batch->size, 0, NULL);
+    }
+  while (rc == -1 && errno == EINTR);
+
+  if (rc > 0)
+    {
+      batch->filled = rc;
+      stats_aggregator_add_data_point(batch->datagrams_per_syscall, rc);
+    }
+  return rc;
+}
+
+static gssize
+log_transport_dgram_socket_read_batched_method(LogTransport *s, gpointer buf, gsize buflen, LogTransportAuxData *aux)
+{
+  LogTransportSocket *self = (LogTransportSocket *) s;
+  LogTransportSocketRecvBatch *batch = self->recv_batch;
+
+  while (1)
+    {
+      if (batch->pos >= batch->filled)
+        {
+          gint rc = _recv_batch_fill(self, buflen);
+
+          if (rc < 0)
+            return rc;
+          if (rc == 0)
+            break;
+        }
+
+      struct mmsghdr *m = &batch->msgs[batch->pos++];
+
+      /* DGRAM sockets should never return EOF, skip empty datagrams */
+      if (m->msg_len == 0)
+        continue;
+
+      gsize len = MIN(m->msg_len, buflen);
+      memcpy(buf, m->msg_hdr.msg_iov[0].iov_base, len);
+      _extract_from_msghdr_method(self, &m->msg_hdr, aux);
+      return len;
+    }
+
+  errno = EAGAIN;
+  return -1;
+}
+
+static gboolean
+log_transport_dgram_socket_has_buffered_input(LogTransport *s)
+{
+  LogTransportSocket *self = (LogTransportSocket *) s;
+
+  return self->recv_batch->pos < self->recv_batch->filled;
+}
+
+static void
+log_transport_dgram_socket_register_stats(LogTransport *s, StatsClusterKeyBuilder *kb)
+{
+  LogTransportSocket *self = (LogTransportSocket *) s;
+
+  if (!kb)
+    return;
+
+  stats_cluster_key_builder_push(kb);
+  stats_cluster_key_builder_set_name(kb, METRIC(socket_receive_datagrams_per_syscall));
+  StatsClusterKey *sc_key = stats_cluster_key_builder_build_single(kb);
+  stats_cluster_key_builder_pop(kb);
+
+  stats_aggregator_lock();
+  stats_unregister_aggregator(&self->recv_batch->datagrams_per_syscall);
+  stats_register_aggregator_average(STATS_LEVEL1, sc_key, &self->recv_batch->datagrams_per_syscall);
+  stats_aggregator_unlock();
+
+  stats_cluster_key_free(sc_key);
+}
+
+static LogTransportSocketRecvBatch *
+_recv_batch_new(gint batch_size)
+{
+  LogTransportSocketRecvBatch *self = g_new0(LogTransportSocketRecvBatch, 1);
+
+  self->size = batch_size;
+  self->msgs = g_new0(struct mmsghdr, batch_size);
+  self->iovs = g_new0(struct iovec, batch_size);
+  self->addrs = g_new0(struct sockaddr_storage, batch_size);
+#if defined(SYSLOG_NG_HAVE_CTRLBUF_IN_MSGHDR)
+  self->ctlbufs = g_malloc0(batch_size * LOG_TRANSPORT_SOCKET_CTLBUF_SIZE);
+#endif
+  return self;
+}
+
+static void
+_recv_batch_free(LogTransportSocketRecvBatch *self)
+{
+  if (self->datagrams_per_syscall)
+    {
+      stats_aggregator_lock();
+      stats_unregister_aggregator(&self->datagrams_per_syscall);
+      stats_aggregator_unlock();
+    }
+
+  _recv_batch_free_slots(self);
+  g_free(self->msgs);
+  g_free(self->iovs);
+  g_free(self->addrs);
+#if defined(SYSLOG_NG_HAVE_CTRLBUF_IN_MSGHDR)
+  g_free(self->ctlbufs);
+#endif
+  g_free(self);
+}
+
+#endif
+
 static gssize
 log_transport_socket_write_method(LogTransport *s, const gpointer buf, gsize buflen)
 {
@@ -205,12 +409,25 @@ log_transport_socket_write_method(LogTransport *s, const gpointer buf, gsize buf
   return rc;
 }
 
+void
+log_transport_socket_free_method(LogTransport *s)
+{
+#if SYSLOG_NG_HAVE_RECVMMSG
+  LogTransportSocket *self = (LogTransportSocket *) s;
+
+  if (self->recv_batch)
+    _recv_batch_free(self->recv_batch);
+#endif
+  log_transport_free_method(s);
+}
+
 static void
 log_transport_socket_init_instance(LogTransportSocket *self, const gchar *name, gint fd)
 {
   log_transport_init_instance(&self->super, name, fd);
   self->super.read = log_transport_socket_read_method;
   self->super.write = log_transport_socket_write_method;
+  self->super.free_fn = log_transport_socket_free_method;
   self->address_family = _determine_address_family(fd);
   self->proto = _determine_proto(fd, self->address_family);
   self->parse_cmsg = log_transport_socket_parse_cmsg_method;
@@ -260,6 +477,29 @@ log_transport_dgram_socket_init_instance(LogTransportSocket *self, gint fd)
   self->super.write = log_transport_dgram_socket_write_method;
 }
 
+/* returns FALSE if batched receive is not supported on this platform */
+gboolean
+log_transport_dgram_socket_set_recv_batch_size(LogTransport *s, gint batch_size)
+{
+#if SYSLOG_NG_HAVE_RECVMMSG
+  LogTransportSocket *self = (LogTransportSocket *) s;
+
+  g_assert(batch_size <= LOG_TRANSPORT_SOCKET_MAX_RECV_BATCH_SIZE);
+  g_assert(!self->recv_batch);
+
+  if (batch_size <= 1)
+    return TRUE;
+
+  self->recv_batch = _recv_batch_new(batch_size);
+  self->super.read = log_transport_dgram_socket_read_batched_method;
+  self->super.has_buffered_input = log_transport_dgram_socket_has_buffered_input;
+  self->super.register_stats = log_transport_dgram_socket_register_stats;
+  return TRUE;
+#else
+  return batch_size <= 1;
+#endif
+}
+
 LogTransport *
 log_transport_dgram_socket_new(gint fd)
 {
@@ -269,6 +509,20 @@ log_transport_dgram_socket_new(gint fd)
   return &self->super;
 }
 
+static gssize
+log_transport_stream_socket_writev_method(LogTransport *s, struct iovec *iov, gint iov_count)
+{
+  LogTransportSocket *self = (LogTransportSocket *) s;
+  gssize rc;
+
+  do
+    {
+      rc = writev(self->super.fd, iov, iov_count);
+    }
+  while (rc == -1 && errno == EINTR);
+  return rc;
+}
+
 static void
 log_transport_stream_socket_shutdown(LogTransport *s)
 {
@@ -280,6 +534,7 @@ void
 log_transport_stream_socket_init_instance(LogTransportSocket *self, gint fd)
 {
   log_transport_socket_init_instance(self, "stream-socket", fd);
+  self->super.writev = log_transport_stream_socket_writev_method;
   self->super.shutdown = log_transport_stream_socket_shutdown;
 }
 
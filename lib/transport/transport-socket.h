@@ -26,6 +26,10 @@
 
 #include "logtransport.h"
 
+#define LOG_TRANSPORT_SOCKET_MAX_RECV_BATCH_SIZE 1024
+
+typedef struct _LogTransportSocketRecvBatch LogTransportSocketRecvBatch;
+
 typedef struct _LogTransportSocket LogTransportSocket;
 struct _LogTransportSocket
 {
@@ -33,12 +37,18 @@ struct _LogTransportSocket
   gint address_family;
   gint proto;
   void (*parse_cmsg)(LogTransportSocket *self, struct cmsghdr *cmsg, LogTransportAuxData *aux);
+
+  /* ring of datagrams received by a single recvmmsg() call, only used for
+   * datagram sockets with a receive batch size larger than 1 */
+  LogTransportSocketRecvBatch *recv_batch;
 };
 
 void log_transport_socket_parse_cmsg_method(LogTransportSocket *s, struct cmsghdr *cmsg, LogTransportAuxData *aux);
 gssize log_transport_socket_read_method(LogTransport *s, gpointer buf, gsize buflen, LogTransportAuxData *aux);
+void log_transport_socket_free_method(LogTransport *s);
 
 void log_transport_dgram_socket_init_instance(LogTransportSocket *self, gint fd);
+gboolean log_transport_dgram_socket_set_recv_batch_size(LogTransport *s, gint batch_size);
 LogTransport *log_transport_dgram_socket_new(gint fd);
 
 void log_transport_stream_socket_init_instance(LogTransportSocket *self, gint fd);
@@ -40,6 +40,9 @@ typedef struct _LogTransportTLS
   TLSSession *tls_session;
   gboolean sending_shutdown;
 
+  /* coalesced writev() payload, kept intact until SSL_write() succeeds */
+  GString *writev_buffer;
+
   StatsClusterKeyBuilder *kb;
 } LogTransportTLS;
 
@@ -388,6 +391,33 @@ tls_error:
   return -1;
 }
 
+/*
+ * Coalesce the iovec into a single buffer, so that the batch is encrypted
+ * into full sized TLS records instead of one (small) record per message.
+ *
+ * If SSL_write() fails with SSL_ERROR_WANT_*, it has to be retried with the
+ * same buffer, so we keep the coalesced buffer until it is written.  Our
+ * callers never change the data that has not been written yet, they may
+ * only append to it, which we ignore while retrying.
+ */
+static gssize
+log_transport_tls_writev_method(LogTransport *s, struct iovec *iov, gint iov_count)
+{
+  LogTransportTLS *self = (LogTransportTLS *) s;
+
+  if (self->writev_buffer->len == 0)
+    {
+      for (gint i = 0; i < iov_count; i++)
+        g_string_append_len(self->writev_buffer, iov[i].iov_base, iov[i].iov_len);
+    }
+
+  gssize rc = log_transport_tls_write_method(s, self->writev_buffer->str, self->writev_buffer->len);
+  if (rc >= 0 || errno != EAGAIN)
+    g_string_truncate(self->writev_buffer, 0);
+
+  return rc;
+}
+
 TLSSession *
 log_tansport_tls_get_session(LogTransport *s)
 {
@@ -420,10 +450,12 @@ log_transport_tls_new(TLSSession *tls_session, LogTransportIndex base)
   self->super.super.cond = LTIO_NOTHING;
   self->super.super.read = log_transport_tls_read_method;
   self->super.super.write = log_transport_tls_write_method;
+  self->super.super.writev = log_transport_tls_writev_method;
   self->super.super.shutdown = log_transport_tls_shutdown_method;
   self->super.super.free_fn = log_transport_tls_free_method;
   self->super.super.register_stats = log_transport_tls_register_stats;
   self->tls_session = tls_session;
+  self->writev_buffer = g_string_sized_new(0);
 
   BIO *bio = BIO_transport_new(self);
   SSL_set_bio(self->tls_session->ssl, bio, bio);
@@ -438,6 +470,7 @@ log_transport_tls_free_method(LogTransport *s)
   if (self->kb)
     stats_cluster_key_builder_free(self->kb);
 
+  g_string_free(self->writev_buffer, TRUE);
   tls_session_free(self->tls_session);
   log_transport_adapter_free_method(s);
 }
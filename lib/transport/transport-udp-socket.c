@@ -163,7 +163,7 @@ log_transport_udp_socket_free(LogTransport *s)
 {
   LogTransportUDP *self = (LogTransportUDP *)s;
   g_sockaddr_unref(self->bind_addr);
-  log_transport_free_method(s);
+  log_transport_socket_free_method(s);
 }
 
 LogTransport *
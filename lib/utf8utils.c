@@ -22,6 +22,160 @@
  */
 #include "utf8utils.h"
 #include "str-utils.h"
+#include "cpu-features.h"
+
+#include <string.h>
+
+#if CPU_FEATURES_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#if CPU_FEATURES_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+/*
+ * Scanning kernels: return the length of the prefix of s[0..n) that can be
+ * copied to the output as is, e.g.  it contains no control characters, no
+ * backslash, no non-ASCII bytes (these need utf8 validation) and neither
+ * of the two additional unsafe characters.  Most log data needs no
+ * escaping at all, so this is what makes escaping run at memcpy speed.
+ */
+typedef gsize (*Utf8FindUnsafeFunc)(const gchar *s, gsize n, gchar unsafe1, gchar unsafe2);
+
+static inline gboolean
+_is_byte_unsafe(guchar c, gchar unsafe1, gchar unsafe2)
+{
+  return c < 0x20 || c >= 0x80 || c == '\\' || c == (guchar) unsafe1 || c == (guchar) unsafe2;
+}
+
+static gsize
+_find_unsafe_scalar(const gchar *s, gsize n, gchar unsafe1, gchar unsafe2)
+{
+  for (gsize i = 0; i < n; i++)
+    {
+      if (_is_byte_unsafe((guchar) s[i], unsafe1, unsafe2))
+        return i;
+    }
+  return n;
+}
+
+#if CPU_FEATURES_HAVE_X86_SIMD
+
+/* bytes >= 0x80 are negative as signed chars, so a single signed
+ * comparison catches both control characters and non-ASCII bytes */
+
+__attribute__((target("sse4.2")))
+static gsize
+_find_unsafe_sse42(const gchar *s, gsize n, gchar unsafe1, gchar unsafe2)
+{
+  const __m128i space = _mm_set1_epi8(0x20);
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i u1 = _mm_set1_epi8(unsafe1);
+  const __m128i u2 = _mm_set1_epi8(unsafe2);
+  gsize i = 0;
+
+  for (; i + 16 <= n; i += 16)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *) (s + i));
+      __m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmplt_epi8(chunk, space),
+                                                  _mm_cmpeq_epi8(chunk, backslash)),
+                                     _mm_or_si128(_mm_cmpeq_epi8(chunk, u1),
+                                                  _mm_cmpeq_epi8(chunk, u2)));
+      guint32 mask = (guint32) _mm_movemask_epi8(matches);
+
+      if (mask)
+        return i + __builtin_ctz(mask);
+    }
+  return i + _find_unsafe_scalar(s + i, n - i, unsafe1, unsafe2);
+}
+
+__attribute__((target("avx2")))
+static gsize
+_find_unsafe_avx2(const gchar *s, gsize n, gchar unsafe1, gchar unsafe2)
+{
+  const __m256i below_space = _mm256_set1_epi8(0x1f);
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i u1 = _mm256_set1_epi8(unsafe1);
+  const __m256i u2 = _mm256_set1_epi8(unsafe2);
+  gsize i = 0;
+
+  for (; i + 32 <= n; i += 32)
+    {
+      __m256i chunk = _mm256_loadu_si256((const __m256i *) (s + i));
+      /* AVX2 has no signed less-than, c < 0x20 is 0x1f > c */
+      __m256i matches = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi8(below_space, chunk),
+                                                        _mm256_cmpeq_epi8(chunk, backslash)),
+                                        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, u1),
+                                                        _mm256_cmpeq_epi8(chunk, u2)));
+      guint32 mask = (guint32) _mm256_movemask_epi8(matches);
+
+      if (mask)
+        return i + __builtin_ctz(mask);
+    }
+  return i + _find_unsafe_sse42(s + i, n - i, unsafe1, unsafe2);
+}
+
+#endif
+
+#if CPU_FEATURES_HAVE_NEON
+
+static gsize
+_find_unsafe_neon(const gchar *s, gsize n, gchar unsafe1, gchar unsafe2)
+{
+  const uint8x16_t space = vdupq_n_u8(0x20);
+  const uint8x16_t high = vdupq_n_u8(0x80);
+  const uint8x16_t backslash = vdupq_n_u8('\\');
+  const uint8x16_t u1 = vdupq_n_u8((guchar) unsafe1);
+  const uint8x16_t u2 = vdupq_n_u8((guchar) unsafe2);
+  gsize i = 0;
+
+  for (; i + 16 <= n; i += 16)
+    {
+      uint8x16_t chunk = vld1q_u8((const uint8_t *) (s + i));
+      uint8x16_t matches = vorrq_u8(vorrq_u8(vcltq_u8(chunk, space), vcgeq_u8(chunk, high)),
+                                    vorrq_u8(vceqq_u8(chunk, backslash),
+                                             vorrq_u8(vceqq_u8(chunk, u1), vceqq_u8(chunk, u2))));
+      /* narrow the byte mask to 4 bits per byte, NEON has no movemask */
+      guint64 mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+
+      if (mask)
+        return i + (__builtin_ctzll(mask) >> 2);
+    }
+  return i + _find_unsafe_scalar(s + i, n - i, unsafe1, unsafe2);
+}
+
+#endif
+
+/* selected by utf8utils_global_init() before any worker threads are started */
+static Utf8FindUnsafeFunc _find_unsafe = _find_unsafe_scalar;
+
+void
+utf8utils_global_init(void)
+{
+  Utf8FindUnsafeFunc func = _find_unsafe_scalar;
+
+#if CPU_FEATURES_HAVE_X86_SIMD
+  if (cpu_supports_avx2())
+    func = _find_unsafe_avx2;
+  else if (cpu_supports_sse42())
+    func = _find_unsafe_sse42;
+#endif
+#if CPU_FEATURES_HAVE_NEON
+  func = _find_unsafe_neon;
+#endif
+
+  _find_unsafe = func;
+}
+
+/* the unsafe characters selected by unsafe_flags, backslash is used as a
+ * filler as that is always unsafe anyway */
+static inline void
+_get_unsafe_chars(guint32 unsafe_flags, gchar *unsafe1, gchar *unsafe2)
+{
+  *unsafe1 = (unsafe_flags & AUTF8_UNSAFE_QUOTE) ? '"' : '\\';
+  *unsafe2 = (unsafe_flags & AUTF8_UNSAFE_APOSTROPHE) ? '\'' : '\\';
+}
 
 static inline gboolean
 _is_character_unsafe(gunichar uchar, guint32 unsafe_flags)
@@ -164,10 +318,23 @@ _append_unsafe_utf8_as_escaped_with_specific_length(GString *escaped_output, con
                                                     const gchar *invalid_format)
 {
   const gchar *raw_end = raw + raw_len;
+  gchar unsafe1, unsafe2;
 
+  _get_unsafe_chars(unsafe_flags, &unsafe1, &unsafe2);
   while (raw < raw_end)
-    _append_escaped_utf8_character(escaped_output, &raw, raw_end - raw, unsafe_flags,
-                                   control_format, invalid_format);
+    {
+      gsize safe_len = _find_unsafe(raw, raw_end - raw, unsafe1, unsafe2);
+
+      if (safe_len > 0)
+        {
+          g_string_append_len(escaped_output, raw, safe_len);
+          raw += safe_len;
+          if (raw == raw_end)
+            break;
+        }
+      _append_escaped_utf8_character(escaped_output, &raw, raw_end - raw, unsafe_flags,
+                                     control_format, invalid_format);
+    }
 }
 
 static inline void
@@ -279,16 +446,30 @@ convert_unsafe_utf8_to_escaped_text(const gchar *str, gssize str_len,
   return g_string_free(escaped_string, FALSE);
 }
 
-/* this is not to be called on hot paths as it is relatively slow */
 gboolean
 unsafe_utf8_is_escaping_needed(const gchar *str, gssize str_len, guint32 unsafe_flags)
 {
   if (str_len < 0)
     str_len = strlen(str);
-  GString *escaped_string = g_string_sized_new(str_len);
 
-  append_unsafe_utf8_as_escaped_binary(escaped_string, str, str_len, unsafe_flags);
-  gboolean result = (str_len != escaped_string->len);
-  g_string_free(escaped_string, TRUE);
-  return result;
+  const gchar *end = str + str_len;
+  gchar unsafe1, unsafe2;
+
+  _get_unsafe_chars(unsafe_flags, &unsafe1, &unsafe2);
+  while (str < end)
+    {
+      str += _find_unsafe(str, end - str, unsafe1, unsafe2);
+      if (str == end)
+        break;
+
+      /* anything ASCII the kernel stopped at is escaped */
+      if ((guchar) *str < 0x80)
+        return TRUE;
+
+      gunichar uchar = g_utf8_get_char_validated(str, end - str);
+      if (uchar == (gunichar) -1 || uchar == (gunichar) -2)
+        return TRUE;
+      str = g_utf8_next_char(str);
+    }
+  return FALSE;
 }
@@ -46,6 +46,8 @@ void append_unsafe_utf8_as_escaped(GString *escaped_output, const gchar *raw,
 
 gboolean unsafe_utf8_is_escaping_needed(const gchar *str, gssize str_len, guint32 unsafe_flags);
 
+void utf8utils_global_init(void);
+
 /* for performance-critical use only */
 
 #define SANITIZE_UTF8_BUFFER_SIZE(l) (l * 6 + 1)
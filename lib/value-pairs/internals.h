@@ -27,6 +27,15 @@
 #include "syslog-ng.h"
 #include "atomic.h"
 
+typedef struct _VPPlanEntry VPPlanEntry;
+
+/* the selection plan caches the include decision and the transformed key
+ * for NVHandles below VP_PLAN_MAX_CHUNKS * VP_PLAN_CHUNK_SIZE, anything
+ * above is evaluated for each message */
+#define VP_PLAN_CHUNK_BITS 8
+#define VP_PLAN_CHUNK_SIZE (1 << VP_PLAN_CHUNK_BITS)
+#define VP_PLAN_MAX_CHUNKS 256
+
 struct _ValuePairs
 {
   GAtomicCounter ref_cnt;
@@ -46,6 +55,11 @@ struct _ValuePairs
    * strings to avoid leaking type information to callers */
   gboolean cast_to_strings;
   gboolean explicit_cast_to_strings;
+
+  /* lazily populated from the nvpairs foreach, indexed by NVHandle.
+   * Chunks and entries are published atomically as multiple threads may
+   * evaluate the same ValuePairs instance concurrently. */
+  VPPlanEntry **plan_chunks[VP_PLAN_MAX_CHUNKS];
 };
 
 
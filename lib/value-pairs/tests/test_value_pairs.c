@@ -509,6 +509,51 @@ Test(value_pairs, test_include_bytes_v3)
   value_pairs_unref(vp);
 }
 
+static GString *
+_format_keys(ValuePairs *vp, LogMessage *msg)
+{
+  GList *vp_keys_list = NULL;
+  gboolean test_key_found = FALSE;
+  gpointer args[] = { &vp_keys_list, &test_key_found };
+  GString *result = g_string_new("");
+
+  LogTemplateEvalOptions options = {&template_options, LTZ_LOCAL, 11, NULL, LM_VT_STRING};
+  value_pairs_foreach(vp, vp_keys_foreach, msg, &options, args);
+
+  g_list_foreach(vp_keys_list, (GFunc) cat_keys_foreach, result);
+  g_list_free_full(vp_keys_list, g_free);
+  return result;
+}
+
+Test(value_pairs, test_selection_plan_is_reused_and_extended_with_new_handles)
+{
+  ValuePairs *vp = value_pairs_new(configuration);
+  value_pairs_add_scope(vp, "nv-pairs");
+  value_pairs_add_glob_pattern(vp, "PID", FALSE);
+
+  ValuePairsTransformSet *vpts = value_pairs_transform_set_new("*");
+  value_pairs_transform_set_add_func(vpts, value_pairs_new_transform_add_prefix("_"));
+  value_pairs_add_transforms(vp, vpts);
+
+  LogMessage *msg = create_message();
+  GString *first = _format_keys(vp, msg);
+  GString *second = _format_keys(vp, msg);
+
+  cr_assert_str_eq(first->str, "_HOST,_MESSAGE,_MSGFORMAT,_MSGID,_PROGRAM");
+  cr_assert_str_eq(second->str, first->str);
+
+  /* a handle registered after the plan was populated */
+  log_msg_set_value_by_name(msg, "vp.plan.late", "value", -1);
+  GString *third = _format_keys(vp, msg);
+  cr_assert_str_eq(third->str, "_HOST,_MESSAGE,_MSGFORMAT,_MSGID,_PROGRAM,_vp.plan.late");
+
+  g_string_free(first, TRUE);
+  g_string_free(second, TRUE);
+  g_string_free(third, TRUE);
+  log_msg_unref(msg);
+  value_pairs_unref(vp);
+}
+
 void
 setup(void)
 {
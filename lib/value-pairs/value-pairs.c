@@ -260,6 +260,119 @@ vp_pairs_foreach(gpointer data, gpointer user_data)
   vp_results_insert(results, vp_transform_apply(vp, vpc->name), type, sb);
 }
 
+static gboolean
+vp_is_nvpair_included(ValuePairs *vp, NVHandle handle, const gchar *name)
+{
+  guint j;
+  gboolean inc;
+
+  inc = (name[0] == '.' && (vp->scopes & VPS_DOT_NV_PAIRS)) ||
+        (name[0] != '.' && (vp->scopes & VPS_NV_PAIRS)) ||
+        (log_msg_is_handle_sdata(handle) && (vp->scopes & (VPS_SDATA + VPS_RFC5424)));
+
+  for (j = 0; j < vp->patterns->len; j++)
+    {
+      VPPatternSpec *vps = (VPPatternSpec *) g_ptr_array_index(vp->patterns, j);
+      if (vp_pattern_spec_eval(vps, name))
+        inc = vps->include;
+    }
+  return inc;
+}
+
+/*
+ * Selection plan: the include decision and the transformed key only depend
+ * on the name of the nvpair and the configuration of the ValuePairs
+ * instance, so we calculate them once per NVHandle instead of once per
+ * message.
+ */
+struct _VPPlanEntry
+{
+  gboolean include;
+  gsize key_len;
+  gchar key[];
+};
+
+static VPPlanEntry *
+vp_plan_entry_new(ValuePairs *vp, NVHandle handle, const gchar *name)
+{
+  VPPlanEntry *self;
+  ScratchBuffersMarker mark;
+
+  if (!vp_is_nvpair_included(vp, handle, name))
+    {
+      self = g_malloc(sizeof(VPPlanEntry) + 1);
+      self->include = FALSE;
+      self->key_len = 0;
+      self->key[0] = 0;
+      return self;
+    }
+
+  scratch_buffers_mark(&mark);
+  GString *key = vp_transform_apply(vp, name);
+
+  self = g_malloc(sizeof(VPPlanEntry) + key->len + 1);
+  self->include = TRUE;
+  self->key_len = key->len;
+  memcpy(self->key, key->str, key->len + 1);
+  scratch_buffers_reclaim_marked(mark);
+  return self;
+}
+
+static VPPlanEntry *
+vp_plan_lookup(ValuePairs *vp, NVHandle handle, const gchar *name)
+{
+  guint chunk_ndx = handle >> VP_PLAN_CHUNK_BITS;
+  guint entry_ndx = handle & (VP_PLAN_CHUNK_SIZE - 1);
+
+  if (chunk_ndx >= VP_PLAN_MAX_CHUNKS)
+    return NULL;
+
+  VPPlanEntry **chunk = g_atomic_pointer_get(&vp->plan_chunks[chunk_ndx]);
+  if (!chunk)
+    {
+      VPPlanEntry **new_chunk = g_new0(VPPlanEntry *, VP_PLAN_CHUNK_SIZE);
+
+      if (g_atomic_pointer_compare_and_exchange(&vp->plan_chunks[chunk_ndx], NULL, new_chunk))
+        chunk = new_chunk;
+      else
+        {
+          g_free(new_chunk);
+          chunk = g_atomic_pointer_get(&vp->plan_chunks[chunk_ndx]);
+        }
+    }
+
+  VPPlanEntry *entry = g_atomic_pointer_get(&chunk[entry_ndx]);
+  if (entry)
+    return entry;
+
+  VPPlanEntry *new_entry = vp_plan_entry_new(vp, handle, name);
+  if (g_atomic_pointer_compare_and_exchange(&chunk[entry_ndx], NULL, new_entry))
+    return new_entry;
+
+  /* somebody else was faster, theirs is the same anyway */
+  g_free(new_entry);
+  return g_atomic_pointer_get(&chunk[entry_ndx]);
+}
+
+/* configuration changed, has to be called before the ValuePairs instance
+ * is used concurrently */
+static void
+vp_plan_clear(ValuePairs *vp)
+{
+  for (gint i = 0; i < VP_PLAN_MAX_CHUNKS; i++)
+    {
+      VPPlanEntry **chunk = vp->plan_chunks[i];
+
+      if (!chunk)
+        continue;
+
+      for (gint j = 0; j < VP_PLAN_CHUNK_SIZE; j++)
+        g_free(chunk[j]);
+      g_free(chunk);
+      vp->plan_chunks[i] = NULL;
+    }
+}
+
 /* runs over the LogMessage nv-pairs, and inserts them unless excluded */
 static gboolean
 vp_msg_nvpairs_foreach(NVHandle handle, const gchar *name,
@@ -268,9 +381,7 @@ vp_msg_nvpairs_foreach(NVHandle handle, const gchar *name,
 {
   ValuePairs *vp = ((gpointer *)user_data)[0];
   VPResults *results = ((gpointer *)user_data)[5];
-  guint j;
-  gboolean inc;
-  GString *sb;
+  GString *sb, *key;
 
   if (vp->omit_empty_values && value_len == 0)
     return FALSE;
@@ -278,19 +389,22 @@ vp_msg_nvpairs_foreach(NVHandle handle, const gchar *name,
   if ((type == LM_VT_BYTES || type == LM_VT_PROTOBUF) && !vp->include_bytes)
     return FALSE;
 
-  inc = (name[0] == '.' && (vp->scopes & VPS_DOT_NV_PAIRS)) ||
-        (name[0] != '.' && (vp->scopes & VPS_NV_PAIRS)) ||
-        (log_msg_is_handle_sdata(handle) && (vp->scopes & (VPS_SDATA + VPS_RFC5424)));
-
-  for (j = 0; j < vp->patterns->len; j++)
+  VPPlanEntry *plan = vp_plan_lookup(vp, handle, name);
+  if (plan)
     {
-      VPPatternSpec *vps = (VPPatternSpec *) g_ptr_array_index(vp->patterns, j);
-      if (vp_pattern_spec_eval(vps, name))
-        inc = vps->include;
+      if (!plan->include)
+        return FALSE;
+
+      key = scratch_buffers_alloc();
+      g_string_append_len(key, plan->key, plan->key_len);
     }
+  else
+    {
+      if (!vp_is_nvpair_included(vp, handle, name))
+        return FALSE;
 
-  if (!inc)
-    return FALSE;
+      key = vp_transform_apply(vp, name);
+    }
 
   sb = scratch_buffers_alloc();
 
@@ -299,7 +413,7 @@ vp_msg_nvpairs_foreach(NVHandle handle, const gchar *name,
   if (vp->cast_to_strings)
     type = LM_VT_STRING;
 
-  vp_results_insert(results, vp_transform_apply(vp, name), type, sb);
+  vp_results_insert(results, key, type, sb);
 
   return FALSE;
 }
@@ -910,12 +1024,14 @@ value_pairs_add_scope(ValuePairs *vp, const gchar *scope)
   if (strcmp(scope, "none") != 0)
     {
       result = cfg_process_flag(value_pair_scope, vp, scope);
+      vp_plan_clear(vp);
       vp_update_builtin_list_of_values(vp);
     }
   else
     {
       result = TRUE;
       vp->scopes = 0;
+      vp_plan_clear(vp);
       vp_update_builtin_list_of_values(vp);
     }
   return result;
@@ -926,6 +1042,7 @@ value_pairs_add_glob_pattern(ValuePairs *vp, const gchar *pattern,
                              gboolean include)
 {
   g_ptr_array_add(vp->patterns, vp_pattern_spec_new(pattern, include));
+  vp_plan_clear(vp);
   vp_update_builtin_list_of_values(vp);
 }
 
@@ -954,6 +1071,7 @@ void
 value_pairs_add_transforms(ValuePairs *vp, ValuePairsTransformSet *vpts)
 {
   g_ptr_array_add(vp->transforms, vpts);
+  vp_plan_clear(vp);
   vp_update_builtin_list_of_values(vp);
 }
 
@@ -1045,6 +1163,7 @@ value_pairs_free (ValuePairs *vp)
     }
   g_ptr_array_free(vp->transforms, TRUE);
   g_ptr_array_free(vp->builtins, TRUE);
+  vp_plan_clear(vp);
   g_free(vp);
 }
 
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "add-contextual-data-filter-index.h"
+#include "filter/filter-re.h"
+#include "filter/filter-cmp.h"
+#include "filter/filter-netmask.h"
+#include "str-utils.h"
+#include "messages.h"
+
+#include <string.h>
+
+/* hash table values are positions + 1, so that 0 (NULL) means "not found" */
+#define POSITION_TO_POINTER(pos) GUINT_TO_POINTER((pos) + 1)
+#define POINTER_TO_POSITION(p) (GPOINTER_TO_UINT(p) - 1)
+#define NO_MATCH G_MAXUINT
+
+typedef struct _ExactMatchGroup
+{
+  NVHandle value_handle;
+  gboolean ignore_case;
+  GHashTable *positions;
+} ExactMatchGroup;
+
+typedef struct _NetmaskGroup
+{
+  /* in host byte order */
+  guint32 netmask;
+  GHashTable *positions;
+} NetmaskGroup;
+
+struct _AddContextualDataFilterIndex
+{
+  GPtrArray *filters;
+  GPtrArray *names;
+  GArray *exact_match_groups;
+  GArray *netmask_groups;
+  /* positions of filters that can not be indexed, in ascending order */
+  GArray *fallback;
+};
+
+static guint
+_str_case_hash(gconstpointer value)
+{
+  const gchar *str = (const gchar *) value;
+  guint hash = 5381;
+  gint c;
+
+  while ((c = *str++))
+    hash = ((hash << 5) + hash) + ch_tolower(c);
+
+  return hash;
+}
+
+static gboolean
+_str_case_equal(gconstpointer a, gconstpointer b)
+{
+  return g_ascii_strcasecmp((const gchar *) a, (const gchar *) b) == 0;
+}
+
+static ExactMatchGroup *
+_lookup_exact_match_group(AddContextualDataFilterIndex *self, NVHandle value_handle, gboolean ignore_case)
+{
+  for (guint i = 0; i < self->exact_match_groups->len; i++)
+    {
+      ExactMatchGroup *group = &g_array_index(self->exact_match_groups, ExactMatchGroup, i);
+
+      if (group->value_handle == value_handle && group->ignore_case == ignore_case)
+        return group;
+    }
+
+  ExactMatchGroup new_group =
+  {
+    .value_handle = value_handle,
+    .ignore_case = ignore_case,
+    .positions = g_hash_table_new_full(ignore_case ? _str_case_hash : g_str_hash,
+                                       ignore_case ? _str_case_equal : g_str_equal,
+                                       g_free, NULL),
+  };
+  g_array_append_val(self->exact_match_groups, new_group);
+  return &g_array_index(self->exact_match_groups, ExactMatchGroup, self->exact_match_groups->len - 1);
+}
+
+static NetmaskGroup *
+_lookup_netmask_group(AddContextualDataFilterIndex *self, guint32 netmask)
+{
+  for (guint i = 0; i < self->netmask_groups->len; i++)
+    {
+      NetmaskGroup *group = &g_array_index(self->netmask_groups, NetmaskGroup, i);
+
+      if (group->netmask == netmask)
+        return group;
+    }
+
+  NetmaskGroup new_group =
+  {
+    .netmask = netmask,
+    .positions = g_hash_table_new(g_direct_hash, g_direct_equal),
+  };
+  g_array_append_val(self->netmask_groups, new_group);
+  return &g_array_index(self->netmask_groups, NetmaskGroup, self->netmask_groups->len - 1);
+}
+
+static gboolean
+_index_exact_match(AddContextualDataFilterIndex *self, FilterExprNode *filter, guint position)
+{
+  NVHandle value_handle;
+  gboolean ignore_case = FALSE;
+  const gchar *value;
+
+  value = filter_re_get_exact_match(filter, &value_handle, &ignore_case);
+  if (!value)
+    value = fop_cmp_get_exact_match(filter, &value_handle);
+  if (!value)
+    return FALSE;
+
+  ExactMatchGroup *group = _lookup_exact_match_group(self, value_handle, ignore_case);
+
+  /* an earlier filter with the same value always wins */
+  if (!g_hash_table_contains(group->positions, value))
+    g_hash_table_insert(group->positions, g_strdup(value), POSITION_TO_POINTER(position));
+  return TRUE;
+}
+
+static gboolean
+_index_netmask(AddContextualDataFilterIndex *self, FilterExprNode *filter, guint position)
+{
+  struct in_addr address, netmask;
+
+  if (!filter_netmask_get_network(filter, &address, &netmask))
+    return FALSE;
+
+  NetmaskGroup *group = _lookup_netmask_group(self, ntohl(netmask.s_addr));
+  gpointer network = GUINT_TO_POINTER(ntohl(address.s_addr));
+
+  if (!g_hash_table_contains(group->positions, network))
+    g_hash_table_insert(group->positions, network, POSITION_TO_POINTER(position));
+  return TRUE;
+}
+
+void
+add_contextual_data_filter_index_add(AddContextualDataFilterIndex *self, FilterExprNode *filter, const gchar *name)
+{
+  guint position = self->filters->len;
+
+  g_ptr_array_add(self->filters, filter);
+  g_ptr_array_add(self->names, (gpointer) name);
+
+  if (_index_exact_match(self, filter, position) || _index_netmask(self, filter, position))
+    {
+      msg_debug("Filter indexed", evt_tag_str("filter_name", name));
+      return;
+    }
+
+  g_array_append_val(self->fallback, position);
+}
+
+static guint
+_lookup_exact_matches(AddContextualDataFilterIndex *self, LogMessage *msg, guint best)
+{
+  for (guint i = 0; i < self->exact_match_groups->len; i++)
+    {
+      ExactMatchGroup *group = &g_array_index(self->exact_match_groups, ExactMatchGroup, i);
+      gssize value_len;
+      const gchar *value = log_msg_get_value(msg, group->value_handle, &value_len);
+
+      APPEND_ZERO(value, value, value_len);
+
+      gpointer p = g_hash_table_lookup(group->positions, value);
+      if (p)
+        best = MIN(best, POINTER_TO_POSITION(p));
+    }
+  return best;
+}
+
+static guint
+_lookup_netmasks(AddContextualDataFilterIndex *self, LogMessage *msg, guint best)
+{
+  struct in_addr addr_storage;
+
+  if (self->netmask_groups->len == 0)
+    return best;
+
+  struct in_addr *addr = filter_netmask_get_msg_address(msg, &addr_storage);
+  if (!addr)
+    return best;
+
+  guint32 host_addr = ntohl(addr->s_addr);
+  for (guint i = 0; i < self->netmask_groups->len; i++)
+    {
+      NetmaskGroup *group = &g_array_index(self->netmask_groups, NetmaskGroup, i);
+      gpointer p = g_hash_table_lookup(group->positions, GUINT_TO_POINTER(host_addr & group->netmask));
+
+      if (p)
+        best = MIN(best, POINTER_TO_POSITION(p));
+    }
+  return best;
+}
+
+const gchar *
+add_contextual_data_filter_index_lookup(AddContextualDataFilterIndex *self, LogMessage *msg)
+{
+  guint best = NO_MATCH;
+
+  best = _lookup_exact_matches(self, msg, best);
+  best = _lookup_netmasks(self, msg, best);
+
+  /* filters that could not be indexed only matter if they come earlier */
+  for (guint i = 0; i < self->fallback->len; i++)
+    {
+      guint position = g_array_index(self->fallback, guint, i);
+
+      if (position >= best)
+        break;
+
+      msg_debug("Evaluating filter", evt_tag_str("filter_name", g_ptr_array_index(self->names, position)));
+      if (filter_expr_eval(g_ptr_array_index(self->filters, position), msg))
+        {
+          best = position;
+          break;
+        }
+    }
+
+  if (best == NO_MATCH)
+    return NULL;
+  return g_ptr_array_index(self->names, best);
+}
+
+AddContextualDataFilterIndex *
+add_contextual_data_filter_index_new(void)
+{
+  AddContextualDataFilterIndex *self = g_new0(AddContextualDataFilterIndex, 1);
+
+  self->filters = g_ptr_array_new();
+  self->names = g_ptr_array_new();
+  self->exact_match_groups = g_array_new(FALSE, FALSE, sizeof(ExactMatchGroup));
+  self->netmask_groups = g_array_new(FALSE, FALSE, sizeof(NetmaskGroup));
+  self->fallback = g_array_new(FALSE, FALSE, sizeof(guint));
+  return self;
+}
+
+void
+add_contextual_data_filter_index_free(AddContextualDataFilterIndex *self)
+{
+  for (guint i = 0; i < self->exact_match_groups->len; i++)
+    g_hash_table_unref(g_array_index(self->exact_match_groups, ExactMatchGroup, i).positions);
+  for (guint i = 0; i < self->netmask_groups->len; i++)
+    g_hash_table_unref(g_array_index(self->netmask_groups, NetmaskGroup, i).positions);
+
+  g_ptr_array_free(self->filters, TRUE);
+  g_ptr_array_free(self->names, TRUE);
+  g_array_free(self->exact_match_groups, TRUE);
+  g_array_free(self->netmask_groups, TRUE);
+  g_array_free(self->fallback, TRUE);
+  g_free(self);
+}
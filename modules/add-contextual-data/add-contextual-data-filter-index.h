@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef ADD_CONTEXTUAL_DATA_FILTER_INDEX_H_INCLUDED
+#define ADD_CONTEXTUAL_DATA_FILTER_INDEX_H_INCLUDED
+
+#include "syslog-ng.h"
+#include "filter/filter-expr.h"
+#include "logmsg/logmsg.h"
+
+/*
+ * AddContextualDataFilterIndex returns the name of the first filter (in
+ * the order they were added) that matches a message.
+ *
+ * Filters that compare a name-value pair to a literal string (e.g.
+ * host("foo" type(string)) or "$PROGRAM" eq "bar") are grouped by the
+ * name-value pair and looked up in a hash table, netmask() filters are
+ * grouped by their netmask and looked up by the masked address.  Only the
+ * rest of the filters are evaluated one by one, and only those that come
+ * before the best indexed match.
+ */
+typedef struct _AddContextualDataFilterIndex AddContextualDataFilterIndex;
+
+void add_contextual_data_filter_index_add(AddContextualDataFilterIndex *self, FilterExprNode *filter,
+                                          const gchar *name);
+const gchar *add_contextual_data_filter_index_lookup(AddContextualDataFilterIndex *self, LogMessage *msg);
+
+AddContextualDataFilterIndex *add_contextual_data_filter_index_new(void);
+void add_contextual_data_filter_index_free(AddContextualDataFilterIndex *self);
+
+#endif
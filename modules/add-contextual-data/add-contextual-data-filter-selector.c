@@ -21,6 +21,7 @@
  */
 
 #include "add-contextual-data-filter-selector.h"
+#include "add-contextual-data-filter-index.h"
 #include "syslog-ng.h"
 #include "cfg.h"
 #include "messages.h"
@@ -32,6 +33,7 @@ typedef struct _FilterStore
 {
   GList *filters;
   GList *filter_names;
+  AddContextualDataFilterIndex *index;
 } FilterStore;
 
 typedef struct _AddContextualDataFilterSelector
@@ -53,17 +55,36 @@ _filter_store_new(void)
 static void
 _filter_store_free(FilterStore *self)
 {
+  if (self->index)
+    add_contextual_data_filter_index_free(self->index);
   g_list_free(self->filters);
   g_list_free(self->filter_names);
   g_free(self);
 }
 
+static void
+_filter_store_build_index(FilterStore *self)
+{
+  GList *filter_it, *name_it;
+
+  self->index = add_contextual_data_filter_index_new();
+  for (filter_it = self->filters, name_it = self->filter_names;
+       filter_it != NULL && name_it != NULL;
+       filter_it = filter_it->next, name_it = name_it->next)
+    {
+      add_contextual_data_filter_index_add(self->index, (FilterExprNode *) filter_it->data,
+                                           (const gchar *) name_it->data);
+    }
+}
+
 FilterStore *
 _filter_store_clone(FilterStore *self)
 {
   FilterStore *cloned = _filter_store_new();
   cloned->filters = g_list_copy(self->filters);
   cloned->filter_names = g_list_copy(self->filter_names);
+  if (self->index)
+    _filter_store_build_index(cloned);
   return cloned;
 }
 
@@ -77,24 +98,10 @@ _filter_store_prepend(FilterStore *self, gchar *name, FilterExprNode *filter)
 static const gchar *
 _filter_store_get_first_matching_name(FilterStore *self, LogMessage *msg)
 {
-  GList *filter_it, *name_it;
-  FilterExprNode *filter;
-  const gchar *name = NULL;
-
-  for (filter_it = self->filters, name_it = self->filter_names;
-       filter_it != NULL && name_it != NULL;
-       filter_it = filter_it->next, name_it = name_it->next)
-    {
-      filter = (FilterExprNode *) filter_it->data;
-      msg_debug("Evaluating filter", evt_tag_str("filter_name", name_it->data));
-      if (filter_expr_eval(filter, msg))
-        {
-          name = (const gchar *) name_it->data;
-          break;
-        }
-    }
+  if (!self->index)
+    return NULL;
 
-  return name;
+  return add_contextual_data_filter_index_lookup(self->index, msg);
 }
 
 static gboolean
@@ -192,6 +199,7 @@ _init(AddContextualDataSelector *s, GList *ordered_selectors)
     return FALSE;
 
   self->filter_store = _filter_store_order_by_selectors(self->filter_store, ordered_selectors);
+  _filter_store_build_index(self->filter_store);
 
   return TRUE;
 }
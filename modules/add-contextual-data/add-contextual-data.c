@@ -30,6 +30,7 @@
 #include "add-contextual-data-selector.h"
 #include "template/templates.h"
 #include "context-info-db.h"
+#include "context-info-db-file.h"
 #include "pathutils.h"
 #include "scratch-buffers.h"
 
@@ -100,6 +101,14 @@ static void
 _add_context_data_to_message(gpointer pmsg, const ContextualDataRecord *record)
 {
   LogMessage *msg = (LogMessage *) pmsg;
+
+  if (!record->value)
+    {
+      log_msg_set_value_with_type(msg, record->value_handle, record->literal_value, record->literal_value_len,
+                                  LM_VT_STRING);
+      return;
+    }
+
   GString *result = scratch_buffers_alloc();
   LogMessageValueType type;
 
@@ -190,26 +199,31 @@ _complete_relative_path_with_config_path(const gchar *filename)
                      filename, NULL);
 }
 
+static gchar *
+_resolve_data_file_path(const gchar *filename)
+{
+  if (_is_relative_path(filename))
+    return _complete_relative_path_with_config_path(filename);
+
+  return g_strdup(filename);
+}
+
 static FILE *
 _open_data_file(const gchar *filename)
 {
-  FILE *f = NULL;
-
-  if (_is_relative_path(filename))
-    {
-      gchar *absolute_path =
-        _complete_relative_path_with_config_path(filename);
-      f = fopen(absolute_path, "r");
-      g_free(absolute_path);
-    }
-  else
-    {
-      f = fopen(filename, "r");
-    }
+  gchar *path = _resolve_data_file_path(filename);
+  FILE *f = fopen(path, "r");
 
+  g_free(path);
   return f;
 }
 
+static gboolean
+_is_compiled_database(AddContextualData *self)
+{
+  return g_strcmp0(get_filename_extension(self->filename), CONTEXT_INFO_DB_FILE_EXTENSION) == 0;
+}
+
 static ContextualDataRecordScanner *
 _get_scanner(AddContextualData *self)
 {
@@ -217,7 +231,8 @@ _get_scanner(AddContextualData *self)
 
   if (g_strcmp0(type, "csv") != 0)
     {
-      msg_error("add-contextual-data(): unknown file extension, only files with a .csv extension are supported",
+      msg_error("add-contextual-data(): unknown file extension, only files with a .csv or ."
+                CONTEXT_INFO_DB_FILE_EXTENSION " extension are supported",
                 evt_tag_str("filename", self->filename));
       return NULL;
     }
@@ -225,6 +240,17 @@ _get_scanner(AddContextualData *self)
   return contextual_data_record_scanner_new(log_pipe_get_config(&self->super.super), self->prefix);
 }
 
+static gboolean
+_load_compiled_context_info_db(AddContextualData *self)
+{
+  gchar *path = _resolve_data_file_path(self->filename);
+  gboolean result = context_info_db_load_compiled(self->context_info_db, path,
+                                                  log_pipe_get_config(&self->super.super), self->prefix);
+
+  g_free(path);
+  return result;
+}
+
 static gboolean
 _load_context_info_db(AddContextualData *self)
 {
@@ -232,6 +258,9 @@ _load_context_info_db(AddContextualData *self)
   FILE *f = NULL;
   gboolean result = FALSE;
 
+  if (_is_compiled_database(self))
+    return _load_compiled_context_info_db(self);
+
   if (!(scanner = _get_scanner(self)))
     goto error;
 
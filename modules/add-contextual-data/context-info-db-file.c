@@ -0,0 +1,374 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "context-info-db-file.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* open files, keyed by filename, an entry is removed when the last
+ * reference to the file is dropped */
+static GHashTable *context_info_db_files;
+static GMutex context_info_db_files_lock;
+
+/* lookup */
+
+typedef gint (*ContextInfoDBFileCmp)(const gchar *s1, const gchar *s2);
+
+/* returns the first position in [0, num_selectors) whose selector is not
+ * less than the key */
+static guint32
+_lower_bound(const ContextInfoDBFile *self, const gchar *key, gboolean ignore_case, ContextInfoDBFileCmp cmp)
+{
+  guint32 lo = 0;
+  guint32 hi = self->header->num_selectors;
+
+  while (lo < hi)
+    {
+      guint32 mid = lo + (hi - lo) / 2;
+      const gchar *selector = context_info_db_file_get_selector(self,
+                                                                context_info_db_file_selector_at(self, mid, ignore_case));
+
+      if (cmp(selector, key) < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  return lo;
+}
+
+/* Looks up the selector and returns the [first, last) range of positions
+ * that match it.  Without ignore_case there is at most one, with
+ * ignore_case selectors that only differ in case are adjacent in the
+ * casefold order. */
+gboolean
+context_info_db_file_lookup(const ContextInfoDBFile *self, const gchar *selector, gboolean ignore_case,
+                            guint32 *first, guint32 *last)
+{
+  ContextInfoDBFileCmp cmp = ignore_case ? g_ascii_strcasecmp : strcmp;
+  guint32 num_selectors = self->header->num_selectors;
+  guint32 pos = _lower_bound(self, selector, ignore_case, cmp);
+  guint32 end = pos;
+
+  while (end < num_selectors &&
+         cmp(context_info_db_file_get_selector(self, context_info_db_file_selector_at(self, end, ignore_case)),
+             selector) == 0)
+    end++;
+
+  *first = pos;
+  *last = end;
+  return pos != end;
+}
+
+/* records are grouped by selector, in the order of the selectors */
+gint64
+context_info_db_file_find_selector_of_record(const ContextInfoDBFile *self, guint32 record_ndx)
+{
+  guint32 lo = 0;
+  guint32 hi = self->header->num_selectors;
+
+  while (lo < hi)
+    {
+      guint32 mid = lo + (hi - lo) / 2;
+
+      if (self->selectors[mid].first_record <= record_ndx)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  if (lo == 0)
+    return -1;
+  return lo - 1;
+}
+
+/* mapping */
+
+static gboolean
+_section_is_valid(const ContextInfoDBFile *self, guint64 offset, guint64 count, gsize entry_size)
+{
+  if (offset % CONTEXT_INFO_DB_FILE_ALIGNMENT != 0 || offset > self->map_size)
+    return FALSE;
+  return count <= (self->map_size - offset) / entry_size;
+}
+
+static gboolean
+_setup_sections(ContextInfoDBFile *self)
+{
+  const ContextInfoDBFileHeader *header = (const ContextInfoDBFileHeader *) self->map;
+
+  if (self->map_size < sizeof(*header) ||
+      memcmp(header->magic, CONTEXT_INFO_DB_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != CONTEXT_INFO_DB_FILE_VERSION ||
+      header->byte_order != CONTEXT_INFO_DB_FILE_BYTE_ORDER)
+    return FALSE;
+
+  self->header = header;
+  if (!_section_is_valid(self, header->selectors_offset, header->num_selectors, sizeof(ContextInfoDBFileSelector)) ||
+      !_section_is_valid(self, header->casefold_order_offset, header->num_selectors, sizeof(guint32)) ||
+      !_section_is_valid(self, header->load_order_offset, header->num_selectors, sizeof(guint32)) ||
+      !_section_is_valid(self, header->records_offset, header->num_records, sizeof(ContextInfoDBFileRecord)) ||
+      !_section_is_valid(self, header->names_offset, header->num_names, sizeof(ContextInfoDBFileString)) ||
+      !_section_is_valid(self, header->templates_offset, header->num_templates, sizeof(guint32)) ||
+      !_section_is_valid(self, header->pool_offset, header->pool_size, 1))
+    return FALSE;
+
+  self->selectors = (const ContextInfoDBFileSelector *) (self->map + header->selectors_offset);
+  self->casefold_order = (const guint32 *) (self->map + header->casefold_order_offset);
+  self->load_order = (const guint32 *) (self->map + header->load_order_offset);
+  self->records = (const ContextInfoDBFileRecord *) (self->map + header->records_offset);
+  self->names = (const ContextInfoDBFileString *) (self->map + header->names_offset);
+  self->templates = (const guint32 *) (self->map + header->templates_offset);
+  self->pool = (const gchar *) (self->map + header->pool_offset);
+
+  return TRUE;
+}
+
+static gboolean
+_string_is_valid(const ContextInfoDBFile *self, ContextInfoDBFileString str)
+{
+  return (guint64) str.offset + str.len < self->header->pool_size && self->pool[str.offset + str.len] == '\0';
+}
+
+/* every entry of @order is a selector index and each of them occurs once */
+static gboolean
+_order_is_valid(const ContextInfoDBFile *self, const guint32 *order, guint8 *seen)
+{
+  guint32 num_selectors = self->header->num_selectors;
+
+  memset(seen, 0, num_selectors);
+  for (guint32 i = 0; i < num_selectors; i++)
+    {
+      if (order[i] >= num_selectors || seen[order[i]])
+        return FALSE;
+      seen[order[i]] = 1;
+    }
+  return TRUE;
+}
+
+static gboolean
+_selectors_are_valid(const ContextInfoDBFile *self)
+{
+  guint32 next_record = 0;
+
+  for (guint32 i = 0; i < self->header->num_selectors; i++)
+    {
+      const ContextInfoDBFileSelector *selector = &self->selectors[i];
+
+      if (!_string_is_valid(self, selector->selector) ||
+          selector->first_record != next_record ||
+          selector->num_records > self->header->num_records - next_record)
+        return FALSE;
+
+      /* lookups are binary searches */
+      if (i > 0 &&
+          strcmp(context_info_db_file_get_selector(self, i - 1), context_info_db_file_get_selector(self, i)) >= 0)
+        return FALSE;
+
+      next_record += selector->num_records;
+    }
+
+  /* every record belongs to a selector */
+  if (next_record != self->header->num_records)
+    return FALSE;
+
+  if (self->header->num_selectors == 0)
+    return TRUE;
+
+  guint8 *seen = g_new(guint8, self->header->num_selectors);
+  gboolean valid = _order_is_valid(self, self->casefold_order, seen) && _order_is_valid(self, self->load_order, seen);
+  g_free(seen);
+  return valid;
+}
+
+static gboolean
+_records_are_valid(const ContextInfoDBFile *self)
+{
+  const ContextInfoDBFileHeader *header = self->header;
+
+  for (guint32 i = 0; i < header->num_names; i++)
+    {
+      if (!_string_is_valid(self, self->names[i]))
+        return FALSE;
+    }
+
+  for (guint32 i = 0; i < header->num_records; i++)
+    {
+      const ContextInfoDBFileRecord *record = &self->records[i];
+
+      if (record->name >= header->num_names || !_string_is_valid(self, record->value))
+        return FALSE;
+      if (record->template != CONTEXT_INFO_DB_FILE_NO_TEMPLATE &&
+          (record->template >= header->num_templates || self->templates[record->template] != i))
+        return FALSE;
+    }
+
+  for (guint32 i = 0; i < header->num_templates; i++)
+    {
+      if (self->templates[i] >= header->num_records || self->records[self->templates[i]].template != i)
+        return FALSE;
+    }
+  return TRUE;
+}
+
+/*
+ * Every index and string reference is checked when the file is opened, so
+ * the accessors in context-info-db-file.h can use them as they are.  This
+ * is a single pass over the file, which is still much cheaper than parsing
+ * the CSV it was compiled from.
+ */
+static gboolean
+_contents_are_valid(const ContextInfoDBFile *self)
+{
+  return _selectors_are_valid(self) && _records_are_valid(self);
+}
+
+static void
+_free(ContextInfoDBFile *self)
+{
+  if (context_info_db_files && g_hash_table_lookup(context_info_db_files, self->filename) == self)
+    g_hash_table_remove(context_info_db_files, self->filename);
+
+  munmap((gpointer) self->map, self->map_size);
+  g_free(self->filename);
+  g_free(self);
+}
+
+static ContextInfoDBFile *
+_map_file(const gchar *filename, gint fd, struct stat *st, GError **error)
+{
+  if (st->st_size < (off_t) sizeof(ContextInfoDBFileHeader))
+    {
+      g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s: file too short for a compiled database", filename);
+      return NULL;
+    }
+
+  gpointer map = mmap(NULL, st->st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED)
+    {
+      gint errsv = errno;
+      g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errsv), "%s: error mapping file: %s",
+                  filename, g_strerror(errsv));
+      return NULL;
+    }
+
+  /* lookups are binary searches, readahead would only pull in pages we
+   * never touch */
+  madvise(map, st->st_size, MADV_RANDOM);
+
+  ContextInfoDBFile *self = g_new0(ContextInfoDBFile, 1);
+  g_atomic_counter_set(&self->ref_cnt, 1);
+  self->filename = g_strdup(filename);
+  self->dev = st->st_dev;
+  self->ino = st->st_ino;
+  self->mtime = st->st_mtime;
+  self->map = map;
+  self->map_size = st->st_size;
+
+  if (!_setup_sections(self) || !_contents_are_valid(self))
+    {
+      g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                  "%s: not a compiled add-contextual-data() database or it is corrupt, recompile it with ctxdbtool",
+                  filename);
+      _free(self);
+      return NULL;
+    }
+  return self;
+}
+
+static gboolean
+_is_same_file(ContextInfoDBFile *self, struct stat *st)
+{
+  return self->dev == st->st_dev && self->ino == st->st_ino &&
+         self->mtime == st->st_mtime && self->map_size == (gsize) st->st_size;
+}
+
+ContextInfoDBFile *
+context_info_db_file_open(const gchar *filename, GError **error)
+{
+  ContextInfoDBFile *self = NULL;
+  struct stat st;
+
+  gint fd = open(filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0 || fstat(fd, &st) < 0)
+    {
+      gint errsv = errno;
+      g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errsv), "%s: %s", filename, g_strerror(errsv));
+      if (fd >= 0)
+        close(fd);
+      return NULL;
+    }
+
+  g_mutex_lock(&context_info_db_files_lock);
+  if (!context_info_db_files)
+    context_info_db_files = g_hash_table_new(g_str_hash, g_str_equal);
+
+  ContextInfoDBFile *existing = g_hash_table_lookup(context_info_db_files, filename);
+  if (existing && _is_same_file(existing, &st))
+    {
+      self = context_info_db_file_ref(existing);
+    }
+  else
+    {
+      self = _map_file(filename, fd, &st, error);
+
+      /* the previous version stays mapped until its users are gone, it
+       * is just not shared anymore */
+      if (self)
+        g_hash_table_replace(context_info_db_files, self->filename, self);
+    }
+  g_mutex_unlock(&context_info_db_files_lock);
+
+  close(fd);
+  return self;
+}
+
+ContextInfoDBFile *
+context_info_db_file_ref(ContextInfoDBFile *self)
+{
+  if (self)
+    {
+      g_assert(g_atomic_counter_get(&self->ref_cnt) > 0);
+      g_atomic_counter_inc(&self->ref_cnt);
+    }
+  return self;
+}
+
+void
+context_info_db_file_unref(ContextInfoDBFile *self)
+{
+  if (!self)
+    return;
+
+  g_assert(g_atomic_counter_get(&self->ref_cnt));
+
+  /* the registry lock is held while dropping the reference, so that
+   * open() can not pick up a file that is being freed */
+  g_mutex_lock(&context_info_db_files_lock);
+  if (g_atomic_counter_dec_and_test(&self->ref_cnt))
+    _free(self);
+  g_mutex_unlock(&context_info_db_files_lock);
+}
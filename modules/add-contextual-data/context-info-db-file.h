@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef CONTEXT_INFO_DB_FILE_H_INCLUDED
+#define CONTEXT_INFO_DB_FILE_H_INCLUDED
+
+#include "syslog-ng.h"
+#include "atomic.h"
+
+#include <sys/types.h>
+
+/*
+ * On-disk format of compiled add-contextual-data() databases.
+ *
+ * The file is produced by ctxdbtool from a CSV file and is mapped
+ * read-only by the parser, records are looked up directly from the
+ * mapping, without importing them first.  All integers are in host byte
+ * order, the byte_order field of the header is used to detect a file
+ * produced on a host with a different one.
+ *
+ * The file consists of the header and the following sections, each
+ * aligned to 8 bytes:
+ *
+ *   - selectors: ContextInfoDBFileSelector entries, sorted by the
+ *     selector (strcmp() order), each refers to the range of records
+ *     that belong to the selector
+ *
+ *   - casefold order: selector indices sorted by g_ascii_strcasecmp(),
+ *     used when ignore-case(yes) is in effect
+ *
+ *   - load order: selector indices in the order of their first
+ *     appearance in the CSV file
+ *
+ *   - records: ContextInfoDBFileRecord entries, grouped by selector, in
+ *     the order of the CSV file within a group
+ *
+ *   - names: ContextInfoDBFileString entries, the names of the name-value
+ *     pairs to be set, without the prefix() of the parser
+ *
+ *   - templates: record indices of values that need to be compiled as a
+ *     template, every other value is a literal string
+ *
+ *   - string pool: NUL terminated strings referenced by the sections
+ *     above
+ */
+
+#define CONTEXT_INFO_DB_FILE_MAGIC "SNGCTXDB"
+#define CONTEXT_INFO_DB_FILE_VERSION 1
+#define CONTEXT_INFO_DB_FILE_BYTE_ORDER 0x01020304
+#define CONTEXT_INFO_DB_FILE_ALIGNMENT 8
+#define CONTEXT_INFO_DB_FILE_EXTENSION "ctxdb"
+
+#define CONTEXT_INFO_DB_FILE_NO_TEMPLATE G_MAXUINT32
+
+typedef struct _ContextInfoDBFileString
+{
+  guint32 offset;
+  guint32 len;
+} ContextInfoDBFileString;
+
+typedef struct _ContextInfoDBFileSelector
+{
+  ContextInfoDBFileString selector;
+  guint32 first_record;
+  guint32 num_records;
+} ContextInfoDBFileSelector;
+
+typedef struct _ContextInfoDBFileRecord
+{
+  guint32 name;
+  /* index into the templates section or CONTEXT_INFO_DB_FILE_NO_TEMPLATE */
+  guint32 template;
+  ContextInfoDBFileString value;
+} ContextInfoDBFileRecord;
+
+typedef struct _ContextInfoDBFileHeader
+{
+  gchar magic[8];
+  guint32 version;
+  guint32 byte_order;
+
+  guint32 num_selectors;
+  guint32 num_records;
+  guint32 num_names;
+  guint32 num_templates;
+
+  guint64 selectors_offset;
+  guint64 casefold_order_offset;
+  guint64 load_order_offset;
+  guint64 records_offset;
+  guint64 names_offset;
+  guint64 templates_offset;
+  guint64 pool_offset;
+  guint64 pool_size;
+} ContextInfoDBFileHeader;
+
+/*
+ * ContextInfoDBFile is a read-only mapping of a compiled database.  Files
+ * are shared: opening the same, unchanged file again returns the existing
+ * mapping, so all parser instances (and the configurations before and
+ * after a reload) use the same pages.
+ */
+typedef struct _ContextInfoDBFile
+{
+  GAtomicCounter ref_cnt;
+  gchar *filename;
+  dev_t dev;
+  ino_t ino;
+  time_t mtime;
+
+  const guint8 *map;
+  gsize map_size;
+  const ContextInfoDBFileHeader *header;
+  const ContextInfoDBFileSelector *selectors;
+  const guint32 *casefold_order;
+  const guint32 *load_order;
+  const ContextInfoDBFileRecord *records;
+  const ContextInfoDBFileString *names;
+  const guint32 *templates;
+  const gchar *pool;
+} ContextInfoDBFile;
+
+/*
+ * The accessors below do not check their arguments against the file:
+ * context_info_db_file_open() rejects files with any reference pointing
+ * outside of its section, so indices taken from the file itself are always
+ * valid.  Indices coming from elsewhere must be checked by the caller.
+ */
+
+static inline const gchar *
+context_info_db_file_get_string(const ContextInfoDBFile *self, ContextInfoDBFileString str)
+{
+  return self->pool + str.offset;
+}
+
+static inline const gchar *
+context_info_db_file_get_selector(const ContextInfoDBFile *self, guint32 selector_ndx)
+{
+  g_assert(selector_ndx < self->header->num_selectors);
+  return context_info_db_file_get_string(self, self->selectors[selector_ndx].selector);
+}
+
+/* the [first, last) range of records of a selector */
+static inline void
+context_info_db_file_get_record_range(const ContextInfoDBFile *self, guint32 selector_ndx,
+                                      guint32 *first, guint32 *last)
+{
+  g_assert(selector_ndx < self->header->num_selectors);
+
+  const ContextInfoDBFileSelector *selector = &self->selectors[selector_ndx];
+
+  *first = selector->first_record;
+  *last = selector->first_record + selector->num_records;
+}
+
+/* maps a position returned by context_info_db_file_lookup() to a selector index */
+static inline guint32
+context_info_db_file_selector_at(const ContextInfoDBFile *self, guint32 pos, gboolean ignore_case)
+{
+  g_assert(pos < self->header->num_selectors);
+  return ignore_case ? self->casefold_order[pos] : pos;
+}
+
+gboolean context_info_db_file_lookup(const ContextInfoDBFile *self, const gchar *selector, gboolean ignore_case,
+                                     guint32 *first, guint32 *last);
+gint64 context_info_db_file_find_selector_of_record(const ContextInfoDBFile *self, guint32 record_ndx);
+
+ContextInfoDBFile *context_info_db_file_open(const gchar *filename, GError **error);
+ContextInfoDBFile *context_info_db_file_ref(ContextInfoDBFile *self);
+void context_info_db_file_unref(ContextInfoDBFile *self);
+
+#endif
@@ -0,0 +1,474 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "context-info-db-writer.h"
+#include "context-info-db-file.h"
+#include "scanner/csv-scanner/csv-scanner.h"
+#include "messages.h"
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+typedef struct _ContextInfoDBPendingRecord
+{
+  ContextInfoDBFileString selector;
+  guint32 name;
+  ContextInfoDBFileString value;
+  guint32 seq;
+} ContextInfoDBPendingRecord;
+
+struct _ContextInfoDBWriter
+{
+  GString *pool;
+  GArray *records;
+  GArray *names;
+  GHashTable *name_index;
+  gboolean pool_overflow;
+};
+
+static ContextInfoDBFileString
+_pool_add(GString *pool, const gchar *str, gboolean *overflow)
+{
+  gsize len = strlen(str);
+  ContextInfoDBFileString result = { .offset = pool->len, .len = len };
+
+  if (pool->len + len + 1 > G_MAXUINT32)
+    *overflow = TRUE;
+
+  /* strings are stored with their NUL terminator */
+  g_string_append_len(pool, str, len + 1);
+  return result;
+}
+
+static inline const gchar *
+_pool_get(GString *pool, ContextInfoDBFileString str)
+{
+  return pool->str + str.offset;
+}
+
+void
+context_info_db_writer_add(ContextInfoDBWriter *self, const gchar *selector, const gchar *name, const gchar *value)
+{
+  guint32 name_ndx = GPOINTER_TO_UINT(g_hash_table_lookup(self->name_index, name));
+
+  if (!name_ndx)
+    {
+      ContextInfoDBFileString name_str = _pool_add(self->pool, name, &self->pool_overflow);
+
+      g_array_append_val(self->names, name_str);
+      name_ndx = self->names->len;
+      g_hash_table_insert(self->name_index, g_strdup(name), GUINT_TO_POINTER(name_ndx));
+    }
+
+  ContextInfoDBPendingRecord record =
+  {
+    .selector = _pool_add(self->pool, selector, &self->pool_overflow),
+    .name = name_ndx - 1,
+    .value = _pool_add(self->pool, value, &self->pool_overflow),
+    .seq = self->records->len,
+  };
+  g_array_append_val(self->records, record);
+}
+
+/* CSV import, uses the same dialect as the parser */
+
+static void
+_truncate_eol(gchar *line, gsize line_len)
+{
+  if (line_len >= 2 && line[line_len - 2] == '\r' && line[line_len - 1] == '\n')
+    line[line_len - 2] = '\0';
+  else if (line_len >= 1 && line[line_len - 1] == '\n')
+    line[line_len - 1] = '\0';
+}
+
+static gboolean
+_scan_columns(CSVScannerOptions *options, const gchar *line, gchar *columns[3])
+{
+  CSVScanner scanner;
+  gboolean result = FALSE;
+  gint i;
+
+  csv_scanner_init(&scanner, options, line);
+  csv_scanner_set_expected_columns(&scanner, 3);
+
+  for (i = 0; i < 3; i++)
+    {
+      if (!csv_scanner_scan_next(&scanner))
+        goto exit;
+      columns[i] = g_strdup(csv_scanner_get_current_value(&scanner));
+    }
+
+  result = !csv_scanner_scan_next(&scanner) && csv_scanner_is_scan_complete(&scanner);
+
+exit:
+  if (!result)
+    {
+      for (gint j = 0; j < i; j++)
+        g_free(columns[j]);
+    }
+  csv_scanner_deinit(&scanner);
+  return result;
+}
+
+gboolean
+context_info_db_writer_import_csv(ContextInfoDBWriter *self, FILE *fp, const gchar *filename)
+{
+  CSVScannerOptions options = {0};
+  gchar *line_buf = NULL;
+  size_t line_buf_len = 0;
+  gssize n;
+  gint lineno = 0;
+  gboolean result = TRUE;
+
+  csv_scanner_options_set_delimiters(&options, ",");
+  csv_scanner_options_set_quote_pairs(&options, "\"\"''");
+  csv_scanner_options_set_flags(&options, CSV_SCANNER_STRIP_WHITESPACE);
+  csv_scanner_options_set_dialect(&options, CSV_SCANNER_ESCAPE_DOUBLE_CHAR);
+
+  while ((n = getline(&line_buf, &line_buf_len, fp)) != -1)
+    {
+      gchar *columns[3];
+
+      lineno++;
+      _truncate_eol(line_buf, n);
+      if (line_buf[0] == '\0')
+        continue;
+
+      if (!_scan_columns(&options, line_buf, columns))
+        {
+          msg_error("add-contextual-data(): error parsing CSV file, expecting (selector, name, value) triplets",
+                    evt_tag_str("input", line_buf),
+                    evt_tag_printf("filename", "%s:%d", filename, lineno));
+          result = FALSE;
+          break;
+        }
+
+      context_info_db_writer_add(self, columns[0], columns[1], columns[2]);
+      for (gint i = 0; i < 3; i++)
+        g_free(columns[i]);
+    }
+
+  g_free(line_buf);
+  csv_scanner_options_clean(&options);
+  return result;
+}
+
+/* compiling */
+
+static gint
+_pending_record_cmp(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  const ContextInfoDBPendingRecord *r1 = (const ContextInfoDBPendingRecord *) a;
+  const ContextInfoDBPendingRecord *r2 = (const ContextInfoDBPendingRecord *) b;
+  GString *pool = (GString *) user_data;
+
+  gint result = strcmp(_pool_get(pool, r1->selector), _pool_get(pool, r2->selector));
+  if (result)
+    return result;
+
+  /* keep the order of the CSV file within a selector */
+  return r1->seq < r2->seq ? -1 : r1->seq > r2->seq;
+}
+
+typedef struct _ContextInfoDBCompiled
+{
+  GString *pool;
+  GArray *selectors;
+  GArray *casefold_order;
+  GArray *load_order;
+  GArray *records;
+  GArray *names;
+  GArray *templates;
+  GArray *first_seen;
+} ContextInfoDBCompiled;
+
+static gint
+_casefold_order_cmp(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  ContextInfoDBCompiled *compiled = (ContextInfoDBCompiled *) user_data;
+  guint32 ndx1 = *(const guint32 *) a;
+  guint32 ndx2 = *(const guint32 *) b;
+  ContextInfoDBFileSelector *s1 = &g_array_index(compiled->selectors, ContextInfoDBFileSelector, ndx1);
+  ContextInfoDBFileSelector *s2 = &g_array_index(compiled->selectors, ContextInfoDBFileSelector, ndx2);
+
+  gint result = g_ascii_strcasecmp(_pool_get(compiled->pool, s1->selector), _pool_get(compiled->pool, s2->selector));
+  if (result)
+    return result;
+
+  /* selectors that only differ in case are visited in the order of the CSV file */
+  guint32 seq1 = g_array_index(compiled->first_seen, guint32, ndx1);
+  guint32 seq2 = g_array_index(compiled->first_seen, guint32, ndx2);
+  return seq1 < seq2 ? -1 : seq1 > seq2;
+}
+
+static gint
+_load_order_cmp(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  GArray *first_seen = (GArray *) user_data;
+  guint32 seq1 = g_array_index(first_seen, guint32, *(const guint32 *) a);
+  guint32 seq2 = g_array_index(first_seen, guint32, *(const guint32 *) b);
+
+  return seq1 < seq2 ? -1 : seq1 > seq2;
+}
+
+/* values that are surely literal strings regardless of the config
+ * version, everything else is compiled as a template when loaded */
+static gboolean
+_value_needs_template(const gchar *value)
+{
+  return value[0] == '\0' || strpbrk(value, "$\\(") != NULL;
+}
+
+static void
+_compile(ContextInfoDBWriter *self, ContextInfoDBCompiled *compiled)
+{
+  gboolean overflow = FALSE;
+
+  g_array_sort_with_data(self->records, _pending_record_cmp, self->pool);
+
+  compiled->pool = g_string_sized_new(self->pool->len);
+  compiled->selectors = g_array_new(FALSE, FALSE, sizeof(ContextInfoDBFileSelector));
+  compiled->records = g_array_sized_new(FALSE, FALSE, sizeof(ContextInfoDBFileRecord), self->records->len);
+  compiled->names = g_array_sized_new(FALSE, FALSE, sizeof(ContextInfoDBFileString), self->names->len);
+  compiled->templates = g_array_new(FALSE, FALSE, sizeof(guint32));
+  compiled->first_seen = g_array_new(FALSE, FALSE, sizeof(guint32));
+
+  for (guint i = 0; i < self->names->len; i++)
+    {
+      ContextInfoDBFileString name = g_array_index(self->names, ContextInfoDBFileString, i);
+      ContextInfoDBFileString copy = _pool_add(compiled->pool, _pool_get(self->pool, name), &overflow);
+
+      g_array_append_val(compiled->names, copy);
+    }
+
+  /* the selector is followed by its values in the string pool, so a
+   * lookup touches as few pages of the mapping as possible */
+  for (guint32 i = 0; i < self->records->len; i++)
+    {
+      ContextInfoDBPendingRecord *pending = &g_array_index(self->records, ContextInfoDBPendingRecord, i);
+      const gchar *selector = _pool_get(self->pool, pending->selector);
+
+      if (i == 0 ||
+          strcmp(selector, _pool_get(self->pool,
+                                     g_array_index(self->records, ContextInfoDBPendingRecord, i - 1).selector)) != 0)
+        {
+          ContextInfoDBFileSelector new_selector =
+          {
+            .selector = _pool_add(compiled->pool, selector, &overflow),
+            .first_record = i,
+            .num_records = 0,
+          };
+          g_array_append_val(compiled->selectors, new_selector);
+          g_array_append_val(compiled->first_seen, pending->seq);
+        }
+      g_array_index(compiled->selectors, ContextInfoDBFileSelector, compiled->selectors->len - 1).num_records++;
+
+      const gchar *value = _pool_get(self->pool, pending->value);
+      ContextInfoDBFileRecord record =
+      {
+        .name = pending->name,
+        .template = CONTEXT_INFO_DB_FILE_NO_TEMPLATE,
+        .value = _pool_add(compiled->pool, value, &overflow),
+      };
+      if (_value_needs_template(value))
+        {
+          record.template = compiled->templates->len;
+          g_array_append_val(compiled->templates, i);
+        }
+      g_array_append_val(compiled->records, record);
+    }
+
+  /* the compiled pool holds a subset of the strings of the pending one */
+  g_assert(!overflow);
+
+  guint32 num_selectors = compiled->selectors->len;
+  compiled->casefold_order = g_array_sized_new(FALSE, FALSE, sizeof(guint32), num_selectors);
+  compiled->load_order = g_array_sized_new(FALSE, FALSE, sizeof(guint32), num_selectors);
+  for (guint32 i = 0; i < num_selectors; i++)
+    {
+      g_array_append_val(compiled->casefold_order, i);
+      g_array_append_val(compiled->load_order, i);
+    }
+  g_array_sort_with_data(compiled->casefold_order, _casefold_order_cmp, compiled);
+  g_array_sort_with_data(compiled->load_order, _load_order_cmp, compiled->first_seen);
+}
+
+static void
+_compiled_clear(ContextInfoDBCompiled *compiled)
+{
+  g_string_free(compiled->pool, TRUE);
+  g_array_free(compiled->selectors, TRUE);
+  g_array_free(compiled->casefold_order, TRUE);
+  g_array_free(compiled->load_order, TRUE);
+  g_array_free(compiled->records, TRUE);
+  g_array_free(compiled->names, TRUE);
+  g_array_free(compiled->templates, TRUE);
+  g_array_free(compiled->first_seen, TRUE);
+}
+
+static guint64
+_reserve_section(guint64 *pos, gsize size)
+{
+  guint64 start = (*pos + CONTEXT_INFO_DB_FILE_ALIGNMENT - 1) & ~((guint64) CONTEXT_INFO_DB_FILE_ALIGNMENT - 1);
+
+  *pos = start + size;
+  return start;
+}
+
+static gboolean
+_write_section(FILE *fp, guint64 *pos, guint64 start, gconstpointer data, gsize size)
+{
+  for (; *pos < start; (*pos)++)
+    {
+      if (fputc(0, fp) == EOF)
+        return FALSE;
+    }
+
+  if (size && fwrite(data, size, 1, fp) != 1)
+    return FALSE;
+
+  *pos += size;
+  return TRUE;
+}
+
+static gboolean
+_write_compiled(ContextInfoDBCompiled *compiled, FILE *fp)
+{
+  ContextInfoDBFileHeader header = {0};
+  guint64 pos = sizeof(header);
+
+  memcpy(header.magic, CONTEXT_INFO_DB_FILE_MAGIC, sizeof(header.magic));
+  header.version = CONTEXT_INFO_DB_FILE_VERSION;
+  header.byte_order = CONTEXT_INFO_DB_FILE_BYTE_ORDER;
+  header.num_selectors = compiled->selectors->len;
+  header.num_records = compiled->records->len;
+  header.num_names = compiled->names->len;
+  header.num_templates = compiled->templates->len;
+
+  header.selectors_offset = _reserve_section(&pos, compiled->selectors->len * sizeof(ContextInfoDBFileSelector));
+  header.casefold_order_offset = _reserve_section(&pos, compiled->casefold_order->len * sizeof(guint32));
+  header.load_order_offset = _reserve_section(&pos, compiled->load_order->len * sizeof(guint32));
+  header.records_offset = _reserve_section(&pos, compiled->records->len * sizeof(ContextInfoDBFileRecord));
+  header.names_offset = _reserve_section(&pos, compiled->names->len * sizeof(ContextInfoDBFileString));
+  header.templates_offset = _reserve_section(&pos, compiled->templates->len * sizeof(guint32));
+  header.pool_offset = _reserve_section(&pos, compiled->pool->len);
+  header.pool_size = compiled->pool->len;
+
+  pos = 0;
+  return _write_section(fp, &pos, 0, &header, sizeof(header)) &&
+         _write_section(fp, &pos, header.selectors_offset, compiled->selectors->data,
+                        compiled->selectors->len * sizeof(ContextInfoDBFileSelector)) &&
+         _write_section(fp, &pos, header.casefold_order_offset, compiled->casefold_order->data,
+                        compiled->casefold_order->len * sizeof(guint32)) &&
+         _write_section(fp, &pos, header.load_order_offset, compiled->load_order->data,
+                        compiled->load_order->len * sizeof(guint32)) &&
+         _write_section(fp, &pos, header.records_offset, compiled->records->data,
+                        compiled->records->len * sizeof(ContextInfoDBFileRecord)) &&
+         _write_section(fp, &pos, header.names_offset, compiled->names->data,
+                        compiled->names->len * sizeof(ContextInfoDBFileString)) &&
+         _write_section(fp, &pos, header.templates_offset, compiled->templates->data,
+                        compiled->templates->len * sizeof(guint32)) &&
+         _write_section(fp, &pos, header.pool_offset, compiled->pool->str, compiled->pool->len);
+}
+
+static void
+_set_error_from_errno(GError **error, const gchar *filename, const gchar *what)
+{
+  gint errsv = errno;
+
+  g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errsv), "%s %s: %s", what, filename, g_strerror(errsv));
+}
+
+/* The database is written to a temporary file, which is then renamed into
+ * place, so that running instances never see a partially written file:
+ * truncating a file which is mapped by syslog-ng would crash it. */
+gboolean
+context_info_db_writer_write(ContextInfoDBWriter *self, const gchar *filename, GError **error)
+{
+  ContextInfoDBCompiled compiled;
+  gboolean result = FALSE;
+
+  if (self->pool_overflow || self->records->len >= G_MAXUINT32)
+    {
+      g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                  "too much data for a compiled database, strings are limited to 4GiB in total");
+      return FALSE;
+    }
+
+  _compile(self, &compiled);
+
+  gchar *temp_filename = g_strdup_printf("%s.XXXXXX", filename);
+  gint fd = g_mkstemp(temp_filename);
+  if (fd < 0)
+    {
+      _set_error_from_errno(error, temp_filename, "Error creating temporary file");
+      goto exit;
+    }
+  fchmod(fd, 0644);
+
+  FILE *fp = fdopen(fd, "wb");
+  if (!_write_compiled(&compiled, fp) || fflush(fp) != 0 || fsync(fd) != 0)
+    {
+      _set_error_from_errno(error, temp_filename, "Error writing");
+      fclose(fp);
+      unlink(temp_filename);
+      goto exit;
+    }
+  fclose(fp);
+
+  if (rename(temp_filename, filename) < 0)
+    {
+      _set_error_from_errno(error, filename, "Error renaming temporary file to");
+      unlink(temp_filename);
+      goto exit;
+    }
+  result = TRUE;
+
+exit:
+  g_free(temp_filename);
+  _compiled_clear(&compiled);
+  return result;
+}
+
+ContextInfoDBWriter *
+context_info_db_writer_new(void)
+{
+  ContextInfoDBWriter *self = g_new0(ContextInfoDBWriter, 1);
+
+  self->pool = g_string_sized_new(4096);
+  self->records = g_array_new(FALSE, FALSE, sizeof(ContextInfoDBPendingRecord));
+  self->names = g_array_new(FALSE, FALSE, sizeof(ContextInfoDBFileString));
+  self->name_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  return self;
+}
+
+void
+context_info_db_writer_free(ContextInfoDBWriter *self)
+{
+  g_string_free(self->pool, TRUE);
+  g_array_free(self->records, TRUE);
+  g_array_free(self->names, TRUE);
+  g_hash_table_unref(self->name_index);
+  g_free(self);
+}
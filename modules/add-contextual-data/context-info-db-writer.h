@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef CONTEXT_INFO_DB_WRITER_H_INCLUDED
+#define CONTEXT_INFO_DB_WRITER_H_INCLUDED
+
+#include "syslog-ng.h"
+#include <stdio.h>
+
+/*
+ * ContextInfoDBWriter produces the compiled database format described in
+ * context-info-db-file.h, from (selector, name, value) triplets.
+ */
+typedef struct _ContextInfoDBWriter ContextInfoDBWriter;
+
+void context_info_db_writer_add(ContextInfoDBWriter *self, const gchar *selector, const gchar *name,
+                                const gchar *value);
+gboolean context_info_db_writer_import_csv(ContextInfoDBWriter *self, FILE *fp, const gchar *filename);
+gboolean context_info_db_writer_write(ContextInfoDBWriter *self, const gchar *filename, GError **error);
+
+ContextInfoDBWriter *context_info_db_writer_new(void);
+void context_info_db_writer_free(ContextInfoDBWriter *self);
+
+#endif
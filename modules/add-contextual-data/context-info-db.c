@@ -21,6 +21,7 @@
  */
 
 #include "context-info-db.h"
+#include "context-info-db-file.h"
 #include "atomic.h"
 #include "messages.h"
 #include "scratch-buffers.h"
@@ -40,6 +41,13 @@ struct _ContextInfoDB
   gboolean is_ordering_enabled;
   GList *ordered_selectors;
   gboolean ignore_case;
+
+  /* compiled databases are not imported, records are looked up in the
+   * mapped file, only the value handles of the names and the values that
+   * are templates are resolved when loading */
+  ContextInfoDBFile *file;
+  NVHandle *name_handles;
+  LogTemplate **templates;
 };
 
 typedef struct _element_range
@@ -95,6 +103,13 @@ context_info_db_ordered_selectors(ContextInfoDB *self)
 void
 context_info_db_index(ContextInfoDB *self)
 {
+  if (self->file)
+    {
+      /* the file is indexed by ctxdbtool */
+      self->is_data_indexed = TRUE;
+      return;
+    }
+
   GCompareFunc record_cmp = self->ignore_case ? _contextual_data_record_case_cmp : _contextual_data_record_cmp;
 
   if (self->data->len > 0)
@@ -184,9 +199,26 @@ _free_array(GArray *array)
   g_array_free(array, TRUE);
 }
 
+static void
+_free_file(ContextInfoDB *self)
+{
+  if (self->templates)
+    {
+      for (guint32 i = 0; i < self->file->header->num_templates; i++)
+        log_template_unref(self->templates[i]);
+      g_free(self->templates);
+    }
+  g_free(self->name_handles);
+  context_info_db_file_unref(self->file);
+}
+
 static void
 _free(ContextInfoDB *self)
 {
+  if (self->file)
+    {
+      _free_file(self);
+    }
   if (self->index)
     {
       g_hash_table_unref(self->index);
@@ -236,14 +268,42 @@ context_info_db_contains(ContextInfoDB *self, const gchar *selector)
   if (!selector)
     return FALSE;
 
+  if (self->file)
+    {
+      guint32 first, last;
+      return context_info_db_file_lookup(self->file, selector, self->ignore_case, &first, &last);
+    }
+
   _ensure_indexed_db(self);
   return (_get_range_of_records(self, selector) != NULL);
 }
 
+static gsize
+_file_number_of_records(ContextInfoDB *self, const gchar *selector)
+{
+  guint32 first, last;
+  gsize n = 0;
+
+  context_info_db_file_lookup(self->file, selector, self->ignore_case, &first, &last);
+  for (guint32 pos = first; pos < last; pos++)
+    {
+      guint32 first_record, last_record;
+
+      context_info_db_file_get_record_range(self->file,
+                                            context_info_db_file_selector_at(self->file, pos, self->ignore_case),
+                                            &first_record, &last_record);
+      n += last_record - first_record;
+    }
+  return n;
+}
+
 gsize
 context_info_db_number_of_records(ContextInfoDB *self,
                                   const gchar *selector)
 {
+  if (self->file)
+    return _file_number_of_records(self, selector);
+
   _ensure_indexed_db(self);
 
   gsize n = 0;
@@ -255,10 +315,54 @@ context_info_db_number_of_records(ContextInfoDB *self,
   return n;
 }
 
+static void
+_file_foreach_record(ContextInfoDB *self, const gchar *selector,
+                     ADD_CONTEXT_INFO_CB callback, gpointer arg)
+{
+  const ContextInfoDBFile *file = self->file;
+  guint32 first, last;
+
+  context_info_db_file_lookup(file, selector, self->ignore_case, &first, &last);
+  for (guint32 pos = first; pos < last; pos++)
+    {
+      guint32 selector_ndx = context_info_db_file_selector_at(file, pos, self->ignore_case);
+      guint32 first_record, last_record;
+      ContextualDataRecord record;
+
+      contextual_data_record_init(&record);
+      record.selector = (gchar *) context_info_db_file_get_selector(file, selector_ndx);
+
+      context_info_db_file_get_record_range(file, selector_ndx, &first_record, &last_record);
+      for (guint32 i = first_record; i < last_record; i++)
+        {
+          const ContextInfoDBFileRecord *file_record = &file->records[i];
+
+          record.value_handle = self->name_handles[file_record->name];
+          if (file_record->template != CONTEXT_INFO_DB_FILE_NO_TEMPLATE)
+            {
+              record.value = self->templates[file_record->template];
+            }
+          else
+            {
+              record.value = NULL;
+              record.literal_value = context_info_db_file_get_string(file, file_record->value);
+              record.literal_value_len = file_record->value.len;
+            }
+          callback(arg, &record);
+        }
+    }
+}
+
 void
 context_info_db_foreach_record(ContextInfoDB *self, const gchar *selector,
                                ADD_CONTEXT_INFO_CB callback, gpointer arg)
 {
+  if (self->file)
+    {
+      _file_foreach_record(self, selector, callback, arg);
+      return;
+    }
+
   _ensure_indexed_db(self);
 
   element_range *record_range = _get_range_of_records(self, selector);
@@ -284,12 +388,23 @@ context_info_db_is_indexed(const ContextInfoDB *self)
 gboolean
 context_info_db_is_loaded(const ContextInfoDB *self)
 {
+  if (self->file)
+    return self->file->header->num_records > 0;
   return (self->data != NULL && self->data->len > 0);
 }
 
 GList *
 context_info_db_get_selectors(ContextInfoDB *self)
 {
+  if (self->file)
+    {
+      GList *selectors = NULL;
+
+      for (guint32 i = self->file->header->num_selectors; i > 0; i--)
+        selectors = g_list_prepend(selectors, (gpointer) context_info_db_file_get_selector(self->file, i - 1));
+      return selectors;
+    }
+
   _ensure_indexed_db(self);
   return g_hash_table_get_keys(self->index);
 }
@@ -355,6 +470,95 @@ context_info_db_import(ContextInfoDB *self, FILE *fp, const gchar *filename,
   return TRUE;
 }
 
+static void
+_resolve_names(ContextInfoDB *self, const gchar *name_prefix)
+{
+  const ContextInfoDBFile *file = self->file;
+  GString *name = g_string_sized_new(64);
+
+  self->name_handles = g_new(NVHandle, file->header->num_names);
+  for (guint32 i = 0; i < file->header->num_names; i++)
+    {
+      g_string_assign(name, name_prefix ? : "");
+      g_string_append(name, context_info_db_file_get_string(file, file->names[i]));
+      self->name_handles[i] = log_msg_get_value_handle(name->str);
+    }
+  g_string_free(name, TRUE);
+}
+
+static gboolean
+_compile_templates(ContextInfoDB *self, GlobalConfig *cfg)
+{
+  const ContextInfoDBFile *file = self->file;
+
+  self->templates = g_new0(LogTemplate *, file->header->num_templates);
+  for (guint32 i = 0; i < file->header->num_templates; i++)
+    {
+      guint32 record_ndx = file->templates[i];
+      gint64 selector_ndx = context_info_db_file_find_selector_of_record(file, record_ndx);
+      const ContextInfoDBFileRecord *file_record = &file->records[record_ndx];
+      ContextualDataRecord record;
+
+      contextual_data_record_init(&record);
+      record.selector = (gchar *) context_info_db_file_get_selector(file, selector_ndx);
+      record.value_handle = self->name_handles[file_record->name];
+
+      gboolean success = contextual_data_record_compile_value(&record, cfg,
+                                                              context_info_db_file_get_string(file, file_record->value));
+      self->templates[i] = record.value;
+      if (!success)
+        return FALSE;
+
+      log_template_forget_template_string(record.value);
+    }
+  return TRUE;
+}
+
+static void
+_collect_ordered_selectors(ContextInfoDB *self)
+{
+  for (guint32 i = self->file->header->num_selectors; i > 0; i--)
+    {
+      const gchar *selector = context_info_db_file_get_selector(self->file, self->file->load_order[i - 1]);
+      self->ordered_selectors = g_list_prepend(self->ordered_selectors, (gpointer) selector);
+    }
+}
+
+gboolean
+context_info_db_load_compiled(ContextInfoDB *self, const gchar *filename, GlobalConfig *cfg,
+                              const gchar *name_prefix)
+{
+  GError *error = NULL;
+
+  g_assert(!self->file && self->data->len == 0);
+
+  self->file = context_info_db_file_open(filename, &error);
+  if (!self->file)
+    {
+      msg_error("add-contextual-data(): Error opening compiled database",
+                evt_tag_str("filename", filename),
+                evt_tag_str("error", error->message));
+      g_clear_error(&error);
+      return FALSE;
+    }
+
+  _resolve_names(self, name_prefix);
+  if (!_compile_templates(self, cfg))
+    return FALSE;
+
+  if (self->is_ordering_enabled)
+    _collect_ordered_selectors(self);
+
+  msg_debug("add-contextual-data(): compiled database loaded",
+            evt_tag_str("filename", filename),
+            evt_tag_int("selectors", self->file->header->num_selectors),
+            evt_tag_int("records", self->file->header->num_records),
+            evt_tag_int("templates", self->file->header->num_templates));
+
+  self->is_data_indexed = TRUE;
+  return TRUE;
+}
+
 ContextInfoDB *
 context_info_db_new(gboolean ignore_case)
 {
@@ -59,6 +59,8 @@ GList *context_info_db_get_selectors(ContextInfoDB *self);
 
 gboolean context_info_db_import(ContextInfoDB *self, FILE *fp, const gchar *filename,
                                 ContextualDataRecordScanner *scanner);
+gboolean context_info_db_load_compiled(ContextInfoDB *self, const gchar *filename, GlobalConfig *cfg,
+                                       const gchar *name_prefix);
 
 
 ContextInfoDB *context_info_db_new(gboolean ignore_case);
@@ -21,6 +21,10 @@
  */
 
 #include "contextual-data-record.h"
+#include "messages.h"
+#include "cfg.h"
+
+#include <string.h>
 
 void
 contextual_data_record_init(ContextualDataRecord *record)
@@ -28,6 +32,8 @@ contextual_data_record_init(ContextualDataRecord *record)
   record->selector = NULL;
   record->value_handle = 0;
   record->value = NULL;
+  record->literal_value = NULL;
+  record->literal_value_len = 0;
 }
 
 void
@@ -37,3 +43,88 @@ contextual_data_record_clean(ContextualDataRecord *record)
   log_template_unref(record->value);
   contextual_data_record_init(record);
 }
+
+/* compile the value column of a record, taking the config version into
+ * account for backward compatibility */
+gboolean
+contextual_data_record_compile_value(ContextualDataRecord *record, GlobalConfig *cfg, const gchar *value_template)
+{
+  record->value = log_template_new(cfg, NULL);
+
+  GError *error = NULL;
+  gboolean success;
+
+  if (cfg_is_config_version_older(cfg, VERSION_VALUE_3_21) &&
+      strchr(value_template, '$') != NULL)
+    {
+      msg_warning("WARNING: the value field in add-contextual-data() CSV files has been changed "
+                  "to be a template starting with " VERSION_3_21 ". You are using an older config "
+                  "version and your CSV file contains a '$' character in this field, which needs "
+                  "to be escaped as '$$' once you change your @version declaration in the "
+                  "configuration. This message means that this string is now assumed to be a "
+                  "literal (non-template) string for compatibility",
+                  cfg_format_config_version_tag(cfg),
+                  evt_tag_str("selector", record->selector),
+                  evt_tag_str("name", log_msg_get_value_name(record->value_handle, NULL)),
+                  evt_tag_str("value", value_template));
+      log_template_compile_literal_string(record->value, value_template);
+      success = TRUE;
+    }
+  else if (cfg_is_typing_feature_enabled(cfg))
+    {
+      /* typing feature is enabled */
+      if (cfg_is_config_version_older(cfg, VERSION_VALUE_4_0))
+        {
+          /* old @config, use compat mode but warn if the format would become incompatible */
+          if (strchr(value_template, '(') != NULL)
+            {
+              success = log_template_compile_with_type_hint(record->value, value_template, &error);
+              if (!success)
+                {
+                  log_template_set_type_hint(record->value, "string", NULL);
+                  msg_warning("WARNING: the value field in add-contextual-data() CSV files has been changed "
+                              "to support typing from " FEATURE_TYPING_VERSION ". You are using an older config "
+                              "version and your CSV file contains an unrecognized type-cast, probably a "
+                              "parenthesis in the value field. This will be interpreted in the `type(value)' "
+                              "format in future versions. Please add an "
+                              "explicit string() cast as shown in the 'fixed-value' tag of this log message "
+                              "or remove the parenthesis. The value column will be processed as a 'string' "
+                              "expression",
+                              cfg_format_config_version_tag(cfg),
+                              evt_tag_str("selector", record->selector),
+                              evt_tag_str("name", log_msg_get_value_name(record->value_handle, NULL)),
+                              evt_tag_str("value", value_template),
+                              evt_tag_printf("fixed-value", "string(%s)", value_template));
+                  g_clear_error(&error);
+                  success = log_template_compile(record->value, value_template, &error);
+                }
+            }
+          else
+            {
+              success = log_template_compile(record->value, value_template, &error);
+            }
+        }
+      else
+        {
+          /* new @config, use the new format with error handling */
+          success = log_template_compile_with_type_hint(record->value, value_template, &error);
+        }
+    }
+  else
+    {
+      /* typing feature is disabled, use old format, no warnings */
+      success = log_template_compile(record->value, value_template, &error);
+    }
+
+  if (!success)
+    {
+      msg_error("add-contextual-data(): error compiling template",
+                evt_tag_str("selector", record->selector),
+                evt_tag_str("name", log_msg_get_value_name(record->value_handle, NULL)),
+                evt_tag_str("value", value_template),
+                evt_tag_str("error", error->message));
+      g_clear_error(&error);
+      return FALSE;
+    }
+  return TRUE;
+}
@@ -32,9 +32,16 @@ typedef struct _ContextualDataRecord
   gchar *selector;
   NVHandle value_handle;
   LogTemplate *value;
+
+  /* records coming from a compiled database have no template if their
+   * value is a literal string, it points into the mapped file instead */
+  const gchar *literal_value;
+  gsize literal_value_len;
 } ContextualDataRecord;
 
 void contextual_data_record_init(ContextualDataRecord *record);
 void contextual_data_record_clean(ContextualDataRecord *record);
+gboolean contextual_data_record_compile_value(ContextualDataRecord *record, GlobalConfig *cfg,
+                                              const gchar *value_template);
 
 #endif
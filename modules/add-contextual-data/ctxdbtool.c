@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2026 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "syslog-ng.h"
+#include "context-info-db-writer.h"
+#include "context-info-db-file.h"
+#include "messages.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+static gchar *input_filename;
+static gchar *output_filename;
+static gboolean display_version;
+
+static GOptionEntry compile_options[] =
+{
+  {
+    "input", 'i', 0, G_OPTION_ARG_STRING, &input_filename,
+    "CSV file to compile, in the format accepted by add-contextual-data()", "<csv-file>"
+  },
+  {
+    "output", 'o', 0, G_OPTION_ARG_STRING, &output_filename,
+    "Name of the compiled database, it should have a ." CONTEXT_INFO_DB_FILE_EXTENSION " extension",
+    "<" CONTEXT_INFO_DB_FILE_EXTENSION "-file>"
+  },
+  { NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL }
+};
+
+static GOptionEntry info_options[] =
+{
+  {
+    "input", 'i', 0, G_OPTION_ARG_STRING, &input_filename,
+    "Compiled database to display information about", "<" CONTEXT_INFO_DB_FILE_EXTENSION "-file>"
+  },
+  { NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL }
+};
+
+static gint
+ctxdbtool_compile(gint argc, gchar *argv[])
+{
+  ContextInfoDBWriter *writer;
+  GError *error = NULL;
+  FILE *fp;
+  gint result = 1;
+
+  if (!input_filename || !output_filename)
+    {
+      fprintf(stderr, "Both --input and --output must be specified\n");
+      return 1;
+    }
+
+  if (g_str_has_suffix(input_filename, "." CONTEXT_INFO_DB_FILE_EXTENSION))
+    {
+      fprintf(stderr, "The input file should be a CSV file: %s\n", input_filename);
+      return 1;
+    }
+
+  fp = fopen(input_filename, "r");
+  if (!fp)
+    {
+      fprintf(stderr, "Error opening input file %s: %s\n", input_filename, g_strerror(errno));
+      return 1;
+    }
+
+  writer = context_info_db_writer_new();
+  if (!context_info_db_writer_import_csv(writer, fp, input_filename))
+    goto exit;
+
+  if (!context_info_db_writer_write(writer, output_filename, &error))
+    {
+      fprintf(stderr, "Error writing compiled database: %s\n", error->message);
+      g_clear_error(&error);
+      goto exit;
+    }
+  result = 0;
+
+exit:
+  context_info_db_writer_free(writer);
+  fclose(fp);
+  return result;
+}
+
+static gint
+ctxdbtool_info(gint argc, gchar *argv[])
+{
+  ContextInfoDBFile *file;
+  GError *error = NULL;
+
+  if (!input_filename)
+    {
+      fprintf(stderr, "The --input option must be specified\n");
+      return 1;
+    }
+
+  file = context_info_db_file_open(input_filename, &error);
+  if (!file)
+    {
+      fprintf(stderr, "%s\n", error->message);
+      g_clear_error(&error);
+      return 1;
+    }
+
+  printf("Format version: %u\n", file->header->version);
+  printf("Selectors: %u\n", file->header->num_selectors);
+  printf("Records: %u\n", file->header->num_records);
+  printf("Names: %u\n", file->header->num_names);
+  printf("Templates: %u\n", file->header->num_templates);
+  printf("String pool size: %" G_GUINT64_FORMAT "\n", file->header->pool_size);
+  printf("File size: %" G_GSIZE_FORMAT "\n", file->map_size);
+
+  context_info_db_file_unref(file);
+  return 0;
+}
+
+static GOptionEntry ctxdbtool_options[] =
+{
+  {
+    "debug",     'd', 0, G_OPTION_ARG_NONE, &debug_flag,
+    "Enable debug/diagnostic messages on stderr", NULL
+  },
+  {
+    "verbose",   'v', 0, G_OPTION_ARG_NONE, &verbose_flag,
+    "Enable verbose messages on stderr", NULL
+  },
+  {
+    "version",   'V', 0, G_OPTION_ARG_NONE, &display_version,
+    "Display version number (" SYSLOG_NG_VERSION ")", NULL
+  },
+  { NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL }
+};
+
+static struct
+{
+  const gchar *mode;
+  const GOptionEntry *options;
+  const gchar *description;
+  gint (*main)(gint argc, gchar *argv[]);
+} modes[] =
+{
+  { "compile", compile_options, "Compile a CSV file into a database that add-contextual-data() maps into memory", ctxdbtool_compile },
+  { "info", info_options, "Print information about a compiled database", ctxdbtool_info },
+  { NULL, NULL },
+};
+
+static const gchar *
+ctxdbtool_mode(int *argc, char **argv[])
+{
+  gint i;
+  const gchar *mode;
+
+  for (i = 1; i < (*argc); i++)
+    {
+      if ((*argv)[i][0] != '-')
+        {
+          mode = (*argv)[i];
+          memmove(&(*argv)[i], &(*argv)[i+1], ((*argc) - i) * sizeof(gchar *));
+          (*argc)--;
+          return mode;
+        }
+    }
+  return NULL;
+}
+
+static void
+usage(void)
+{
+  gint mode;
+
+  fprintf(stderr, "Syntax: ctxdbtool <command> [options]\nPossible commands are:\n");
+  for (mode = 0; modes[mode].mode; mode++)
+    {
+      fprintf(stderr, "    %-12s %s\n", modes[mode].mode, modes[mode].description);
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+  const gchar *mode_string;
+  GOptionContext *ctx;
+  gint mode;
+  gint result;
+  GError *error = NULL;
+
+  mode_string = ctxdbtool_mode(&argc, &argv);
+  if (!mode_string)
+    {
+      usage();
+      return 1;
+    }
+
+  ctx = NULL;
+  for (mode = 0; modes[mode].mode; mode++)
+    {
+      if (strcmp(modes[mode].mode, mode_string) == 0)
+        {
+          ctx = g_option_context_new(mode_string);
+          g_option_context_set_summary(ctx, modes[mode].description);
+          g_option_context_add_main_entries(ctx, modes[mode].options, NULL);
+          g_option_context_add_main_entries(ctx, ctxdbtool_options, NULL);
+          break;
+        }
+    }
+
+  if (!ctx)
+    {
+      fprintf(stderr, "Unknown command\n");
+      usage();
+      return 1;
+    }
+
+  if (!g_option_context_parse(ctx, &argc, &argv, &error))
+    {
+      fprintf(stderr, "Error parsing command line arguments: %s\n", error ? error->message : "Invalid arguments");
+      g_clear_error(&error);
+      g_option_context_free(ctx);
+      return 1;
+    }
+  g_option_context_free(ctx);
+  if (display_version)
+    {
+      printf(SYSLOG_NG_VERSION "\n");
+      return 0;
+    }
+
+  msg_init(TRUE);
+  result = modes[mode].main(argc, argv);
+  msg_deinit();
+  return result;
+}
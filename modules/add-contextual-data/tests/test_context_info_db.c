@@ -25,11 +25,14 @@
 #include "libtest/cr_template.h"
 
 #include "context-info-db.h"
+#include "context-info-db-writer.h"
+#include "context-info-db-file.h"
 #include "apphook.h"
 #include "scratch-buffers.h"
 #include "cfg.h"
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
 
@@ -180,9 +183,16 @@ _foreach_get_nvpairs(gpointer arg, const ContextualDataRecord *record)
 
   pair.name = log_msg_get_value_name(record->value_handle, NULL);
 
-  LogMessage *msg = create_sample_message();
-  log_template_format(record->value, msg, &DEFAULT_TEMPLATE_EVAL_OPTIONS, result);
-  log_msg_unref(msg);
+  if (record->value)
+    {
+      LogMessage *msg = create_sample_message();
+      log_template_format(record->value, msg, &DEFAULT_TEMPLATE_EVAL_OPTIONS, result);
+      log_msg_unref(msg);
+    }
+  else
+    {
+      g_string_append_len(result, record->literal_value, record->literal_value_len);
+    }
 
   pair.value = result->str;
   store->pairs[store->ctr++] = pair;
@@ -520,6 +530,225 @@ Test(add_contextual_data, test_selected_nvpairs_when_ignore_case_on)
   contextual_data_record_scanner_free(scanner);
 }
 
+static ContextInfoDB *
+_load_compiled_db(gchar *csv_content, gboolean ignore_case, const gchar *prefix, gchar **filename)
+{
+  ContextInfoDBWriter *writer = context_info_db_writer_new();
+  FILE *fp = fmemopen(csv_content, strlen(csv_content), "r");
+
+  cr_assert(context_info_db_writer_import_csv(writer, fp, "dummy.csv"), "Failed to import valid CSV file.");
+  fclose(fp);
+
+  gint fd = g_file_open_tmp("test_context_info_db_XXXXXX.ctxdb", filename, NULL);
+  cr_assert(fd >= 0);
+  close(fd);
+
+  cr_assert(context_info_db_writer_write(writer, *filename, NULL), "Failed to write compiled database.");
+  context_info_db_writer_free(writer);
+
+  ContextInfoDB *db = context_info_db_new(ignore_case);
+  context_info_db_enable_ordering(db);
+  cr_assert(context_info_db_load_compiled(db, *filename, configuration, prefix),
+            "Failed to load compiled database.");
+  return db;
+}
+
+static void
+_free_compiled_db(ContextInfoDB *db, gchar *filename)
+{
+  context_info_db_unref(db);
+  unlink(filename);
+  g_free(filename);
+}
+
+Test(add_contextual_data, test_compiled_db)
+{
+  gchar csv_content[] = "selector2,name2,value2\n"
+                        "selector1,name1,value1\n"
+                        "selector3,name3,value3\n"
+                        "selector1,name1.1,value1.1\n"
+                        "selector3,name3.1,$(echo $HOST_FROM)";
+  gchar *filename;
+  ContextInfoDB *db = _load_compiled_db(csv_content, FALSE, NULL, &filename);
+
+  cr_assert(context_info_db_is_loaded(db));
+  cr_assert(context_info_db_is_indexed(db));
+  cr_assert(context_info_db_contains(db, "selector1"));
+  cr_assert_not(context_info_db_contains(db, "SELECTOR1"));
+  cr_assert_not(context_info_db_contains(db, "selector"));
+  cr_assert_not(context_info_db_contains(db, "selector4"));
+  cr_assert_eq(context_info_db_number_of_records(db, "selector1"), 2);
+  cr_assert_eq(context_info_db_number_of_records(db, "selector4"), 0);
+
+  TestNVPair expected_nvpairs_selector1[] =
+  {
+    {.name = "name1", .value = "value1"},
+    {.name = "name1.1", .value = "value1.1"},
+  };
+
+  TestNVPair expected_nvpairs_selector3[] =
+  {
+    {.name = "name3", .value = "value3"},
+    {.name = "name3.1", .value = "kismacska"},
+  };
+
+  _assert_context_info_db_contains_name_value_pairs_by_selector(db, "selector1", expected_nvpairs_selector1,
+      ARRAY_SIZE(expected_nvpairs_selector1));
+  _assert_context_info_db_contains_name_value_pairs_by_selector(db, "selector3", expected_nvpairs_selector3,
+      ARRAY_SIZE(expected_nvpairs_selector3));
+
+  GList *ordered_selectors = context_info_db_ordered_selectors(db);
+  cr_assert_eq(g_list_length(ordered_selectors), 3);
+  cr_assert_str_eq(g_list_nth_data(ordered_selectors, 0), "selector2");
+  cr_assert_str_eq(g_list_nth_data(ordered_selectors, 1), "selector1");
+  cr_assert_str_eq(g_list_nth_data(ordered_selectors, 2), "selector3");
+
+  _free_compiled_db(db, filename);
+}
+
+Test(add_contextual_data, test_compiled_db_with_prefix_and_ignore_case)
+{
+  gchar csv_content[] = "selector,name1,value1\n"
+                        "SeLeCtOr,name2,value2\n"
+                        "another,name3,value3";
+  gchar *filename;
+  ContextInfoDB *db = _load_compiled_db(csv_content, TRUE, "prefix.", &filename);
+
+  cr_assert(context_info_db_contains(db, "SELECTOR"));
+  cr_assert_eq(context_info_db_number_of_records(db, "SELECTOR"), 2);
+
+  TestNVPair expected_nvpairs[] =
+  {
+    {.name = "prefix.name1", .value = "value1"},
+    {.name = "prefix.name2", .value = "value2"},
+  };
+
+  _assert_context_info_db_contains_name_value_pairs_by_selector(db, "selector", expected_nvpairs,
+      ARRAY_SIZE(expected_nvpairs));
+
+  _free_compiled_db(db, filename);
+}
+
+Test(add_contextual_data, test_compiled_db_is_shared)
+{
+  gchar csv_content[] = "selector1,name1,value1";
+  gchar *filename;
+  ContextInfoDB *db = _load_compiled_db(csv_content, FALSE, NULL, &filename);
+  ContextInfoDB *other_db = context_info_db_new(FALSE);
+
+  cr_assert(context_info_db_load_compiled(other_db, filename, configuration, NULL));
+
+  GList *selectors = context_info_db_get_selectors(db);
+  GList *other_selectors = context_info_db_get_selectors(other_db);
+  cr_assert_eq(selectors->data, other_selectors->data, "the two databases should use the same mapping");
+  g_list_free(selectors);
+  g_list_free(other_selectors);
+
+  context_info_db_unref(other_db);
+  _free_compiled_db(db, filename);
+}
+
+Test(add_contextual_data, test_compiled_db_rejects_csv_file)
+{
+  gchar *filename;
+  gint fd = g_file_open_tmp("test_context_info_db_XXXXXX.ctxdb", &filename, NULL);
+  const gchar csv_content[] = "selector1,name1,value1\n";
+
+  cr_assert(write(fd, csv_content, strlen(csv_content)) == strlen(csv_content));
+  close(fd);
+
+  ContextInfoDB *db = context_info_db_new(FALSE);
+  cr_assert_not(context_info_db_load_compiled(db, filename, configuration, NULL));
+  cr_assert_not(context_info_db_is_loaded(db));
+
+  _free_compiled_db(db, filename);
+}
+
+static void
+_assert_compiled_db_is_rejected(const gchar *filename, const gchar *contents, gsize length)
+{
+  cr_assert(g_file_set_contents(filename, contents, length, NULL));
+
+  ContextInfoDB *db = context_info_db_new(FALSE);
+  cr_assert_not(context_info_db_load_compiled(db, filename, configuration, NULL),
+                "corrupt compiled database was loaded, length: %" G_GSIZE_FORMAT, length);
+  context_info_db_unref(db);
+}
+
+/* overwrites a single guint32 in a copy of the file */
+static void
+_assert_patched_compiled_db_is_rejected(const gchar *filename, const gchar *contents, gsize length,
+                                        guint64 offset, guint32 value)
+{
+  gchar *patched = g_malloc(length);
+
+  memcpy(patched, contents, length);
+  memcpy(patched + offset, &value, sizeof(value));
+  _assert_compiled_db_is_rejected(filename, patched, length);
+  g_free(patched);
+}
+
+Test(add_contextual_data, test_compiled_db_rejects_truncated_and_corrupt_files)
+{
+  gchar csv_content[] = "selector1,name1,value1\n"
+                        "selector2,name2,$(echo $HOST)\n"
+                        "selector2,name1,value2";
+  gchar *filename;
+  gchar *contents;
+  gsize length;
+
+  ContextInfoDB *db = _load_compiled_db(csv_content, FALSE, NULL, &filename);
+  context_info_db_unref(db);
+  cr_assert(g_file_get_contents(filename, &contents, &length, NULL));
+
+  ContextInfoDBFileHeader header;
+  memcpy(&header, contents, sizeof(header));
+  cr_assert_eq(header.num_selectors, 2);
+  cr_assert_eq(header.num_records, 3);
+  cr_assert_eq(header.num_templates, 1);
+
+  _assert_compiled_db_is_rejected(filename, contents, sizeof(header) - 1);
+  _assert_compiled_db_is_rejected(filename, contents, length / 2);
+  _assert_compiled_db_is_rejected(filename, contents, length - 1);
+
+  guint64 selector = header.selectors_offset;
+  guint64 second_selector = selector + sizeof(ContextInfoDBFileSelector);
+  guint64 record = header.records_offset;
+  _assert_patched_compiled_db_is_rejected(filename, contents, length,
+                                          selector + offsetof(ContextInfoDBFileSelector, selector.offset),
+                                          header.pool_size);
+  _assert_patched_compiled_db_is_rejected(filename, contents, length,
+                                          selector + offsetof(ContextInfoDBFileSelector, selector.len),
+                                          G_MAXUINT32);
+  _assert_patched_compiled_db_is_rejected(filename, contents, length,
+                                          selector + offsetof(ContextInfoDBFileSelector, first_record), 1);
+  _assert_patched_compiled_db_is_rejected(filename, contents, length,
+                                          second_selector + offsetof(ContextInfoDBFileSelector, num_records),
+                                          G_MAXUINT32);
+  _assert_patched_compiled_db_is_rejected(filename, contents, length, header.casefold_order_offset,
+                                          header.num_selectors);
+  _assert_patched_compiled_db_is_rejected(filename, contents, length, header.load_order_offset + sizeof(guint32),
+                                          ((guint32 *) (contents + header.load_order_offset))[0]);
+  _assert_patched_compiled_db_is_rejected(filename, contents, length,
+                                          record + offsetof(ContextInfoDBFileRecord, name), header.num_names);
+  _assert_patched_compiled_db_is_rejected(filename, contents, length,
+                                          record + offsetof(ContextInfoDBFileRecord, template), header.num_templates);
+  _assert_patched_compiled_db_is_rejected(filename, contents, length,
+                                          record + offsetof(ContextInfoDBFileRecord, value.offset),
+                                          header.pool_size - 1);
+  _assert_patched_compiled_db_is_rejected(filename, contents, length, header.names_offset, header.pool_size);
+  _assert_patched_compiled_db_is_rejected(filename, contents, length, header.templates_offset, header.num_records);
+
+  /* the original is still fine */
+  cr_assert(g_file_set_contents(filename, contents, length, NULL));
+  db = context_info_db_new(FALSE);
+  cr_assert(context_info_db_load_compiled(db, filename, configuration, NULL));
+  cr_assert_eq(context_info_db_number_of_records(db, "selector2"), 2);
+
+  g_free(contents);
+  _free_compiled_db(db, filename);
+}
+
 static void
 setup(void)
 {
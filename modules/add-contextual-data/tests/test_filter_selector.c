@@ -26,6 +26,7 @@
 #include "template/macros.h"
 #include "cfg.h"
 #include "apphook.h"
+#include "gsocket.h"
 #include <unistd.h>
 
 static gchar *test_filter_conf;
@@ -152,3 +153,92 @@ Test(add_contextual_data_filter_selector, test_matching_msg_filter_selection)
   add_contextual_data_selector_free(selector);
   g_list_free(ordered_filters);
 }
+
+static gchar *
+_resolve_with_host_and_program(AddContextualDataSelector *selector, const gchar *host, const gchar *program)
+{
+  LogMessage *msg = _create_log_msg("testmsg", host);
+  log_msg_set_value(msg, LM_V_PROGRAM, program, -1);
+
+  gchar *resolved_selector = add_contextual_data_selector_resolve(selector, msg);
+  log_msg_unref(msg);
+  return resolved_selector;
+}
+
+Test(add_contextual_data_filter_selector, test_indexed_filters_keep_the_order_of_the_database)
+{
+  const gchar cfg_content[] = "filter f_host_a { host(\"host-a\" type(string)); };"
+                              "filter f_generic { message(\"testmsg\") and host(\"^host-b\"); };"
+                              "filter f_host_b { host(\"host-b\" type(string)); };"
+                              "filter f_program { \"$PROGRAM\" eq \"prg\"; };"
+                              "filter f_host_icase { host(\"HOST-C\" type(string) flags(ignore-case)); };"
+                              "filter f_host_a_again { host(\"host-a\" type(string)); };";
+  GList *ordered_filters = NULL;
+  ordered_filters = g_list_append(ordered_filters, "f_host_a");
+  ordered_filters = g_list_append(ordered_filters, "f_generic");
+  ordered_filters = g_list_append(ordered_filters, "f_host_b");
+  ordered_filters = g_list_append(ordered_filters, "f_program");
+  ordered_filters = g_list_append(ordered_filters, "f_host_icase");
+  ordered_filters = g_list_append(ordered_filters, "f_host_a_again");
+  AddContextualDataSelector *selector = _create_filter_selector(cfg_content, strlen(cfg_content), ordered_filters);
+  gchar *resolved_selector;
+
+  resolved_selector = _resolve_with_host_and_program(selector, "host-a", "prg");
+  cr_assert_str_eq(resolved_selector, "f_host_a");
+  g_free(resolved_selector);
+
+  /* the generic filter comes before the indexed one */
+  resolved_selector = _resolve_with_host_and_program(selector, "host-b", "prg");
+  cr_assert_str_eq(resolved_selector, "f_generic");
+  g_free(resolved_selector);
+
+  resolved_selector = _resolve_with_host_and_program(selector, "host-x", "prg");
+  cr_assert_str_eq(resolved_selector, "f_program");
+  g_free(resolved_selector);
+
+  resolved_selector = _resolve_with_host_and_program(selector, "Host-C", "other");
+  cr_assert_str_eq(resolved_selector, "f_host_icase");
+  g_free(resolved_selector);
+
+  resolved_selector = _resolve_with_host_and_program(selector, "host-a-suffix", "other");
+  cr_assert_null(resolved_selector);
+
+  add_contextual_data_selector_free(selector);
+  g_list_free(ordered_filters);
+}
+
+Test(add_contextual_data_filter_selector, test_indexed_netmask_filters)
+{
+  const gchar cfg_content[] = "filter f_remote { netmask(\"10.0.0.0/8\"); };"
+                              "filter f_local { netmask(\"127.0.0.1/32\"); };"
+                              "filter f_any { netmask(\"0.0.0.0/0\"); };";
+  GList *ordered_filters = NULL;
+  ordered_filters = g_list_append(ordered_filters, "f_remote");
+  ordered_filters = g_list_append(ordered_filters, "f_local");
+  ordered_filters = g_list_append(ordered_filters, "f_any");
+  AddContextualDataSelector *selector = _create_filter_selector(cfg_content, strlen(cfg_content), ordered_filters);
+
+  /* messages without a source address are matched as if they were coming from 127.0.0.1 */
+  LogMessage *msg = _create_log_msg("testmsg", "localhost");
+  gchar *resolved_selector = add_contextual_data_selector_resolve(selector, msg);
+  cr_assert_str_eq(resolved_selector, "f_local");
+  g_free(resolved_selector);
+  log_msg_unref(msg);
+
+  msg = _create_log_msg("testmsg", "remote");
+  log_msg_set_saddr_ref(msg, g_sockaddr_inet_new("10.1.2.3", 514));
+  resolved_selector = add_contextual_data_selector_resolve(selector, msg);
+  cr_assert_str_eq(resolved_selector, "f_remote");
+  g_free(resolved_selector);
+  log_msg_unref(msg);
+
+  msg = _create_log_msg("testmsg", "remote");
+  log_msg_set_saddr_ref(msg, g_sockaddr_inet_new("192.168.1.1", 514));
+  resolved_selector = add_contextual_data_selector_resolve(selector, msg);
+  cr_assert_str_eq(resolved_selector, "f_any");
+  g_free(resolved_selector);
+  log_msg_unref(msg);
+
+  add_contextual_data_selector_free(selector);
+  g_list_free(ordered_filters);
+}
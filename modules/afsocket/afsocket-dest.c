@@ -426,6 +426,11 @@ afsocket_dd_setup_writer_options(AFSocketDestDriver *self)
   GlobalConfig *cfg = log_pipe_get_config(&self->super.super.super);
 
   log_writer_options_init(&self->writer_options, cfg, 0);
+
+  /* write-batch-size() coalesces messages into a single write, datagram
+   * transports need to keep message boundaries, so it is ignored there */
+  if (self->transport_mapper->sock_type != SOCK_STREAM)
+    log_proto_client_options_set_write_batch_size(&self->writer_options.proto_options.super, 1);
   return TRUE;
 }
 
@@ -75,12 +75,23 @@ transport_mapper_inet_apply_transport_method(TransportMapper *s, GlobalConfig *c
   return transport_mapper_inet_validate_tls_options(self);
 }
 
+static LogTransport *
+_construct_dgram_socket_transport(TransportMapperInet *self, gint fd)
+{
+  LogTransport *transport = log_transport_udp_socket_new(fd);
+
+  /* availability of recvmmsg() is validated at config parsing time */
+  if (self->recv_batch_size > 1)
+    log_transport_dgram_socket_set_recv_batch_size(transport, self->recv_batch_size);
+  return transport;
+}
+
 static gboolean
 _setup_socket_transport(TransportMapperInet *self, LogTransportStack *stack)
 {
   log_transport_stack_add_transport(stack, LOG_TRANSPORT_SOCKET,
                                     self->super.sock_type == SOCK_DGRAM
-                                    ? log_transport_udp_socket_new(stack->fd)
+                                    ? _construct_dgram_socket_transport(self, stack->fd)
                                     : log_transport_stream_socket_new(stack->fd));
   return TRUE;
 }
@@ -275,6 +286,17 @@ transport_mapper_inet_free_method(TransportMapper *s)
   transport_mapper_free_method(s);
 }
 
+gboolean
+transport_mapper_inet_set_recv_batch_size(TransportMapperInet *self, gint recv_batch_size)
+{
+#if SYSLOG_NG_HAVE_RECVMMSG
+  self->recv_batch_size = recv_batch_size;
+  return TRUE;
+#else
+  return recv_batch_size <= 1;
+#endif
+}
+
 void
 transport_mapper_inet_init_instance(TransportMapperInet *self, const gchar *transport)
 {
@@ -60,6 +60,9 @@ typedef struct _TransportMapperInet
   TLSContext *tls_context;
   TLSVerifier *tls_verifier;
   gpointer secret_store_cb_data;
+
+  /* number of datagrams to fetch with a single recvmmsg() call */
+  gint recv_batch_size;
 } TransportMapperInet;
 
 static inline gint
@@ -95,6 +98,8 @@ transport_mapper_inet_set_tls_verifier(TransportMapperInet *self, TLSVerifier *t
   self->tls_verifier = tls_verifier;
 }
 
+gboolean transport_mapper_inet_set_recv_batch_size(TransportMapperInet *self, gint recv_batch_size);
+
 void transport_mapper_inet_init_instance(TransportMapperInet *self, const gchar *transport);
 TransportMapper *transport_mapper_tcp_new(void);
 TransportMapper *transport_mapper_tcp6_new(void);
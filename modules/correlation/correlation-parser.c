@@ -51,6 +51,7 @@ static CfgLexerKeyword correlation_keywords[] =
   { "prefix",             KW_PREFIX },
   { "program_template",   KW_PROGRAM_TEMPLATE },
   { "message_template",   KW_MESSAGE_TEMPLATE },
+  { "shards",             KW_SHARDS },
 
   /* group lines */
   { "group_lines",        KW_GROUP_LINES },
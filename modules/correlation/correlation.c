@@ -25,44 +25,87 @@
 #include "correlation-context.h"
 #include "timeutils/cache.h"
 #include "timeutils/misc.h"
+#include "stats/stats-cluster-single.h"
+
+static inline CorrelationStateShard *
+_get_shard(CorrelationState *self, const CorrelationKey *key)
+{
+  if (self->num_shards == 1)
+    return self->shards[0];
+
+  /* the same hash selects the bucket within the shard's hash table,
+   * scramble it so that shards don't end up with correlated buckets */
+  guint hash = correlation_key_hash(key) * 2654435769U;
+  return self->shards[(hash >> 16) % self->num_shards];
+}
+
+static void
+_shard_lock(CorrelationStateShard *shard)
+{
+  if (g_mutex_trylock(&shard->lock))
+    return;
+
+  gint64 wait_start = g_get_monotonic_time();
+  g_mutex_lock(&shard->lock);
+  stats_counter_inc(shard->metrics.lock_contentions_total);
+  stats_counter_add(shard->metrics.lock_wait_seconds_total, (g_get_monotonic_time() - wait_start) * 1000);
+}
+
+static void
+_shard_unlock(CorrelationStateShard *shard)
+{
+  g_mutex_unlock(&shard->lock);
+}
+
+static void
+_shard_update_contexts(CorrelationStateShard *shard)
+{
+  stats_counter_set(shard->metrics.contexts, g_hash_table_size(shard->state));
+}
 
 void
-correlation_state_tx_begin(CorrelationState *self)
+correlation_state_tx_begin(CorrelationState *self, const CorrelationKey *key)
 {
-  g_mutex_lock(&self->lock);
+  _shard_lock(_get_shard(self, key));
 }
 
 void
-correlation_state_tx_end(CorrelationState *self)
+correlation_state_tx_end(CorrelationState *self, const CorrelationKey *key)
 {
-  g_mutex_unlock(&self->lock);
+  _shard_unlock(_get_shard(self, key));
 }
 
 CorrelationContext *
 correlation_state_tx_lookup_context(CorrelationState *self, const CorrelationKey *key)
 {
-  return g_hash_table_lookup(self->state, key);
+  return g_hash_table_lookup(_get_shard(self, key)->state, key);
 }
 
 void
 correlation_state_tx_store_context(CorrelationState *self, CorrelationContext *context, gint timeout)
 {
+  CorrelationStateShard *shard = _get_shard(self, &context->key);
+
   g_assert(context->timer == NULL);
 
-  g_hash_table_insert(self->state, &context->key, context);
-  context->timer = timer_wheel_add_timer(self->timer_wheel, timeout, self->expire_callback,
+  g_hash_table_insert(shard->state, &context->key, context);
+  context->timer = timer_wheel_add_timer(shard->timer_wheel, timeout, self->expire_callback,
                                          correlation_context_ref(context), (GDestroyNotify) correlation_context_unref);
+  _shard_update_contexts(shard);
 }
 
 void
 correlation_state_tx_remove_context(CorrelationState *self, CorrelationContext *context)
 {
+  CorrelationStateShard *shard = _get_shard(self, &context->key);
+
   /* NOTE: in expire callbacks our timer is already deleted and thus it is
    * set to NULL in which case we don't need to remove it again.  */
 
   if (context->timer)
-    timer_wheel_del_timer(self->timer_wheel, context->timer);
-  g_hash_table_remove(self->state, &context->key);
+    timer_wheel_del_timer(shard->timer_wheel, context->timer);
+  g_hash_table_remove(shard->state, &context->key);
+  _shard_update_contexts(shard);
 }
 
 void
@@ -70,26 +113,50 @@ correlation_state_tx_update_context(CorrelationState *self, CorrelationContext *
 {
   g_assert(context->timer != NULL);
 
-  timer_wheel_mod_timer(self->timer_wheel, context->timer, timeout);
+  timer_wheel_mod_timer(_get_shard(self, &context->key)->timer_wheel, context->timer, timeout);
 }
 
 void
 correlation_state_expire_all(CorrelationState *self, gpointer caller_context)
 {
-  g_mutex_lock(&self->lock);
-  timer_wheel_expire_all(self->timer_wheel, caller_context);
-  g_mutex_unlock(&self->lock);
+  for (gint i = 0; i < self->num_shards; i++)
+    {
+      CorrelationStateShard *shard = self->shards[i];
+
+      _shard_lock(shard);
+      timer_wheel_expire_all(shard->timer_wheel, caller_context);
+      _shard_unlock(shard);
+    }
+}
+
+/* Moves every shard forward to new_time, shards are locked one by one, so
+ * expiring the contexts of a shard does not hold up the others. */
+static void
+_set_time_of_shards(CorrelationState *self, guint64 new_time, gpointer caller_context)
+{
+  gssize now = atomic_gssize_get(&self->now);
+
+  while (now < (gssize) new_time)
+    {
+      if (atomic_gssize_compare_and_exchange(&self->now, now, new_time))
+        break;
+      now = atomic_gssize_get(&self->now);
+    }
+
+  for (gint i = 0; i < self->num_shards; i++)
+    {
+      CorrelationStateShard *shard = self->shards[i];
+
+      _shard_lock(shard);
+      timer_wheel_set_time(shard->timer_wheel, new_time, caller_context);
+      _shard_unlock(shard);
+    }
 }
 
 void
 correlation_state_advance_time(CorrelationState *self, gint timeout, gpointer caller_context)
 {
-  guint64  new_time;
-
-  g_mutex_lock(&self->lock);
-  new_time = timer_wheel_get_time(self->timer_wheel) + timeout;
-  timer_wheel_set_time(self->timer_wheel, new_time, caller_context);
-  g_mutex_unlock(&self->lock);
+  _set_time_of_shards(self, correlation_state_get_time(self) + timeout, caller_context);
 }
 
 void
@@ -108,15 +175,19 @@ correlation_state_set_time(CorrelationState *self, guint64 sec, gpointer caller_
   if (sec < now.tv_sec)
     now.tv_sec = sec;
 
-  g_mutex_lock(&self->lock);
-  timer_wheel_set_time(self->timer_wheel, now.tv_sec, caller_context);
-  g_mutex_unlock(&self->lock);
+  /* time is not allowed to go backwards, and most messages arrive within
+   * the same second, so this is usually decided without touching any of
+   * the shards */
+  if ((gssize) now.tv_sec <= atomic_gssize_get(&self->now))
+    return;
+
+  _set_time_of_shards(self, now.tv_sec, caller_context);
 }
 
 guint64
 correlation_state_get_time(CorrelationState *self)
 {
-  return timer_wheel_get_time(self->timer_wheel);
+  return atomic_gssize_get(&self->now);
 }
 
 gboolean
@@ -134,7 +205,7 @@ correlation_state_timer_tick(CorrelationState *self, gpointer caller_context)
     {
       glong diff_sec = (glong)(diff / 1e6);
 
-      timer_wheel_set_time(self->timer_wheel, timer_wheel_get_time(self->timer_wheel) + diff_sec, caller_context);
+      _set_time_of_shards(self, correlation_state_get_time(self) + diff_sec, caller_context);
       /* update last_tick, take the fraction of the seconds not calculated into this update into account */
 
       self->last_tick = now;
@@ -153,16 +224,126 @@ correlation_state_timer_tick(CorrelationState *self, gpointer caller_context)
   return updated;
 }
 
+/* The associated data is shared by all shards, only the first one owns
+ * it. */
+void
+correlation_state_set_associated_data(CorrelationState *self, gpointer assoc_data, GDestroyNotify assoc_data_free)
+{
+  timer_wheel_set_associated_data(self->shards[0]->timer_wheel, assoc_data, assoc_data_free);
+  for (gint i = 1; i < self->num_shards; i++)
+    timer_wheel_set_associated_data(self->shards[i]->timer_wheel, assoc_data, NULL);
+}
+
+static void
+_format_sc_key(const gchar *id, gint shard_index, StatsClusterKey *sc_key, const gchar *name)
+{
+  StatsClusterKey temp_sc_key;
+  gchar shard_index_buf[64];
+  g_snprintf(shard_index_buf, sizeof(shard_index_buf), "%d", shard_index);
+
+  StatsClusterLabel labels[2];
+  labels[0] = stats_cluster_label("id", id);
+  labels[1] = stats_cluster_label("shard_index", shard_index_buf);
+
+  stats_cluster_single_key_set(&temp_sc_key, name, labels, 2);
+  stats_cluster_key_clone(sc_key, &temp_sc_key);
+}
+
+void
+correlation_state_register_stats(CorrelationState *self, gint level, const gchar *id)
+{
+  g_assert(!self->stats_registered);
+
+  stats_lock();
+  for (gint i = 0; i < self->num_shards; i++)
+    {
+      CorrelationStateShard *shard = self->shards[i];
+
+      _format_sc_key(id, i, &shard->metrics.contexts_key, METRIC(correlation_contexts));
+      stats_register_counter(level, &shard->metrics.contexts_key, SC_TYPE_SINGLE_VALUE, &shard->metrics.contexts);
+
+      _format_sc_key(id, i, &shard->metrics.lock_contentions_total_key, METRIC(correlation_lock_contentions_total));
+      stats_register_counter(level, &shard->metrics.lock_contentions_total_key, SC_TYPE_SINGLE_VALUE,
+                             &shard->metrics.lock_contentions_total);
+
+      _format_sc_key(id, i, &shard->metrics.lock_wait_seconds_total_key, METRIC(correlation_lock_wait_seconds_total));
+      stats_cluster_key_add_unit(&shard->metrics.lock_wait_seconds_total_key, SCU_NANOSECONDS);
+      stats_register_counter(level, &shard->metrics.lock_wait_seconds_total_key, SC_TYPE_SINGLE_VALUE,
+                             &shard->metrics.lock_wait_seconds_total);
+    }
+  stats_unlock();
+
+  /* the state may have been inherited from the previous configuration */
+  for (gint i = 0; i < self->num_shards; i++)
+    {
+      CorrelationStateShard *shard = self->shards[i];
+
+      _shard_lock(shard);
+      _shard_update_contexts(shard);
+      _shard_unlock(shard);
+    }
+  self->stats_registered = TRUE;
+}
+
+void
+correlation_state_unregister_stats(CorrelationState *self)
+{
+  if (!self->stats_registered)
+    return;
+
+  stats_lock();
+  for (gint i = 0; i < self->num_shards; i++)
+    {
+      CorrelationStateShard *shard = self->shards[i];
+
+      stats_unregister_counter(&shard->metrics.contexts_key, SC_TYPE_SINGLE_VALUE, &shard->metrics.contexts);
+      stats_unregister_counter(&shard->metrics.lock_contentions_total_key, SC_TYPE_SINGLE_VALUE,
+                               &shard->metrics.lock_contentions_total);
+      stats_unregister_counter(&shard->metrics.lock_wait_seconds_total_key, SC_TYPE_SINGLE_VALUE,
+                               &shard->metrics.lock_wait_seconds_total);
+      stats_cluster_key_cloned_free(&shard->metrics.contexts_key);
+      stats_cluster_key_cloned_free(&shard->metrics.lock_contentions_total_key);
+      stats_cluster_key_cloned_free(&shard->metrics.lock_wait_seconds_total_key);
+    }
+  stats_unlock();
+  self->stats_registered = FALSE;
+}
+
+static CorrelationStateShard *
+_shard_new(void)
+{
+  CorrelationStateShard *shard = g_new0(CorrelationStateShard, 1);
+
+  g_mutex_init(&shard->lock);
+  shard->state = g_hash_table_new_full(correlation_key_hash, correlation_key_equal, NULL,
+                                       (GDestroyNotify) correlation_context_unref);
+  shard->timer_wheel = timer_wheel_new();
+  return shard;
+}
+
+static void
+_shard_free(CorrelationStateShard *shard)
+{
+  if (shard->state)
+    g_hash_table_destroy(shard->state);
+  timer_wheel_free(shard->timer_wheel);
+  g_mutex_clear(&shard->lock);
+  g_free(shard);
+}
 
 CorrelationState *
-correlation_state_new(TWCallbackFunc expire_callback)
+correlation_state_new(TWCallbackFunc expire_callback, gint num_shards)
 {
   CorrelationState *self = g_new0(CorrelationState, 1);
 
+  g_assert(num_shards > 0);
+
   g_mutex_init(&self->lock);
-  self->state = g_hash_table_new_full(correlation_key_hash, correlation_key_equal, NULL,
-                                      (GDestroyNotify) correlation_context_unref);
-  self->timer_wheel = timer_wheel_new();
+  self->num_shards = num_shards;
+  self->shards = g_new0(CorrelationStateShard *, num_shards);
+  for (gint i = 0; i < num_shards; i++)
+    self->shards[i] = _shard_new();
+  atomic_gssize_set(&self->now, 0);
   get_cached_realtime(&self->last_tick);
   g_atomic_counter_set(&self->ref_cnt, 1);
   self->expire_callback = expire_callback;
@@ -172,9 +353,10 @@ correlation_state_new(TWCallbackFunc expire_callback)
 void
 _free(CorrelationState *self)
 {
-  if (self->state)
-    g_hash_table_destroy(self->state);
-  timer_wheel_free(self->timer_wheel);
+  correlation_state_unregister_stats(self);
+  for (gint i = 0; i < self->num_shards; i++)
+    _shard_free(self->shards[i]);
+  g_free(self->shards);
   g_mutex_clear(&self->lock);
   g_free(self);
 }
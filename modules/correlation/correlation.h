@@ -28,19 +28,48 @@
 #include "correlation-context.h"
 #include "timerwheel.h"
 #include "timeutils/unixtime.h"
+#include "stats/stats-registry.h"
+#include "atomic-gssize.h"
 
-typedef struct _CorrelationState
+/* A shard holds the contexts whose key hashes to it, along with the timers
+ * that expire them.  Shards are independent: each has its own lock and
+ * its own timer wheel, so that messages that belong to different contexts
+ * can be correlated in parallel. */
+typedef struct _CorrelationStateShard
 {
-  GAtomicCounter ref_cnt;
   GMutex lock;
   GHashTable *state;
   TimerWheel *timer_wheel;
+  struct
+  {
+    StatsClusterKey contexts_key;
+    StatsClusterKey lock_contentions_total_key;
+    StatsClusterKey lock_wait_seconds_total_key;
+    StatsCounterItem *contexts;
+    StatsCounterItem *lock_contentions_total;
+    StatsCounterItem *lock_wait_seconds_total;
+  } metrics;
+} CorrelationStateShard;
+
+typedef struct _CorrelationState
+{
+  GAtomicCounter ref_cnt;
+  /* protects last_tick */
+  GMutex lock;
+  CorrelationStateShard **shards;
+  gint num_shards;
+  atomic_gssize now;
   TWCallbackFunc expire_callback;
   struct timespec last_tick;
+  gboolean stats_registered;
 } CorrelationState;
 
-void correlation_state_tx_begin(CorrelationState *self);
-void correlation_state_tx_end(CorrelationState *self);
+/* A transaction locks the shard of a single key, the tx_*() functions may
+ * only be used for contexts with that key until the transaction is ended.
+ * Expire callbacks are invoked with the shard of the expiring context
+ * locked. */
+void correlation_state_tx_begin(CorrelationState *self, const CorrelationKey *key);
+void correlation_state_tx_end(CorrelationState *self, const CorrelationKey *key);
 CorrelationContext *correlation_state_tx_lookup_context(CorrelationState *self, const CorrelationKey *key);
 void correlation_state_tx_store_context(CorrelationState *self, CorrelationContext *context, gint timeout);
 void correlation_state_tx_remove_context(CorrelationState *self, CorrelationContext *context);
@@ -52,9 +81,13 @@ gboolean correlation_state_timer_tick(CorrelationState *self, gpointer caller_co
 void correlation_state_expire_all(CorrelationState *self, gpointer caller_context);
 void correlation_state_advance_time(CorrelationState *self, gint timeout, gpointer caller_context);
 
+void correlation_state_set_associated_data(CorrelationState *self, gpointer assoc_data, GDestroyNotify assoc_data_free);
+void correlation_state_register_stats(CorrelationState *self, gint level, const gchar *id);
+void correlation_state_unregister_stats(CorrelationState *self);
+
 void correlation_state_init_instance(CorrelationState *self);
 void correlation_state_deinit_instance(CorrelationState *self);
-CorrelationState *correlation_state_new(TWCallbackFunc expire);
+CorrelationState *correlation_state_new(TWCallbackFunc expire, gint num_shards);
 CorrelationState *correlation_state_ref(CorrelationState *self);
 void correlation_state_unref(CorrelationState *self);
 
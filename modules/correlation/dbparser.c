@@ -36,7 +36,6 @@
 struct _LogDBParser
 {
   StatefulParser super;
-  GMutex lock;
   struct iv_timer tick;
   PatternDB *db;
   gchar *db_file;
@@ -44,7 +43,7 @@ struct _LogDBParser
   time_t db_file_last_check;
   ino_t db_file_inode;
   time_t db_file_mtime;
-  gboolean db_file_reloading;
+  gint db_file_reloading;
   gboolean drop_unmatched;
   LogTemplate *program_template;
 };
@@ -130,7 +129,16 @@ log_db_parser_init(LogPipe *s)
   self->db = cfg_persist_config_fetch(cfg, log_db_parser_format_persist_name(self));
 
   if (!self->db)
-    self->db = pattern_db_new(self->prefix);
+    {
+      self->db = pattern_db_new(self->prefix);
+      pattern_db_set_num_shards(self->db, self->super.num_shards);
+    }
+  else if (pattern_db_get_num_shards(self->db) != self->super.num_shards)
+    {
+      msg_warning("db-parser: shards() changed, the new value takes effect after restarting syslog-ng",
+                  evt_tag_int("shards", pattern_db_get_num_shards(self->db)),
+                  log_pipe_location_tag(&self->super.super.super));
+    }
 
   log_db_parser_reload_database(self);
   if (self->db)
@@ -148,7 +156,11 @@ log_db_parser_init(LogPipe *s)
   iv_timer_register(&self->tick);
   if (!self->db)
     return FALSE;
-  return stateful_parser_init_method(s);
+  if (!stateful_parser_init_method(s))
+    return FALSE;
+
+  pattern_db_register_stats(self->db, STATS_LEVEL4, self->super.super.name);
+  return TRUE;
 }
 
 static gboolean
@@ -162,6 +174,7 @@ log_db_parser_deinit(LogPipe *s)
       iv_timer_unregister(&self->tick);
     }
 
+  pattern_db_unregister_stats(self->db);
   cfg_persist_config_add(cfg, log_db_parser_format_persist_name(self), self->db, (GDestroyNotify) pattern_db_free);
   self->db = NULL;
   return stateful_parser_deinit_method(s);
@@ -174,29 +187,27 @@ log_db_parser_process(LogParser *s, LogMessage **pmsg, const LogPathOptions *pat
   LogDBParser *self = (LogDBParser *) s;
   gboolean matched = FALSE;
 
-  if (G_UNLIKELY(!self->db_file_reloading && (self->db_file_last_check == 0
-                                              || self->db_file_last_check < (*pmsg)->timestamps[LM_TS_RECVD].ut_sec - 5)))
+  if (G_UNLIKELY(!g_atomic_int_get(&self->db_file_reloading) && (self->db_file_last_check == 0
+                  || self->db_file_last_check < (*pmsg)->timestamps[LM_TS_RECVD].ut_sec - 5)))
     {
-      /* first check if we need to reload without doing a lock, then grab
-       * the lock, recheck the condition to rule out parallel database
-       * reloads. This avoids a lock in the fast path. */
-
-      g_mutex_lock(&self->lock);
+      /* first check if we need to reload without any synchronization, then
+       * claim the reload and recheck the condition to rule out parallel
+       * database reloads. */
 
-      if (!self->db_file_reloading && (self->db_file_last_check == 0
-                                       || self->db_file_last_check < (*pmsg)->timestamps[LM_TS_RECVD].ut_sec - 5))
+      if (g_atomic_int_compare_and_exchange(&self->db_file_reloading, FALSE, TRUE))
         {
-          self->db_file_last_check = (*pmsg)->timestamps[LM_TS_RECVD].ut_sec;
-          self->db_file_reloading = TRUE;
-          g_mutex_unlock(&self->lock);
-
-          /* only one thread may come here, the others may continue to use self->db, until we update it here. */
-          log_db_parser_reload_database(self);
-
-          g_mutex_lock(&self->lock);
-          self->db_file_reloading = FALSE;
+          if (self->db_file_last_check == 0
+              || self->db_file_last_check < (*pmsg)->timestamps[LM_TS_RECVD].ut_sec - 5)
+            {
+              self->db_file_last_check = (*pmsg)->timestamps[LM_TS_RECVD].ut_sec;
+
+              /* only one thread may come here, the others may continue to
+               * use self->db, the new ruleset is published without
+               * stopping their lookups */
+              log_db_parser_reload_database(self);
+            }
+          g_atomic_int_set(&self->db_file_reloading, FALSE);
         }
-      g_mutex_unlock(&self->lock);
     }
   if (self->db)
     {
@@ -275,7 +286,6 @@ log_db_parser_free(LogPipe *s)
   LogDBParser *self = (LogDBParser *) s;
 
   log_template_unref(self->program_template);
-  g_mutex_clear(&self->lock);
 
   if (self->db)
     pattern_db_free(self->db);
@@ -297,7 +307,6 @@ log_db_parser_new(GlobalConfig *cfg)
   self->super.super.super.clone = log_db_parser_clone;
   self->super.super.process = log_db_parser_process;
   self->db_file = g_strdup(get_installation_path_for(PATH_PATTERNDB_FILE));
-  g_mutex_init(&self->lock);
   if (cfg_is_config_version_older(cfg, VERSION_VALUE_3_3))
     {
       msg_warning_once("WARNING: The default behaviour for injecting messages in db-parser() has changed in " VERSION_3_3
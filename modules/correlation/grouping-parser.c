@@ -113,6 +113,8 @@ _advance_time_based_on_message(GroupingParser *self, const UnixTime *ls,
             log_pipe_location_tag(&self->super.super.super));
 }
 
+static void _expire_entry(TimerWheel *wheel, guint64 now, gpointer user_data, gpointer caller_context);
+
 static void
 _load_correlation_state(GroupingParser *self, GlobalConfig *cfg)
 {
@@ -120,17 +122,27 @@ _load_correlation_state(GroupingParser *self, GlobalConfig *cfg)
                                             log_pipe_get_persist_name(&self->super.super.super));
   if (persisted_correlation)
     {
+      if (persisted_correlation->num_shards != self->super.num_shards)
+        msg_warning("grouping-parser: shards() changed, the new value takes effect after restarting syslog-ng",
+                    evt_tag_int("shards", persisted_correlation->num_shards),
+                    log_pipe_location_tag(&self->super.super.super));
       correlation_state_unref(self->correlation);
       self->correlation = persisted_correlation;
     }
+  else if (self->correlation->num_shards != self->super.num_shards)
+    {
+      correlation_state_unref(self->correlation);
+      self->correlation = correlation_state_new(_expire_entry, self->super.num_shards);
+    }
 
-  timer_wheel_set_associated_data(self->correlation->timer_wheel, log_pipe_ref((LogPipe *)self),
-                                  (GDestroyNotify)log_pipe_unref);
+  correlation_state_set_associated_data(self->correlation, log_pipe_ref((LogPipe *)self),
+                                        (GDestroyNotify)log_pipe_unref);
 }
 
 static void
 _store_data_in_persist(GroupingParser *self, GlobalConfig *cfg)
 {
+  correlation_state_unregister_stats(self->correlation);
   cfg_persist_config_add(cfg, log_pipe_get_persist_name(&self->super.super.super),
                          correlation_state_ref(self->correlation),
                          (GDestroyNotify) correlation_state_unref);
@@ -180,6 +192,8 @@ _expire_entry(TimerWheel *wheel, guint64 now, gpointer user_data, gpointer calle
 }
 
 
+/* Begins a transaction on the key of the message, which is ended by the
+ * caller, using the key of the returned context. */
 CorrelationContext *
 grouping_parser_lookup_or_create_context(GroupingParser *self, LogMessage *msg)
 {
@@ -190,6 +204,7 @@ grouping_parser_lookup_or_create_context(GroupingParser *self, LogMessage *msg)
   log_template_format(self->key_template, msg, &DEFAULT_TEMPLATE_EVAL_OPTIONS, buffer);
 
   correlation_key_init(&key, self->scope, msg, buffer->str);
+  correlation_state_tx_begin(self->correlation, &key);
   context = correlation_state_tx_lookup_context(self->correlation, &key);
   if (!context)
     {
@@ -221,7 +236,7 @@ _aggregate_and_emit(GroupingParser *self, CorrelationContext *context, StatefulP
 {
   LogMessage *genmsg = grouping_parser_aggregate_context(self, context);
   correlation_state_tx_update_context(self->correlation, context, self->timeout);
-  correlation_state_tx_end(self->correlation);
+  correlation_state_tx_end(self->correlation, &context->key);
   if (genmsg)
     {
       stateful_parser_emitted_messages_add(emitted_messages, genmsg);
@@ -232,8 +247,6 @@ _aggregate_and_emit(GroupingParser *self, CorrelationContext *context, StatefulP
 void
 grouping_parser_perform_grouping(GroupingParser *self, LogMessage *msg, StatefulParserEmittedMessages *emitted_messages)
 {
-  correlation_state_tx_begin(self->correlation);
-
   CorrelationContext *context = grouping_parser_lookup_or_create_context(self, msg);
 
   GroupingParserUpdateContextResult r = grouping_parser_update_context(self, context, msg);
@@ -246,7 +259,7 @@ grouping_parser_perform_grouping(GroupingParser *self, LogMessage *msg, Stateful
                 evt_tag_int("expiration", correlation_state_get_time(self->correlation) + self->timeout),
                 log_pipe_location_tag(&self->super.super.super));
       correlation_state_tx_update_context(self->correlation, context, self->timeout);
-      correlation_state_tx_end(self->correlation);
+      correlation_state_tx_end(self->correlation, &context->key);
     }
   else if (r == GP_CONTEXT_COMPLETE)
     {
@@ -306,7 +319,11 @@ grouping_parser_init_method(LogPipe *s)
 
   _load_correlation_state(self, cfg);
 
-  return stateful_parser_init_method(s);
+  if (!stateful_parser_init_method(s))
+    return FALSE;
+
+  correlation_state_register_stats(self->correlation, STATS_LEVEL4, self->super.super.name);
+  return TRUE;
 }
 
 gboolean
@@ -346,7 +363,7 @@ grouping_parser_init_instance(GroupingParser *self, GlobalConfig *cfg)
   self->super.super.process = grouping_parser_process_method;
   self->scope = RCS_GLOBAL;
   self->timeout = -1;
-  self->correlation = correlation_state_new(_expire_entry);
+  self->correlation = correlation_state_new(_expire_entry, 1);
 }
 
 void
@@ -199,6 +199,22 @@ _init(LogPipe *s)
   return grouping_parser_init_method(s);
 }
 
+static gboolean
+_deinit(LogPipe *s)
+{
+  GroupingBy *self = (GroupingBy *) s;
+  GlobalConfig *cfg = log_pipe_get_config(s);
+
+  if (self->trigger_condition_expr)
+    filter_expr_deinit(self->trigger_condition_expr, cfg);
+  if (self->where_condition_expr)
+    filter_expr_deinit(self->where_condition_expr, cfg);
+  if (self->having_condition_expr)
+    filter_expr_deinit(self->having_condition_expr, cfg);
+
+  return grouping_parser_deinit_method(s);
+}
+
 static LogPipe *
 _clone(LogPipe *s)
 {
@@ -247,6 +263,7 @@ grouping_by_new(GlobalConfig *cfg)
   grouping_parser_init_instance(&self->super, cfg);
   self->super.super.super.super.free_fn = _free;
   self->super.super.super.super.init = _init;
+  self->super.super.super.super.deinit = _deinit;
   self->super.super.super.super.clone = _clone;
   self->super.super.super.super.generate_persist_name = _format_persist_name;
   self->super.filter_messages = _evaluate_where;
@@ -36,6 +36,7 @@
 #include "str-utils.h"
 #include "filter/filter-expr-parser.h"
 #include "logpipe.h"
+#include "mainloop-worker.h"
 #include "timeutils/cache.h"
 #include "timeutils/misc.h"
 
@@ -48,12 +49,28 @@ static NVHandle context_id_handle = 0;
 
 #define EXPECTED_NUMBER_OF_MESSAGES_EMITTED 32
 
+/* must be a power of 2 */
+#define PDB_RULESET_READER_SHARDS 16
+#define PDB_RULESET_READER_SHARD_SIZE 64
+
+/* Number of lookups using the ruleset, per generation.  Lookups are
+ * counted in the slot of the current worker thread, each on its own
+ * cache line, so that they don't contend with each other. */
+typedef union _PDBRuleSetReaders
+{
+  gint count[2];
+  gchar _pad[PDB_RULESET_READER_SHARD_SIZE];
+} PDBRuleSetReaders;
+
 typedef struct _PDBProcessParams
 {
   PDBRule *rule;
   PDBAction *action;
   PDBContext *context;
   LogMessage *msg;
+  /* contexts created by actions, they are stored once the state is
+   * unlocked, as they may belong to a different shard */
+  GPtrArray *new_contexts;
   gpointer emitted_messages[EXPECTED_NUMBER_OF_MESSAGES_EMITTED];
   GPtrArray *emitted_messages_overflow;
   gint num_emitted_messages;
@@ -61,10 +78,18 @@ typedef struct _PDBProcessParams
 
 struct _PatternDB
 {
+  /* serializes ruleset updates, lookups do not take it */
   GMutex ruleset_lock;
   PDBRuleSet *ruleset;
+  gint ruleset_generation;
+  PDBRuleSetReaders ruleset_readers[PDB_RULESET_READER_SHARDS];
+  /* the previous ruleset, freed once the lookups that may use it are finished */
+  PDBRuleSet *retired_ruleset;
+  gint retired_generation;
   CorrelationState *correlation;
+  gint num_shards;
   LogTemplate *program_template;
+  GMutex rate_limits_lock;
   GHashTable *rate_limits;
   PatternDBEmitFunc emit;
   gpointer emit_data;
@@ -109,16 +134,39 @@ _send_emitted_message_array(PatternDB *self, gpointer *values, gsize len)
     }
 }
 
+static void
+_store_new_contexts(PatternDB *self, PDBProcessParams *process_params)
+{
+  if (!process_params->new_contexts)
+    return;
+
+  for (gint i = 0; i < process_params->new_contexts->len; i++)
+    {
+      PDBContext *context = g_ptr_array_index(process_params->new_contexts, i);
+
+      correlation_state_tx_begin(self->correlation, &context->super.key);
+      correlation_state_tx_store_context(self->correlation, &context->super, context->rule->context.timeout);
+      correlation_state_tx_end(self->correlation, &context->super.key);
+    }
+  g_ptr_array_free(process_params->new_contexts, TRUE);
+  process_params->new_contexts = NULL;
+}
+
 /* This function is called to flush the accumulated list of messages that
  * are generated during rule evaluation.  We must not hold any locks within
  * PatternDB when doing this, as it will cause log_pipe_queue() calls to
  * subsequent elements in the message pipeline, which in turn may recurse
  * into PatternDB.  This works as process_params itself is per-thread
  * (actually an auto variable on the stack), and this is called without
- * locks held at the end of a pattern_db_process() invocation. */
+ * locks held at the end of a pattern_db_process() invocation.
+ *
+ * Contexts created by actions are stored here too, before the messages
+ * are sent, so that messages recursing into PatternDB find them. */
 static void
 _flush_emitted_messages(PatternDB *self, PDBProcessParams *process_params)
 {
+  _store_new_contexts(self, process_params);
+
   /* send inline elements */
   _send_emitted_message_array(self, process_params->emitted_messages, process_params->num_emitted_messages);
   process_params->num_emitted_messages = 0;
@@ -188,6 +236,7 @@ _is_action_within_rate_limit(PatternDB *db, PDBProcessParams *process_params)
   g_string_printf(buffer, "%s:%d", rule->rule_id, action->id);
   correlation_key_init(&key, rule->context.scope, msg, buffer->str);
 
+  g_mutex_lock(&db->rate_limits_lock);
   rl = g_hash_table_lookup(db->rate_limits, &key);
   if (!rl)
     {
@@ -221,12 +270,11 @@ _is_action_within_rate_limit(PatternDB *db, PDBProcessParams *process_params)
           rl->last_check = now;
         }
     }
-  if (rl->buckets)
-    {
-      rl->buckets--;
-      return TRUE;
-    }
-  return FALSE;
+  gboolean within_rate_limit = rl->buckets > 0;
+  if (within_rate_limit)
+    rl->buckets--;
+  g_mutex_unlock(&db->rate_limits_lock);
+  return within_rate_limit;
 }
 
 static gboolean
@@ -319,12 +367,15 @@ _execute_action_create_context(PatternDB *db, PDBProcessParams *process_params)
 
   correlation_key_init(&key, syn_context->scope, context_msg, buffer->str);
   new_context = pdb_context_new(&key);
-  correlation_state_tx_store_context(db->correlation, &new_context->super, rule->context.timeout);
   g_string_free(buffer, FALSE);
 
   g_ptr_array_add(new_context->super.messages, context_msg);
 
   new_context->rule = pdb_rule_ref(rule);
+
+  if (!process_params->new_contexts)
+    process_params->new_contexts = g_ptr_array_new();
+  g_ptr_array_add(process_params->new_contexts, new_context);
 }
 
 static void
@@ -376,12 +427,11 @@ _execute_rule_actions(PatternDB *db, PDBProcessParams *process_params, PDBAction
  * PatternDB
  *********************************************************/
 
-/* NOTE: this function requires PatternDB reader/writer lock to be
- * write-locked.
+/* NOTE: this function requires the shard of the context to be locked.
  *
- * Currently, it is, as timer_wheel_set_time() is only called with that
- * precondition, and timer-wheel callbacks are only called from within
- * timer_wheel_set_time().
+ * Currently, it is, as timer-wheel callbacks are only called from within
+ * timer_wheel_set_time(), which CorrelationState calls with the shard
+ * locked.
  */
 
 static void
@@ -421,6 +471,10 @@ pattern_db_timer_tick(PatternDB *self)
 {
   PDBProcessParams process_params = {0};
 
+  g_mutex_lock(&self->ruleset_lock);
+  _free_retired_ruleset(self, FALSE);
+  g_mutex_unlock(&self->ruleset_lock);
+
   if (correlation_state_timer_tick(self->correlation, &process_params))
     {
       msg_debug("Advancing patterndb current time because of timer tick",
@@ -448,6 +502,99 @@ pattern_db_advance_time(PatternDB *self, gint timeout)
   _flush_emitted_messages(self, &process_params);
 }
 
+/*
+ * Ruleset updates
+ * ===============
+ *
+ * Lookups don't take any locks, the ruleset is published with an atomic
+ * pointer store instead, and the old one is freed once no lookups use it
+ * anymore.
+ *
+ * Lookups are counted in one of two generations: a lookup reads the
+ * current generation, increments its counter, checks that the generation
+ * is still the same (retrying otherwise) and only then loads the ruleset
+ * pointer.  An update stores the new pointer first and flips the
+ * generation after that, so lookups that may still use the old ruleset are
+ * all counted in the old generation.  The old ruleset is freed when that
+ * generation drains, which is checked right after the update and at every
+ * timer tick.  The next update waits for it, so that the old generation is
+ * not reused while it still has lookups of an older ruleset.
+ */
+
+static PDBRuleSet *
+_ruleset_read_begin(PatternDB *self, gint **readers)
+{
+  gint shard = (main_loop_worker_get_thread_index() + 1) & (PDB_RULESET_READER_SHARDS - 1);
+
+  while (TRUE)
+    {
+      gint generation = g_atomic_int_get(&self->ruleset_generation);
+
+      *readers = &self->ruleset_readers[shard].count[generation];
+      g_atomic_int_inc(*readers);
+
+      /* if an update flipped the generation before we were counted, it may
+       * have found our generation drained already, and the next update
+       * would not wait for us */
+      if (g_atomic_int_get(&self->ruleset_generation) == generation)
+        break;
+
+      g_atomic_int_add(*readers, -1);
+    }
+
+  return g_atomic_pointer_get(&self->ruleset);
+}
+
+static void
+_ruleset_read_end(PatternDB *self, gint *readers)
+{
+  g_atomic_int_add(readers, -1);
+}
+
+static gboolean
+_ruleset_generation_drained(PatternDB *self, gint generation)
+{
+  for (gint i = 0; i < PDB_RULESET_READER_SHARDS; i++)
+    {
+      if (g_atomic_int_get(&self->ruleset_readers[i].count[generation]) != 0)
+        return FALSE;
+    }
+  return TRUE;
+}
+
+/* NOTE: requires ruleset_lock to be held */
+static void
+_free_retired_ruleset(PatternDB *self, gboolean wait)
+{
+  if (!self->retired_ruleset)
+    return;
+
+  while (!_ruleset_generation_drained(self, self->retired_generation))
+    {
+      if (!wait)
+        return;
+      g_thread_yield();
+    }
+
+  pdb_rule_set_free(self->retired_ruleset);
+  self->retired_ruleset = NULL;
+}
+
+/* NOTE: requires ruleset_lock to be held */
+static void
+_publish_ruleset(PatternDB *self, PDBRuleSet *new_ruleset)
+{
+  _free_retired_ruleset(self, TRUE);
+
+  self->retired_ruleset = self->ruleset;
+  self->retired_generation = self->ruleset_generation;
+
+  g_atomic_pointer_set(&self->ruleset, new_ruleset);
+  g_atomic_int_set(&self->ruleset_generation, !self->retired_generation);
+
+  _free_retired_ruleset(self, FALSE);
+}
+
 gboolean
 pattern_db_reload_ruleset(PatternDB *self, GlobalConfig *cfg, const gchar *pdb_file)
 {
@@ -461,10 +608,10 @@ pattern_db_reload_ruleset(PatternDB *self, GlobalConfig *cfg, const gchar *pdb_f
     }
   else
     {
+      pdb_rule_set_freeze(new_ruleset);
+
       g_mutex_lock(&self->ruleset_lock);
-      if (self->ruleset)
-        pdb_rule_set_free(self->ruleset);
-      self->ruleset = new_ruleset;
+      _publish_ruleset(self, new_ruleset);
       g_mutex_unlock(&self->ruleset_lock);
       return TRUE;
     }
@@ -504,9 +651,9 @@ pattern_db_get_ruleset(PatternDB *self)
 }
 
 static gboolean
-_pattern_db_is_empty(PatternDB *self)
+_pattern_db_is_empty(PDBRuleSet *ruleset)
 {
-  return (G_UNLIKELY(!self->ruleset) || self->ruleset->is_empty);
+  return (G_UNLIKELY(!ruleset) || ruleset->is_empty);
 }
 
 static void
@@ -517,7 +664,6 @@ _pattern_db_process_matching_rule(PatternDB *self, PDBProcessParams *process_par
   LogMessage *msg = process_params->msg;
   GString *buffer = g_string_sized_new(32);
 
-  correlation_state_tx_begin(self->correlation);
   if (rule->context.id_template)
     {
       CorrelationKey key;
@@ -526,6 +672,7 @@ _pattern_db_process_matching_rule(PatternDB *self, PDBProcessParams *process_par
       log_msg_set_value(msg, context_id_handle, buffer->str, -1);
 
       correlation_key_init(&key, rule->context.scope, msg, buffer->str);
+      correlation_state_tx_begin(self->correlation, &key);
       context = (PDBContext *) correlation_state_tx_lookup_context(self->correlation, &key);
       if (!context)
         {
@@ -570,10 +717,12 @@ _pattern_db_process_matching_rule(PatternDB *self, PDBProcessParams *process_par
   _execute_rule_actions(self, process_params, RAT_MATCH);
 
   pdb_rule_unref(rule);
-  correlation_state_tx_end(self->correlation);
 
   if (context)
-    log_msg_write_protect(msg);
+    {
+      correlation_state_tx_end(self->correlation, &context->super.key);
+      log_msg_write_protect(msg);
+    }
 
   g_string_free(buffer, TRUE);
 }
@@ -594,15 +743,16 @@ _pattern_db_process(PatternDB *self, PDBLookupParams *lookup, GArray *dbg_list)
   PDBProcessParams process_params_p = {0};
   PDBProcessParams *process_params = &process_params_p;
 
-  g_mutex_lock(&self->ruleset_lock);
-  if (_pattern_db_is_empty(self))
+  gint *ruleset_readers;
+  PDBRuleSet *ruleset = _ruleset_read_begin(self, &ruleset_readers);
+  if (_pattern_db_is_empty(ruleset))
     {
-      g_mutex_unlock(&self->ruleset_lock);
+      _ruleset_read_end(self, ruleset_readers);
       return FALSE;
     }
-  process_params->rule = pdb_ruleset_lookup(self->ruleset, lookup, dbg_list);
+  process_params->rule = pdb_ruleset_lookup(ruleset, lookup, dbg_list);
   process_params->msg = msg;
-  g_mutex_unlock(&self->ruleset_lock);
+  _ruleset_read_end(self, ruleset_readers);
 
   _pattern_db_advance_time_and_flush_expired(self, msg);
 
@@ -652,13 +802,19 @@ pattern_db_expire_state(PatternDB *self)
 
 }
 
+static void
+_init_correlation_state(PatternDB *self)
+{
+  self->correlation = correlation_state_new(pattern_db_expire_entry, self->num_shards);
+  correlation_state_set_associated_data(self->correlation, self, NULL);
+}
+
 static void
 _init_state(PatternDB *self)
 {
   self->rate_limits = g_hash_table_new_full(correlation_key_hash, correlation_key_equal, NULL,
                                             (GDestroyNotify) pdb_rate_limit_free);
-  self->correlation = correlation_state_new(pattern_db_expire_entry);
-  timer_wheel_set_associated_data(self->correlation->timer_wheel, self, NULL);
+  _init_correlation_state(self);
 }
 
 static void
@@ -670,6 +826,37 @@ _destroy_state(PatternDB *self)
 }
 
 
+/* NOTE: this function must be called before processing messages, the
+ * correlation state is recreated with the new number of shards. */
+void
+pattern_db_set_num_shards(PatternDB *self, gint num_shards)
+{
+  if (self->num_shards == num_shards)
+    return;
+
+  self->num_shards = num_shards;
+  correlation_state_unref(self->correlation);
+  _init_correlation_state(self);
+}
+
+gint
+pattern_db_get_num_shards(PatternDB *self)
+{
+  return self->num_shards;
+}
+
+void
+pattern_db_register_stats(PatternDB *self, gint level, const gchar *id)
+{
+  correlation_state_register_stats(self->correlation, level, id);
+}
+
+void
+pattern_db_unregister_stats(PatternDB *self)
+{
+  correlation_state_unregister_stats(self->correlation);
+}
+
 /* NOTE: this function is for testing only and is not expecting parallel
  * threads taking actions within the same PatternDB instance. */
 void
@@ -686,7 +873,9 @@ pattern_db_new(const gchar *prefix)
 
   self->prefix = g_strdup(prefix);
   self->ruleset = pdb_rule_set_new(self->prefix);
+  self->num_shards = 1;
   g_mutex_init(&self->ruleset_lock);
+  g_mutex_init(&self->rate_limits_lock);
   _init_state(self);
   return self;
 }
@@ -696,9 +885,11 @@ pattern_db_free(PatternDB *self)
 {
   g_free(self->prefix);
   log_template_unref(self->program_template);
+  _free_retired_ruleset(self, TRUE);
   if (self->ruleset)
     pdb_rule_set_free(self->ruleset);
   _destroy_state(self);
+  g_mutex_clear(&self->rate_limits_lock);
   g_mutex_clear(&self->ruleset_lock);
   g_free(self);
 }
@@ -47,6 +47,10 @@ gboolean pattern_db_process_with_custom_message(PatternDB *self, LogMessage *msg
 void pattern_db_debug_ruleset(PatternDB *self, LogMessage *msg, GArray *dbg_list);
 void pattern_db_expire_state(PatternDB *self);
 void pattern_db_forget_state(PatternDB *self);
+void pattern_db_set_num_shards(PatternDB *self, gint num_shards);
+gint pattern_db_get_num_shards(PatternDB *self);
+void pattern_db_register_stats(PatternDB *self, gint level, const gchar *id);
+void pattern_db_unregister_stats(PatternDB *self);
 
 PatternDB *pattern_db_new(const gchar *prefix);
 void pattern_db_free(PatternDB *self);
@@ -182,6 +182,37 @@ pdb_rule_set_new(const gchar *prefix)
   return self;
 }
 
+static void
+_freeze_program_rules(RNode *node)
+{
+  PDBProgram *program = (PDBProgram *) node->value;
+  gint i;
+
+  /* a program may be shared between several program patterns, freezing
+   * an already frozen tree is a no-op */
+  if (program && program->rules)
+    program->rules = r_freeze_tree(program->rules);
+
+  for (i = 0; i < node->num_children; i++)
+    _freeze_program_rules(node->children[i]);
+  for (i = 0; i < node->num_pchildren; i++)
+    _freeze_program_rules(node->pchildren[i]);
+}
+
+/*
+ * Lays out the radix trees of a completely loaded ruleset for lookups,
+ * rules can't be added to it afterwards.
+ */
+void
+pdb_rule_set_freeze(PDBRuleSet *self)
+{
+  if (!self->programs)
+    return;
+
+  _freeze_program_rules(self->programs);
+  self->programs = r_freeze_tree(self->programs);
+}
+
 void
 pdb_rule_set_free(PDBRuleSet *self)
 {
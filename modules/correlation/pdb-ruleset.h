@@ -40,6 +40,7 @@ typedef struct _PDBRuleSet
 
 PDBRule *pdb_ruleset_lookup(PDBRuleSet *rule_set, PDBLookupParams *lookup, GArray *dbg_list);
 PDBRuleSet *pdb_rule_set_new(const gchar *prefix);
+void pdb_rule_set_freeze(PDBRuleSet *self);
 void pdb_rule_set_free(PDBRuleSet *self);
 
 void pdb_rule_set_global_init(void);
@@ -24,11 +24,20 @@
 #include "radix.h"
 #include "compat/pcre.h"
 #include "str-utils.h"
+#include "cpu-features.h"
 
 #include <string.h>
 #include <stdlib.h>
 #include <limits.h>
 
+#if CPU_FEATURES_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#if CPU_FEATURES_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
 /**************************************************************
  * Parsing nodes.
  **************************************************************/
@@ -991,12 +1000,86 @@ r_find_pchild(RNode *parent, RParserNode *parser_node)
   return node;
 }
 
+/* the child index is padded to a multiple of 16 bytes, the first chars of
+ * the children are unique, so the first hit is the only one */
+#define R_CHILD_INDEX_SIZE(num_children) (((num_children) + 15) & ~15U)
+
+static gboolean child_index_use_sse2;
+
+#if CPU_FEATURES_HAVE_X86_SIMD
+
+__attribute__((target("sse2")))
+static gint
+_find_in_child_index_sse2(const gchar *child_index, guint num_children, gchar key)
+{
+  const __m128i k = _mm_set1_epi8(key);
+
+  for (guint i = 0; i < num_children; i += 16)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *) (child_index + i));
+      guint32 mask = (guint32) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, k));
+
+      if (mask)
+        {
+          guint ndx = i + __builtin_ctz(mask);
+          return ndx < num_children ? ndx : -1;
+        }
+    }
+  return -1;
+}
+
+#endif
+
+#if CPU_FEATURES_HAVE_NEON
+
+static gint
+_find_in_child_index_neon(const gchar *child_index, guint num_children, gchar key)
+{
+  const uint8x16_t k = vdupq_n_u8((guint8) key);
+
+  for (guint i = 0; i < num_children; i += 16)
+    {
+      uint8x16_t chunk = vld1q_u8((const uint8_t *) (child_index + i));
+      /* narrow the byte mask to 4 bits per byte, NEON has no movemask */
+      guint64 mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(vceqq_u8(chunk, k)), 4)), 0);
+
+      if (mask)
+        {
+          guint ndx = i + (__builtin_ctzll(mask) >> 2);
+          return ndx < num_children ? ndx : -1;
+        }
+    }
+  return -1;
+}
+
+#endif
+
+static inline gint
+_find_in_child_index(const gchar *child_index, guint num_children, gchar key)
+{
+#if CPU_FEATURES_HAVE_X86_SIMD
+  if (G_LIKELY(child_index_use_sse2))
+    return _find_in_child_index_sse2(child_index, num_children, key);
+#elif CPU_FEATURES_HAVE_NEON
+  return _find_in_child_index_neon(child_index, num_children, key);
+#endif
+
+  const gchar *hit = memchr(child_index, key, num_children);
+  return hit ? hit - child_index : -1;
+}
+
 RNode *
 r_find_child_by_first_character(RNode *root, char key)
 {
   register gint l, u, idx;
   register char k = key;
 
+  if (root->child_index)
+    {
+      idx = _find_in_child_index(root->child_index, root->num_children, k);
+      return idx >= 0 ? root->children[idx] : NULL;
+    }
+
   l = 0;
   u = root->num_children;
 
@@ -1024,6 +1107,8 @@ r_insert_node(RNode *root, gchar *key, gpointer value,
   gint nodelen = root->keylen;
   gint i = 0;
 
+  g_assert(!root->frozen);
+
   if (key[0] == '@')
     {
       gchar *end;
@@ -1636,11 +1721,202 @@ r_new_node(const gchar *key, gpointer value)
   return node;
 }
 
+/**************************************************************
+ * Frozen trees.
+ *
+ * Once loading is finished the tree is only read, so it is copied into a
+ * single allocation in breadth first order: siblings are adjacent and each
+ * node is followed by its parser, child pointers and key.  Nodes with
+ * literal children get a table of their first characters, which is
+ * scanned with SIMD instead of the binary search over the children.
+ **************************************************************/
+
+#define R_FROZEN_ALIGN(size) (((size) + 7) & ~((gsize) 7))
+
+static gsize
+_frozen_node_size(RNode *node)
+{
+  gsize size = R_FROZEN_ALIGN(sizeof(RNode));
+
+  if (node->parser)
+    size += R_FROZEN_ALIGN(sizeof(RParserNode));
+  size += R_FROZEN_ALIGN(sizeof(RNode *) * (node->num_children + node->num_pchildren));
+  if (node->num_children)
+    size += R_FROZEN_ALIGN(R_CHILD_INDEX_SIZE(node->num_children));
+  if (node->key)
+    size += R_FROZEN_ALIGN(node->keylen + 1);
+  if (node->pdb_location)
+    size += R_FROZEN_ALIGN(strlen(node->pdb_location) + 1);
+  return size;
+}
+
+static gpointer
+_frozen_alloc(gchar **p, gsize size)
+{
+  gpointer result = *p;
+
+  *p += R_FROZEN_ALIGN(size);
+  return result;
+}
+
+/* @first_child is the breadth first index of the first child of @node, its
+ * children are followed by its pchildren */
+static void
+_freeze_node(RNode *node, RNode *frozen, gchar *arena, const gsize *offsets, guint first_child)
+{
+  guint num_all_children = node->num_children + node->num_pchildren;
+  gchar *p = (gchar *) frozen;
+  gint i;
+
+  _frozen_alloc(&p, sizeof(RNode));
+  *frozen = *node;
+  frozen->frozen = TRUE;
+  frozen->children = NULL;
+  frozen->pchildren = NULL;
+
+  if (node->parser)
+    {
+      frozen->parser = _frozen_alloc(&p, sizeof(RParserNode));
+      *frozen->parser = *node->parser;
+    }
+
+  RNode **child_ptrs = _frozen_alloc(&p, sizeof(RNode *) * num_all_children);
+  for (i = 0; i < num_all_children; i++)
+    child_ptrs[i] = (RNode *) (arena + offsets[first_child + i]);
+  if (node->num_children)
+    frozen->children = child_ptrs;
+  if (node->num_pchildren)
+    frozen->pchildren = child_ptrs + node->num_children;
+
+  if (node->num_children)
+    {
+      gchar *child_index = _frozen_alloc(&p, R_CHILD_INDEX_SIZE(node->num_children));
+
+      for (i = 0; i < node->num_children; i++)
+        child_index[i] = node->children[i]->key[0];
+      frozen->child_index = child_index;
+    }
+
+  if (node->key)
+    {
+      frozen->key = _frozen_alloc(&p, node->keylen + 1);
+      memcpy(frozen->key, node->key, node->keylen + 1);
+    }
+
+  if (node->pdb_location)
+    {
+      gsize len = strlen(node->pdb_location) + 1;
+
+      frozen->pdb_location = _frozen_alloc(&p, len);
+      memcpy(frozen->pdb_location, node->pdb_location, len);
+    }
+}
+
+/* the parameters and the state of the parser and the value are taken over
+ * by the frozen copy */
+static void
+_free_node_structure(RNode *node)
+{
+  g_free(node->children);
+  g_free(node->pchildren);
+  g_free(node->key);
+  g_free(node->pdb_location);
+  g_free(node->parser);
+  g_free(node);
+}
+
+/*
+ * Copies the tree under @root into a single allocation and frees the
+ * original nodes.  Lookups work the same way on the returned tree, but
+ * nodes can't be inserted anymore.
+ */
+RNode *
+r_freeze_tree(RNode *root)
+{
+  GPtrArray *nodes;
+  GArray *first_children;
+  gsize *offsets;
+  gsize size = 0;
+  gchar *arena;
+  guint i, j;
+
+  if (root->frozen)
+    return root;
+
+  nodes = g_ptr_array_new();
+  first_children = g_array_new(FALSE, FALSE, sizeof(guint));
+
+  g_ptr_array_add(nodes, root);
+  for (i = 0; i < nodes->len; i++)
+    {
+      RNode *node = g_ptr_array_index(nodes, i);
+      guint first_child = nodes->len;
+
+      g_array_append_val(first_children, first_child);
+      for (j = 0; j < node->num_children; j++)
+        g_ptr_array_add(nodes, node->children[j]);
+      for (j = 0; j < node->num_pchildren; j++)
+        g_ptr_array_add(nodes, node->pchildren[j]);
+    }
+
+  offsets = g_new(gsize, nodes->len);
+  for (i = 0; i < nodes->len; i++)
+    {
+      offsets[i] = size;
+      size += _frozen_node_size(g_ptr_array_index(nodes, i));
+    }
+
+  arena = g_malloc0(size);
+  for (i = 0; i < nodes->len; i++)
+    _freeze_node(g_ptr_array_index(nodes, i), (RNode *) (arena + offsets[i]), arena, offsets,
+                 g_array_index(first_children, guint, i));
+
+  for (i = 0; i < nodes->len; i++)
+    _free_node_structure(g_ptr_array_index(nodes, i));
+
+  child_index_use_sse2 = cpu_supports_sse2();
+
+  g_free(offsets);
+  g_array_free(first_children, TRUE);
+  g_ptr_array_free(nodes, TRUE);
+  return (RNode *) arena;
+}
+
+static void
+_free_frozen_node_contents(RNode *node, void (*free_fn)(gpointer data))
+{
+  gint i;
+
+  for (i = 0; i < node->num_children; i++)
+    _free_frozen_node_contents(node->children[i], free_fn);
+
+  for (i = 0; i < node->num_pchildren; i++)
+    _free_frozen_node_contents(node->pchildren[i], free_fn);
+
+  if (node->parser)
+    {
+      g_free(node->parser->param);
+      if (node->parser->state && node->parser->free_state)
+        node->parser->free_state(node->parser->state);
+    }
+
+  if (node->value && free_fn)
+    free_fn(node->value);
+}
+
 void
 r_free_node(RNode *node, void (*free_fn)(gpointer data))
 {
   gint i;
 
+  if (node->frozen)
+    {
+      /* the whole tree lives in the allocation of its root */
+      _free_frozen_node_contents(node, free_fn);
+      g_free(node);
+      return;
+    }
+
   for (i = 0; i < node->num_children; i++)
     r_free_node(node->children[i], free_fn);
 
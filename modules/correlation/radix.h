@@ -97,8 +97,11 @@ struct _RNode
   gchar *pdb_location;
   guint num_children;
   RNode **children;
+  /* the first characters of the children, only set in frozen trees */
+  const gchar *child_index;
 
   guint num_pchildren;
+  gboolean frozen;
   RNode **pchildren;
 };
 
@@ -157,6 +160,7 @@ RNode *r_new_node(const gchar *key, gpointer value);
 void r_free_node(RNode *node, void (*free_fn)(gpointer data));
 void r_insert_node(RNode *root, gchar *key, gpointer value,
                    const gchar *capture_prefix, RNodeGetValueFunc value_func, const gchar *location);
+RNode *r_freeze_tree(RNode *root);
 RNode *r_find_node(RNode *root, gchar *key, gint keylen, GArray *matches);
 RNode *r_find_node_dbg(RNode *root, gchar *key, gint keylen, GArray *matches, GArray *dbg_list);
 gchar **r_find_all_applicable_nodes(RNode *root, gchar *key, gint keylen, RNodeGetValueFunc value_func);
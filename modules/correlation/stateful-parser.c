@@ -30,11 +30,18 @@ stateful_parser_set_inject_mode(StatefulParser *self, LogDBParserInjectMode inje
   self->inject_mode = inject_mode;
 }
 
+void
+stateful_parser_set_num_shards(StatefulParser *self, gint num_shards)
+{
+  self->num_shards = num_shards;
+}
+
 void
 stateful_parser_clone_settings(StatefulParser *self, StatefulParser *cloned)
 {
   log_parser_clone_settings(&self->super, &cloned->super);
   cloned->inject_mode = self->inject_mode;
+  cloned->num_shards = self->num_shards;
 }
 
 void
@@ -90,6 +97,7 @@ stateful_parser_init_instance(StatefulParser *self, GlobalConfig *cfg)
   log_parser_init_instance(&self->super, cfg);
   self->super.super.queue = _queue;
   self->inject_mode = LDBP_IM_PASSTHROUGH;
+  self->num_shards = 1;
 }
 
 void
@@ -37,6 +37,8 @@ typedef struct _StatefulParser
 {
   LogParser super;
   LogDBParserInjectMode inject_mode;
+  /* number of independently locked partitions of the correlation state */
+  gint num_shards;
 } StatefulParser;
 
 static inline gboolean
@@ -52,6 +54,7 @@ stateful_parser_deinit_method(LogPipe *s)
 }
 
 void stateful_parser_set_inject_mode(StatefulParser *self, LogDBParserInjectMode inject_mode);
+void stateful_parser_set_num_shards(StatefulParser *self, gint num_shards);
 void stateful_parser_clone_settings(StatefulParser *self, StatefulParser *cloned);
 void stateful_parser_emit_synthetic(StatefulParser *self, LogMessage *msg);
 void stateful_parser_emit_synthetic_list(StatefulParser *self, LogMessage **values, gsize len);
@@ -37,7 +37,9 @@
 #include "plugin.h"
 #include "cfg.h"
 #include "timerwheel.h"
+#include "mainloop-worker.h"
 
+#include <iv.h>
 #include <stdio.h>
 #include <sys/time.h>
 #include <time.h>
@@ -534,6 +536,109 @@ Test(pattern_db, test_correlation_rule_with_create_context)
   g_free(filename);
 }
 
+Test(pattern_db, test_correlation_rule_with_create_context_in_sharded_state)
+{
+  gchar *filename;
+  PatternDB *patterndb = _create_pattern_db(pdb_ruletest_skeleton, &filename);
+
+  /* the created context may land in a different shard than the one that
+   * is locked when the action runs */
+  pattern_db_set_num_shards(patterndb, 16);
+
+  assert_msg_matches_and_nvpair_equals(patterndb, "correlated-message-with-action-to-create-context",
+                                       ".classifier.rule_id", "14");
+  _dont_reset_patterndb_state_for_the_next_call();
+  assert_msg_matches_and_nvpair_equals(patterndb, "correlated-message-that-uses-context-created-by-rule-id#14",
+                                       "triggering-message", "context message 1001 assd");
+  _dont_reset_patterndb_state_for_the_next_call();
+  assert_msg_matches_and_nvpair_equals(patterndb, "correlated-message-that-uses-context-created-by-rule-id#14",
+                                       "triggering-message-context-id", "1001");
+
+  _destroy_pattern_db(patterndb, filename);
+  g_free(filename);
+}
+
+Test(pattern_db, test_ruleset_reload_replaces_the_ruleset_in_use)
+{
+  gchar *filename;
+  PatternDB *patterndb = _create_pattern_db(pdb_ruletest_skeleton, &filename);
+
+  /* each reload retires the previous ruleset, the one before that is freed */
+  for (gint i = 0; i < 3; i++)
+    {
+      cr_assert(pattern_db_reload_ruleset(patterndb, configuration, filename));
+      assert_msg_matches_and_nvpair_equals(patterndb, "simple-message-with-action-to-create-context",
+                                           ".classifier.rule_id", "12");
+    }
+
+  _destroy_pattern_db(patterndb, filename);
+  g_free(filename);
+}
+
+#define RELOAD_STRESS_THREADS 4
+#define RELOAD_STRESS_RELOADS 200
+
+typedef struct _ReloadStressState
+{
+  PatternDB *patterndb;
+  gint stop;
+  gint lookups;
+  gint mismatches;
+} ReloadStressState;
+
+static gpointer
+_lookup_while_reloading(gpointer user_data)
+{
+  ReloadStressState *state = (ReloadStressState *) user_data;
+
+  iv_init();
+  main_loop_worker_thread_start(MLW_ASYNC_WORKER);
+
+  while (!g_atomic_int_get(&state->stop))
+    {
+      main_loop_worker_run_gc();
+
+      LogMessage *msg = _construct_message("prog1", "simple-message");
+      if (!pattern_db_process(state->patterndb, msg)
+          || strcmp(log_msg_get_value_by_name(msg, "simple-msg-value-1", NULL), "value1") != 0)
+        g_atomic_int_inc(&state->mismatches);
+      log_msg_unref(msg);
+
+      g_atomic_int_inc(&state->lookups);
+    }
+
+  main_loop_worker_thread_stop();
+  iv_deinit();
+  return NULL;
+}
+
+Test(pattern_db, test_ruleset_reload_while_lookups_are_running)
+{
+  gchar *filename;
+  PatternDB *patterndb = _create_pattern_db(pdb_ruletest_skeleton, &filename);
+  ReloadStressState state = { .patterndb = patterndb };
+  GThread *threads[RELOAD_STRESS_THREADS];
+
+  main_loop_worker_allocate_thread_space(RELOAD_STRESS_THREADS);
+  main_loop_worker_finalize_thread_space();
+
+  for (gint i = 0; i < RELOAD_STRESS_THREADS; i++)
+    threads[i] = g_thread_new(NULL, _lookup_while_reloading, &state);
+
+  for (gint i = 0; i < RELOAD_STRESS_RELOADS; i++)
+    cr_assert(pattern_db_reload_ruleset(patterndb, configuration, filename));
+
+  g_atomic_int_set(&state.stop, TRUE);
+  for (gint i = 0; i < RELOAD_STRESS_THREADS; i++)
+    g_thread_join(threads[i]);
+
+  cr_assert_gt(state.lookups, 0);
+  cr_assert_eq(state.mismatches, 0, "%d of %d lookups failed during reloads", state.mismatches, state.lookups);
+
+  _destroy_pattern_db(patterndb, filename);
+  g_free(filename);
+}
+
 Test(pattern_db, test_patterndb_loads_a_syntactically_complete_xml_properly)
 {
   gchar *filename;
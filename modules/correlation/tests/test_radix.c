@@ -28,6 +28,7 @@
 #include "apphook.h"
 #include "radix.h"
 #include "messages.h"
+#include "libtest/stopwatch.h"
 
 #include <stdio.h>
 #include <sys/time.h>
@@ -1212,3 +1213,119 @@ Test(dbparser, test_radix_zorp_log, .init = test_setup, .fini = test_teardown)
 
   r_free_node(root, NULL);
 }
+
+Test(dbparser, test_frozen_tree_lookups, .init = test_setup, .fini = test_teardown)
+{
+  RNode *root = r_new_node("", NULL);
+  gchar key[] = "?literal";
+
+  /* more first characters than a single 16 byte chunk of the child index */
+  for (gint c = ' ' + 1; c < 127; c++)
+    {
+      if (c == '@')
+        continue;
+      key[0] = c;
+      insert_node_with_value(root, key, GINT_TO_POINTER(c));
+    }
+  insert_node(root, "a@NUMBER:number@aaa");
+  insert_node(root, "a@NUMBER@aa");
+  insert_node(root, "a@@ab");
+  insert_node(root, "AAA@PCRE:set@AAA");
+  insert_node(root, "newline@NUMBER@\n2ndline\n");
+  insert_node(root, "@@a");
+
+  root = r_freeze_tree(root);
+  cr_assert(root->frozen);
+  cr_assert(r_freeze_tree(root) == root, "freezing a frozen tree should be a no-op");
+
+  for (gint c = ' ' + 1; c < 127; c++)
+    {
+      if (c == '@')
+        continue;
+      key[0] = c;
+      RNode *node = r_find_node(root, key, strlen(key), NULL);
+      cr_assert(node, "node not found. key=%s\n", key);
+      cr_assert_eq(GPOINTER_TO_INT(node->value), c);
+    }
+
+  test_search(root, "\tliteral", FALSE);
+  test_search(root, "\x80literal", FALSE);
+  test_search_value(root, "a15555aaa", "a@NUMBER:number@aaa");
+  test_search_value(root, "a15555aa", "a@NUMBER@aa");
+  test_search_value(root, "a@ab", "a@@ab");
+  test_search_value(root, "newline123\r\n2ndline\n", "newline@NUMBER@\n2ndline\n");
+  test_search_value(root, "@a", "@@a");
+
+  const gchar *expected_pattern[] = { "number", "15555", NULL };
+  test_search_matches(root, "a15555aaa", expected_pattern);
+
+  r_free_node(root, NULL);
+}
+
+#define PERF_PROGRAMS 64
+#define PERF_PATTERNS 64
+#define PERF_ITERATIONS 20
+
+static void
+_format_perf_pattern(GString *pattern, gint program, gint ndx)
+{
+  g_string_printf(pattern, "%c%02d service%d: session @NUMBER:session@ opened for user @ESTRING:user: @from @IPv4:ip@",
+                  'A' + program % 58, program, ndx);
+}
+
+static void
+_format_perf_message(GString *message, gint program, gint ndx)
+{
+  g_string_printf(message, "%c%02d service%d: session %d opened for user root from 10.0.0.%d",
+                  'A' + program % 58, program, ndx, program * ndx, ndx);
+}
+
+static void
+_perform_lookups(RNode *root, const gchar *title)
+{
+  GArray *matches = g_array_new(FALSE, TRUE, sizeof(RParserMatch));
+  GString *message = g_string_new("");
+  gint found = 0;
+
+  start_stopwatch();
+  for (gint i = 0; i < PERF_ITERATIONS; i++)
+    {
+      for (gint program = 0; program < PERF_PROGRAMS; program++)
+        {
+          for (gint ndx = 0; ndx < PERF_PATTERNS; ndx++)
+            {
+              _format_perf_message(message, program, ndx);
+              g_array_set_size(matches, 1);
+              if (r_find_node(root, message->str, message->len, matches))
+                found++;
+            }
+        }
+    }
+  stop_stopwatch_and_display_result(PERF_ITERATIONS * PERF_PROGRAMS * PERF_PATTERNS, "%s", title);
+  cr_assert_eq(found, PERF_ITERATIONS * PERF_PROGRAMS * PERF_PATTERNS);
+
+  g_string_free(message, TRUE);
+  g_array_free(matches, TRUE);
+}
+
+Test(dbparser, test_lookup_performance, .init = test_setup, .fini = test_teardown)
+{
+  RNode *root = r_new_node("", NULL);
+  GString *pattern = g_string_new("");
+
+  for (gint program = 0; program < PERF_PROGRAMS; program++)
+    {
+      for (gint ndx = 0; ndx < PERF_PATTERNS; ndx++)
+        {
+          _format_perf_pattern(pattern, program, ndx);
+          r_insert_node(root, pattern->str, GINT_TO_POINTER(1), NULL, NULL, NULL);
+        }
+    }
+  g_string_free(pattern, TRUE);
+
+  _perform_lookups(root, "radix lookups");
+  root = r_freeze_tree(root);
+  _perform_lookups(root, "radix lookups, frozen tree");
+
+  r_free_node(root, NULL);
+}
@@ -83,11 +83,38 @@ disk_queue_options_set_prealloc(DiskQueueOptions *self, gboolean prealloc)
   self->prealloc = prealloc;
 }
 
+void
+disk_queue_options_set_sync_interval(DiskQueueOptions *self, gint sync_interval)
+{
+  self->sync_interval = sync_interval;
+}
+
+void
+disk_queue_options_set_sync_bytes(DiskQueueOptions *self, gint64 sync_bytes)
+{
+  self->sync_bytes = sync_bytes;
+}
+
+void
+disk_queue_options_set_compression(DiskQueueOptions *self, gboolean compression)
+{
+#if !SYSLOG_NG_HAVE_ZSTD
+  if (compression)
+    {
+      msg_warning("WARNING: compression() parameter was ignored as syslog-ng was compiled without zstd support");
+      compression = FALSE;
+    }
+#endif
+  self->compression = compression;
+}
+
 void
 disk_queue_options_check_plugin_settings(DiskQueueOptions *self)
 {
   if (!self->reliable && self->flow_control_window_bytes > 0)
     msg_warning("WARNING: flow-control-window-bytes/mem-buf-size parameter was ignored as it is not compatible with non-reliable queue");
+  if (!self->reliable && (self->sync_interval > 0 || self->sync_bytes > 0))
+    msg_warning("WARNING: sync-interval() and sync-bytes() parameters were ignored as they are only supported by reliable queues");
 }
 
 gchar *
@@ -123,6 +150,9 @@ disk_queue_options_set_default_options(DiskQueueOptions *self)
   self->dir = g_strdup(get_installation_path_for(SYSLOG_NG_PATH_LOCALSTATEDIR));
   self->truncate_size_ratio = -1;
   self->prealloc = -1;
+  self->sync_interval = 0;
+  self->sync_bytes = 0;
+  self->compression = FALSE;
 }
 
 void
@@ -40,6 +40,10 @@ typedef struct _DiskQueueOptions
   gchar *dir;
   gdouble truncate_size_ratio;
   gboolean prealloc;
+  /* group commit for reliable queues, 0 disables the respective trigger */
+  gint sync_interval;
+  gint64 sync_bytes;
+  gboolean compression;
 } DiskQueueOptions;
 
 void disk_queue_options_front_cache_size_set(DiskQueueOptions *self, gint front_cache_size);
@@ -52,6 +56,9 @@ void disk_queue_options_check_plugin_settings(DiskQueueOptions *self);
 void disk_queue_options_set_dir(DiskQueueOptions *self, const gchar *dir);
 void disk_queue_options_set_truncate_size_ratio(DiskQueueOptions *self, gdouble truncate_size_ratio);
 void disk_queue_options_set_prealloc(DiskQueueOptions *self, gboolean prealloc);
+void disk_queue_options_set_sync_interval(DiskQueueOptions *self, gint sync_interval);
+void disk_queue_options_set_sync_bytes(DiskQueueOptions *self, gint64 sync_bytes);
+void disk_queue_options_set_compression(DiskQueueOptions *self, gboolean compression);
 void disk_queue_options_set_default_options(DiskQueueOptions *self);
 void disk_queue_options_destroy(DiskQueueOptions *self);
 
@@ -44,6 +44,9 @@ static CfgLexerKeyword diskq_keywords[] =
   { "dir",               KW_DIR },
   { "truncate_size_ratio", KW_TRUNCATE_SIZE_RATIO },
   { "prealloc",          KW_PREALLOC },
+  { "sync_interval",     KW_SYNC_INTERVAL },
+  { "sync_bytes",        KW_SYNC_BYTES },
+  { "compression",       KW_COMPRESSION },
   { "stats",             KW_STATS },
   { "freq",              KW_FREQ },
   { NULL }
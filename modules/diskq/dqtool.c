@@ -271,6 +271,11 @@ dqtool_info(int argc, char *argv[])
       if (!open_queue(argv[i], &lq, &options, TRUE))
         continue;
 
+      /* compressed records are decompressed by qdisk when they are read, by cat as well */
+      QDisk *qdisk = ((LogQueueDisk *) lq)->qdisk;
+      printf("Disk-buffer %s, compression: %s, compression dictionary: %" G_GSIZE_FORMAT " bytes\n", argv[i],
+             qdisk_get_compression_name(qdisk), qdisk_get_compression_dictionary_size(qdisk));
+
       gboolean persistent;
       log_queue_disk_stop(lq, &persistent);
       log_queue_unref(lq);
@@ -186,7 +186,8 @@ _log_internal_state(LogQueueDiskNonReliable *self, const gchar *operation)
   msg_info("Non-reliable disk-buffer state",
            evt_tag_str("operation", operation),
            evt_tag_str("filename", qdisk_get_filename(self->super.qdisk)),
-           evt_tag_long("number_of_messages", log_queue_get_length(&self->super.super)));
+           evt_tag_long("number_of_messages", log_queue_get_length(&self->super.super)),
+           evt_tag_str("compression", qdisk_get_compression_name(self->super.qdisk)));
 
   msg_debug("Non-reliable disk-buffer internal state",
             evt_tag_str("operation", operation),
@@ -27,10 +27,13 @@
 #include "logqueue-disk-reliable.h"
 #include "messages.h"
 #include "scratch-buffers.h"
+#include "stats/aggregator/stats-aggregator.h"
 
 /*pessimistic default for reliable disk queue 10000 x 16 kbyte*/
 #define PESSIMISTIC_FLOW_CONTROL_WINDOW_BYTES 10000 * 16 *1024
 #define ENTRIES_PER_MSG_IN_MEM_Q 3
+/* the longest time a message waits for its commit when only sync-bytes() is set */
+#define MAX_COMMIT_DELAY_MSEC 1000
 
 #define LOG_PATH_OPTIONS_FOR_BACKLOG GINT_TO_POINTER(0x80000000)
 #define LOG_PATH_OPTIONS_TO_POINTER(lpo) GUINT_TO_POINTER(0x80000000 | (lpo)->ack_needed)
@@ -81,7 +84,8 @@ _log_internal_state(LogQueueDisk *self, const gchar *operation)
   msg_info("Reliable disk-buffer state",
            evt_tag_str("operation", operation),
            evt_tag_str("filename", qdisk_get_filename(self->qdisk)),
-           evt_tag_long("number_of_messages", log_queue_get_length(&self->super)));
+           evt_tag_long("number_of_messages", log_queue_get_length(&self->super)),
+           evt_tag_str("compression", qdisk_get_compression_name(self->qdisk)));
 
   msg_debug("Reliable disk-buffer internal state",
             evt_tag_str("filename", qdisk_get_filename(self->qdisk)),
@@ -127,6 +131,157 @@ _empty_queue(LogQueueDiskReliable *self, GQueue *queue)
     }
 }
 
+static void
+_ack_committed_messages(GQueue *queue)
+{
+  while (queue && queue->length > 0)
+    {
+      gint64 position;
+      LogMessage *msg;
+      LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+      _pop_from_memory_queue_head(queue, &position, &msg, &path_options);
+      log_msg_ack(msg, &path_options, AT_PROCESSED);
+      log_msg_unref(msg);
+    }
+}
+
+/*
+ * The records of the commit are taken under the queue's lock, then they are
+ * written and synced without holding it, so that producers and the
+ * consumer can go on meanwhile.  The messages of the commit are moved to
+ * the committing queue, the ones pushed while the file is synced belong to
+ * the next commit.
+ *
+ * NOTE: must be called from the commit thread, with the queue's lock held.
+ * While commit_running is set, the qdisk must not be stopped, see
+ * _wait_for_commit().
+ */
+static void
+_commit(LogQueueDiskReliable *self)
+{
+  LogQueue *s = &self->super.super;
+  QDisk *qdisk = self->super.qdisk;
+
+  if (!qdisk_commit_begin(qdisk))
+    return;
+
+  GQueue *committing = self->uncommitted;
+  self->uncommitted = self->committing;
+  self->committing = committing;
+  self->commit_running = TRUE;
+
+  gint64 start_time = g_get_monotonic_time();
+
+  g_mutex_unlock(&s->lock);
+  gboolean result = qdisk_commit_sync(qdisk);
+  g_mutex_lock(&s->lock);
+
+  qdisk_commit_finish(qdisk);
+
+  g_mutex_unlock(&s->lock);
+  result = qdisk_commit_sync_header(qdisk) && result;
+  g_mutex_lock(&s->lock);
+
+  self->commit_running = FALSE;
+  g_cond_broadcast(&self->commit_cond);
+
+  if (!result)
+    msg_error("Failed to commit reliable disk-buffer",
+              evt_tag_str("filename", qdisk_get_filename(qdisk)),
+              evt_tag_str("persist_name", s->persist_name));
+
+  stats_aggregator_add_data_point(self->super.metrics.commit_latency, (g_get_monotonic_time() - start_time) / 1000);
+  _ack_committed_messages(self->committing);
+
+  /* the committed messages can be read now */
+  if (qdisk_get_length(qdisk) > 0)
+    log_queue_push_notify(s);
+}
+
+/* NOTE: requires the queue's lock to be held */
+static void
+_wait_for_commit(LogQueueDiskReliable *self)
+{
+  while (self->commit_running)
+    g_cond_wait(&self->commit_cond, &self->super.super.lock);
+}
+
+static inline gint
+_get_commit_delay(LogQueueDiskReliable *self)
+{
+  gint sync_interval = qdisk_get_options(self->super.qdisk)->sync_interval;
+  return sync_interval > 0 ? sync_interval : MAX_COMMIT_DELAY_MSEC;
+}
+
+/*
+ * Commits are done when sync-interval() or sync-bytes() is reached.  The
+ * last records pushed to an idle queue are committed after the commit
+ * delay, otherwise they would never be acked, and flow-control could block
+ * the source forever.
+ */
+static gpointer
+_commit_thread_func(gpointer s)
+{
+  LogQueueDiskReliable *self = (LogQueueDiskReliable *) s;
+  QDisk *qdisk = self->super.qdisk;
+
+  g_mutex_lock(&self->super.super.lock);
+  while (!self->commit_thread_quit)
+    {
+      if (!qdisk_started(qdisk) || !qdisk_has_uncommitted_records(qdisk))
+        {
+          g_cond_wait(&self->commit_cond, &self->super.super.lock);
+          continue;
+        }
+
+      gint64 deadline = qdisk_get_first_uncommitted_time(qdisk) + (gint64) _get_commit_delay(self) * 1000;
+      if (!qdisk_is_commit_due(qdisk) && g_get_monotonic_time() < deadline)
+        {
+          g_cond_wait_until(&self->commit_cond, &self->super.super.lock, deadline);
+          continue;
+        }
+
+      _commit(self);
+    }
+  g_mutex_unlock(&self->super.super.lock);
+
+  return NULL;
+}
+
+static void
+_stop_commit_thread(LogQueueDiskReliable *self)
+{
+  if (!self->commit_thread)
+    return;
+
+  g_mutex_lock(&self->super.super.lock);
+  self->commit_thread_quit = TRUE;
+  g_cond_broadcast(&self->commit_cond);
+  g_mutex_unlock(&self->super.super.lock);
+
+  g_thread_join(self->commit_thread);
+  self->commit_thread = NULL;
+}
+
+/*
+ * With sync-interval() or sync-bytes() the record may only be buffered or
+ * written without being synced yet, in that case the ack is delayed until the
+ * next commit.
+ */
+static void
+_ack_when_committed(LogQueueDiskReliable *self, gint64 position, LogMessage *msg, const LogPathOptions *path_options)
+{
+  if (!qdisk_has_uncommitted_records(self->super.qdisk))
+    {
+      log_msg_ack(msg, path_options, AT_PROCESSED);
+      log_msg_unref(msg);
+      return;
+    }
+
+  _push_to_memory_queue_tail(self->uncommitted, position, msg, path_options);
+}
+
 static gint64
 _get_length(LogQueue *s)
 {
@@ -243,10 +398,11 @@ _rewind_backlog_all(LogQueue *s)
   _rewind_backlog(s, G_MAXUINT);
 }
 
+/* uncommitted messages cannot be read yet, even if they are kept in memory */
 static inline gboolean
 _is_next_message_in_flow_control_window(LogQueueDiskReliable *self)
 {
-  if (self->flow_control_window->length == 0)
+  if (self->flow_control_window->length == 0 || qdisk_get_length(self->super.qdisk) == 0)
     return FALSE;
 
   return _peek_memory_queue_head_position(self->flow_control_window) == qdisk_get_next_head_position(self->super.qdisk);
@@ -255,7 +411,7 @@ _is_next_message_in_flow_control_window(LogQueueDiskReliable *self)
 static inline gboolean
 _is_next_message_in_front_cache(LogQueueDiskReliable *self)
 {
-  if (self->front_cache->length == 0)
+  if (self->front_cache->length == 0 || qdisk_get_length(self->super.qdisk) == 0)
     return FALSE;
 
   return _peek_memory_queue_head_position(self->front_cache) == qdisk_get_next_head_position(self->super.qdisk);
@@ -380,6 +536,7 @@ _push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *path_options)
 
   g_mutex_lock(&s->lock);
 
+  gboolean had_uncommitted_records = qdisk_has_uncommitted_records(self->super.qdisk);
   gint64 message_position = qdisk_get_next_tail_position(self->super.qdisk);
   if (!qdisk_push_tail(self->super.qdisk, serialized_msg))
     {
@@ -423,31 +580,35 @@ _push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *path_options)
       goto exit;
     }
 
-  log_msg_ack(msg, path_options, AT_PROCESSED);
-
   if (_is_space_available_in_front_cache(self))
     {
       /*
        * Keep the message in memory for fast-path.
-       * Set its ack_needed to FALSE, because we have already acked it.
+       * Set its ack_needed to FALSE, because the ack is handled below.
        */
       LogPathOptions local_path_options;
       log_path_options_chain(&local_path_options, path_options);
       local_path_options.ack_needed = FALSE;
-      _push_to_memory_queue_tail(self->front_cache, message_position, msg, &local_path_options);
+      _push_to_memory_queue_tail(self->front_cache, message_position, log_msg_ref(msg), &local_path_options);
       log_queue_memory_usage_add(s, log_msg_get_size(msg));
-      goto exit;
     }
 
-  log_msg_unref(msg);
+  _ack_when_committed(self, message_position, msg, path_options);
 
 exit:
   log_queue_queued_messages_inc(s);
 
+  /* the commit thread learns about the first record of a commit to start the
+   * commit delay, and about the ones that make the commit due */
+  if ((!had_uncommitted_records && qdisk_has_uncommitted_records(self->super.qdisk))
+      || qdisk_is_commit_due(self->super.qdisk))
+    g_cond_signal(&self->commit_cond);
+
   /* this releases the queue's lock for a short time, which may violate the
    * consistency of the disk-buffer, so it must be the last call under lock in this function
    */
-  log_queue_push_notify(s);
+  if (qdisk_get_length(self->super.qdisk) > 0)
+    log_queue_push_notify(s);
   g_mutex_unlock(&s->lock);
 }
 
@@ -456,6 +617,8 @@ _free(LogQueue *s)
 {
   LogQueueDiskReliable *self = (LogQueueDiskReliable *)s;
 
+  _stop_commit_thread(self);
+
   gboolean persistent;
   log_queue_disk_stop(&self->super.super, &persistent);
 
@@ -480,6 +643,21 @@ _free(LogQueue *s)
       self->front_cache = NULL;
     }
 
+  if (self->uncommitted)
+    {
+      g_assert(g_queue_is_empty(self->uncommitted));
+      g_queue_free(self->uncommitted);
+      self->uncommitted = NULL;
+    }
+
+  if (self->committing)
+    {
+      g_assert(g_queue_is_empty(self->committing));
+      g_queue_free(self->committing);
+      self->committing = NULL;
+    }
+
+  g_cond_clear(&self->commit_cond);
   log_queue_disk_free_method(&self->super);
 }
 
@@ -490,6 +668,8 @@ _stop(LogQueueDisk *s, gboolean *persistent)
 
   gboolean result = FALSE;
 
+  _wait_for_commit(self);
+
   _log_internal_state(s, "save");
   if (qdisk_stop(s->qdisk, NULL, NULL))
     {
@@ -497,6 +677,9 @@ _stop(LogQueueDisk *s, gboolean *persistent)
       result = TRUE;
     }
 
+  /* qdisk_stop() has committed everything that could be committed */
+  _ack_committed_messages(self->committing);
+  _ack_committed_messages(self->uncommitted);
   _empty_queue(self, self->flow_control_window);
   _empty_queue(self, self->front_cache);
   _empty_queue(self, self->backlog);
@@ -547,7 +730,13 @@ log_queue_disk_reliable_new(DiskQueueOptions *options, const gchar *filename, co
   self->flow_control_window = g_queue_new();
   self->backlog = g_queue_new();
   self->front_cache = g_queue_new();
+  self->uncommitted = g_queue_new();
+  self->committing = g_queue_new();
+  g_cond_init(&self->commit_cond);
   self->front_cache_size = options->front_cache_size;
   _set_virtual_functions(self);
+
+  if (options->sync_interval > 0 || options->sync_bytes > 0)
+    self->commit_thread = g_thread_new("diskq-commit", _commit_thread_func, self);
   return &self->super.super;
 }
@@ -32,6 +32,17 @@ typedef struct _LogQueueDiskReliable
   GQueue *flow_control_window;
   GQueue *backlog;
   GQueue *front_cache;
+  /* messages written to the disk-buffer but not yet synced, acked by the next commit */
+  GQueue *uncommitted;
+  /* messages of the commit in progress */
+  GQueue *committing;
+  /* syncs the disk-buffer with sync-interval() or sync-bytes(), so that
+   * neither producers nor the main loop wait for the disk */
+  GThread *commit_thread;
+  GCond commit_cond;
+  gboolean commit_thread_quit;
+  /* the commit thread is writing the disk-buffer without the queue's lock */
+  gboolean commit_running;
   gint front_cache_size;
 } LogQueueDiskReliable;
 
@@ -28,6 +28,8 @@
 #include "logmsg/logmsg-serialize.h"
 #include "stats/stats-registry.h"
 #include "stats/stats-cluster-single.h"
+#include "stats/aggregator/stats-aggregator-registry.h"
+#include "compat/pow2.h"
 #include "reloc.h"
 #include "qdisk.h"
 #include "scratch-buffers.h"
@@ -136,6 +138,15 @@ _unregister_counters(LogQueueDisk *self)
       }
   }
   stats_unlock();
+
+  if (self->metrics.commit_latency_sc_key)
+    {
+      stats_aggregator_lock();
+      stats_unregister_aggregator(&self->metrics.commit_latency);
+      stats_aggregator_unlock();
+
+      stats_cluster_key_free(self->metrics.commit_latency_sc_key);
+    }
 }
 
 void
@@ -374,6 +385,23 @@ log_queue_disk_restart_corrupted(LogQueueDisk *self)
   stats_counter_set(self->metrics.capacity, B_TO_KiB(qdisk_get_max_useful_space(self->qdisk)));
 }
 
+static void
+_register_commit_latency(LogQueueDisk *self, StatsClusterKeyBuilder *builder)
+{
+  stats_cluster_key_builder_push(builder);
+  {
+    stats_cluster_key_builder_set_name(builder, "commit_latency_seconds");
+    stats_cluster_key_builder_set_unit(builder, SCU_MILLISECONDS);
+    self->metrics.commit_latency_sc_key = stats_cluster_key_builder_build_hist(builder);
+  }
+  stats_cluster_key_builder_pop(builder);
+
+  stats_aggregator_lock();
+  stats_register_aggregator_hist(STATS_LEVEL2, self->metrics.commit_latency_sc_key, round_to_log2(1), 14,
+                                 &self->metrics.commit_latency);
+  stats_aggregator_unlock();
+}
+
 static void
 _register_counters(LogQueueDisk *self, gint stats_level, StatsClusterKeyBuilder *builder)
 {
@@ -430,6 +458,8 @@ log_queue_disk_init_instance(LogQueueDisk *self, DiskQueueOptions *options, cons
 
   self->qdisk = qdisk_new(options, qdisk_file_id, filename);
   _register_counters(self, stats_level, queue_sck_builder);
+  if (queue_sck_builder && options->reliable && (options->sync_interval > 0 || options->sync_bytes > 0))
+    _register_commit_latency(self, queue_sck_builder);
 
   if (queue_sck_builder)
     stats_cluster_key_builder_pop(queue_sck_builder);
@@ -47,9 +47,12 @@ struct _LogQueueDisk
     StatsClusterKey *disk_usage_sc_key;
     StatsClusterKey *disk_allocated_sc_key;
 
+    StatsClusterKey *commit_latency_sc_key;
+
     StatsCounterItem *capacity;
     StatsCounterItem *disk_usage;
     StatsCounterItem *disk_allocated;
+    StatsAggregator *commit_latency;
   } metrics;
 
   gboolean compaction;
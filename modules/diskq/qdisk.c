@@ -42,6 +42,11 @@
 #include <sys/types.h>
 #include <sys/file.h>
 
+#if SYSLOG_NG_HAVE_ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#endif
+
 /* MADV_RANDOM not defined on legacy Linux systems. Could be removed in the
  * future, when support for Glibc 2.1.X drops.*/
 #ifndef MADV_RANDOM
@@ -50,9 +55,22 @@
 
 #define MAX_RECORD_LENGTH 100 * 1024 * 1024
 
+/* pending records of a group commit are written out once they reach this size */
+#define MAX_PENDING_RECORDS_SIZE 1024 * 1024
+
 #define PATH_QDISK              PATH_LOCALSTATEDIR
 
-#define QDISK_HDR_VERSION_CURRENT 3
+#define QDISK_HDR_VERSION_CURRENT 4
+
+/* the highest bit of the record length marks a zstd compressed record */
+#define QDISK_RECORD_COMPRESSED 0x80000000
+#define QDISK_COMPRESSION_LEVEL 1
+
+/* the dictionary is trained once this many records or bytes are collected */
+#define QDISK_DICTIONARY_TRAINING_SAMPLES 1000
+#define QDISK_DICTIONARY_TRAINING_BYTES 1024 * 1024
+
+G_STATIC_ASSERT(sizeof(QDiskFileHeader) == QDISK_RESERVED_SPACE);
 
 #define QDISK_FILENAME_PREFIX "syslog-ng-"
 #define QDISK_FILENAME_IDX_FMT "%05d"
@@ -78,6 +96,38 @@ struct _QDisk
   gint64 cached_file_size;
   QDiskFileHeader *hdr;
   DiskQueueOptions *options;
+
+  /* the position of the next record, hdr->write_head lags behind it while
+   * there are uncommitted records */
+  gint64 write_head;
+
+  /* group commit: records are buffered here and written in one go, the
+   * header is only updated to refer to them in qdisk_commit(), after they
+   * are synced */
+  GString *pending_records;
+  gint64 pending_records_ofs;
+  gint64 uncommitted_records;
+  gint64 uncommitted_bytes;
+  gint64 first_uncommitted_time;
+
+  /* the batch taken by qdisk_commit_begin() */
+  gboolean commit_in_progress;
+  GString *committing_records;
+  gint64 committing_records_ofs;
+  gint64 committing_records_count;
+  gint64 committing_write_head;
+
+#if SYSLOG_NG_HAVE_ZSTD
+  ZSTD_CCtx *compress_ctx;
+  ZSTD_DCtx *decompress_ctx;
+  ZSTD_CDict *compress_dict;
+  ZSTD_DDict *decompress_dict;
+
+  /* records collected to train the dictionary from, until it is trained */
+  GString *dictionary_samples;
+  GArray *dictionary_sample_sizes;
+  gboolean dictionary_trained;
+#endif
 };
 
 #define QDISK_ERROR qdisk_error_quark()
@@ -114,6 +164,437 @@ pwrite_strict(gint fd, const void *buf, size_t count, off_t offset)
   return result;
 }
 
+static gint
+_sync_file_data(gint fd)
+{
+#if defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+  return fdatasync(fd);
+#else
+  return fsync(fd);
+#endif
+}
+
+static inline gboolean
+_is_group_commit_enabled(QDisk *self)
+{
+  return self->options->reliable && (self->options->sync_interval > 0 || self->options->sync_bytes > 0);
+}
+
+static gboolean
+_write_pending_records(QDisk *self)
+{
+  if (self->pending_records->len == 0)
+    return TRUE;
+
+  gboolean result = pwrite_strict(self->fd, self->pending_records->str, self->pending_records->len,
+                                  self->pending_records_ofs);
+  g_string_truncate(self->pending_records, 0);
+  return result;
+}
+
+/*
+ * Writing a record before it is committed is safe, as the header does not
+ * refer to its position yet.
+ */
+static gboolean
+_write_record(QDisk *self, GString *record, gint64 position)
+{
+  if (!_is_group_commit_enabled(self))
+    return pwrite_strict(self->fd, record->str, record->len, position);
+
+  /* a batch can only be written in one go if its records are contiguous */
+  if (self->pending_records->len > 0 && self->pending_records_ofs + self->pending_records->len != position)
+    {
+      if (!_write_pending_records(self))
+        return FALSE;
+    }
+
+  if (self->pending_records->len == 0)
+    self->pending_records_ofs = position;
+  g_string_append_len(self->pending_records, record->str, record->len);
+
+  if (self->pending_records->len >= MAX_PENDING_RECORDS_SIZE)
+    return _write_pending_records(self);
+  return TRUE;
+}
+
+static void
+_record_pushed(QDisk *self, GString *record)
+{
+  if (!_is_group_commit_enabled(self))
+    {
+      self->hdr->write_head = self->write_head;
+      self->hdr->length++;
+      return;
+    }
+
+  if (self->uncommitted_records == 0)
+    self->first_uncommitted_time = g_get_monotonic_time();
+  self->uncommitted_records++;
+  self->uncommitted_bytes += record->len;
+}
+
+gboolean
+qdisk_has_uncommitted_records(QDisk *self)
+{
+  return self->uncommitted_records > 0;
+}
+
+/* monotonic time of the first record pushed since the last commit */
+gint64
+qdisk_get_first_uncommitted_time(QDisk *self)
+{
+  return self->first_uncommitted_time;
+}
+
+gboolean
+qdisk_is_commit_due(QDisk *self)
+{
+  if (self->uncommitted_records == 0 || self->commit_in_progress)
+    return FALSE;
+
+  if (self->options->sync_bytes > 0 && self->uncommitted_bytes >= self->options->sync_bytes)
+    return TRUE;
+
+  return self->options->sync_interval > 0 &&
+         g_get_monotonic_time() - self->first_uncommitted_time >= (gint64) self->options->sync_interval * 1000;
+}
+
+/*
+ * Committing the records pushed since the last commit is split into four
+ * steps, so that the queue's lock does not have to be held while the file
+ * is synced:
+ *
+ *  - qdisk_commit_begin() takes the batch, records pushed after this belong
+ *    to the next commit,
+ *  - qdisk_commit_sync() writes the buffered records of the batch and syncs
+ *    the file data, it may run concurrently with pushes and pops,
+ *  - qdisk_commit_finish() updates the header to refer to the records of
+ *    the batch,
+ *  - qdisk_commit_sync_header() syncs the header, it may run concurrently
+ *    with pushes and pops too.
+ *
+ * The caller must make sure that the qdisk is not stopped while the
+ * unlocked steps are running.
+ *
+ * The header only ever refers to records that have already been synced, so
+ * neither a crash of syslog-ng nor of the system can leave it pointing to
+ * records that did not make it to the disk. Uncommitted records cannot be
+ * read from the queue either.
+ *
+ * Only one commit can be in progress at a time, qdisk_commit_begin()
+ * returns FALSE if there is nothing to commit or another commit is in
+ * progress.
+ */
+gboolean
+qdisk_commit_begin(QDisk *self)
+{
+  if (self->uncommitted_records == 0 || self->commit_in_progress)
+    return FALSE;
+
+  GString *committing_records = self->committing_records;
+  self->committing_records = self->pending_records;
+  self->committing_records_ofs = self->pending_records_ofs;
+  self->pending_records = committing_records;
+
+  self->committing_records_count = self->uncommitted_records;
+  self->committing_write_head = self->write_head;
+  self->uncommitted_records = 0;
+  self->uncommitted_bytes = 0;
+  self->commit_in_progress = TRUE;
+
+  return TRUE;
+}
+
+gboolean
+qdisk_commit_sync(QDisk *self)
+{
+  g_assert(self->commit_in_progress);
+
+  gboolean result = TRUE;
+  if (self->committing_records->len > 0)
+    result = pwrite_strict(self->fd, self->committing_records->str, self->committing_records->len,
+                           self->committing_records_ofs);
+  g_string_truncate(self->committing_records, 0);
+
+  if (!result)
+    {
+      msg_error("Error writing disk-queue file",
+                evt_tag_str("filename", self->filename),
+                evt_tag_error("error"));
+      return FALSE;
+    }
+
+  if (_sync_file_data(self->fd) < 0)
+    {
+      msg_error("Error syncing disk-queue file",
+                evt_tag_str("filename", self->filename),
+                evt_tag_error("error"));
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/*
+ * The records are published even if qdisk_commit_sync() failed: they are
+ * already part of the queue's in-memory state, and a record that could not
+ * be written is detected as corrupt when it is read.
+ */
+void
+qdisk_commit_finish(QDisk *self)
+{
+  g_assert(self->commit_in_progress);
+
+  self->hdr->write_head = self->committing_write_head;
+  self->hdr->length += self->committing_records_count;
+  self->committing_records_count = 0;
+  self->commit_in_progress = FALSE;
+}
+
+gboolean
+qdisk_commit_sync_header(QDisk *self)
+{
+  if (msync(self->hdr, sizeof(QDiskFileHeader), MS_SYNC) < 0)
+    {
+      msg_error("Error syncing disk-queue file header",
+                evt_tag_str("filename", self->filename),
+                evt_tag_error("error"));
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+gboolean
+qdisk_commit(QDisk *self)
+{
+  if (!qdisk_commit_begin(self))
+    return TRUE;
+
+  gboolean result = qdisk_commit_sync(self);
+  qdisk_commit_finish(self);
+  return qdisk_commit_sync_header(self) && result;
+}
+
+#if SYSLOG_NG_HAVE_ZSTD
+
+static void
+_load_dictionary(QDisk *self)
+{
+  if (self->hdr->dictionary_len == 0)
+    return;
+
+  self->dictionary_trained = TRUE;
+  self->compress_dict = ZSTD_createCDict(self->hdr->dictionary, self->hdr->dictionary_len, QDISK_COMPRESSION_LEVEL);
+  self->decompress_dict = ZSTD_createDDict(self->hdr->dictionary, self->hdr->dictionary_len);
+}
+
+static void
+_free_dictionary(QDisk *self)
+{
+  ZSTD_freeCDict(self->compress_dict);
+  self->compress_dict = NULL;
+  ZSTD_freeDDict(self->decompress_dict);
+  self->decompress_dict = NULL;
+
+  if (self->dictionary_samples)
+    {
+      g_string_free(self->dictionary_samples, TRUE);
+      self->dictionary_samples = NULL;
+      g_array_free(self->dictionary_sample_sizes, TRUE);
+      self->dictionary_sample_sizes = NULL;
+    }
+  self->dictionary_trained = FALSE;
+}
+
+/*
+ * Log records are small and similar to each other, compressing them one by
+ * one without a dictionary gains little.  The dictionary is trained once
+ * from the first records of the file, and it is stored in its header, as
+ * records are read back by their own.  The records compressed earlier do
+ * not use it, which is recorded in their zstd frame.
+ */
+static void
+_train_dictionary(QDisk *self)
+{
+  gchar dictionary[QDISK_MAX_DICTIONARY_SIZE];
+
+  gsize dictionary_len = ZDICT_trainFromBuffer(dictionary, sizeof(dictionary),
+                                               self->dictionary_samples->str,
+                                               (const size_t *) self->dictionary_sample_sizes->data,
+                                               self->dictionary_sample_sizes->len);
+  g_string_free(self->dictionary_samples, TRUE);
+  self->dictionary_samples = NULL;
+  g_array_free(self->dictionary_sample_sizes, TRUE);
+  self->dictionary_sample_sizes = NULL;
+  self->dictionary_trained = TRUE;
+
+  if (ZDICT_isError(dictionary_len))
+    {
+      msg_debug("Error training disk-queue compression dictionary, compressing records without it",
+                evt_tag_str("filename", self->filename),
+                evt_tag_str("error", ZDICT_getErrorName(dictionary_len)));
+      return;
+    }
+
+  memcpy(self->hdr->dictionary, dictionary, dictionary_len);
+  self->hdr->dictionary_len = dictionary_len;
+  _load_dictionary(self);
+
+  msg_debug("Disk-queue compression dictionary trained",
+            evt_tag_str("filename", self->filename),
+            evt_tag_long("dictionary_size", dictionary_len));
+}
+
+static void
+_collect_dictionary_sample(QDisk *self, const gchar *payload, gsize payload_len)
+{
+  if (self->dictionary_trained)
+    return;
+
+  if (!self->dictionary_samples)
+    {
+      self->dictionary_samples = g_string_sized_new(QDISK_DICTIONARY_TRAINING_BYTES);
+      self->dictionary_sample_sizes = g_array_sized_new(FALSE, FALSE, sizeof(size_t),
+                                                        QDISK_DICTIONARY_TRAINING_SAMPLES);
+    }
+
+  size_t sample_size = payload_len;
+  g_string_append_len(self->dictionary_samples, payload, payload_len);
+  g_array_append_val(self->dictionary_sample_sizes, sample_size);
+
+  if (self->dictionary_sample_sizes->len >= QDISK_DICTIONARY_TRAINING_SAMPLES ||
+      self->dictionary_samples->len >= QDISK_DICTIONARY_TRAINING_BYTES)
+    _train_dictionary(self);
+}
+
+/* returns FALSE if the record should be stored as is */
+static gboolean
+_compress_record(QDisk *self, const GString *record, GString *compressed)
+{
+  const gchar *payload = record->str + sizeof(guint32);
+  gsize payload_len = record->len - sizeof(guint32);
+  gsize compressed_len;
+
+  if (!self->compress_ctx)
+    self->compress_ctx = ZSTD_createCCtx();
+
+  g_string_set_size(compressed, sizeof(guint32) + ZSTD_compressBound(payload_len));
+  if (self->compress_dict)
+    compressed_len = ZSTD_compress_usingCDict(self->compress_ctx, compressed->str + sizeof(guint32),
+                                              compressed->len - sizeof(guint32), payload, payload_len,
+                                              self->compress_dict);
+  else
+    compressed_len = ZSTD_compressCCtx(self->compress_ctx, compressed->str + sizeof(guint32),
+                                       compressed->len - sizeof(guint32), payload, payload_len,
+                                       QDISK_COMPRESSION_LEVEL);
+
+  _collect_dictionary_sample(self, payload, payload_len);
+
+  if (ZSTD_isError(compressed_len) || compressed_len >= payload_len)
+    return FALSE;
+
+  guint32 record_length = GUINT32_TO_BE(compressed_len | QDISK_RECORD_COMPRESSED);
+  memcpy(compressed->str, &record_length, sizeof(record_length));
+  g_string_truncate(compressed, sizeof(guint32) + compressed_len);
+
+  self->hdr->compression = QDISK_COMPRESSION_ZSTD;
+  return TRUE;
+}
+
+static gboolean
+_decompress_record(QDisk *self, GString *record)
+{
+  unsigned long long payload_len = ZSTD_getFrameContentSize(record->str, record->len);
+  if (payload_len == ZSTD_CONTENTSIZE_UNKNOWN || payload_len == ZSTD_CONTENTSIZE_ERROR ||
+      payload_len > MAX_RECORD_LENGTH)
+    {
+      msg_error("Error decompressing disk-queue record, invalid frame",
+                evt_tag_str("filename", self->filename),
+                evt_tag_long("offset", self->hdr->read_head));
+      return FALSE;
+    }
+
+  guint dictionary_id = ZSTD_getDictID_fromFrame(record->str, record->len);
+  if (dictionary_id != 0 &&
+      (!self->decompress_dict || ZSTD_getDictID_fromDDict(self->decompress_dict) != dictionary_id))
+    {
+      msg_error("Error decompressing disk-queue record, it was compressed with an unknown dictionary",
+                evt_tag_str("filename", self->filename),
+                evt_tag_long("offset", self->hdr->read_head));
+      return FALSE;
+    }
+
+  if (!self->decompress_ctx)
+    self->decompress_ctx = ZSTD_createDCtx();
+
+  ScratchBuffersMarker marker;
+  GString *payload = scratch_buffers_alloc_and_mark(&marker);
+  g_string_set_size(payload, payload_len);
+
+  gsize decompressed_len = dictionary_id != 0
+                           ? ZSTD_decompress_usingDDict(self->decompress_ctx, payload->str, payload->len,
+                                                        record->str, record->len, self->decompress_dict)
+                           : ZSTD_decompressDCtx(self->decompress_ctx, payload->str, payload->len,
+                                                 record->str, record->len);
+  if (ZSTD_isError(decompressed_len) || decompressed_len != payload_len)
+    {
+      msg_error("Error decompressing disk-queue record",
+                evt_tag_str("filename", self->filename),
+                evt_tag_long("offset", self->hdr->read_head),
+                evt_tag_str("error", ZSTD_isError(decompressed_len) ? ZSTD_getErrorName(decompressed_len) : "short frame"));
+      scratch_buffers_reclaim_marked(marker);
+      return FALSE;
+    }
+
+  g_string_truncate(record, 0);
+  g_string_append_len(record, payload->str, payload->len);
+  scratch_buffers_reclaim_marked(marker);
+  return TRUE;
+}
+
+static void
+_free_compression_contexts(QDisk *self)
+{
+  _free_dictionary(self);
+  ZSTD_freeCCtx(self->compress_ctx);
+  ZSTD_freeDCtx(self->decompress_ctx);
+}
+
+#else
+
+static void
+_load_dictionary(QDisk *self)
+{
+}
+
+static void
+_free_dictionary(QDisk *self)
+{
+}
+
+static gboolean
+_compress_record(QDisk *self, const GString *record, GString *compressed)
+{
+  return FALSE;
+}
+
+static gboolean
+_decompress_record(QDisk *self, GString *record)
+{
+  msg_error("Error reading disk-queue file, compressed record found but syslog-ng was compiled without zstd support",
+            evt_tag_str("filename", self->filename),
+            evt_tag_long("offset", self->hdr->read_head));
+  return FALSE;
+}
+
+static void
+_free_compression_contexts(QDisk *self)
+{
+}
+
+#endif
 
 static inline gboolean
 _has_position_reached_max_size(QDisk *self, gint64 position)
@@ -327,13 +808,13 @@ qdisk_started(QDisk *self)
 static inline gboolean
 _does_backlog_head_precede_write_head(QDisk *self)
 {
-  return self->hdr->backlog_head <= self->hdr->write_head;
+  return self->hdr->backlog_head <= self->write_head;
 }
 
 static inline gboolean
 _is_write_head_less_than_max_size(QDisk *self)
 {
-  return self->hdr->write_head < self->hdr->capacity_bytes;
+  return self->write_head < self->hdr->capacity_bytes;
 }
 
 static inline gboolean
@@ -346,7 +827,7 @@ static inline gboolean
 _is_free_space_between_write_head_and_backlog_head(QDisk *self, gint msg_len)
 {
   /* this forces 1 byte of empty space between backlog and write */
-  return self->hdr->write_head + msg_len < self->hdr->backlog_head;
+  return self->write_head + msg_len < self->hdr->backlog_head;
 }
 
 static inline gboolean
@@ -359,7 +840,8 @@ _is_free_space_at_the_beginning_of_qdisk(QDisk *self, gint msg_len)
 gboolean
 qdisk_is_file_empty(QDisk *self)
 {
-  return self->hdr->length == 0 && self->hdr->backlog_len == 0;
+  return self->hdr->length == 0 && self->hdr->backlog_len == 0
+         && self->uncommitted_records == 0 && !self->commit_in_progress;
 }
 
 gboolean
@@ -650,7 +1132,7 @@ qdisk_get_used_useful_space(QDisk *self)
 static inline gboolean
 _could_not_wrap_write_head_last_push_but_now_can(QDisk *self)
 {
-  return _has_position_reached_max_size(self, self->hdr->write_head)
+  return _has_position_reached_max_size(self, self->write_head)
          && _is_able_to_reset_write_head_to_beginning_of_qdisk(self);
 }
 
@@ -660,15 +1142,12 @@ qdisk_get_next_tail_position(QDisk *self)
   if (_could_not_wrap_write_head_last_push_but_now_can(self))
     return QDISK_RESERVED_SPACE;
 
-  return self->hdr->write_head;
+  return self->write_head;
 }
 
-gboolean
-qdisk_push_tail(QDisk *self, GString *record)
+static gboolean
+_push_tail(QDisk *self, GString *record)
 {
-  if (!qdisk_started(self))
-    return FALSE;
-
   if (_could_not_wrap_write_head_last_push_but_now_can(self))
     {
       /*
@@ -676,20 +1155,20 @@ qdisk_push_tail(QDisk *self, GString *record)
        * not sure, if this message will have space. We move the write_head
        * then check the available space compared to the new position.
        */
-      self->hdr->write_head = QDISK_RESERVED_SPACE;
+      self->write_head = QDISK_RESERVED_SPACE;
     }
 
   if (!qdisk_is_space_avail(self, record->len))
     return FALSE;
 
-  if (!pwrite_strict(self->fd, record->str, record->len, self->hdr->write_head))
+  if (!_write_record(self, record, self->write_head))
     {
       msg_error("Error writing disk-queue file",
                 evt_tag_error("error"));
       return FALSE;
     }
 
-  self->hdr->write_head = self->hdr->write_head + record->len;
+  self->write_head = self->write_head + record->len;
 
 
   /* NOTE: we only wrap around if the read head is before the write,
@@ -713,20 +1192,20 @@ qdisk_push_tail(QDisk *self, GString *record)
    * */
 
   /* NOTE: if these were equal, that'd mean the queue is empty, so we spoiled something */
-  g_assert(self->hdr->write_head != self->hdr->backlog_head);
+  g_assert(self->write_head != self->hdr->backlog_head);
 
-  if (self->hdr->write_head > MAX(self->hdr->backlog_head, self->hdr->read_head))
+  if (self->write_head > MAX(self->hdr->backlog_head, self->hdr->read_head))
     {
-      if (self->cached_file_size > self->hdr->write_head)
+      if (self->cached_file_size > self->write_head)
         {
-          _maybe_truncate_file(self, self->hdr->write_head);
+          _maybe_truncate_file(self, self->write_head);
         }
       else
         {
-          self->cached_file_size = self->hdr->write_head;
+          self->cached_file_size = self->write_head;
         }
 
-      if (_has_position_reached_max_size(self, self->hdr->write_head)
+      if (_has_position_reached_max_size(self, self->write_head)
           && _is_able_to_reset_write_head_to_beginning_of_qdisk(self))
         {
           /* we were appending to the file, we are over the limit, and space
@@ -737,13 +1216,31 @@ qdisk_push_tail(QDisk *self, GString *record)
            * This way we guarantee, that only a part of 1 message is written after
            * capacity_bytes.
            */
-          self->hdr->write_head = QDISK_RESERVED_SPACE;
+          self->write_head = QDISK_RESERVED_SPACE;
         }
     }
-  self->hdr->length++;
+
+  _record_pushed(self, record);
   return TRUE;
 }
 
+gboolean
+qdisk_push_tail(QDisk *self, GString *record)
+{
+  if (!qdisk_started(self))
+    return FALSE;
+
+  if (!self->options->compression)
+    return _push_tail(self, record);
+
+  ScratchBuffersMarker marker;
+  GString *compressed = scratch_buffers_alloc_and_mark(&marker);
+  gboolean result = _push_tail(self, _compress_record(self, record, compressed) ? compressed : record);
+  scratch_buffers_reclaim_marked(marker);
+
+  return result;
+}
+
 static inline gssize
 _read_record_length_from_disk(QDisk *self, gint64 position, guint32 *record_length)
 {
@@ -794,11 +1291,15 @@ _is_record_length_valid(QDisk *self, gssize bytes_read, guint32 record_length, g
 }
 
 static inline gboolean
-_try_reading_record_length(QDisk *self, gint64 position, guint32 *record_length)
+_try_reading_record_length(QDisk *self, gint64 position, guint32 *record_length, gboolean *compressed)
 {
   guint32 read_record_length;
   gssize bytes_read = _read_record_length_from_disk(self, position, &read_record_length);
 
+  if (compressed)
+    *compressed = !!(read_record_length & QDISK_RECORD_COMPRESSED);
+  read_record_length &= ~QDISK_RECORD_COMPRESSED;
+
   if (!_is_record_length_valid(self, bytes_read, read_record_length, position))
     return FALSE;
 
@@ -868,12 +1369,16 @@ qdisk_peek_head(QDisk *self, GString *record)
     self->hdr->read_head = _correct_position_if_max_size_is_reached(self, self->hdr->read_head);
 
   guint32 record_length;
-  if (!_try_reading_record_length(self, self->hdr->read_head, &record_length))
+  gboolean compressed;
+  if (!_try_reading_record_length(self, self->hdr->read_head, &record_length, &compressed))
     return FALSE;
 
   if (!_read_record_from_disk(self, record, record_length))
     return FALSE;
 
+  if (compressed && !_decompress_record(self, record))
+    return FALSE;
+
   return TRUE;
 }
 
@@ -887,12 +1392,16 @@ qdisk_pop_head(QDisk *self, GString *record)
     self->hdr->read_head = _correct_position_if_max_size_is_reached(self, self->hdr->read_head);
 
   guint32 record_length;
-  if (!_try_reading_record_length(self, self->hdr->read_head, &record_length))
+  gboolean compressed;
+  if (!_try_reading_record_length(self, self->hdr->read_head, &record_length, &compressed))
     return FALSE;
 
   if (!_read_record_from_disk(self, record, record_length))
     return FALSE;
 
+  if (compressed && !_decompress_record(self, record))
+    return FALSE;
+
   _update_position_after_read(self, record_length, &self->hdr->read_head);
   self->hdr->length--;
   self->hdr->backlog_len++;
@@ -913,7 +1422,7 @@ _skip_record(QDisk *self, gint64 position, gint64 *new_position)
   *new_position = position;
 
   guint32 record_length;
-  if (!_try_reading_record_length(self, *new_position, &record_length))
+  if (!_try_reading_record_length(self, *new_position, &record_length, NULL))
     return FALSE;
 
   _update_position_after_read(self, record_length, new_position);
@@ -1326,6 +1835,7 @@ _ensure_header_byte_order(QDisk *self)
       self->hdr->backlog_head = GUINT64_SWAP_LE_BE(self->hdr->backlog_head);
       self->hdr->backlog_len = GUINT64_SWAP_LE_BE(self->hdr->backlog_len);
       self->hdr->capacity_bytes = GUINT64_SWAP_LE_BE(self->hdr->capacity_bytes);
+      self->hdr->dictionary_len = GUINT16_SWAP_LE_BE(self->hdr->dictionary_len);
       self->hdr->big_endian = (G_BYTE_ORDER == G_BIG_ENDIAN);
     }
 }
@@ -1396,6 +1906,9 @@ _create_header(QDisk *self)
   self->hdr->length = 0;
   self->hdr->use_v1_wrap_condition = FALSE;
   self->hdr->capacity_bytes = self->options->capacity_bytes;
+  self->hdr->compression = QDISK_COMPRESSION_NONE;
+  self->hdr->dictionary_len = 0;
+  self->write_head = self->hdr->write_head;
 
   return TRUE;
 }
@@ -1427,6 +1940,12 @@ _upgrade_header(QDisk *self)
       self->hdr->capacity_bytes = self->options->capacity_bytes;
     }
 
+  if (self->hdr->version < 4)
+    {
+      self->hdr->compression = QDISK_COMPRESSION_NONE;
+      self->hdr->dictionary_len = 0;
+    }
+
   self->hdr->version = QDISK_HDR_VERSION_CURRENT;
 }
 
@@ -1468,6 +1987,16 @@ _load_header(QDisk *self)
       return FALSE;
     }
 
+#if !SYSLOG_NG_HAVE_ZSTD
+  if (self->hdr->compression != QDISK_COMPRESSION_NONE)
+    {
+      msg_error("Error loading disk-queue file, it contains compressed records but syslog-ng was compiled "
+                "without zstd support",
+                evt_tag_str("filename", self->filename));
+      return FALSE;
+    }
+#endif
+
   if (qdisk_header_is_inconsistent(self))
     {
       msg_error("Inconsistent header data in disk-queue file, ignoring",
@@ -1478,6 +2007,7 @@ _load_header(QDisk *self)
       return FALSE;
     }
 
+  self->write_head = self->hdr->write_head;
   return TRUE;
 }
 
@@ -1689,13 +2219,18 @@ qdisk_start(QDisk *self, QDiskMemQLoadFunc func, gpointer user_data)
   struct stat st;
   gboolean file_exists = stat(self->filename, &st) != -1;
 
+  gboolean result;
   if (!file_exists)
-    return _create_qdisk_file(self);
+    result = _create_qdisk_file(self);
+  else if (st.st_size != 0)
+    result = _load_qdisk_file(self, func, user_data);
+  else
+    result = _init_qdisk_file_from_empty_file(self);
 
-  if (st.st_size != 0)
-    return _load_qdisk_file(self, func, user_data);
+  if (result)
+    _load_dictionary(self);
 
-  return _init_qdisk_file_from_empty_file(self);
+  return result;
 }
 
 gboolean
@@ -1704,9 +2239,13 @@ qdisk_stop(QDisk *self, QDiskMemQSaveFunc func, gpointer user_data)
   gboolean result = TRUE;
 
   if (!self->options->read_only)
-    result = _save_state(self, func, user_data);
+    {
+      result = qdisk_commit(self);
+      result = _save_state(self, func, user_data) && result;
+    }
 
   _close_file(self);
+  _free_dictionary(self);
 
   return result;
 }
@@ -1720,6 +2259,12 @@ qdisk_reset_file_if_empty(QDisk *self)
   self->hdr->read_head = QDISK_RESERVED_SPACE;
   self->hdr->write_head = QDISK_RESERVED_SPACE;
   self->hdr->backlog_head = QDISK_RESERVED_SPACE;
+  self->hdr->compression = QDISK_COMPRESSION_NONE;
+  self->hdr->dictionary_len = 0;
+  self->write_head = QDISK_RESERVED_SPACE;
+
+  /* no record refers to the dictionary anymore, a new one is trained from the next records */
+  _free_dictionary(self);
 
   _maybe_truncate_file(self, QDISK_RESERVED_SPACE);
 }
@@ -1764,10 +2309,22 @@ qdisk_get_file_size(QDisk *self)
   return self->cached_file_size;
 }
 
+const gchar *
+qdisk_get_compression_name(QDisk *self)
+{
+  return self->hdr->compression == QDISK_COMPRESSION_ZSTD ? "zstd" : "none";
+}
+
+gsize
+qdisk_get_compression_dictionary_size(QDisk *self)
+{
+  return self->hdr->dictionary_len;
+}
+
 gint64
 qdisk_get_writer_head(QDisk *self)
 {
-  return self->hdr->write_head;
+  return self->write_head;
 }
 
 gint64
@@ -1804,6 +2361,9 @@ void
 qdisk_free(QDisk *self)
 {
   self->options = NULL;
+  _free_compression_contexts(self);
+  g_string_free(self->pending_records, TRUE);
+  g_string_free(self->committing_records, TRUE);
   g_free(self->filename);
   g_free(self);
 }
@@ -1833,6 +2393,8 @@ qdisk_new(DiskQueueOptions *options, const gchar *file_id, const gchar *filename
 
   self->file_id = file_id;
   self->filename = g_strdup(filename);
+  self->pending_records = g_string_new(NULL);
+  self->committing_records = g_string_new(NULL);
 
   return self;
 }
@@ -28,6 +28,8 @@
 #include "diskq-options.h"
 
 #define QDISK_RESERVED_SPACE 4096
+/* the compression dictionary is stored in the unused part of the header */
+#define QDISK_MAX_DICTIONARY_SIZE 3072
 
 typedef enum
 {
@@ -36,6 +38,12 @@ typedef enum
   QDISK_MQ_FLOW_CONTROL_WINDOW,
 } QDiskMemoryQueueType;
 
+typedef enum
+{
+  QDISK_COMPRESSION_NONE,
+  QDISK_COMPRESSION_ZSTD,
+} QDiskCompression;
+
 typedef struct
 {
   gint64 ofs;
@@ -64,6 +72,14 @@ typedef union _QDiskFileHeader
 
     guint8 use_v1_wrap_condition;
     gint64 capacity_bytes;
+
+    /* set once the file may contain compressed records */
+    guint8 compression;
+
+    /* zstd dictionary trained from the first records of the file, records
+     * compressed after it was stored refer to it by its ID */
+    guint16 dictionary_len;
+    gchar dictionary[QDISK_MAX_DICTIONARY_SIZE];
   };
   gchar _pad2[QDISK_RESERVED_SPACE];
 } QDiskFileHeader;
@@ -99,6 +115,14 @@ gboolean qdisk_started(QDisk *self);
 void qdisk_free(QDisk *self);
 void qdisk_set_options(QDisk *self, DiskQueueOptions *options);
 gboolean qdisk_is_compatible(QDisk *self, DiskQueueOptions *options);
+gboolean qdisk_has_uncommitted_records(QDisk *self);
+gint64 qdisk_get_first_uncommitted_time(QDisk *self);
+gboolean qdisk_is_commit_due(QDisk *self);
+gboolean qdisk_commit(QDisk *self);
+gboolean qdisk_commit_begin(QDisk *self);
+gboolean qdisk_commit_sync(QDisk *self);
+void qdisk_commit_finish(QDisk *self);
+gboolean qdisk_commit_sync_header(QDisk *self);
 
 DiskQueueOptions *qdisk_get_options(QDisk *self);
 gint64 qdisk_get_length(QDisk *self);
@@ -112,6 +136,8 @@ gint qdisk_get_flow_control_window_bytes(QDisk *self);
 gboolean qdisk_is_read_only(QDisk *self);
 const gchar *qdisk_get_filename(QDisk *self);
 gint64 qdisk_get_file_size(QDisk *self);
+const gchar *qdisk_get_compression_name(QDisk *self);
+gsize qdisk_get_compression_dictionary_size(QDisk *self);
 
 gchar *qdisk_get_next_filename(const gchar *dir, gboolean reliable);
 gboolean qdisk_is_file_a_disk_buffer_file(const gchar *filename);
@@ -696,6 +696,64 @@ Test(logqueue_disk, test_non_reliable_queue_persistance)
   stop_grabbing_messages();
 }
 
+/* acks of committed messages are sent from the commit thread, under the queue's lock */
+static gboolean
+_wait_for_acked_messages(LogQueue *queue, gint expected)
+{
+  for (gint i = 0; i < 500; i++)
+    {
+      g_mutex_lock(&queue->lock);
+      gint acked = acked_messages;
+      g_mutex_unlock(&queue->lock);
+
+      if (acked >= expected)
+        return TRUE;
+      g_usleep(10000);
+    }
+  return FALSE;
+}
+
+Test(logqueue_disk, reliable_queue_commits_in_the_background_when_idle)
+{
+  const gchar *filename = "background_commit_reliable.rqf";
+
+  DiskQueueOptions options = {0};
+  disk_queue_options_set_default_options(&options);
+  disk_queue_options_reliable_set(&options, TRUE);
+  disk_queue_options_capacity_bytes_set(&options, MIN_CAPACITY_BYTES);
+  disk_queue_options_set_sync_interval(&options, 500);
+
+  StatsClusterKeyBuilder *driver_sck_builder = stats_cluster_key_builder_new();
+  StatsClusterKeyBuilder *queue_sck_builder = stats_cluster_key_builder_new();
+  LogQueue *queue = log_queue_disk_reliable_new(&options, filename, "background_commit_reliable", STATS_LEVEL0,
+                                                driver_sck_builder, queue_sck_builder);
+  stats_cluster_key_builder_free(driver_sck_builder);
+  stats_cluster_key_builder_free(queue_sck_builder);
+  cr_assert(log_queue_disk_start(queue));
+
+  acked_messages = 0;
+  feed_some_messages(queue, 2);
+
+  /* not synced yet: neither acked, nor readable */
+  g_mutex_lock(&queue->lock);
+  cr_assert_eq(acked_messages, 0);
+  g_mutex_unlock(&queue->lock);
+  cr_assert_eq(log_queue_get_length(queue), 0);
+  cr_assert_null(log_queue_peek_head(queue));
+
+  /* no more messages arrive, the commit thread commits them once sync-interval() passes */
+  cr_assert(_wait_for_acked_messages(queue, 2));
+  cr_assert_eq(log_queue_get_length(queue), 2);
+  _pop_msgs(queue, 2);
+  cr_assert_eq(log_queue_get_length(queue), 0);
+
+  gboolean persistent;
+  log_queue_disk_stop(queue, &persistent);
+  log_queue_unref(queue);
+  disk_queue_options_destroy(&options);
+  unlink(filename);
+}
+
 static void
 setup(void)
 {
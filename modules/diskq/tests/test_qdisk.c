@@ -29,8 +29,10 @@
 #include "scratch-buffers.h"
 
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <string.h>
 
 /* QDisk-internal: the frame is a 4-byte integer */
 #define FRAME_LENGTH 4
@@ -574,6 +576,207 @@ Test(qdisk, get_empty_space_wrapped)
   cleanup_qdisk(filename, qdisk);
 }
 
+Test(qdisk, group_commit_is_due_after_sync_bytes)
+{
+  const gchar *filename = "test_qdisk_group_commit.rqf";
+  QDisk *qdisk = create_qdisk(TDISKQ_RELIABLE, filename, MiB(1));
+  disk_queue_options_set_sync_bytes(qdisk_get_options(qdisk), 1000);
+  qdisk_start(qdisk, NULL, NULL);
+
+  cr_assert_not(qdisk_has_uncommitted_records(qdisk));
+
+  cr_assert(push_dummy_record(qdisk, 400));
+  cr_assert(qdisk_has_uncommitted_records(qdisk));
+  cr_assert_not(qdisk_is_commit_due(qdisk));
+
+  cr_assert(push_dummy_record(qdisk, 400));
+  cr_assert(push_dummy_record(qdisk, 400));
+  cr_assert(qdisk_is_commit_due(qdisk));
+
+  /* uncommitted records cannot be read */
+  GString *popped_data = g_string_new(NULL);
+  cr_assert_eq(qdisk_get_length(qdisk), 0);
+  cr_assert_not(reliable_pop_record_without_backlog(qdisk, popped_data));
+
+  cr_assert(qdisk_commit(qdisk));
+  cr_assert_not(qdisk_has_uncommitted_records(qdisk));
+  cr_assert_not(qdisk_is_commit_due(qdisk));
+  cr_assert_eq(qdisk_get_length(qdisk), 3);
+
+  cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data));
+  assert_dummy_record(popped_data, 400);
+  g_string_free(popped_data, TRUE);
+  cr_assert_eq(qdisk_get_length(qdisk), 2);
+
+  cr_assert(qdisk_stop(qdisk, NULL, NULL));
+  cleanup_qdisk(filename, qdisk);
+}
+
+static void
+_read_header_from_file(const gchar *filename, QDiskFileHeader *hdr)
+{
+  gint fd = open(filename, O_RDONLY);
+  cr_assert_geq(fd, 0);
+  cr_assert_eq(pread(fd, hdr, sizeof(*hdr), 0), sizeof(*hdr));
+  close(fd);
+}
+
+Test(qdisk, group_commit_updates_the_header_only_after_the_records_are_synced)
+{
+  const gchar *filename = "test_qdisk_group_commit_header.rqf";
+  QDisk *qdisk = create_qdisk(TDISKQ_RELIABLE, filename, MiB(1));
+  disk_queue_options_set_sync_bytes(qdisk_get_options(qdisk), MiB(1));
+  qdisk_start(qdisk, NULL, NULL);
+
+  cr_assert(push_dummy_record(qdisk, 400));
+  cr_assert(push_dummy_record(qdisk, 400));
+  cr_assert_gt(qdisk_get_writer_head(qdisk), QDISK_RESERVED_SPACE);
+
+  /* this is what a restart would see if syslog-ng crashed now */
+  QDiskFileHeader hdr;
+  _read_header_from_file(filename, &hdr);
+  cr_assert_eq(hdr.write_head, QDISK_RESERVED_SPACE);
+  cr_assert_eq(hdr.length, 0);
+
+  cr_assert(qdisk_commit(qdisk));
+
+  _read_header_from_file(filename, &hdr);
+  cr_assert_eq(hdr.write_head, qdisk_get_writer_head(qdisk));
+  cr_assert_eq(hdr.length, 2);
+
+  cr_assert(qdisk_stop(qdisk, NULL, NULL));
+  cleanup_qdisk(filename, qdisk);
+}
+
+Test(qdisk, group_commit_is_disabled_by_default)
+{
+  const gchar *filename = "test_qdisk_no_group_commit.rqf";
+  QDisk *qdisk = create_qdisk(TDISKQ_RELIABLE, filename, MiB(1));
+  qdisk_start(qdisk, NULL, NULL);
+
+  cr_assert(push_dummy_record(qdisk, 400));
+  cr_assert_not(qdisk_has_uncommitted_records(qdisk));
+  cr_assert_not(qdisk_is_commit_due(qdisk));
+
+  cr_assert(qdisk_stop(qdisk, NULL, NULL));
+  cleanup_qdisk(filename, qdisk);
+}
+
+#if SYSLOG_NG_HAVE_ZSTD
+
+Test(qdisk, compressed_records_are_read_back_transparently)
+{
+  const gchar *filename = "test_qdisk_compression.rqf";
+  QDisk *qdisk = create_qdisk(TDISKQ_RELIABLE, filename, MiB(1));
+  disk_queue_options_set_compression(qdisk_get_options(qdisk), TRUE);
+  qdisk_start(qdisk, NULL, NULL);
+
+  cr_assert_str_eq(qdisk_get_compression_name(qdisk), "none");
+
+  guint record_len = 4096;
+  gint64 write_head = qdisk_get_writer_head(qdisk);
+  cr_assert(push_dummy_record(qdisk, record_len));
+  cr_assert(push_dummy_record(qdisk, record_len));
+
+  /* the dummy payload is highly compressible */
+  cr_assert_lt(qdisk_get_writer_head(qdisk) - write_head, record_len);
+  cr_assert_str_eq(qdisk_get_compression_name(qdisk), "zstd");
+
+  GString *popped_data = g_string_new(NULL);
+  cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data));
+  assert_dummy_record(popped_data, record_len);
+
+  /* uncompressed records can be mixed with compressed ones */
+  disk_queue_options_set_compression(qdisk_get_options(qdisk), FALSE);
+  cr_assert(push_dummy_record(qdisk, record_len));
+
+  cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data));
+  assert_dummy_record(popped_data, record_len);
+  cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data));
+  assert_dummy_record(popped_data, record_len);
+  g_string_free(popped_data, TRUE);
+
+  cr_assert_eq(qdisk_get_length(qdisk), 0);
+
+  cr_assert(qdisk_stop(qdisk, NULL, NULL));
+  cleanup_qdisk(filename, qdisk);
+}
+
+static gboolean
+_generate_log_payload(SerializeArchive *sa, gpointer user_data)
+{
+  const gchar *payload = (const gchar *) user_data;
+
+  serialize_archive_write_bytes(sa, payload, strlen(payload));
+  return TRUE;
+}
+
+static gchar *
+_format_log_payload(gint i)
+{
+  return g_strdup_printf("<13>1 2026-10-16T20:23:%02d.%03dZ web-%d.example.com nginx %d - - 10.0.%d.%d - - "
+                         "\"GET /api/v1/items/%d HTTP/1.1\" %d %d \"-\" \"Mozilla/5.0 (X11; Linux x86_64)\"",
+                         i % 60, i % 1000, i % 7, 1000 + i % 13, i % 256, (i * 7) % 256, i,
+                         i % 3 ? 200 : 404, 512 + i);
+}
+
+static gboolean
+_push_log_record(QDisk *qdisk, gint i)
+{
+  gchar *payload = _format_log_payload(i);
+  GString *data = g_string_new(NULL);
+  GError *error = NULL;
+
+  qdisk_serialize(data, _generate_log_payload, payload, &error);
+  gboolean success = qdisk_push_tail(qdisk, data);
+
+  g_string_free(data, TRUE);
+  g_free(payload);
+  return success;
+}
+
+Test(qdisk, compression_dictionary_is_trained_and_stored_in_the_header)
+{
+  const gchar *filename = "test_qdisk_compression_dictionary.rqf";
+  QDisk *qdisk = create_qdisk(TDISKQ_RELIABLE, filename, MiB(10));
+  disk_queue_options_set_compression(qdisk_get_options(qdisk), TRUE);
+  qdisk_start(qdisk, NULL, NULL);
+
+  cr_assert_eq(qdisk_get_compression_dictionary_size(qdisk), 0);
+
+  /* the records pushed before and after the training are both readable */
+  const gint num_records = 1500;
+  for (gint i = 0; i < num_records; i++)
+    cr_assert(_push_log_record(qdisk, i));
+
+  cr_assert_gt(qdisk_get_compression_dictionary_size(qdisk), 0);
+  cr_assert_leq(qdisk_get_compression_dictionary_size(qdisk), QDISK_MAX_DICTIONARY_SIZE);
+
+  /* the dictionary is loaded from the header on restart */
+  cr_assert(qdisk_stop(qdisk, NULL, NULL));
+  cr_assert(qdisk_start(qdisk, NULL, NULL));
+  cr_assert_gt(qdisk_get_compression_dictionary_size(qdisk), 0);
+
+  GString *popped_data = g_string_new(NULL);
+  for (gint i = 0; i < num_records; i++)
+    {
+      gchar *expected = _format_log_payload(i);
+
+      cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data), "record: %d", i);
+      cr_assert_eq(popped_data->len, strlen(expected), "record: %d", i);
+      cr_assert(memcmp(popped_data->str, expected, popped_data->len) == 0, "record: %d", i);
+      g_free(expected);
+    }
+  g_string_free(popped_data, TRUE);
+
+  cr_assert_eq(qdisk_get_length(qdisk), 0);
+
+  cr_assert(qdisk_stop(qdisk, NULL, NULL));
+  cleanup_qdisk(filename, qdisk);
+}
+
+#endif
+
 static void
 setup(void)
 {
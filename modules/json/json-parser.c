@@ -26,6 +26,7 @@
 #include "dot-notation.h"
 #include "scratch-buffers.h"
 #include "str-repr/encode.h"
+#include "scanner/json-scanner/json-scanner.h"
 
 #include <string.h>
 #include <ctype.h>
@@ -36,6 +37,10 @@
 #include <json_object_private.h>
 #endif
 
+/* the json-c default, deeper documents are rejected by both parsers */
+#define JSON_PARSER_MAX_DEPTH 32
+#define JSON_PARSER_PREALLOCATED_TOKENS 128
+
 typedef struct _JSONParser
 {
   LogParser super;
@@ -85,7 +90,7 @@ json_parser_set_key_delimiter(LogParser *s, gchar delimiter)
 static void
 json_parser_store_value(JSONParser *self,
                         const gchar *prefix, const gchar *obj_key,
-                        GString *value, LogMessageValueType type,
+                        const gchar *value, gssize value_len, LogMessageValueType type,
                         LogMessage *msg)
 {
   GString *key;
@@ -95,10 +100,10 @@ json_parser_store_value(JSONParser *self,
     {
       g_string_assign(key, prefix);
       g_string_append(key, obj_key);
-      log_msg_set_value_by_name_with_type(msg, key->str, value->str, value->len, type);
+      log_msg_set_value_by_name_with_type(msg, key->str, value, value_len, type);
     }
   else
-    log_msg_set_value_by_name_with_type(msg, obj_key, value->str, value->len, type);
+    log_msg_set_value_by_name_with_type(msg, obj_key, value, value_len, type);
 }
 
 static void
@@ -173,7 +178,7 @@ json_parser_extract_value_from_simple_json_object(JSONParser *self,
 
   if (!json_parser_extract_string_from_simple_json_object(self, jso, value, &type))
     return FALSE;
-  json_parser_store_value(self, prefix, obj_key, value, type, msg);
+  json_parser_store_value(self, prefix, obj_key, value->str, value->len, type, msg);
   return TRUE;
 }
 
@@ -221,7 +226,7 @@ json_parser_extract_values_from_complex_json_object(JSONParser *self,
             }
         }
 
-      json_parser_store_value(self, prefix, obj_key, value, type, msg);
+      json_parser_store_value(self, prefix, obj_key, value->str, value->len, type, msg);
       return TRUE;
     }
     default:
@@ -317,6 +322,428 @@ json_parser_extract(JSONParser *self, struct json_object *jso, LogMessage *msg)
   return FALSE;
 }
 
+/*
+ * Extraction from the tokens of JSONScanner.  This is the fast path, it
+ * produces the same name-value pairs as the json-c based code above, but
+ * without building a json-c object tree first.
+ */
+
+static void
+json_parser_process_object_tokens(JSONParser *self, const gchar *input, const JSONToken *tokens, guint32 idx,
+                                  const gchar *prefix, LogMessage *msg);
+
+static void
+_append_string_token(GString *value, const gchar *input, const JSONToken *token)
+{
+  if (token->flags & JSON_TOKEN_FLAG_ESCAPED)
+    json_scanner_append_unescaped_string(value, &input[token->start], token->end - token->start);
+  else
+    g_string_append_len(value, &input[token->start], token->end - token->start);
+}
+
+/* escapes a string the same way json-c does, including the escaping of '/' */
+static void
+_append_json_escaped_string(GString *value, const gchar *str, gsize str_len)
+{
+  static const gchar hex_digits[] = "0123456789abcdef";
+
+  g_string_append_c(value, '"');
+  for (gsize i = 0; i < str_len; i++)
+    {
+      guchar c = str[i];
+
+      switch (c)
+        {
+        case '\b':
+          g_string_append(value, "\\b");
+          break;
+        case '\n':
+          g_string_append(value, "\\n");
+          break;
+        case '\r':
+          g_string_append(value, "\\r");
+          break;
+        case '\t':
+          g_string_append(value, "\\t");
+          break;
+        case '\f':
+          g_string_append(value, "\\f");
+          break;
+        case '"':
+        case '\\':
+        case '/':
+          g_string_append_c(value, '\\');
+          g_string_append_c(value, c);
+          break;
+        default:
+          if (c < ' ')
+            {
+              g_string_append(value, "\\u00");
+              g_string_append_c(value, hex_digits[c >> 4]);
+              g_string_append_c(value, hex_digits[c & 0xf]);
+            }
+          else
+            {
+              g_string_append_c(value, c);
+            }
+          break;
+        }
+    }
+  g_string_append_c(value, '"');
+}
+
+static void
+_append_string_token_as_json(GString *value, const gchar *input, const JSONToken *token)
+{
+  ScratchBuffersMarker marker;
+  GString *unescaped = scratch_buffers_alloc_and_mark(&marker);
+
+  _append_string_token(unescaped, input, token);
+  _append_json_escaped_string(value, unescaped->str, unescaped->len);
+  scratch_buffers_reclaim_marked(marker);
+}
+
+/*
+ * json-c parses integers into 64 bit values, clamping the ones that do not
+ * fit.  Non-negative ones are stored as unsigned, but
+ * json_object_get_int64() clamps those to G_MAXINT64 as well.
+ */
+static void
+_append_integer_token(GString *value, const gchar *input, const JSONToken *token, gboolean allow_unsigned)
+{
+  gchar *digits = g_strndup(&input[token->start], token->end - token->start);
+
+  if (allow_unsigned && digits[0] != '-')
+    g_string_append_printf(value, "%" G_GUINT64_FORMAT, (guint64) g_ascii_strtoull(digits, NULL, 10));
+  else
+    g_string_append_printf(value, "%" G_GINT64_FORMAT, (gint64) g_ascii_strtoll(digits, NULL, 10));
+  g_free(digits);
+}
+
+/* json-c keeps the original text of floating point numbers */
+static void
+_append_number_token_as_json(GString *value, const gchar *input, const JSONToken *token)
+{
+  if (token->flags & JSON_TOKEN_FLAG_FLOAT)
+    {
+      g_string_append_len(value, &input[token->start], token->end - token->start);
+      return;
+    }
+
+  _append_integer_token(value, input, token, TRUE);
+}
+
+static guint32 _append_tokens_as_json(GString *value, const gchar *input, const JSONToken *tokens, guint32 idx);
+
+/*
+ * json-c stores objects in a hash table: a repeated key keeps the position
+ * of its first occurrence, but takes the value of the last one.
+ */
+static void
+_append_object_tokens_as_json(GString *value, const gchar *input, const JSONToken *tokens, guint32 idx)
+{
+  ScratchBuffersMarker marker;
+  GString *key = scratch_buffers_alloc_and_mark(&marker);
+  GHashTable *last_values = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  guint32 member = idx + 1;
+
+  for (guint32 i = 0; i < tokens[idx].size; i++)
+    {
+      g_string_truncate(key, 0);
+      _append_string_token(key, input, &tokens[member]);
+      g_hash_table_replace(last_values, g_strdup(key->str), GUINT_TO_POINTER(member + 1));
+      member = tokens[member + 1].next;
+    }
+
+  gboolean first = TRUE;
+  member = idx + 1;
+  g_string_append_c(value, '{');
+  for (guint32 i = 0; i < tokens[idx].size; i++)
+    {
+      g_string_truncate(key, 0);
+      _append_string_token(key, input, &tokens[member]);
+
+      guint32 value_idx = GPOINTER_TO_UINT(g_hash_table_lookup(last_values, key->str));
+      if (value_idx)
+        {
+          if (!first)
+            g_string_append_c(value, ',');
+          first = FALSE;
+          _append_json_escaped_string(value, key->str, key->len);
+          g_string_append_c(value, ':');
+          _append_tokens_as_json(value, input, tokens, value_idx);
+          g_hash_table_remove(last_values, key->str);
+        }
+      member = tokens[member + 1].next;
+    }
+  g_string_append_c(value, '}');
+
+  g_hash_table_destroy(last_values);
+  scratch_buffers_reclaim_marked(marker);
+}
+
+/* compact JSON, as json_object_to_json_string_ext(JSON_C_TO_STRING_PLAIN) would produce it */
+static guint32
+_append_tokens_as_json(GString *value, const gchar *input, const JSONToken *tokens, guint32 idx)
+{
+  const JSONToken *token = &tokens[idx];
+
+  switch (token->type)
+    {
+    case JSON_TOKEN_OBJECT:
+      _append_object_tokens_as_json(value, input, tokens, idx);
+      break;
+    case JSON_TOKEN_ARRAY:
+    {
+      guint32 element = idx + 1;
+
+      g_string_append_c(value, '[');
+      for (guint32 i = 0; i < token->size; i++)
+        {
+          if (i != 0)
+            g_string_append_c(value, ',');
+          element = _append_tokens_as_json(value, input, tokens, element);
+        }
+      g_string_append_c(value, ']');
+      break;
+    }
+    case JSON_TOKEN_STRING:
+      _append_string_token_as_json(value, input, token);
+      break;
+    case JSON_TOKEN_NUMBER:
+      _append_number_token_as_json(value, input, token);
+      break;
+    default:
+      g_string_append_len(value, &input[token->start], token->end - token->start);
+      break;
+    }
+  return token->next;
+}
+
+static gboolean
+json_parser_extract_string_from_simple_token(JSONParser *self, const gchar *input, const JSONToken *token,
+                                             GString *value, LogMessageValueType *type)
+{
+  g_string_truncate(value, 0);
+  switch (token->type)
+    {
+    case JSON_TOKEN_TRUE:
+      g_string_assign(value, "true");
+      *type = LM_VT_BOOLEAN;
+      return TRUE;
+    case JSON_TOKEN_FALSE:
+      g_string_assign(value, "false");
+      *type = LM_VT_BOOLEAN;
+      return TRUE;
+    case JSON_TOKEN_NUMBER:
+      /* formatted as json_parser_extract_string_from_simple_json_object() does */
+      if (token->flags & JSON_TOKEN_FLAG_FLOAT)
+        {
+          g_string_append_len(value, &input[token->start], token->end - token->start);
+          g_string_printf(value, "%f", g_ascii_strtod(value->str, NULL));
+          *type = LM_VT_DOUBLE;
+        }
+      else
+        {
+          _append_integer_token(value, input, token, FALSE);
+          *type = LM_VT_INTEGER;
+        }
+      return TRUE;
+    case JSON_TOKEN_STRING:
+      _append_string_token(value, input, token);
+      *type = LM_VT_STRING;
+      return TRUE;
+    case JSON_TOKEN_NULL:
+      /* see json_parser_extract_string_from_simple_json_object() */
+      *type = LM_VT_NULL;
+      return TRUE;
+    default:
+      break;
+    }
+  return FALSE;
+}
+
+static void
+json_parser_store_array_tokens(JSONParser *self, const gchar *input, const JSONToken *tokens, guint32 idx,
+                               const gchar *prefix, const gchar *obj_key, LogMessage *msg)
+{
+  GString *value = scratch_buffers_alloc();
+  GString *element_value = scratch_buffers_alloc();
+  LogMessageValueType type = LM_VT_LIST;
+  guint32 element = idx + 1;
+
+  for (guint32 i = 0; i < tokens[idx].size; i++)
+    {
+      const JSONToken *token = &tokens[element];
+
+      if (token->type != JSON_TOKEN_STRING)
+        {
+          /* unknown type, encode the entire array as JSON */
+          g_string_truncate(value, 0);
+          _append_tokens_as_json(value, input, tokens, idx);
+          type = LM_VT_JSON;
+          break;
+        }
+
+      if (i != 0)
+        g_string_append_c(value, ',');
+      g_string_truncate(element_value, 0);
+      _append_string_token(element_value, input, token);
+      str_repr_encode_append(value, element_value->str, element_value->len, ",");
+      element = token->next;
+    }
+
+  json_parser_store_value(self, prefix, obj_key, value->str, value->len, type, msg);
+}
+
+static void
+json_parser_process_attribute_token(JSONParser *self, const gchar *input, const JSONToken *tokens, guint32 idx,
+                                    const gchar *prefix, const gchar *obj_key, LogMessage *msg)
+{
+  const JSONToken *token = &tokens[idx];
+  ScratchBuffersMarker marker;
+  scratch_buffers_mark(&marker);
+
+  switch (token->type)
+    {
+    case JSON_TOKEN_OBJECT:
+    {
+      GString *key = scratch_buffers_alloc();
+      if (prefix)
+        g_string_assign(key, prefix);
+      g_string_append(key, obj_key);
+      g_string_append_c(key, self->key_delimiter);
+      json_parser_process_object_tokens(self, input, tokens, idx, key->str, msg);
+      break;
+    }
+    case JSON_TOKEN_ARRAY:
+      json_parser_store_array_tokens(self, input, tokens, idx, prefix, obj_key, msg);
+      break;
+    case JSON_TOKEN_STRING:
+      if (!(token->flags & JSON_TOKEN_FLAG_ESCAPED))
+        {
+          /* no need to copy, the value goes straight from the input to the message */
+          json_parser_store_value(self, prefix, obj_key, &input[token->start], token->end - token->start,
+                                  LM_VT_STRING, msg);
+          break;
+        }
+    /* fallthrough */
+    default:
+    {
+      GString *value = scratch_buffers_alloc();
+      LogMessageValueType type;
+
+      json_parser_extract_string_from_simple_token(self, input, token, value, &type);
+      json_parser_store_value(self, prefix, obj_key, value->str, value->len, type, msg);
+      break;
+    }
+    }
+
+  scratch_buffers_reclaim_marked(marker);
+}
+
+static void
+json_parser_process_object_tokens(JSONParser *self, const gchar *input, const JSONToken *tokens, guint32 idx,
+                                  const gchar *prefix, LogMessage *msg)
+{
+  guint32 size = tokens[idx].size;
+  guint32 member = idx + 1;
+
+  for (guint32 i = 0; i < size; i++)
+    {
+      ScratchBuffersMarker marker;
+      GString *key = scratch_buffers_alloc_and_mark(&marker);
+
+      _append_string_token(key, input, &tokens[member]);
+      json_parser_process_attribute_token(self, input, tokens, member + 1, prefix, key->str, msg);
+      member = tokens[member + 1].next;
+
+      scratch_buffers_reclaim_marked(marker);
+    }
+}
+
+static void
+json_parser_process_array_tokens(JSONParser *self, const gchar *input, const JSONToken *tokens, LogMessage *msg)
+{
+  guint32 element = 1;
+  gint i;
+
+  log_msg_unset_match(msg, 0);
+  for (i = 0; i < tokens[0].size && i < LOGMSG_MAX_MATCHES; i++)
+    {
+      GString *element_value = scratch_buffers_alloc();
+      LogMessageValueType element_type;
+
+      if (!json_parser_extract_string_from_simple_token(self, input, &tokens[element], element_value, &element_type))
+        {
+          /* unknown type, encode the entire value as JSON */
+          _append_tokens_as_json(element_value, input, tokens, element);
+          element_type = LM_VT_JSON;
+        }
+      log_msg_set_match_with_type(msg, i + 1, element_value->str, element_value->len, element_type);
+      element = tokens[element].next;
+    }
+  log_msg_truncate_matches(msg, i + 1);
+}
+
+static gboolean
+json_parser_extract_tokens(JSONParser *self, const gchar *input, const JSONToken *tokens, LogMessage *msg)
+{
+  switch (tokens[0].type)
+    {
+    case JSON_TOKEN_OBJECT:
+      json_parser_process_object_tokens(self, input, tokens, 0, self->prefix, msg);
+      return TRUE;
+    case JSON_TOKEN_ARRAY:
+      json_parser_process_array_tokens(self, input, tokens, msg);
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+/*
+ * Returns FALSE if the input is not strict JSON, in which case the caller
+ * falls back to json-c, which accepts a more relaxed syntax (e.g.  single
+ * quoted strings).  The LogMessage is only changed if the input was valid.
+ */
+static gboolean
+json_parser_process_with_scanner(JSONParser *self, LogMessage **pmsg, const LogPathOptions *path_options,
+                                 const gchar *input, gsize input_len, gboolean *success)
+{
+  JSONToken preallocated_tokens[JSON_PARSER_PREALLOCATED_TOKENS];
+  JSONScanner scanner;
+
+  json_scanner_init(&scanner, preallocated_tokens, G_N_ELEMENTS(preallocated_tokens));
+  json_scanner_set_max_depth(&scanner, JSON_PARSER_MAX_DEPTH);
+
+  JSONScannerResult result = json_scanner_scan(&scanner, input, input_len);
+  if (result != JSON_SCANNER_SUCCESS)
+    {
+      msg_trace("json-parser(): input is not strict JSON, falling back to json-c",
+                evt_tag_str("error", json_scanner_result_to_string(result)),
+                evt_tag_long("error_pos", json_scanner_get_error_pos(&scanner)));
+      json_scanner_deinit(&scanner);
+      return FALSE;
+    }
+
+  const JSONToken *tokens = json_scanner_get_tokens(&scanner);
+  if (tokens[0].type != JSON_TOKEN_OBJECT && tokens[0].type != JSON_TOKEN_ARRAY)
+    {
+      msg_debug("json-parser(): failed to extract JSON members into name-value pairs. The parsed/extracted JSON payload was not an object",
+                evt_tag_str("input", input));
+      *success = FALSE;
+    }
+  else
+    {
+      log_msg_make_writable(pmsg, path_options);
+      *success = json_parser_extract_tokens(self, input, tokens, *pmsg);
+    }
+
+  json_scanner_deinit(&scanner);
+  return TRUE;
+}
+
 #ifndef JSON_C_VERSION
 const char *
 json_tokener_error_desc(enum json_tokener_error err)
@@ -348,11 +775,20 @@ json_parser_process(LogParser *s, LogMessage **pmsg, const LogPathOptions *path_
           return FALSE;
         }
       input += self->marker_len;
+      input_len -= self->marker_len;
 
       while (isspace(*input))
-        input++;
+        {
+          input++;
+          input_len--;
+        }
     }
 
+  gboolean success;
+  if (!self->extract_prefix &&
+      json_parser_process_with_scanner(self, pmsg, path_options, input, input_len, &success))
+    return success;
+
   tok = json_tokener_new();
   jso = json_tokener_parse_ex(tok, input, input_len);
   if (tok->err != json_tokener_success || !jso)
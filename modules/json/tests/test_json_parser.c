@@ -161,6 +161,114 @@ Test(json_parser, test_json_parser_validate_type_representation)
   log_pipe_unref(&json_parser->super);
 }
 
+Test(json_parser, test_json_parser_validate_type_representation_of_strict_json)
+{
+  LogMessage *msg;
+  LogParser *json_parser = json_parser_new(NULL);
+
+  json_parser_set_prefix(json_parser, ".prefix.");
+  msg = parse_json_into_log_message("{\"int\": 123, \"booltrue\": true, \"boolfalse\": false, \"double\": 1.23, "
+                                    "\"object\": {\"member1\": \"foo\", \"member2\": \"bar\"}, "
+                                    "\"array\": [\"1\", \"2\", \"3\"], \"null\": null, "
+                                    "\"escaped\": \"foo\\n\\\"bar\\\" \\u00e9\", \"esc\\u0061ped_key\": \"baz\"}",
+                                    json_parser);
+  assert_log_message_value_and_type_by_name(msg, ".prefix.int", "123", LM_VT_INTEGER);
+  assert_log_message_value_and_type_by_name(msg, ".prefix.booltrue", "true", LM_VT_BOOLEAN);
+  assert_log_message_value_and_type_by_name(msg, ".prefix.boolfalse", "false", LM_VT_BOOLEAN);
+  assert_log_message_value_and_type_by_name(msg, ".prefix.double", "1.230000", LM_VT_DOUBLE);
+  assert_log_message_value_and_type_by_name(msg, ".prefix.object.member1", "foo", LM_VT_STRING);
+  assert_log_message_value_and_type_by_name(msg, ".prefix.object.member2", "bar", LM_VT_STRING);
+  assert_log_message_value_and_type_by_name(msg, ".prefix.array", "1,2,3", LM_VT_LIST);
+  assert_log_message_value_and_type_by_name(msg, ".prefix.null", "", LM_VT_NULL);
+  assert_log_message_value_and_type_by_name(msg, ".prefix.escaped", "foo\n\"bar\" \xc3\xa9", LM_VT_STRING);
+  assert_log_message_value_and_type_by_name(msg, ".prefix.escaped_key", "baz", LM_VT_STRING);
+  log_msg_unref(msg);
+  log_pipe_unref(&json_parser->super);
+}
+
+Test(json_parser, test_json_parser_strict_json_compound_types_are_represented_as_compact_json)
+{
+  LogMessage *msg;
+  LogParser *json_parser = json_parser_new(NULL);
+
+  json_parser_set_prefix(json_parser, ".prefix.");
+  msg = parse_json_into_log_message("{\"arrayofmixedtypes\": [\"str\", 42, {}, null],"
+                                    " \"arrayofobjects\": [ {\"foo\" : \"bar\"}, {\"bar\": [1, 2.5]} ]}",
+                                    json_parser);
+  assert_log_message_value_and_type_by_name(msg, ".prefix.arrayofmixedtypes", "[\"str\",42,{},null]", LM_VT_JSON);
+  assert_log_message_value_and_type_by_name(msg, ".prefix.arrayofobjects",
+                                            "[{\"foo\":\"bar\"},{\"bar\":[1,2.5]}]", LM_VT_JSON);
+  log_msg_unref(msg);
+
+  msg = parse_json_into_log_message("[42, \"foo\", {\"foo\": \"bar\"}]", json_parser);
+  assert_log_message_value_and_type_by_name(msg, "1", "42", LM_VT_INTEGER);
+  assert_log_message_value_and_type_by_name(msg, "2", "foo", LM_VT_STRING);
+  assert_log_message_value_and_type_by_name(msg, "3", "{\"foo\":\"bar\"}", LM_VT_JSON);
+  cr_assert(msg->num_matches == 4);
+  log_msg_unref(msg);
+
+  log_pipe_unref(&json_parser->super);
+}
+
+/* the scanner is bypassed if extract-prefix() is set, json-c parses the input instead */
+static void
+assert_scanner_and_json_c_produce_the_same_typed_value(const gchar *json, const gchar *name,
+                                                       const gchar *expected_value, LogMessageValueType expected_type)
+{
+  LogParser *scanner_parser = json_parser_new(NULL);
+  LogParser *json_c_parser = json_parser_new(NULL);
+  gchar *wrapped_json = g_strdup_printf("[%s]", json);
+
+  json_parser_set_extract_prefix(json_c_parser, "[0]");
+
+  LogMessage *msg = parse_json_into_log_message(json, scanner_parser);
+  assert_log_message_value_and_type_by_name(msg, name, expected_value, expected_type);
+  log_msg_unref(msg);
+
+  msg = parse_json_into_log_message(wrapped_json, json_c_parser);
+  assert_log_message_value_and_type_by_name(msg, name, expected_value, expected_type);
+  log_msg_unref(msg);
+
+  g_free(wrapped_json);
+  log_pipe_unref(&json_c_parser->super);
+  log_pipe_unref(&scanner_parser->super);
+}
+
+static void
+assert_scanner_and_json_c_produce_the_same_value(const gchar *json, const gchar *name, const gchar *expected_value)
+{
+  assert_scanner_and_json_c_produce_the_same_typed_value(json, name, expected_value, LM_VT_JSON);
+}
+
+Test(json_parser, test_json_parser_strict_json_compound_types_match_the_json_c_representation)
+{
+  assert_scanner_and_json_c_produce_the_same_value("{\"array\": [1, \"a\\\"b\\\\c\\/d\\n\\u0001\"]}",
+                                                   "array", "[1,\"a\\\"b\\\\c\\/d\\n\\u0001\"]");
+  assert_scanner_and_json_c_produce_the_same_value("{\"array\": [1, \"http://example.com/\"]}",
+                                                   "array", "[1,\"http:\\/\\/example.com\\/\"]");
+  assert_scanner_and_json_c_produce_the_same_value("{\"array\": [1, \"\\u00e9\\u20ac\\ud83d\\ude00\\u0041\"]}",
+                                                   "array", "[1,\"\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80" "A\"]");
+  assert_scanner_and_json_c_produce_the_same_value("{\"array\": [1.50, 1e6, -2.5E-3, 0.0]}",
+                                                   "array", "[1.50,1e6,-2.5E-3,0.0]");
+  assert_scanner_and_json_c_produce_the_same_value("{\"array\": [{\"a\": 1, \"b\": 2, \"a\": 3}]}",
+                                                   "array", "[{\"a\":3,\"b\":2}]");
+  assert_scanner_and_json_c_produce_the_same_value("{\"array\": [{\"k\\u0065y\": 1, \"key\": {\"x\": [], \"x\": {}}}]}",
+                                                   "array", "[{\"key\":{\"x\":{}}}]");
+}
+
+Test(json_parser, test_json_parser_strict_json_integers_match_the_json_c_representation)
+{
+  assert_scanner_and_json_c_produce_the_same_typed_value("{\"int\": -0}", "int", "0", LM_VT_INTEGER);
+  assert_scanner_and_json_c_produce_the_same_typed_value("{\"int\": 9223372036854775807}",
+                                                         "int", "9223372036854775807", LM_VT_INTEGER);
+  assert_scanner_and_json_c_produce_the_same_typed_value("{\"int\": 9223372036854775808}",
+                                                         "int", "9223372036854775807", LM_VT_INTEGER);
+  assert_scanner_and_json_c_produce_the_same_typed_value("{\"int\": -9223372036854775809}",
+                                                         "int", "-9223372036854775808", LM_VT_INTEGER);
+  assert_scanner_and_json_c_produce_the_same_value("{\"array\": [-0, 9223372036854775808, -9223372036854775809]}",
+                                                   "array", "[0,9223372036854775808,-9223372036854775808]");
+}
+
 Test(json_parser, test_json_parser_different_type_arrays)
 {
   LogMessage *msg;
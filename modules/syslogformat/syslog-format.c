@@ -34,12 +34,21 @@
 #include "str-utils.h"
 #include "syslog-names.h"
 #include "scratch-buffers.h"
+#include "cpu-features.h"
 
 #include "logproto/logproto.h"
 
 #include <regex.h>
 #include <string.h>
 
+#if CPU_FEATURES_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#if CPU_FEATURES_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
 #define SD_NAME_SIZE 256
 
 static const char aix_fwd_string[] = "Message forwarded from ";
@@ -326,6 +335,261 @@ _syslog_format_parse_version(LogMessage *msg, const guchar **data, gint *length)
   return TRUE;
 }
 
+/*
+ * Header scanner
+ *
+ * The hostname, the program name and the pid are short fields, they
+ * usually end well within the first 64 bytes following the timestamp.
+ * Instead of testing them byte by byte, the scanner classifies a 64 byte
+ * window with SIMD instructions, producing one bit per byte for each
+ * character class the parsers are looking for, so finding the end of a
+ * field is a count-trailing-zeros.  Later fields reuse the same window
+ * as long as they start within it.
+ *
+ * The scanner only answers the common cases, whenever the masks do not
+ * tell the whole story (a field does not end in the window, a hostname
+ * that needs the IPv6 heuristics, etc.) the scalar loops below decide.
+ */
+
+#define HEADER_SCAN_WINDOW 64
+
+enum
+{
+  HEADER_SCAN_SPACE,
+  HEADER_SCAN_OPEN_BRACKET,
+  HEADER_SCAN_CLOSE_BRACKET,
+  HEADER_SCAN_COLON,
+  /* the complement of the set in _init_parse_hostname_invalid_chars() */
+  HEADER_SCAN_INVALID_HOSTNAME_CHAR,
+  HEADER_SCAN_CLASSES
+};
+
+#define HEADER_SCAN_MATCH(class) (1 << (class))
+
+typedef struct _HeaderScan
+{
+  const guchar *base;
+  gint len;
+  guint64 masks[HEADER_SCAN_CLASSES];
+} HeaderScan;
+
+/* classifies exactly HEADER_SCAN_WINDOW bytes, setting bit i of
+ * masks[class] if window[i] belongs to class */
+typedef void (*HeaderScanClassifyFunc)(const guchar *window, guint64 *masks);
+
+#if CPU_FEATURES_HAVE_X86_SIMD
+
+/* bytes above 0x7f are negative as signed chars, so they are never in an
+ * ASCII range */
+__attribute__((target("sse2")))
+static inline __m128i
+_in_range_sse2(__m128i chunk, gchar lo, gchar hi)
+{
+  return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(lo - 1)),
+                       _mm_cmplt_epi8(chunk, _mm_set1_epi8(hi + 1)));
+}
+
+__attribute__((target("sse2")))
+static inline guint64
+_movemask_sse2(__m128i matches)
+{
+  return (guint32) _mm_movemask_epi8(matches);
+}
+
+__attribute__((target("sse2")))
+static void
+_header_scan_classify_sse2(const guchar *window, guint64 *masks)
+{
+  for (gint i = 0; i < HEADER_SCAN_WINDOW; i += 16)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *) (window + i));
+
+      /* '-' ... ':' covers "-./0123456789:", '@' ... 'Z' covers the
+       * capital letters */
+      __m128i hostname_chars = _mm_or_si128(_mm_or_si128(_in_range_sse2(chunk, '-', ':'),
+                                                         _in_range_sse2(chunk, '@', 'Z')),
+                                            _mm_or_si128(_in_range_sse2(chunk, 'a', 'z'),
+                                                         _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_'))));
+
+      masks[HEADER_SCAN_SPACE] |= _movemask_sse2(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '))) << i;
+      masks[HEADER_SCAN_OPEN_BRACKET] |= _movemask_sse2(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('['))) << i;
+      masks[HEADER_SCAN_CLOSE_BRACKET] |= _movemask_sse2(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(']'))) << i;
+      masks[HEADER_SCAN_COLON] |= _movemask_sse2(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(':'))) << i;
+      masks[HEADER_SCAN_INVALID_HOSTNAME_CHAR] |= (~_movemask_sse2(hostname_chars) & 0xFFFF) << i;
+    }
+}
+
+#endif
+
+#if CPU_FEATURES_HAVE_NEON
+
+static inline uint8x16_t
+_in_range_neon(uint8x16_t chunk, guint8 lo, guint8 hi)
+{
+  return vandq_u8(vcgeq_u8(chunk, vdupq_n_u8(lo)), vcleq_u8(chunk, vdupq_n_u8(hi)));
+}
+
+/* NEON has no movemask, weight each byte by its bit and add them up */
+static inline guint64
+_movemask_neon(uint8x16_t matches)
+{
+  static const guint8 weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+  uint8x16_t bits = vandq_u8(matches, vld1q_u8(weights));
+
+  return vaddv_u8(vget_low_u8(bits)) | ((guint64) vaddv_u8(vget_high_u8(bits)) << 8);
+}
+
+static void
+_header_scan_classify_neon(const guchar *window, guint64 *masks)
+{
+  for (gint i = 0; i < HEADER_SCAN_WINDOW; i += 16)
+    {
+      uint8x16_t chunk = vld1q_u8(window + i);
+      uint8x16_t hostname_chars = vorrq_u8(vorrq_u8(_in_range_neon(chunk, '-', ':'),
+                                                    _in_range_neon(chunk, '@', 'Z')),
+                                           vorrq_u8(_in_range_neon(chunk, 'a', 'z'),
+                                                    vceqq_u8(chunk, vdupq_n_u8('_'))));
+
+      masks[HEADER_SCAN_SPACE] |= _movemask_neon(vceqq_u8(chunk, vdupq_n_u8(' '))) << i;
+      masks[HEADER_SCAN_OPEN_BRACKET] |= _movemask_neon(vceqq_u8(chunk, vdupq_n_u8('['))) << i;
+      masks[HEADER_SCAN_CLOSE_BRACKET] |= _movemask_neon(vceqq_u8(chunk, vdupq_n_u8(']'))) << i;
+      masks[HEADER_SCAN_COLON] |= _movemask_neon(vceqq_u8(chunk, vdupq_n_u8(':'))) << i;
+      masks[HEADER_SCAN_INVALID_HOSTNAME_CHAR] |= _movemask_neon(vmvnq_u8(hostname_chars)) << i;
+    }
+}
+
+#endif
+
+static SyslogFormatSIMDLevel header_scan_simd_level = SYSLOG_FORMAT_SIMD_NONE;
+static HeaderScanClassifyFunc header_scan_classify;
+static gboolean header_scan_resolved;
+
+gboolean
+syslog_format_set_simd_level(SyslogFormatSIMDLevel level)
+{
+  HeaderScanClassifyFunc func;
+
+  switch (level)
+    {
+    case SYSLOG_FORMAT_SIMD_NONE:
+      func = NULL;
+      break;
+#if CPU_FEATURES_HAVE_X86_SIMD
+    case SYSLOG_FORMAT_SIMD_SSE2:
+      if (!cpu_supports_sse2())
+        return FALSE;
+      func = _header_scan_classify_sse2;
+      break;
+#endif
+#if CPU_FEATURES_HAVE_NEON
+    case SYSLOG_FORMAT_SIMD_NEON:
+      func = _header_scan_classify_neon;
+      break;
+#endif
+    default:
+      return FALSE;
+    }
+
+  header_scan_simd_level = level;
+  header_scan_classify = func;
+  header_scan_resolved = TRUE;
+  return TRUE;
+}
+
+SyslogFormatSIMDLevel
+syslog_format_get_simd_level(void)
+{
+  return header_scan_simd_level;
+}
+
+static void
+_header_scan_classify(HeaderScan *self, const guchar *src, gint left)
+{
+  guchar window[HEADER_SCAN_WINDOW];
+  const guchar *p = src;
+
+  self->base = src;
+  self->len = MIN(left, HEADER_SCAN_WINDOW);
+  memset(self->masks, 0, sizeof(self->masks));
+
+  /* the kernels always read a full window, pad short messages, the
+   * padding is masked out below */
+  if (self->len < HEADER_SCAN_WINDOW)
+    {
+      memset(window, 0, sizeof(window));
+      memcpy(window, src, self->len);
+      p = window;
+    }
+  header_scan_classify(p, self->masks);
+
+  if (self->len < HEADER_SCAN_WINDOW)
+    {
+      guint64 in_window = (G_GUINT64_CONSTANT(1) << self->len) - 1;
+
+      for (gint i = 0; i < HEADER_SCAN_CLASSES; i++)
+        self->masks[i] &= in_window;
+    }
+}
+
+static inline gint
+_header_scan_lookup(const HeaderScan *self, const guchar *src, guint classes)
+{
+  guint64 mask = 0;
+
+  for (gint i = 0; i < HEADER_SCAN_CLASSES; i++)
+    {
+      if (classes & HEADER_SCAN_MATCH(i))
+        mask |= self->masks[i];
+    }
+  mask >>= src - self->base;
+  return mask ? __builtin_ctzll(mask) : -1;
+}
+
+/* Returns the offset of the first byte at src that belongs to any of
+ * classes, or -1 if there is no such byte within the window (or there is
+ * no scanner at all), in which case the caller falls back to the scalar
+ * loop. */
+static gint
+_header_scan_find(HeaderScan *self, const guchar *src, gint left, guint classes)
+{
+  gint pos;
+
+  if (!header_scan_classify || left <= 0)
+    return -1;
+
+  if (self->base && src >= self->base && src < self->base + self->len)
+    {
+      pos = _header_scan_lookup(self, src, classes);
+      /* a window that started here could still find it further on */
+      if (pos >= 0 || src == self->base || self->len < HEADER_SCAN_WINDOW)
+        return pos;
+    }
+
+  _header_scan_classify(self, src, left);
+  return _header_scan_lookup(self, src, classes);
+}
+
+/* whether any of src[0..len) belongs to class, src and len must be
+ * covered by the last successful _header_scan_find() */
+static inline gboolean
+_header_scan_span_has(const HeaderScan *self, const guchar *src, gint len, gint class)
+{
+  guint64 span = (G_GUINT64_CONSTANT(1) << len) - 1;
+
+  return ((self->masks[class] >> (src - self->base)) & span) != 0;
+}
+
+static void
+_header_scan_init(void)
+{
+  if (header_scan_resolved)
+    return;
+
+  if (!syslog_format_set_simd_level(SYSLOG_FORMAT_SIMD_SSE2) &&
+      !syslog_format_set_simd_level(SYSLOG_FORMAT_SIMD_NEON))
+    syslog_format_set_simd_level(SYSLOG_FORMAT_SIMD_NONE);
+}
+
 static const gchar program_name_allowed_specials[] = ".-_()/";
 static gsize program_name_allowed_spacial_chars_len = G_N_ELEMENTS(program_name_allowed_specials) - 1;
 
@@ -345,17 +609,28 @@ _validate_program_char(const guchar ch, gboolean *has_alpha)
 }
 
 static void
-_syslog_format_parse_legacy_program_name(LogMessage *msg, const guchar **data, gint *length, guint flags)
+_syslog_format_parse_legacy_program_name(LogMessage *msg, const guchar **data, gint *length, guint flags,
+                                         HeaderScan *scan)
 {
   /* the data pointer will not change */
   const guchar *src, *prog_start;
-  gint left;
+  gint left, pos;
 
   src = *data;
   left = *length;
   prog_start = src;
   gboolean has_alpha_char = FALSE;
 
+  if (G_LIKELY(!(flags & LP_CHECK_PROGRAM)) &&
+      (pos = _header_scan_find(scan, src, left,
+                               HEADER_SCAN_MATCH(HEADER_SCAN_SPACE) |
+                               HEADER_SCAN_MATCH(HEADER_SCAN_OPEN_BRACKET) |
+                               HEADER_SCAN_MATCH(HEADER_SCAN_COLON))) >= 0)
+    {
+      src += pos;
+      left -= pos;
+    }
+
   while (left && *src != ' ' && *src != '[' && *src != ':')
     {
       if (G_UNLIKELY(flags & LP_CHECK_PROGRAM) && !_validate_program_char(*src, &has_alpha_char))
@@ -376,6 +651,16 @@ _syslog_format_parse_legacy_program_name(LogMessage *msg, const guchar **data, g
   if (left > 0 && *src == '[')
     {
       const guchar *pid_start = src + 1;
+
+      pos = _header_scan_find(scan, src, left,
+                              HEADER_SCAN_MATCH(HEADER_SCAN_SPACE) |
+                              HEADER_SCAN_MATCH(HEADER_SCAN_CLOSE_BRACKET) |
+                              HEADER_SCAN_MATCH(HEADER_SCAN_COLON));
+      if (pos >= 0)
+        {
+          src += pos;
+          left -= pos;
+        }
       while (left && *src != ' ' && *src != ']' && *src != ':')
         {
           _skip_char(&src, &left);
@@ -479,10 +764,41 @@ ipv6_heuristics_feed_gchar(IPv6Heuristics *self, gchar c)
   return TRUE;
 }
 
+/* The common case of _syslog_format_parse_hostname(): a hostname without
+ * colons (so no IPv6 heuristics), terminated by a space within the scan
+ * window.  Returns the length of the hostname or -1 to have the scalar
+ * loop decide, which also takes care of tagging invalid hostnames. */
+static gint
+_syslog_format_scan_hostname(HeaderScan *scan, const guchar *src, gint left, guint flags, regex_t *bad_hostname)
+{
+  gint len = _header_scan_find(scan, src, left,
+                               HEADER_SCAN_MATCH(HEADER_SCAN_SPACE) | HEADER_SCAN_MATCH(HEADER_SCAN_OPEN_BRACKET));
+
+  if (len < 0 || src[len] != ' ')
+    return -1;
+
+  if (_header_scan_span_has(scan, src, len, HEADER_SCAN_COLON))
+    return -1;
+
+  if ((flags & LP_CHECK_HOSTNAME) && _header_scan_span_has(scan, src, len, HEADER_SCAN_INVALID_HOSTNAME_CHAR))
+    return -1;
+
+  if (bad_hostname)
+    {
+      gchar hostname_buf[HEADER_SCAN_WINDOW];
+
+      memcpy(hostname_buf, src, len);
+      hostname_buf[len] = 0;
+      if (regexec(bad_hostname, hostname_buf, 0, NULL, 0) == 0)
+        return -1;
+    }
+  return len;
+}
+
 static void
 _syslog_format_parse_hostname(LogMessage *msg, const guchar **data, gint *length,
                               const guchar **hostname_start, int *hostname_len,
-                              guint flags, regex_t *bad_hostname)
+                              guint flags, regex_t *bad_hostname, HeaderScan *scan)
 {
   /* FIXME: support nil value support  with new protocol*/
   const guchar *src, *oldsrc;
@@ -495,6 +811,16 @@ _syslog_format_parse_hostname(LogMessage *msg, const guchar **data, gint *length
   src = *data;
   left = *length;
 
+  gint len = _syslog_format_scan_hostname(scan, src, left, flags, bad_hostname);
+  if (len >= 0)
+    {
+      *hostname_start = src;
+      *hostname_len = len;
+      *data = src + len;
+      *length = left - len;
+      return;
+    }
+
   /* If we haven't already found the original hostname,
      look for it now. */
 
@@ -919,6 +1245,7 @@ _syslog_format_parse_legacy_header(LogMessage *msg, const guchar **data, gint *l
       /* Possibly: Message forwarded from hostname: ... */
       const guchar *hostname_start = NULL;
       int hostname_len = 0;
+      HeaderScan scan = { 0 };
 
       _skip_chars(&src, &left, " ", -1);
 
@@ -946,14 +1273,14 @@ _syslog_format_parse_legacy_header(LogMessage *msg, const guchar **data, gint *l
               /* Don't parse a hostname if it is local */
               /* It's a regular ol' message. */
               _syslog_format_parse_hostname(msg, &src, &left, &hostname_start, &hostname_len, parse_options->flags,
-                                            parse_options->bad_hostname);
+                                            parse_options->bad_hostname, &scan);
 
               /* Skip whitespace. */
               _skip_chars(&src, &left, " ", -1);
             }
 
           /* Try to extract a program name */
-          _syslog_format_parse_legacy_program_name(msg, &src, &left, parse_options->flags);
+          _syslog_format_parse_legacy_program_name(msg, &src, &left, parse_options->flags, &scan);
         }
 
       /* If we did manage to find a hostname, store it. */
@@ -975,9 +1302,11 @@ _syslog_format_parse_legacy_header(LogMessage *msg, const guchar **data, gint *l
       /* No, not a kernel message. */
       else
         {
+          HeaderScan scan = { 0 };
+
           log_msg_set_tag_by_id(msg, LM_T_SYSLOG_RFC3164_MISSING_HEADER);
           /* Capture the program name */
-          _syslog_format_parse_legacy_program_name(msg, &src, &left, parse_options->flags);
+          _syslog_format_parse_legacy_program_name(msg, &src, &left, parse_options->flags, &scan);
         }
     }
   *data = src;
@@ -1115,6 +1444,7 @@ _syslog_format_parse_syslog_proto(const MsgFormatOptions *parse_options, const g
   gint left;
   const guchar *hostname_start = NULL;
   gint hostname_len = 0;
+  HeaderScan scan = { 0 };
 
   src = (guchar *) data;
   left = length;
@@ -1147,7 +1477,7 @@ _syslog_format_parse_syslog_proto(const MsgFormatOptions *parse_options, const g
     }
 
   /* hostname 255 ascii */
-  _syslog_format_parse_hostname(msg, &src, &left, &hostname_start, &hostname_len, parse_options->flags, NULL);
+  _syslog_format_parse_hostname(msg, &src, &left, &hostname_start, &hostname_len, parse_options->flags, NULL, &scan);
   if (!_skip_space(&src, &left))
     {
       src++;
@@ -1236,4 +1566,5 @@ syslog_format_init(void)
     }
 
   _init_parse_hostname_invalid_chars();
+  _header_scan_init();
 }
@@ -33,6 +33,18 @@ gboolean syslog_format_handler(const MsgFormatOptions *parse_options,
 
 void syslog_format_init(void);
 
+typedef enum
+{
+  SYSLOG_FORMAT_SIMD_NONE,
+  SYSLOG_FORMAT_SIMD_SSE2,
+  SYSLOG_FORMAT_SIMD_NEON,
+} SyslogFormatSIMDLevel;
+
+/* the best available header scanner is selected by syslog_format_init(),
+ * these are for tests and benchmarks */
+gboolean syslog_format_set_simd_level(SyslogFormatSIMDLevel level);
+SyslogFormatSIMDLevel syslog_format_get_simd_level(void);
+
 gboolean _syslog_format_parse_sd(LogMessage *self, const guchar **data, gint *length, const MsgFormatOptions *options);
 
 
@@ -23,6 +23,7 @@
 
 #include <criterion/criterion.h>
 #include "libtest/msg_parse_lib.h"
+#include "libtest/stopwatch.h"
 
 #include "apphook.h"
 #include "cfg.h"
@@ -32,6 +33,7 @@
 #include "scratch-buffers.h"
 
 #include <string.h>
+#include <regex.h>
 
 GlobalConfig *cfg;
 MsgFormatOptions parse_options;
@@ -545,3 +547,139 @@ Test(syslog_format, test_framing_not_detected_on_input_starting_with_whitespace)
 
   log_msg_unref(msg);
 }
+
+static LogMessage *
+_parse_with_simd_level(SyslogFormatSIMDLevel level, const gchar *data, gsize data_length, gboolean *success)
+{
+  LogMessage *msg = msg_format_construct_message(&parse_options, (const guchar *) data, data_length);
+  gsize problem_position;
+
+  cr_assert(syslog_format_set_simd_level(level));
+  *success = syslog_format_handler(&parse_options, msg, (const guchar *) data, data_length, &problem_position);
+  return msg;
+}
+
+static void
+_assert_same_value(LogMessage *expected, LogMessage *actual, NVHandle handle, const gchar *data, gsize data_length)
+{
+  const gchar *expected_value = log_msg_get_value(expected, handle, NULL);
+  const gchar *actual_value = log_msg_get_value(actual, handle, NULL);
+
+  cr_assert_str_eq(actual_value, expected_value, "%s differs from the scalar parser, data=%.*s",
+                   log_msg_get_value_name(handle, NULL), (gint) data_length, data);
+}
+
+Test(syslog_format, test_header_scanner_matches_scalar_parser)
+{
+  const gchar *messages[] =
+  {
+    "<189>Feb  3 12:34:56 host program[1234]: message",
+    "<189>Feb  3 12:34:56 host program: message",
+    "<189>Feb  3 12:34:56 host program[1234 message",
+    "<189>Feb  3 12:34:56 host program[12:34]: message",
+    "<189>Feb  3 12:34:56 host.example.com /usr/sbin/cron[42]: (root) CMD (run-parts /etc/cron.hourly)",
+    "<189>Feb  3 12:34:56 1.2.3.4 program: message",
+    "<189>Feb  3 12:34:56 0000:BABA:BA00:DAB:BABA:BABA:BABA:BAB0 program: message",
+    "<189>Feb  3 12:34:56 0002:: program: message",
+    "<189>Feb  3 12:34:56 host:program: message",
+    "<189>Feb  3 12:34:56 [host] program: message",
+    "<189>Feb  3 12:34:56 %host program[1]: message",
+    "<189>Feb  3 12:34:56 h\xc3\xa1st program[1]: message",
+    "<189>Feb  3 12:34:56    host   program  [1]: message",
+    "<189>Feb  3 12:34:56 a-very-long-hostname-that-does-not-end-within-the-first-64-bytes.example.com program: message",
+    "<189>Feb  3 12:34:56 host a-very-long-program-name-that-does-not-end-within-the-first-64-bytes[1]: message",
+    "<189>Feb  3 12:34:56 host program[a-very-long-pid-that-does-not-end-within-the-first-64-bytes-either]: message",
+    "<189>Feb  3 12:34:56 bad-host program: message",
+    "<189>program[1]: message without a timestamp",
+    "<189>1 2003-10-11T22:14:15.003Z mymachine.example.com evntslog - ID47 [exampleSDID@0 iut=\"3\"] message",
+    "<189>1 2003-10-11T22:14:15.003Z - - - - - message",
+    "<189>1 2003-10-11T22:14:15.003Z ::1 app 42 - - message",
+    NULL
+  };
+  guint flags[] =
+  {
+    LP_EXPECT_HOSTNAME,
+    LP_EXPECT_HOSTNAME | LP_CHECK_HOSTNAME,
+    LP_EXPECT_HOSTNAME | LP_CHECK_PROGRAM,
+    LP_EXPECT_HOSTNAME | LP_STORE_LEGACY_MSGHDR,
+    0,
+  };
+  NVHandle handles[] = { LM_V_HOST, LM_V_PROGRAM, LM_V_PID, LM_V_MSGID, LM_V_MESSAGE, LM_V_LEGACY_MSGHDR };
+  LogTagId tags[] = { LM_T_SYSLOG_INVALID_HOSTNAME, LM_T_SYSLOG_RFC_3164_INVALID_PROGRAM };
+  SyslogFormatSIMDLevel best_level = syslog_format_get_simd_level();
+  regex_t bad_hostname;
+
+  cr_assert_eq(regcomp(&bad_hostname, "^bad", REG_NOSUB | REG_EXTENDED), 0);
+  parse_options.bad_hostname = &bad_hostname;
+  for (gint f = 0; f < G_N_ELEMENTS(flags); f++)
+    {
+      for (gint i = 0; messages[i]; i++)
+        {
+          gsize message_length = strlen(messages[i]);
+
+          parse_options.flags = flags[f] | (g_str_has_prefix(messages[i], "<189>1 ") ? LP_SYSLOG_PROTOCOL : 0);
+
+          /* every prefix, so that fields end at each position of the window */
+          for (gsize data_length = 0; data_length <= message_length; data_length++)
+            {
+              gboolean expected_success, actual_success;
+              LogMessage *expected = _parse_with_simd_level(SYSLOG_FORMAT_SIMD_NONE, messages[i], data_length,
+                                                            &expected_success);
+              LogMessage *actual = _parse_with_simd_level(best_level, messages[i], data_length, &actual_success);
+
+              cr_assert_eq(actual_success, expected_success);
+              for (gint h = 0; h < G_N_ELEMENTS(handles); h++)
+                _assert_same_value(expected, actual, handles[h], messages[i], data_length);
+              for (gint t = 0; t < G_N_ELEMENTS(tags); t++)
+                cr_assert_eq(log_msg_is_tag_by_id(actual, tags[t]), log_msg_is_tag_by_id(expected, tags[t]),
+                             "tag %d differs from the scalar parser, data=%.*s", tags[t], (gint) data_length, messages[i]);
+
+              log_msg_unref(expected);
+              log_msg_unref(actual);
+            }
+        }
+    }
+  parse_options.bad_hostname = NULL;
+  regfree(&bad_hostname);
+}
+
+#define PERF_ITERATIONS 10000
+
+Test(syslog_format, test_performance)
+{
+  struct
+  {
+    const gchar *msg;
+    guint parse_flags;
+  } messages[] =
+  {
+    { "<189>Feb  3 12:34:56 host.example.com sshd[2499]: Accepted publickey for root from 10.0.0.1 port 22", LP_EXPECT_HOSTNAME },
+    { "<189>Feb  3 12:34:56 host.example.com sshd[2499]: Accepted publickey for root from 10.0.0.1 port 22", LP_EXPECT_HOSTNAME | LP_CHECK_HOSTNAME },
+    { "<189>1 2003-10-11T22:14:15.003Z mymachine.example.com evntslog 2499 ID47 - An application event", LP_SYSLOG_PROTOCOL },
+  };
+  SyslogFormatSIMDLevel levels[] = { SYSLOG_FORMAT_SIMD_NONE, syslog_format_get_simd_level() };
+
+  for (gint l = 0; l < G_N_ELEMENTS(levels); l++)
+    {
+      cr_assert(syslog_format_set_simd_level(levels[l]));
+      for (gint i = 0; i < G_N_ELEMENTS(messages); i++)
+        {
+          gsize length = strlen(messages[i].msg);
+          gsize problem_position;
+
+          parse_options.flags = messages[i].parse_flags;
+          start_stopwatch();
+          for (gint iteration = 0; iteration < PERF_ITERATIONS; iteration++)
+            {
+              LogMessage *msg = msg_format_construct_message(&parse_options, (const guchar *) messages[i].msg, length);
+
+              cr_assert(syslog_format_handler(&parse_options, msg, (const guchar *) messages[i].msg, length,
+                                              &problem_position));
+              log_msg_unref(msg);
+            }
+          stop_stopwatch_and_display_result(PERF_ITERATIONS, "Parsing syslog header, simd_level=%d, flags=0x%x, msg=%s",
+                                            levels[l], messages[i].parse_flags, messages[i].msg);
+        }
+    }
+  cr_assert(syslog_format_set_simd_level(levels[1]));
+}